@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// A small micro-benchmark harness in the style of Google Benchmark, so the
+// benchmarks build with nothing but the compiler:
+//
+//   void BM_Thing(MicroBench::State& state) {
+//       setUp(state.range(0));                 // not timed
+//       while (state.keepRunning()) doThing();
+//       state.setItemsProcessed(state.iterations() * state.range(0));
+//   }
+//   MICRO_BENCHMARK(BM_Thing)->arg(64)->arg(1024);
+//
+// Each (benchmark, argument) pair is run with a doubling iteration count
+// until a batch takes long enough to time, then with enough iterations to
+// fill the minimum time. Every repetition's time per iteration is kept and
+// the median reported, with items/s when the benchmark set a count.
+namespace MicroBench {
+
+// Keeps the compiler from dropping a computation whose result isn't used
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    static const void* volatile sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+class State {
+public:
+    State(int64_t argument, int64_t iterations) : argument(argument), total(iterations), left(iterations) {}
+
+    // True while there are iterations left; the clock runs from the first
+    // call to the last
+    bool keepRunning() {
+        if (left == total) resumeTiming();
+        if (left-- > 0) return true;
+        pauseTiming();
+        return false;
+    }
+
+    // Setup inside the loop that shouldn't count
+    void pauseTiming() {
+        elapsed += std::chrono::steady_clock::now() - started;
+    }
+    void resumeTiming() {
+        started = std::chrono::steady_clock::now();
+    }
+
+    int64_t range(int = 0) const { return argument; }
+    int64_t iterations() const { return total; }
+    void setItemsProcessed(int64_t items) { itemsProcessed = items; }
+
+    double seconds() const { return std::chrono::duration<double>(elapsed).count(); }
+    int64_t items() const { return itemsProcessed; }
+
+private:
+    int64_t argument;
+    int64_t total;
+    int64_t left;
+    int64_t itemsProcessed = 0;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+};
+
+typedef void (*Function)(State&);
+
+class Benchmark {
+public:
+    Benchmark(const char* name, Function fn) : name(name), fn(fn) {}
+
+    Benchmark* arg(int64_t value) {
+        args.push_back(value);
+        return this;
+    }
+
+    // lo, lo * multiplier, ... up to and including hi
+    Benchmark* range(int64_t lo, int64_t hi, int64_t multiplier = 8) {
+        for (int64_t value = lo; value < hi; value *= multiplier) args.push_back(value);
+        args.push_back(hi);
+        return this;
+    }
+
+    std::string name;
+    Function fn;
+    std::vector<int64_t> args;
+};
+
+inline std::vector<Benchmark*>& registry() {
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark* registerBenchmark(const char* name, Function fn) {
+    registry().push_back(new Benchmark(name, fn));
+    return registry().back();
+}
+
+struct Options {
+    std::string filter;         // run benchmarks whose name contains this
+    double minSeconds = 0.5;    // per repetition
+    int repetitions = 3;
+    bool list = false;
+};
+
+// --filter=TEXT, --min-time=SECONDS, --repetitions=N, --list. Prints usage
+// and exits on anything else.
+inline Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (std::strncmp(a, "--filter=", 9) == 0) options.filter = a + 9;
+        else if (std::strncmp(a, "--min-time=", 11) == 0) options.minSeconds = std::atof(a + 11);
+        else if (std::strncmp(a, "--repetitions=", 14) == 0) options.repetitions = std::max(1, std::atoi(a + 14));
+        else if (std::strcmp(a, "--list") == 0) options.list = true;
+        else {
+            std::printf("Usage: %s [--filter=TEXT] [--min-time=SECONDS] [--repetitions=N] [--list]\n", argv[0]);
+            std::exit(std::strcmp(a, "--help") == 0 ? 0 : 1);
+        }
+    }
+    return options;
+}
+
+inline std::string formatRate(double perSecond) {
+    const char* units[] = { "", "k", "M", "G" };
+    int unit = 0;
+    while (perSecond >= 1000.0 && unit < 3) {
+        perSecond /= 1000.0;
+        ++unit;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.2f%s/s", perSecond, units[unit]);
+    return buffer;
+}
+
+// Runs every registered benchmark that passes the filter; returns main's exit code
+inline int runAll(const Options& options) {
+    std::vector<std::pair<std::string, std::pair<Benchmark*, int64_t>>> runs;
+    for (Benchmark* benchmark : registry()) {
+        std::vector<int64_t> args = benchmark->args.empty() ? std::vector<int64_t>(1, 0) : benchmark->args;
+        for (int64_t arg : args) {
+            std::string name = benchmark->name;
+            if (!benchmark->args.empty()) name += "/" + std::to_string(arg);
+            if (name.find(options.filter) == std::string::npos) continue;
+            runs.push_back(std::make_pair(name, std::make_pair(benchmark, arg)));
+        }
+    }
+    if (options.list) {
+        for (const auto& run : runs) std::printf("%s\n", run.first.c_str());
+        return 0;
+    }
+    if (runs.empty()) {
+        std::printf("No benchmark matches \"%s\"\n", options.filter.c_str());
+        return 1;
+    }
+
+    std::printf("%-40s %14s %12s %14s\n", "Benchmark", "Time", "Iterations", "Items");
+    std::printf("%s\n", std::string(83, '-').c_str());
+    for (const auto& run : runs) {
+        Benchmark* benchmark = run.second.first;
+        int64_t arg = run.second.second;
+
+        // Double the iterations until a batch is a tenth of the minimum time,
+        // then size the batches from that
+        int64_t iterations = 1;
+        for (;;) {
+            State state(arg, iterations);
+            benchmark->fn(state);
+            double seconds = state.seconds();
+            if (seconds >= options.minSeconds * 0.1 || iterations >= (int64_t(1) << 30)) {
+                double perIteration = std::max(seconds / iterations, 1e-9);
+                iterations = std::max<int64_t>(1, (int64_t)(options.minSeconds / perIteration));
+                break;
+            }
+            iterations *= 2;
+        }
+
+        std::vector<double> nsPerIteration;
+        std::vector<double> itemsPerSecond;
+        for (int r = 0; r < options.repetitions; ++r) {
+            State state(arg, iterations);
+            benchmark->fn(state);
+            double seconds = std::max(state.seconds(), 1e-12);
+            nsPerIteration.push_back(seconds * 1e9 / iterations);
+            itemsPerSecond.push_back(state.items() / seconds);
+        }
+        std::sort(nsPerIteration.begin(), nsPerIteration.end());
+        std::sort(itemsPerSecond.begin(), itemsPerSecond.end());
+        double ns = nsPerIteration[nsPerIteration.size() / 2];
+        double items = itemsPerSecond[itemsPerSecond.size() / 2];
+
+        std::printf("%-40s %11.0f ns %12lld %14s\n", run.first.c_str(), ns, (long long)iterations,
+            items > 0.0 ? formatRate(items).c_str() : "");
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+}
+
+#define MICRO_BENCHMARK_CONCAT2(a, b) a##b
+#define MICRO_BENCHMARK_CONCAT(a, b) MICRO_BENCHMARK_CONCAT2(a, b)
+
+// Registers fn(MicroBench::State&) at static initialisation; chain ->arg() or
+// ->range() on it for the entity counts
+#define MICRO_BENCHMARK(fn) \
+    static ::MicroBench::Benchmark* MICRO_BENCHMARK_CONCAT(microBenchmark_, __LINE__) = \
+        ::MicroBench::registerBenchmark(#fn, fn)
@@ -0,0 +1,262 @@
+// Micro-benchmarks for the engine's hot functions: world generation, mesh
+// and HUD geometry, the collision and targeting queries and the camera's
+// movement integration. Each is run over a range of entity counts. Nothing
+// here makes a GL call or needs a window, so the suite runs anywhere the
+// sources compile (GL headers only; the mesh destructor links against GLEW).
+//
+// Windows: the Benchmarks project in the solution (build Release|x64).
+// Linux, from this directory (glm, GLEW and GLFW headers installed):
+//   S="../OpenGl SpaceExplorer"
+//   g++ -std=c++14 -O2 -pthread -I"$S" MicroBenchmarks.cpp "$S/EntityWorld.cpp" "$S/JobSystem.cpp"
+//       "$S/SpatialGrid.cpp" "$S/AsteroidField.cpp" "$S/AsteroidFieldAVX2.cpp" "$S/AsteroidFieldAVX512.cpp"
+//       -lGLEW -o microbench
+//   ./microbench [--filter=TEXT] [--min-time=SECONDS] [--repetitions=N] [--list]
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MicroBench.h"
+
+#include "PlanetGenerator.h"
+#include "Mesh.h"
+#include "HUDRenderer.h"
+#include "Camera.h"
+#include "EntityWorld.h"
+#include "SpatialGrid.h"
+#include "Components.h"
+#include "BodyQueries.h"
+
+namespace {
+
+const uint64_t SEED = 1;
+
+// ---------------------------
+// World generation
+// ---------------------------
+
+void BM_GeneratePlanets(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    std::vector<Planet> planets;
+    while (state.keepRunning()) {
+        planets.clear();
+        PlanetGenerator::generatePlanets(planets, SEED, count, count);
+        MicroBench::doNotOptimize(planets.data());
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_GeneratePlanets)->range(8, 512);
+
+void BM_GenerateAsteroids(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    std::vector<Asteroid> asteroids;
+    while (state.keepRunning()) {
+        asteroids.clear();
+        PlanetGenerator::generateAsteroids(asteroids, SEED, count);
+        MicroBench::doNotOptimize(asteroids.data());
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_GenerateAsteroids)->range(256, 65536);
+
+// range(0) clusters of 25 to 55, as the game generates them (it has 4)
+void BM_GenerateAsteroidClusters(MicroBench::State& state) {
+    int clusters = (int)state.range(0);
+    std::vector<Asteroid> asteroids;
+    int64_t generated = 0;
+    while (state.keepRunning()) {
+        asteroids.clear();
+        PlanetGenerator::generateAsteroidClusters(asteroids, SEED, clusters, 25, 55, 300.0f, 1400.0f);
+        MicroBench::doNotOptimize(asteroids.data());
+        generated += (int64_t)asteroids.size();
+    }
+    state.setItemsProcessed(generated);
+}
+MICRO_BENCHMARK(BM_GenerateAsteroidClusters)->range(4, 256);
+
+void BM_GenerateStars(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    std::vector<Star> stars;
+    while (state.keepRunning()) {
+        stars.clear();
+        PlanetGenerator::generateStars(stars, SEED, count);
+        MicroBench::doNotOptimize(stars.data());
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_GenerateStars)->range(1000, 64000);
+
+// Names for range(0) planets
+void BM_GeneratePlanetName(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    while (state.keepRunning()) {
+        for (int i = 0; i < count; ++i) {
+            std::string name = PlanetGenerator::generatePlanetName((unsigned int)splitmix64(i), i);
+            MicroBench::doNotOptimize(name);
+        }
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_GeneratePlanetName)->range(8, 4096);
+
+// ---------------------------
+// Mesh and HUD geometry
+// ---------------------------
+
+// A sphere of range(0) slices by range(0) / 2 stacks (the game's is 32);
+// items are vertices
+void BM_BuildUVSphere(MicroBench::State& state) {
+    int slices = (int)state.range(0);
+    Mesh mesh;
+    while (state.keepRunning()) {
+        buildUVSphere(mesh, 1.0f, slices, slices / 2);
+        MicroBench::doNotOptimize(mesh.vertices.data());
+    }
+    state.setItemsProcessed(state.iterations() * (int64_t)mesh.vertices.size());
+}
+MICRO_BENCHMARK(BM_BuildUVSphere)->range(16, 512, 2);
+
+// range(0) cubes, each rebuilt from scratch
+void BM_BuildCube(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    Mesh mesh;
+    while (state.keepRunning()) {
+        for (int i = 0; i < count; ++i) {
+            buildCube(mesh, 1.0f + i);
+            MicroBench::doNotOptimize(mesh.vertices.data());
+        }
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_BuildCube)->range(1, 4096);
+
+// range(0) HUD labels a frame (a planet name and distance is ~16 characters)
+void BM_HudAddText(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    HUDGeometry hud;
+    while (state.keepRunning()) {
+        hud.clear();
+        for (int i = 0; i < count; ++i) {
+            hud.addText(glm::vec2(10.0f, 20.0f * i), 8.0f, glm::vec3(0.0f, 1.0f, 0.0f), "ZORVAX PRIME 1042");
+        }
+        MicroBench::doNotOptimize(hud.getVertices().data());
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_HudAddText)->range(8, 512);
+
+// range(0) target markers a frame
+void BM_HudAddCircle(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    HUDGeometry hud;
+    while (state.keepRunning()) {
+        hud.clear();
+        for (int i = 0; i < count; ++i) {
+            hud.addCircle(glm::vec2(400.0f, 300.0f), 10.0f + i, glm::vec3(1.0f, 0.5f, 0.0f));
+        }
+        MicroBench::doNotOptimize(hud.getVertices().data());
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_HudAddCircle)->range(8, 512);
+
+// ---------------------------
+// Collision and targeting
+// ---------------------------
+
+// The player tested against every one of range(0) asteroids, the linear scan
+// the spatial grid replaced; items are sphere tests
+void BM_SphereCollisionLoop(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    std::vector<Asteroid> asteroids;
+    PlanetGenerator::generateAsteroids(asteroids, SEED, count);
+    glm::vec3 player(90.0f, 0.0f, 0.0f);
+    while (state.keepRunning()) {
+        int hits = 0;
+        for (const Asteroid& a : asteroids) {
+            if (checkSphereCollision(player, 2.0f, a.pos, a.collisionRadius)) ++hits;
+        }
+        MicroBench::doNotOptimize(hits);
+    }
+    state.setItemsProcessed(state.iterations() * count);
+}
+MICRO_BENCHMARK(BM_SphereCollisionLoop)->range(256, 65536);
+
+// A system of range(0) planets (with their moons, indexed the way the game
+// does it), half of them scanned, queried from points along the orbits
+void BM_FindNearestUnscannedPlanet(MicroBench::State& state) {
+    int count = (int)state.range(0);
+    std::vector<Planet> planets;
+    PlanetGenerator::generatePlanets(planets, SEED, count, count);
+
+    EntityWorld world;
+    std::vector<Entity> gridEntities;
+    SpatialGrid grid(64.0f);
+    for (int i = 0; i < count; ++i) {
+        const Planet& planet = planets[i];
+        Orbit orbit = Orbits::planetOrbit(planet, glm::vec3(0.0f));
+        glm::vec3 position = Orbits::position(world, orbit, 0.0);
+        Entity entity = world.create(Transform{ position, 0.0f, planet.size }, orbit,
+            Collider{ planet.collisionRadius }, Scannable{ i, i % 2 == 1 });
+        grid.insert((uint32_t)gridEntities.size(), position, planet.collisionRadius);
+        gridEntities.push_back(entity);
+
+        for (const Moon& moon : planet.moons) {
+            glm::vec3 moonPosition = position + glm::vec3(moon.distance, 0.0f, 0.0f);
+            Entity moonEntity = world.create(Transform{ moonPosition, 0.0f, moon.size });
+            grid.insert((uint32_t)gridEntities.size(), moonPosition, 0.0f);
+            gridEntities.push_back(moonEntity);
+        }
+    }
+    grid.build();
+
+    const int QUERIES = 64;
+    std::vector<glm::vec3> from(QUERIES);
+    float outer = planets.back().distance;
+    for (int q = 0; q < QUERIES; ++q) {
+        float angle = q * 6.2831853f / QUERIES;
+        float radius = outer * (q + 0.5f) / QUERIES;
+        from[q] = glm::vec3(std::cos(angle) * radius, 0.0f, std::sin(angle) * radius);
+    }
+
+    while (state.keepRunning()) {
+        for (const glm::vec3& pos : from) {
+            MicroBench::doNotOptimize(nearestUnscannedPlanet(world, grid, gridEntities, pos));
+        }
+    }
+    state.setItemsProcessed(state.iterations() * QUERIES);
+}
+MICRO_BENCHMARK(BM_FindNearestUnscannedPlanet)->range(8, 4096);
+
+// ---------------------------
+// Camera
+// ---------------------------
+
+// range(0) ticks of movement, the keys changing every half second
+void BM_CameraProcessKeyboard(MicroBench::State& state) {
+    int ticks = (int)state.range(0);
+    const float DT = 1.0f / 60.0f;
+    std::vector<MoveKeys> input(ticks);
+    for (int i = 0; i < ticks; ++i) {
+        int pattern = i / 30;
+        input[i].forward = pattern % 2 == 0;
+        input[i].right = pattern % 3 == 1;
+        input[i].up = pattern % 5 == 2;
+        input[i].boost = pattern % 4 == 3;
+    }
+
+    while (state.keepRunning()) {
+        Camera camera(glm::dvec3(0.0, 0.0, 3000.0));
+        for (const MoveKeys& keys : input) camera.ProcessKeyboard(keys, DT);
+        MicroBench::doNotOptimize(camera.Position);
+    }
+    state.setItemsProcessed(state.iterations() * ticks);
+}
+MICRO_BENCHMARK(BM_CameraProcessKeyboard)->range(60, 60 * 64);
+
+}
+
+int main(int argc, char** argv) {
+    return MicroBench::runAll(MicroBench::parseOptions(argc, argv));
+}
@@ -0,0 +1,661 @@
+#include "AabbTree.h"
+#include "JobSystem.h"
+#include "SpatialGrid.h"
+#include "AsteroidField.h"
+#include "Parallel.h"
+
+#include <cfloat>
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+
+const uint32_t AabbTree::NONE;
+constexpr float AabbTree::ROTATE_THRESHOLD;
+constexpr float AabbTree::REBUILD_THRESHOLD;
+const size_t AabbTree::COST_SAMPLES;
+
+namespace {
+
+const int SAH_BINS = 16;
+const size_t PARALLEL_BUILD = 16384;    // subtrees at least this big are built as jobs
+const size_t PARALLEL_REFIT = 16384;    // refit() goes parallel from this many leaves
+
+// Bench: the most a maintained tree's query cost may be over a fresh build's
+// of the same field (REBUILD_THRESHOLD over the cost at the last rebuild,
+// with room for the fresh build itself doing better than that one did)
+const float MAINTAINED_COST_BOUND = 2.0f;
+
+} // namespace
+
+uint32_t AabbTree::allocate() {
+    if (!freeNodes.empty()) {
+        uint32_t node = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[node] = Node();
+        return node;
+    }
+    nodes.push_back(Node());
+    return (uint32_t)(nodes.size() - 1);
+}
+
+void AabbTree::release(uint32_t node) {
+    nodes[node] = Node();
+    freeNodes.push_back(node);
+}
+
+void AabbTree::setChildren(uint32_t parent, uint32_t left, uint32_t right) {
+    nodes[parent].left = left;
+    nodes[parent].right = right;
+    nodes[left].parent = parent;
+    nodes[right].parent = parent;
+}
+
+void AabbTree::fit(uint32_t node) {
+    Node& n = nodes[node];
+    n.lo = glm::min(nodes[n.left].lo, nodes[n.right].lo);
+    n.hi = glm::max(nodes[n.left].hi, nodes[n.right].hi);
+}
+
+void AabbTree::clear() {
+    nodes.clear();
+    freeNodes.clear();
+    root = NONE;
+    leafCount = 0;
+    currentCost = 0.0f;
+    referenceCost = 0.0f;
+}
+
+// Top-down binned SAH build over leaves [0, count), using the given internal
+// nodes (count - 1 of them: the first for this node, then the left subtree's,
+// then the right's, so parallel subtrees never share one)
+uint32_t AabbTree::build(uint32_t* leaves, size_t count, uint32_t* internal, JobSystem* jobs) {
+    if (count == 1) return leaves[0];
+
+    glm::vec3 centroidLo(FLT_MAX), centroidHi(-FLT_MAX);
+    for (size_t i = 0; i < count; ++i) {
+        centroidLo = glm::min(centroidLo, nodes[leaves[i]].center);
+        centroidHi = glm::max(centroidHi, nodes[leaves[i]].center);
+    }
+    glm::vec3 extent = centroidHi - centroidLo;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    size_t mid = count / 2;
+    if (extent[axis] > 0.0f) {
+        // Bin the centroids along the longest axis and split where
+        // count * area is smallest on the two sides
+        struct Bin {
+            glm::vec3 lo = glm::vec3(FLT_MAX);
+            glm::vec3 hi = glm::vec3(-FLT_MAX);
+            size_t count = 0;
+        };
+        Bin bins[SAH_BINS];
+        float scale = SAH_BINS / extent[axis] * 0.9999f;
+        auto binOf = [&](uint32_t leaf) {
+            return std::min(SAH_BINS - 1, (int)((nodes[leaf].center[axis] - centroidLo[axis]) * scale));
+        };
+        for (size_t i = 0; i < count; ++i) {
+            const Node& leaf = nodes[leaves[i]];
+            Bin& bin = bins[binOf(leaves[i])];
+            bin.lo = glm::min(bin.lo, leaf.lo);
+            bin.hi = glm::max(bin.hi, leaf.hi);
+            ++bin.count;
+        }
+
+        float rightCost[SAH_BINS];
+        glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+        size_t n = 0;
+        for (int b = SAH_BINS - 1; b > 0; --b) {
+            lo = glm::min(lo, bins[b].lo);
+            hi = glm::max(hi, bins[b].hi);
+            n += bins[b].count;
+            rightCost[b] = n ? (float)n * area(lo, hi) : 0.0f;
+        }
+
+        float bestCost = FLT_MAX;
+        int split = -1;
+        lo = glm::vec3(FLT_MAX);
+        hi = glm::vec3(-FLT_MAX);
+        n = 0;
+        for (int b = 0; b < SAH_BINS - 1; ++b) {
+            lo = glm::min(lo, bins[b].lo);
+            hi = glm::max(hi, bins[b].hi);
+            n += bins[b].count;
+            float cost = (n ? (float)n * area(lo, hi) : 0.0f) + rightCost[b + 1];
+            if (n > 0 && n < count && cost < bestCost) {
+                bestCost = cost;
+                split = b;
+            }
+        }
+        if (split >= 0) {
+            mid = std::partition(leaves, leaves + count, [&](uint32_t leaf) { return binOf(leaf) <= split; }) - leaves;
+        }
+    }
+
+    uint32_t node = internal[0];
+    uint32_t left = NONE, right = NONE;
+    if (jobs && count >= PARALLEL_BUILD) {
+        JobCounter counter;
+        jobs->run([&]() { left = build(leaves, mid, internal + 1, jobs); }, &counter);
+        right = build(leaves + mid, count - mid, internal + mid, jobs);
+        jobs->wait(counter);
+    }
+    else {
+        left = build(leaves, mid, internal + 1, jobs);
+        right = build(leaves + mid, count - mid, internal + mid, jobs);
+    }
+    setChildren(node, left, right);
+    fit(node);
+    return node;
+}
+
+void AabbTree::rebuild(JobSystem* jobs) {
+    if (root == NONE) return;
+
+    // Gather the leaves and reuse the internal nodes (a tree of n leaves
+    // always has n - 1)
+    std::vector<uint32_t>& leaves = rebuildLeaves;
+    std::vector<uint32_t>& internal = rebuildInternal;
+    leaves.clear();
+    internal.clear();
+    Stack stack;
+    stack.push(root);
+    while (!stack.empty()) {
+        uint32_t node = stack.pop();
+        if (nodes[node].left == NONE) {
+            leaves.push_back(node);
+        }
+        else {
+            internal.push_back(node);
+            stack.push(nodes[node].right);
+            stack.push(nodes[node].left);
+        }
+    }
+
+    root = build(leaves.data(), leaves.size(), internal.data(), jobs);
+    nodes[root].parent = NONE;
+    ++rebuilds;
+
+    currentCost = queryCost();
+    referenceCost = currentCost;
+}
+
+// Mean count of internal boxes holding a leaf's centre, over leaves picked
+// from the node array by a multiplicative hash (so a regular pattern of
+// removed leaves can't hide them all; the same ones each time while the
+// tree's membership doesn't change, so the cost isn't noisy from refit to refit)
+float AabbTree::queryCost() const {
+    if (root == NONE || nodes[root].left == NONE) return 0.0f;
+
+    size_t probes = 0, visited = 0;
+    Stack stack;
+    for (uint64_t k = 0; k < COST_SAMPLES; ++k) {
+        const Node& leaf = nodes[(size_t)((k * 2654435761ull) % nodes.size())];
+        if (leaf.left != NONE || leaf.id == NONE) continue;   // internal or free
+        ++probes;
+        stack.push(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.pop()];
+            if (node.left == NONE || !contains(node, leaf.center)) continue;
+            ++visited;
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+    return probes ? (float)visited / probes : 0.0f;
+}
+
+// Refits everything and sets the current cost from it
+void AabbTree::measure() {
+    if (root != NONE) refitSubtree(root, false);
+    currentCost = queryCost();
+}
+
+// Cheapest place for a new subtree: walk down from the root towards the child
+// whose box grows least, stopping where pairing with the node itself costs
+// less than going further (the usual branch-and-bound-free descent)
+uint32_t AabbTree::findSibling(uint32_t subtree) const {
+    const Node& add = nodes[subtree];
+    uint32_t index = root;
+    while (nodes[index].left != NONE) {
+        const Node& node = nodes[index];
+        float nodeArea = area(node.lo, node.hi);
+        float combinedArea = area(glm::min(node.lo, add.lo), glm::max(node.hi, add.hi));
+
+        float here = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - nodeArea);
+        auto descend = [&](uint32_t child) {
+            const Node& c = nodes[child];
+            float grown = area(glm::min(c.lo, add.lo), glm::max(c.hi, add.hi));
+            return (c.left == NONE ? grown : grown - area(c.lo, c.hi)) + inheritance;
+        };
+        float left = descend(node.left);
+        float right = descend(node.right);
+        if (here < left && here < right) break;
+        index = left < right ? node.left : node.right;
+    }
+    return index;
+}
+
+void AabbTree::attach(uint32_t subtree) {
+    if (root == NONE) {
+        root = subtree;
+        nodes[root].parent = NONE;
+        return;
+    }
+
+    uint32_t sibling = findSibling(subtree);
+    uint32_t parent = allocate();
+    uint32_t grandparent = nodes[sibling].parent;
+    setChildren(parent, sibling, subtree);
+    nodes[parent].parent = grandparent;
+    if (grandparent == NONE) root = parent;
+    else if (nodes[grandparent].left == sibling) nodes[grandparent].left = parent;
+    else nodes[grandparent].right = parent;
+
+    // Refit (and tidy up) everything above the new pair
+    for (uint32_t node = parent; node != NONE; node = nodes[node].parent) {
+        fit(node);
+        rotate(node);
+    }
+}
+
+// Unlinks a leaf, its sibling taking its parent's place. Returns the node
+// above the removed pair (whose boxes are now too big), or NONE.
+uint32_t AabbTree::detach(uint32_t leaf) {
+    uint32_t parent = nodes[leaf].parent;
+    if (parent == NONE) {
+        root = NONE;
+        return NONE;
+    }
+
+    uint32_t grandparent = nodes[parent].parent;
+    uint32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+    nodes[sibling].parent = grandparent;
+    if (grandparent == NONE) root = sibling;
+    else if (nodes[grandparent].left == parent) nodes[grandparent].left = sibling;
+    else nodes[grandparent].right = sibling;
+    release(parent);
+    return grandparent;
+}
+
+void AabbTree::insert(const std::vector<Sphere>& batch, std::vector<uint32_t>& leaves) {
+    leaves.resize(batch.size());
+    if (batch.empty()) return;
+
+    for (size_t k = 0; k < batch.size(); ++k) {
+        uint32_t leaf = allocate();
+        nodes[leaf].id = batch[k].id;
+        set(leaf, batch[k].center, batch[k].radius);
+        leaves[k] = leaf;
+    }
+    std::vector<uint32_t> internal(batch.size() - 1);
+    for (uint32_t& node : internal) node = allocate();
+
+    // The batch becomes one subtree, inserted like a single leaf
+    std::vector<uint32_t> order(leaves);
+    bool empty = root == NONE;
+    attach(build(order.data(), order.size(), internal.data(), nullptr));
+    leafCount += batch.size();
+
+    if (empty) {
+        measure();
+        referenceCost = currentCost;
+    }
+}
+
+void AabbTree::remove(const std::vector<uint32_t>& leaves) {
+    // A big batch is cheaper to follow with one full refit than with a walk
+    // up from every removed leaf
+    bool refitAll = leaves.size() * 16 > leafCount;
+    for (uint32_t leaf : leaves) {
+        uint32_t above = detach(leaf);
+        release(leaf);
+        --leafCount;
+        if (refitAll) continue;
+        for (uint32_t node = above; node != NONE; node = nodes[node].parent) fit(node);
+    }
+    if (refitAll && root != NONE) refitSubtree(root, false);
+}
+
+// Swaps one child of the node with a grandchild on the other side, if that
+// shrinks the child that gets the new pair (the node's own box is unchanged)
+void AabbTree::rotate(uint32_t node) {
+    uint32_t children[2] = { nodes[node].left, nodes[node].right };
+    float best = 0.0f;
+    int bestSide = -1, bestGrandchild = -1;
+
+    for (int side = 0; side < 2; ++side) {
+        // children[side] moves down, into the other child
+        const Node& stay = nodes[children[side]];
+        const Node& other = nodes[children[1 - side]];
+        if (other.left == NONE) continue;
+        uint32_t grand[2] = { other.left, other.right };
+        for (int g = 0; g < 2; ++g) {
+            // grand[g] comes up; the other child keeps grand[1 - g] and takes `stay`
+            const Node& kept = nodes[grand[1 - g]];
+            float newArea = area(glm::min(stay.lo, kept.lo), glm::max(stay.hi, kept.hi));
+            float delta = newArea - area(other.lo, other.hi);
+            if (delta < best) {
+                best = delta;
+                bestSide = side;
+                bestGrandchild = g;
+            }
+        }
+    }
+    if (bestSide < 0) return;
+
+    uint32_t down = children[bestSide];
+    uint32_t other = children[1 - bestSide];
+    uint32_t up = bestGrandchild == 0 ? nodes[other].left : nodes[other].right;
+    uint32_t kept = bestGrandchild == 0 ? nodes[other].right : nodes[other].left;
+
+    if (bestSide == 0) nodes[node].left = up;
+    else nodes[node].right = up;
+    nodes[up].parent = node;
+    setChildren(other, kept, down);
+    fit(other);
+}
+
+// Refits a subtree bottom-up
+void AabbTree::refitSubtree(uint32_t node, bool rotateNodes) {
+    if (nodes[node].left == NONE) return;
+    refitSubtree(nodes[node].left, rotateNodes);
+    refitSubtree(nodes[node].right, rotateNodes);
+    if (rotateNodes) rotate(node);
+    fit(node);
+}
+
+void AabbTree::refit(JobSystem* jobs) {
+    if (root == NONE) {
+        currentCost = 0.0f;
+        return;
+    }
+
+    // Lazily: only once the last refit found the tree noticeably worse
+    bool rotateNodes = referenceCost > 0.0f && currentCost > ROTATE_THRESHOLD * referenceCost;
+
+    if (jobs && leafCount >= PARALLEL_REFIT) {
+        // Cut the top of the tree into a few subtrees per thread, refit those
+        // in parallel, then the top part on this thread
+        std::vector<uint32_t> top, frontier(1, root), next;
+        size_t target = (size_t)jobs->threadCount() * 8;
+        while (frontier.size() < target) {
+            next.clear();
+            for (uint32_t node : frontier) {
+                if (nodes[node].left == NONE) {
+                    next.push_back(node);
+                    continue;
+                }
+                top.push_back(node);
+                next.push_back(nodes[node].left);
+                next.push_back(nodes[node].right);
+            }
+            if (next.size() == frontier.size()) break;   // all leaves
+            frontier.swap(next);
+        }
+
+        JobCounter counter;
+        jobs->parallelFor(frontier.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) refitSubtree(frontier[i], rotateNodes);
+        }, counter);
+        jobs->wait(counter);
+
+        // Children come after their parents in `top`, so walk it backwards
+        for (size_t i = top.size(); i > 0; --i) {
+            uint32_t node = top[i - 1];
+            if (rotateNodes) rotate(node);
+            fit(node);
+        }
+    }
+    else {
+        refitSubtree(root, rotateNodes);
+    }
+
+    currentCost = queryCost();
+    if (referenceCost > 0.0f && currentCost > REBUILD_THRESHOLD * referenceCost) rebuild(jobs);
+}
+
+// Every internal box holds its children, parents and children agree, and the
+// leaf count is right
+bool AabbTree::check() const {
+    if (root == NONE) return leafCount == 0;
+    if (nodes[root].parent != NONE) return false;
+
+    size_t leaves = 0;
+    Stack stack;
+    stack.push(root);
+    while (!stack.empty()) {
+        uint32_t index = stack.pop();
+        const Node& node = nodes[index];
+        if (node.left == NONE) {
+            ++leaves;
+            continue;
+        }
+        for (uint32_t child : { node.left, node.right }) {
+            const Node& c = nodes[child];
+            if (c.parent != index) return false;
+            if (glm::min(c.lo, node.lo) != node.lo || glm::max(c.hi, node.hi) != node.hi) return false;
+            stack.push(child);
+        }
+    }
+    return leaves == leafCount;
+}
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The game's mix: 7/8 belt, the rest in clusters of ~40 (as AsteroidField::benchmark)
+void buildField(AsteroidField& field, size_t count, uint64_t seed) {
+    std::vector<Asteroid> source;
+    size_t clustered = count / 8;
+    PlanetGenerator::generateAsteroids(source, seed, (int)(count - clustered));
+    PlanetGenerator::generateAsteroidClusters(source, seed, std::max(1, (int)(clustered / 40)), 25, 55, 300.0f, 1400.0f);
+    field.build(source, 1.0f / 120.0f);
+}
+
+} // namespace
+
+bool AabbTree::benchmark(size_t maxCount, uint64_t seed) {
+    JobSystem jobs(parallelThreadCount());
+    bool ok = true;
+
+    // Correctness first: queries against brute force while the field moves,
+    // warps (which scrambles the tree into rotations and rebuilds), loses a
+    // third of its asteroids and gets them back
+    {
+        AsteroidField field;
+        buildField(field, 20000, seed);
+        std::vector<uint8_t> present(field.size(), 1);
+
+        AabbTree tree;
+        std::vector<Sphere> batch;
+        for (size_t i = 0; i < field.size(); ++i) {
+            batch.push_back(Sphere{ (uint32_t)i, field.position(i), field.collisionRadius(i) });
+        }
+        std::vector<uint32_t> leafOf;
+        tree.insert(batch, leafOf);
+
+        auto odd = [](uint32_t id) { return (id & 1) != 0; };
+        auto verify = [&](const char* stage) {
+            bool same = tree.check();
+            std::vector<uint32_t> expected, found;
+            std::vector<Hit> brute, hits;
+            for (size_t q = 0; q < field.size(); q += 211) {
+                glm::vec3 c = field.position(q) + glm::vec3((float)(q % 5), 1.0f, -(float)(q % 3));
+
+                for (float range : { 2.0f, 60.0f }) {
+                    expected.clear();
+                    found.clear();
+                    for (size_t i = 0; i < field.size(); ++i) {
+                        if (present[i] && glm::length(c - field.position(i)) < range + field.collisionRadius(i)) expected.push_back((uint32_t)i);
+                    }
+                    tree.forEachOverlap(c, range, [&](uint32_t id, float) { found.push_back(id); });
+                    std::sort(found.begin(), found.end());
+                    same = same && found == expected;
+
+                    expected.clear();
+                    found.clear();
+                    for (size_t i = 0; i < field.size(); ++i) {
+                        if (present[i] && !(glm::length(c - field.position(i)) > range)) expected.push_back((uint32_t)i);
+                    }
+                    tree.forEachInRadius(c, range, [&](uint32_t id, float) { found.push_back(id); });
+                    std::sort(found.begin(), found.end());
+                    same = same && found == expected;
+                }
+
+                brute.clear();
+                for (size_t i = 0; i < field.size(); ++i) {
+                    if (present[i] && odd((uint32_t)i)) brute.push_back(Hit{ (uint32_t)i, glm::length(c - field.position(i)) });
+                }
+                std::sort(brute.begin(), brute.end(), [](const Hit& a, const Hit& b) {
+                    return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+                });
+                brute.resize(std::min<size_t>(brute.size(), 8));
+                tree.nearest(c, 8, odd, hits);
+                same = same && hits.size() == brute.size();
+                for (size_t k = 0; same && k < hits.size(); ++k) same = hits[k].id == brute[k].id;
+            }
+            // Maintaining it mustn't leave queries much slower than a fresh build
+            AabbTree fresh = tree;
+            fresh.rebuild();
+            bool kept = tree.cost() <= MAINTAINED_COST_BOUND * fresh.cost();
+
+            std::cout << "BVH bench: " << stage << ": cost " << tree.cost() << " (built " << tree.builtCost()
+                << ", fresh " << fresh.cost() << "), " << tree.rebuildCount() << " rebuilds, "
+                << (same ? "OK" : "MISMATCH") << (kept ? "" : ", COST NOT KEPT DOWN") << std::endl;
+            ok = ok && same && kept;
+        };
+        auto move = [&](uint64_t tick) {
+            field.evaluate(tick);
+            for (size_t i = 0; i < field.size(); ++i) {
+                if (present[i]) tree.set(leafOf[i], field.position(i), field.collisionRadius(i));
+            }
+            tree.refit(&jobs);
+        };
+
+        verify("inserted");
+        for (uint64_t t = 1; t <= 120; ++t) move(t);
+        verify("120 ticks at 1x");
+        for (uint64_t t = 1; t <= 60; ++t) move(120 + t * 100000);
+        verify("60 ticks at 100000x");
+
+        std::vector<uint32_t> gone;
+        for (size_t i = 0; i < field.size(); i += 3) {
+            gone.push_back(leafOf[i]);
+            present[i] = 0;
+        }
+        tree.remove(gone);
+        move(7000000);
+        verify("a third removed");
+
+        batch.clear();
+        std::vector<size_t> back;
+        for (size_t i = 0; i < field.size(); i += 3) {
+            batch.push_back(Sphere{ (uint32_t)i, field.position(i), field.collisionRadius(i) });
+            back.push_back(i);
+        }
+        std::vector<uint32_t> added;
+        tree.insert(batch, added);
+        for (size_t k = 0; k < back.size(); ++k) {
+            leafOf[back[k]] = added[k];
+            present[back[k]] = 1;
+        }
+        move(7000001);
+        verify("reinserted");
+    }
+
+    // Then the cost of keeping each structure up to date as the field moves,
+    // and of the queries the game makes (player-sized overlaps, 8 nearest)
+    std::cout << "BVH bench: " << jobs.threadCount() << " threads, ms per tick (update / 256 queries)" << std::endl;
+    for (size_t count = 10000; count <= maxCount; count *= 10) {
+        AsteroidField field;
+        buildField(field, count, seed);
+        size_t n = field.size();
+
+        AabbTree refitted, rebuilt;
+        std::vector<Sphere> batch;
+        for (size_t i = 0; i < n; ++i) batch.push_back(Sphere{ (uint32_t)i, field.position(i), field.collisionRadius(i) });
+        std::vector<uint32_t> leafOf, rebuiltLeafOf;
+        refitted.insert(batch, leafOf);
+        rebuilt.insert(batch, rebuiltLeafOf);
+        SpatialGrid grid(50.0f);
+
+        const int ticks = count >= 1000000 ? 10 : 30;
+        uint32_t warps[] = { 1, 1000 };
+        for (uint32_t warp : warps) {
+            double refitMs = 0.0, rebuildMs = 0.0, gridMs = 0.0;
+            double refitQ = 0.0, rebuildQ = 0.0, gridQ = 0.0;
+            float worstCost = 0.0f;   // refitted over rebuilt
+            volatile size_t sink = 0;   // keeps the queries from being optimised away
+
+            for (int t = 1; t <= ticks; ++t) {
+                field.evaluate((uint64_t)t * warp);
+
+                auto start = std::chrono::steady_clock::now();
+                JobCounter counter;
+                jobs.parallelFor(n, 4096, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) refitted.set(leafOf[i], field.position(i), field.collisionRadius(i));
+                }, counter);
+                jobs.wait(counter);
+                refitted.refit(&jobs);
+                refitMs += msSince(start);
+
+                start = std::chrono::steady_clock::now();
+                jobs.parallelFor(n, 4096, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) rebuilt.set(rebuiltLeafOf[i], field.position(i), field.collisionRadius(i));
+                }, counter);
+                jobs.wait(counter);
+                rebuilt.rebuild(&jobs);
+                rebuildMs += msSince(start);
+                worstCost = std::max(worstCost, refitted.cost() / std::max(rebuilt.cost(), 1e-6f));
+
+                start = std::chrono::steady_clock::now();
+                grid.resize(n);
+                jobs.parallelFor(n, 4096, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) grid.set(i, (uint32_t)i, field.position(i), field.collisionRadius(i));
+                }, counter);
+                jobs.wait(counter);
+                grid.build();
+                gridMs += msSince(start);
+
+                // Queries around asteroids spread over the field
+                std::vector<Hit> hits;
+                std::vector<SpatialGrid::Hit> gridHits;
+                auto any = [](uint32_t) { return true; };
+                auto queryPoint = [&](int q) { return field.position((size_t)q * (n / 256)) + glm::vec3(1.0f); };
+
+                start = std::chrono::steady_clock::now();
+                for (int q = 0; q < 256; ++q) {
+                    refitted.forEachOverlap(queryPoint(q), 2.0f, [&](uint32_t id, float) { sink += id; });
+                    sink += refitted.nearest(queryPoint(q), 8, any, hits);
+                }
+                refitQ += msSince(start);
+
+                start = std::chrono::steady_clock::now();
+                for (int q = 0; q < 256; ++q) {
+                    rebuilt.forEachOverlap(queryPoint(q), 2.0f, [&](uint32_t id, float) { sink += id; });
+                    sink += rebuilt.nearest(queryPoint(q), 8, any, hits);
+                }
+                rebuildQ += msSince(start);
+
+                start = std::chrono::steady_clock::now();
+                for (int q = 0; q < 256; ++q) {
+                    grid.forEachOverlap(queryPoint(q), 2.0f, [&](uint32_t id, float) { sink += id; });
+                    sink += grid.nearest(queryPoint(q), 8, any, gridHits);
+                }
+                gridQ += msSince(start);
+            }
+
+            bool kept = worstCost <= MAINTAINED_COST_BOUND;
+            std::cout << "BVH bench: " << n << " asteroids at " << warp << "x: refit " << refitMs / ticks << " / "
+                << refitQ / ticks << " (cost up to " << worstCost << "x a fresh build's, "
+                << refitted.rebuildCount() << " rebuilds), rebuild " << rebuildMs / ticks << " / " << rebuildQ / ticks
+                << ", grid " << gridMs / ticks << " / " << gridQ / ticks << (kept ? "" : "  COST NOT KEPT DOWN") << std::endl;
+            ok = ok && kept;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,260 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// Dynamic bounding volume hierarchy over spheres (each leaf is the axis-aligned
+// box around one), for things that move every tick but stay near their
+// neighbours, like asteroids on their orbits.
+//
+// A leaf handle stays the same for as long as the leaf exists, so the owner
+// keeps one per object and moves its sphere in place with set() (from any
+// thread, each with its own leaves). refit() then recomputes the internal
+// boxes bottom-up without changing the tree's shape. Motion slowly makes the
+// shape worse: refit() also measures the tree's query cost, and past
+// ROTATE_THRESHOLD times the cost it had when last built it starts applying
+// tree rotations on the way up; past REBUILD_THRESHOLD it rebuilds (binned
+// SAH, subtrees in parallel). Objects are added and removed in batches: a
+// batch is built into a subtree of its own and inserted as one.
+//
+// The query cost is the mean number of internal boxes that hold a sample of
+// the objects' centres, i.e. the nodes a query at an object walks through.
+// Summed box areas over the root's (the SAH cost) hardly move when siblings
+// drift apart along their orbits, even as queries get several times slower.
+//
+// Queries match SpatialGrid's, callbacks get (id, distance between centres).
+// Rebuilding the grid is still the cheaper update (see --bvh-bench), which is
+// why the game's asteroids stay in one; the tree pays off for queries, k-nearest
+// especially, once there are many more bodies than the game has.
+class AabbTree {
+public:
+    static const uint32_t NONE = UINT32_MAX;
+    static constexpr float ROTATE_THRESHOLD = 1.2f;
+    static constexpr float REBUILD_THRESHOLD = 1.5f;
+    static const size_t COST_SAMPLES = 512;   // nodes looked at for leaves to probe
+
+    struct Sphere {
+        uint32_t id;
+        glm::vec3 center;
+        float radius;
+    };
+
+    struct Hit {
+        uint32_t id;
+        float distance;
+    };
+
+    // Adds a batch; leaves[k] is the handle for batch[k]
+    void insert(const std::vector<Sphere>& batch, std::vector<uint32_t>& leaves);
+
+    // Removes a batch of leaves (the handles are invalid afterwards)
+    void remove(const std::vector<uint32_t>& leaves);
+
+    void clear();
+
+    // Moves a leaf; the boxes above it are stale until refit()
+    void set(uint32_t leaf, const glm::vec3& center, float radius) {
+        Node& node = nodes[leaf];
+        node.center = center;
+        node.radius = radius;
+        node.lo = center - glm::vec3(radius);
+        node.hi = center + glm::vec3(radius);
+    }
+
+    // Recomputes every internal box after set(), rotating or rebuilding if the
+    // tree has got too much worse. Subtrees are refitted in parallel if given
+    // a job system.
+    void refit(JobSystem* jobs = nullptr);
+
+    // Rebuilds the internal nodes from scratch (the leaves keep their handles)
+    void rebuild(JobSystem* jobs = nullptr);
+
+    size_t size() const { return leafCount; }
+
+    // Query cost (see above) as of the last refit or build, and the same
+    // just after the last build
+    float cost() const { return currentCost; }
+    float builtCost() const { return referenceCost; }
+    int rebuildCount() const { return rebuilds; }
+
+    // fn(id, distance) for every sphere overlapping this one
+    template <typename Fn>
+    void forEachOverlap(const glm::vec3& center, float radius, Fn fn) const {
+        visit(center, radius, [&](const Node& leaf) {
+            float distance = glm::length(center - leaf.center);
+            if (distance < radius + leaf.radius) fn(leaf.id, distance);
+        });
+    }
+
+    // fn(id, distance) for every sphere whose centre is within range
+    template <typename Fn>
+    void forEachInRadius(const glm::vec3& center, float range, Fn fn) const {
+        visit(center, range, [&](const Node& leaf) {
+            float distance = glm::length(center - leaf.center);
+            if (!(distance > range)) fn(leaf.id, distance);
+        });
+    }
+
+    // The k closest spheres (by centre) passing filter(id), nearest first;
+    // equal distances go to the lower id. Children are visited nearest box
+    // first and skipped once they can't beat the k-th best so far.
+    template <typename Filter>
+    size_t nearest(const glm::vec3& center, size_t k, Filter filter, std::vector<Hit>& out) const {
+        out.clear();
+        if (k == 0 || root == NONE) return 0;
+
+        // out is a max-heap on (distance, id) until the end
+        auto worse = [](const Hit& a, const Hit& b) {
+            return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+        };
+        Stack stack;
+        stack.push(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.pop()];
+            if (out.size() == k && boxDistance(node, center) > out.front().distance) continue;
+
+            if (node.left == NONE) {
+                Hit hit{ node.id, glm::length(center - node.center) };
+                if (out.size() == k && !worse(hit, out.front())) continue;
+                if (!filter(node.id)) continue;
+                if (out.size() == k) {
+                    std::pop_heap(out.begin(), out.end(), worse);
+                    out.pop_back();
+                }
+                out.push_back(hit);
+                std::push_heap(out.begin(), out.end(), worse);
+                continue;
+            }
+
+            // Nearer child on top of the stack
+            float dl = boxDistance(nodes[node.left], center);
+            float dr = boxDistance(nodes[node.right], center);
+            if (dl < dr) {
+                stack.push(node.right);
+                stack.push(node.left);
+            }
+            else {
+                stack.push(node.left);
+                stack.push(node.right);
+            }
+        }
+        std::sort_heap(out.begin(), out.end(), worse);
+        return out.size();
+    }
+
+    // The closest sphere passing filter(id), or NONE
+    template <typename Filter>
+    uint32_t nearest(const glm::vec3& center, Filter filter) const {
+        std::vector<Hit> best;
+        nearest(center, 1, filter, best);
+        return best.empty() ? NONE : best[0].id;
+    }
+
+    // Checks queries against brute force through inserts, removals, refits,
+    // rotations and rebuilds, then times refit vs rebuild vs SpatialGrid on
+    // moving asteroid fields from 10k up to maxCount (--bvh-bench).
+    // Returns false on any mismatch.
+    static bool benchmark(size_t maxCount, uint64_t seed);
+
+private:
+    struct Node {
+        glm::vec3 lo;
+        glm::vec3 hi;
+        uint32_t parent = NONE;
+        uint32_t left = NONE;     // NONE for a leaf
+        uint32_t right = NONE;
+        uint32_t id = NONE;       // leaf only
+        glm::vec3 center;         // leaf only: the exact sphere
+        float radius = 0.0f;
+    };
+
+    // Traversal stack, on the stack unless the tree is unusually deep
+    class Stack {
+    public:
+        bool empty() const { return count == 0; }
+        void push(uint32_t node) {
+            if (count < INLINE) fixed[count] = node;
+            else spill.push_back(node);
+            ++count;
+        }
+        uint32_t pop() {
+            --count;
+            if (count < INLINE) return fixed[count];
+            uint32_t node = spill.back();
+            spill.pop_back();
+            return node;
+        }
+
+    private:
+        static const size_t INLINE = 64;
+        uint32_t fixed[INLINE];
+        std::vector<uint32_t> spill;
+        size_t count = 0;
+    };
+
+    static float boxDistance(const Node& node, const glm::vec3& p) {
+        glm::vec3 d = glm::max(glm::max(node.lo - p, p - node.hi), glm::vec3(0.0f));
+        return glm::length(d);
+    }
+
+    static bool contains(const Node& node, const glm::vec3& p) {
+        return p.x >= node.lo.x && p.y >= node.lo.y && p.z >= node.lo.z
+            && p.x <= node.hi.x && p.y <= node.hi.y && p.z <= node.hi.z;
+    }
+
+    static float area(const glm::vec3& lo, const glm::vec3& hi) {
+        glm::vec3 e = hi - lo;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    // visitor(leaf) for every leaf whose box is within range of the point
+    // (a leaf's box already includes its radius, as overlap tests need)
+    template <typename Visitor>
+    void visit(const glm::vec3& center, float range, Visitor visitor) const {
+        if (root == NONE) return;
+        Stack stack;
+        stack.push(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.pop()];
+            if (boxDistance(node, center) > range) continue;
+            if (node.left == NONE) {
+                visitor(node);
+            }
+            else {
+                stack.push(node.right);
+                stack.push(node.left);
+            }
+        }
+    }
+
+    uint32_t allocate();
+    void release(uint32_t node);
+    void setChildren(uint32_t parent, uint32_t left, uint32_t right);
+    void fit(uint32_t node);
+
+    uint32_t build(uint32_t* leaves, size_t count, uint32_t* internal, JobSystem* jobs);
+    uint32_t findSibling(uint32_t subtree) const;
+    void attach(uint32_t subtree);
+    uint32_t detach(uint32_t leaf);
+    void refitSubtree(uint32_t node, bool rotate);
+    void rotate(uint32_t node);
+    float queryCost() const;
+    void measure();
+    bool check() const;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> freeNodes;
+    std::vector<uint32_t> rebuildLeaves;     // rebuild() scratch, kept to save allocating
+    std::vector<uint32_t> rebuildInternal;
+    uint32_t root = NONE;
+    size_t leafCount = 0;
+
+    float currentCost = 0.0f;
+    float referenceCost = 0.0f;
+    int rebuilds = 0;
+};
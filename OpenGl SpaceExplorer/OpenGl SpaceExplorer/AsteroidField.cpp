@@ -0,0 +1,431 @@
+#include "AsteroidField.h"
+#include "AsteroidKernels.h"
+#include "Orbits.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+
+// The scalar path must round exactly like the SIMD kernels
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+namespace {
+
+using namespace AsteroidKernels::constants;
+
+// Scalar twins of the AsteroidKernels helpers, same operations in the same order
+
+void sinCosPoly(float r, float& s, float& c) {
+    float r2 = r * r;
+    s = SIN_2 + r2 * SIN_3;
+    s = SIN_1 + r2 * s;
+    s = r + (r * r2) * s;
+
+    c = COS_2 + r2 * COS_3;
+    c = COS_1 + r2 * c;
+    c = (1.0f - 0.5f * r2) + (r2 * r2) * c;
+}
+
+void sinCosPhase(uint32_t phase, float& s, float& c) {
+    uint32_t shifted = phase + (1u << 29);
+    uint32_t qi = shifted >> 30;
+    uint32_t offset = (shifted & ((1u << 30) - 1u)) >> 6;
+    float r = ((float)(int32_t)offset - 8388608.0f) * QUARTER_TURN_STEP;
+
+    float ps, pc;
+    sinCosPoly(r, ps, pc);
+    bool swap = (qi & 1) != 0;
+    s = swap ? pc : ps;
+    c = swap ? ps : pc;
+    if (qi & 2) s = -s;
+    if ((qi + 1) & 2) c = -c;
+}
+
+void solveKepler(uint32_t phase, float e, float& sinE, float& cosE) {
+    float sinM, cosM;
+    sinCosPhase(phase, sinM, cosM);
+
+    float M = (float)(int32_t)phase * TURN_STEP;
+    float d = e * sinM;
+    float sd, cd;
+    sinCosPoly(d, sd, cd);
+    float E = M + d;
+    sinE = sinM * cd + cosM * sd;
+    cosE = cosM * cd - sinM * sd;
+
+    for (int k = 0; k < KEPLER_ITERATIONS; ++k) {
+        float f = (E - e * sinE) - M;
+        float df = 1.0f - e * cosE;
+        d = f / df;
+        sinCosPoly(d, sd, cd);
+
+        E = E - d;
+        float s = sinE * cd - cosE * sd;
+        cosE = cosE * cd + sinE * sd;
+        sinE = s;
+    }
+}
+
+template <bool Centred>
+void evaluateOrbitsScalar(const AsteroidKernels::OrbitArrays& o, uint32_t tick,
+    float* x, float* y, float* z, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float s, c;
+        solveKepler(o.phase0[i] + o.rate[i] * tick, o.eccentricity[i], s, c);
+        float u = c - o.eccentricity[i];
+
+        float px = u * o.px[i] + s * o.qx[i];
+        float py = u * o.py[i] + s * o.qy[i];
+        float pz = u * o.pz[i] + s * o.qz[i];
+        py = o.baseY[i] + py;
+        if (Centred) {
+            px = o.centerX[i] + px;
+            pz = o.centerZ[i] + pz;
+        }
+        x[i] = px;
+        y[i] = py;
+        z[i] = pz;
+    }
+}
+
+// Radians -> fraction of a turn in 32-bit fixed point (wrapping, negatives included)
+uint32_t toTurns(double radians) {
+    double turns = radians / 6.283185307179586;
+    turns -= std::floor(turns);
+    return (uint32_t)(uint64_t)std::llround(turns * 4294967296.0);
+}
+
+uint32_t toTurnRate(double radiansPerSecond, double tickSeconds) {
+    return (uint32_t)(int64_t)std::llround(radiansPerSecond * tickSeconds / 6.283185307179586 * 4294967296.0);
+}
+
+const AsteroidKernels::Table* baselineTable() {
+#if defined(SIMD_X86)
+    static const AsteroidKernels::Table table = AsteroidKernels::makeTable<SimdSse2>();
+    return &table;
+#elif defined(SIMD_NEON)
+    static const AsteroidKernels::Table table = AsteroidKernels::makeTable<SimdNeon>();
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+struct Dispatch {
+    const char* name;
+    const AsteroidKernels::Table* table;
+};
+
+// Widest table at or below the requested level. NEON counts as the SSE2 tier.
+Dispatch pick(SimdLevel wanted) {
+#if defined(SIMD_NEON)
+    if (wanted != SimdLevel::Scalar) return { "NEON", baselineTable() };
+    return { "scalar", nullptr };
+#else
+    SimdLevel supported = detectSimdLevel();
+    if ((int)wanted > (int)supported) wanted = supported;
+
+    if (wanted == SimdLevel::AVX512 && AsteroidKernels::avx512Table()) return { "AVX-512", AsteroidKernels::avx512Table() };
+    if ((int)wanted >= (int)SimdLevel::AVX2 && AsteroidKernels::avx2Table()) return { "AVX2", AsteroidKernels::avx2Table() };
+    if ((int)wanted >= (int)SimdLevel::SSE2 && baselineTable()) return { "SSE2", baselineTable() };
+    return { "scalar", nullptr };
+#endif
+}
+
+Dispatch& current() {
+    static Dispatch d = pick(SimdLevel::AVX512);
+    return d;
+}
+
+} // namespace
+
+void AsteroidField::build(const std::vector<Asteroid>& asteroids, float tickSeconds) {
+    std::vector<const Asteroid*> ordered;
+    ordered.reserve(asteroids.size());
+    for (const auto& a : asteroids) if (!a.clustered) ordered.push_back(&a);
+    belt = ordered.size();
+    for (const auto& a : asteroids) if (a.clustered) ordered.push_back(&a);
+
+    size_t n = ordered.size();
+    for (auto* v : { &eccentricity, &px, &py, &pz, &qx, &qy, &qz, &baseY, &posX, &posY, &posZ, &scales, &collisionRadii, &motions }) {
+        v->resize(n);
+    }
+    phase0.resize(n);
+    rate.resize(n);
+    centerX.resize(n);
+    centerZ.resize(n);
+    rot.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        const Asteroid& a = *ordered[i];
+        float semiMajor;
+        if (i < belt) {
+            phase0[i] = toTurns(a.orbitAngle);
+            rate[i] = toTurnRate(a.orbitSpeed, tickSeconds);
+            semiMajor = a.orbitRadius;
+            baseY[i] = a.orbitHeight;
+            centerX[i] = 0.0f;
+            centerZ[i] = 0.0f;
+        }
+        else {
+            phase0[i] = toTurns(a.localAngle);
+            rate[i] = toTurnRate(a.localSpeed, tickSeconds);
+            semiMajor = a.localRadius;
+            baseY[i] = a.clusterCenter.y + a.orbitHeight;
+            centerX[i] = a.clusterCenter.x;
+            centerZ[i] = a.clusterCenter.z;
+        }
+
+        // Fold the semi-axes into the orbit's axes so the kernels only need
+        // the eccentricity besides them
+        glm::vec3 P, Q;
+        Orbits::perifocalAxes(a.inclination, a.ascendingNode, a.periapsisArg, P, Q);
+        float semiMinor = semiMajor * std::sqrt(1.0f - a.eccentricity * a.eccentricity);
+        eccentricity[i] = a.eccentricity;
+        px[i] = P.x * semiMajor;
+        py[i] = P.y * semiMajor;
+        pz[i] = P.z * semiMajor;
+        qx[i] = Q.x * semiMinor;
+        qy[i] = Q.y * semiMinor;
+        qz[i] = Q.z * semiMinor;
+
+        rot[i] = a.rot;
+        scales[i] = a.scale;
+        collisionRadii[i] = a.collisionRadius;
+        motions[i] = std::fabs((float)(int32_t)rate[i]) * TURN_STEP * semiMajor;
+    }
+
+    evaluate(0);
+}
+
+AsteroidKernels::OrbitArrays AsteroidField::arrays(size_t first) const {
+    AsteroidKernels::OrbitArrays o;
+    o.phase0 = phase0.data() + first;
+    o.rate = rate.data() + first;
+    o.eccentricity = eccentricity.data() + first;
+    o.px = px.data() + first;
+    o.py = py.data() + first;
+    o.pz = pz.data() + first;
+    o.qx = qx.data() + first;
+    o.qy = qy.data() + first;
+    o.qz = qz.data() + first;
+    o.baseY = baseY.data() + first;
+    o.centerX = centerX.data() + first;
+    o.centerZ = centerZ.data() + first;
+    return o;
+}
+
+void AsteroidField::evaluate(uint64_t tick) {
+    evaluate(tick, 0, size());
+}
+
+void AsteroidField::evaluate(uint64_t tick, size_t begin, size_t end) {
+    const AsteroidKernels::Table* t = current().table;
+
+    // Only the low 32 bits of the tick matter: the phase wraps modulo 2^32 anyway
+    uint32_t tick32 = (uint32_t)tick;
+
+    // Belt: orbits around the sun
+    size_t beltEnd = std::min(end, belt);
+    if (begin < beltEnd) {
+        AsteroidKernels::OrbitArrays b = arrays(begin);
+        size_t n = beltEnd - begin;
+        float* x = posX.data() + begin;
+        float* y = posY.data() + begin;
+        float* z = posZ.data() + begin;
+        size_t i = t ? t->evaluateBelt(b, tick32, x, y, z, n) : 0;
+        evaluateOrbitsScalar<false>(b, tick32, x, y, z, i, n);
+    }
+
+    // Clusters: orbits around each cluster's centre
+    size_t clusterBegin = std::max(begin, belt);
+    if (clusterBegin < end) {
+        AsteroidKernels::OrbitArrays c = arrays(clusterBegin);
+        size_t n = end - clusterBegin;
+        float* x = posX.data() + clusterBegin;
+        float* y = posY.data() + clusterBegin;
+        float* z = posZ.data() + clusterBegin;
+        size_t i = t ? t->evaluateClusters(c, tick32, x, y, z, n) : 0;
+        evaluateOrbitsScalar<true>(c, tick32, x, y, z, i, n);
+    }
+}
+
+void AsteroidField::evaluateListed(uint64_t tick, const uint32_t* indices, size_t count) {
+    size_t beltEnd = std::lower_bound(indices, indices + count, (uint32_t)belt) - indices;
+    evaluateGathered<false>((uint32_t)tick, indices, beltEnd);
+    evaluateGathered<true>((uint32_t)tick, indices + beltEnd, count - beltEnd);
+}
+
+template <bool Centred>
+void AsteroidField::evaluateGathered(uint32_t tick, const uint32_t* indices, size_t count) {
+    const AsteroidKernels::Table* t = current().table;
+
+    // One batch of orbits copied out side by side (~15 KB, stays in L1)
+    const size_t BATCH = 256;
+    uint32_t gPhase0[BATCH], gRate[BATCH];
+    float gE[BATCH], gPx[BATCH], gPy[BATCH], gPz[BATCH], gQx[BATCH], gQy[BATCH], gQz[BATCH];
+    float gBaseY[BATCH], gCenterX[BATCH], gCenterZ[BATCH];
+    float x[BATCH], y[BATCH], z[BATCH];
+    AsteroidKernels::OrbitArrays o{ gPhase0, gRate, gE, gPx, gPy, gPz, gQx, gQy, gQz, gBaseY, gCenterX, gCenterZ };
+
+    for (size_t first = 0; first < count; first += BATCH) {
+        size_t n = std::min(BATCH, count - first);
+        const uint32_t* batch = indices + first;
+        for (size_t k = 0; k < n; ++k) {
+            uint32_t i = batch[k];
+            gPhase0[k] = phase0[i];
+            gRate[k] = rate[i];
+            gE[k] = eccentricity[i];
+            gPx[k] = px[i];
+            gPy[k] = py[i];
+            gPz[k] = pz[i];
+            gQx[k] = qx[i];
+            gQy[k] = qy[i];
+            gQz[k] = qz[i];
+            gBaseY[k] = baseY[i];
+            gCenterX[k] = centerX[i];
+            gCenterZ[k] = centerZ[i];
+        }
+
+        size_t done = !t ? 0 : Centred ? t->evaluateClusters(o, tick, x, y, z, n) : t->evaluateBelt(o, tick, x, y, z, n);
+        evaluateOrbitsScalar<Centred>(o, tick, x, y, z, done, n);
+
+        for (size_t k = 0; k < n; ++k) {
+            posX[batch[k]] = x[k];
+            posY[batch[k]] = y[k];
+            posZ[batch[k]] = z[k];
+        }
+    }
+}
+
+glm::vec3 AsteroidField::positionAt(size_t i, uint64_t tick) const {
+    AsteroidKernels::OrbitArrays o = arrays(i);
+    glm::vec3 p;
+    if (i < belt) evaluateOrbitsScalar<false>(o, (uint32_t)tick, &p.x, &p.y, &p.z, 0, 1);
+    else evaluateOrbitsScalar<true>(o, (uint32_t)tick, &p.x, &p.y, &p.z, 0, 1);
+    return p;
+}
+
+const char* AsteroidField::pathName() {
+    return current().name;
+}
+
+void AsteroidField::setLevel(SimdLevel level) {
+    current() = pick(level);
+}
+
+bool AsteroidField::benchmark(size_t count, uint64_t seed) {
+    // Same generators the game uses: 7/8 belt, the rest in clusters of ~40
+    std::vector<Asteroid> source;
+    size_t clustered = count / 8;
+    PlanetGenerator::generateAsteroids(source, seed, (int)(count - clustered));
+    int clusterGroups = std::max(1, (int)(clustered / 40));
+    PlanetGenerator::generateAsteroidClusters(source, seed, clusterGroups, 25, 55, 300.0f, 1400.0f);
+
+    const int ticks = 120;
+    const float tickSeconds = 1.0f / 120.0f;
+    Dispatch original = current();
+
+    AsteroidField reference;
+    bool ok = true;
+    double scalarMs = 0.0;
+
+    SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+    const char* lastName = nullptr;
+    for (SimdLevel level : levels) {
+        Dispatch d = pick(level);
+        if (lastName && std::strcmp(d.name, lastName) == 0) continue;   // not supported here
+        lastName = d.name;
+        current() = d;
+
+        AsteroidField field;
+        field.build(source, tickSeconds);   // also evaluates tick 0 (warms caches)
+
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 1; t <= ticks; ++t) field.evaluate((uint64_t)t);
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count() / ticks;
+
+        bool match = true;
+        if (level == SimdLevel::Scalar) {
+            reference = field;
+            scalarMs = ms;
+        }
+        else {
+            size_t n = field.size();
+            match = std::memcmp(field.posX.data(), reference.posX.data(), n * sizeof(float)) == 0
+                && std::memcmp(field.posY.data(), reference.posY.data(), n * sizeof(float)) == 0
+                && std::memcmp(field.posZ.data(), reference.posZ.data(), n * sizeof(float)) == 0;
+        }
+
+        std::cout << "Asteroid bench: " << d.name << " " << field.size() << " asteroids ("
+            << field.beltCount() << " belt, " << field.clusterCount() << " clustered) "
+            << ms << " ms/tick";
+        if (level != SimdLevel::Scalar) {
+            std::cout << ", " << (ms > 0.0 ? scalarMs / ms : 0.0) << "x scalar, "
+                << (match ? "matches scalar" : "MISMATCH");
+        }
+        std::cout << std::endl;
+        ok = ok && match;
+    }
+
+    // Float sincos + fixed-step Newton vs Kepler solved in double, relative to
+    // the orbit's size or its distance from the sun, whichever is larger (a
+    // float position far out can't be closer than that anyway)
+    double maxError = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        uint32_t phase = reference.phase0[i] + reference.rate[i] * (uint32_t)ticks;
+        double e = reference.eccentricity[i];
+        double E = Orbits::solveKepler((double)(int32_t)phase * (Orbits::TWO_PI / 4294967296.0), e);
+        double u = std::cos(E) - e;
+        double v = std::sin(E);
+        double x = reference.centerX[i] + u * reference.px[i] + v * reference.qx[i];
+        double y = reference.baseY[i] + u * reference.py[i] + v * reference.qy[i];
+        double z = reference.centerZ[i] + u * reference.pz[i] + v * reference.qz[i];
+        double err = std::sqrt((x - reference.posX[i]) * (x - reference.posX[i])
+            + (y - reference.posY[i]) * (y - reference.posY[i])
+            + (z - reference.posZ[i]) * (z - reference.posZ[i]));
+        double size = std::sqrt((double)reference.px[i] * reference.px[i]
+            + (double)reference.py[i] * reference.py[i] + (double)reference.pz[i] * reference.pz[i]);
+        size = std::max(size, std::sqrt(x * x + y * y + z * z));
+        maxError = std::max(maxError, err / size);
+    }
+    bool accurate = maxError < 1e-5;
+    std::cout << "Asteroid bench: max Kepler error vs double " << maxError
+        << (accurate ? " OK" : " FAILED") << std::endl;
+    ok = ok && accurate;
+
+    // Random access: one asteroid far in the future without stepping there
+    uint64_t farTick = 120ull * 3600 * 24 * 365;
+    reference.evaluate(farTick);
+    glm::vec3 direct = reference.positionAt(reference.size() / 2, farTick);
+    bool randomAccess = direct == reference.position(reference.size() / 2);
+    std::cout << "Asteroid bench: positionAt() after a year of ticks "
+        << (randomAccess ? "matches evaluate()" : "MISMATCH") << std::endl;
+    ok = ok && randomAccess;
+
+    // Gathered: a third of the asteroids through the index list, against
+    // evaluating all of them at the same tick
+    std::vector<uint32_t> third;
+    for (uint32_t i = 0; i < (uint32_t)reference.size(); i += 3) third.push_back(i);
+    AsteroidField gathered = reference;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 1; t <= ticks; ++t) gathered.evaluateListed((uint64_t)t, third.data(), third.size());
+    double gatheredMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / ticks;
+    reference.evaluate((uint64_t)ticks);
+    bool gatherMatch = true;
+    for (uint32_t i : third) gatherMatch = gatherMatch && gathered.position(i) == reference.position(i);
+    std::cout << "Asteroid bench: " << third.size() << " gathered asteroids " << gatheredMs << " ms/tick, "
+        << (gatherMatch ? "matches evaluate()" : "MISMATCH") << std::endl;
+    ok = ok && gatherMatch;
+
+    current() = original;
+    return ok;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "PlanetGenerator.h"
+#include "SimdPack.h"
+#include "AsteroidKernels.h"
+
+// Every asteroid in the scene, stored as structure-of-arrays.
+//
+// The generator's Asteroid structs are split into hot orbit state (phase,
+// rate, orbit shape, centre, position) and cold render/collision data (rotation,
+// scale, collision radius). Belt asteroids come first and cluster members after
+// them, so evaluating the field is two branch-free loops instead of one loop
+// that tests `clustered` per element. The loops run 4 / 8 / 16 asteroids per
+// step (SSE2 or NEON / AVX2 / AVX-512) with a vectorised sincos; the scalar path
+// performs the same operations, so every path gives identical positions.
+//
+// Orbits are Keplerian (eccentric and inclined) and closed-form in the
+// simulation tick: each mean anomaly is a fraction of a turn in 32-bit fixed
+// point, phase(tick) = phase0 + rate * tick, which wraps exactly, and Kepler's
+// equation is solved with a fixed number of Newton steps in every lane. Any
+// tick can be evaluated directly, in any order, without drift.
+class AsteroidField {
+public:
+    // Replaces the contents; belt asteroids keep their order, then clusters.
+    // The generator's angles are the phases at tick 0.
+    void build(const std::vector<Asteroid>& asteroids, float tickSeconds);
+
+    // Rewrites every position for the given simulation tick
+    void evaluate(uint64_t tick);
+
+    // Same for [begin, end) only; disjoint ranges can run on different threads
+    void evaluate(uint64_t tick, size_t begin, size_t end);
+
+    // Same for the listed asteroids only (ascending). They are gathered into
+    // contiguous batches for the kernels, so this pays off when the list is
+    // well under the whole range (the simulation LOD's due asteroids).
+    void evaluateListed(uint64_t tick, const uint32_t* indices, size_t count);
+
+    // One asteroid at any tick, without touching the stored positions
+    glm::vec3 positionAt(size_t i, uint64_t tick) const;
+
+    size_t size() const { return phase0.size(); }
+    size_t beltCount() const { return belt; }
+    size_t clusterCount() const { return phase0.size() - belt; }
+    bool isClustered(size_t i) const { return i >= belt; }
+
+    glm::vec3 position(size_t i) const { return glm::vec3(posX[i], posY[i], posZ[i]); }
+
+    // The point cluster member i orbits, lifted by its orbit height
+    glm::vec3 clusterCenter(size_t i) const { return glm::vec3(centerX[i], baseY[i], centerZ[i]); }
+
+    // Overrides a position until the asteroid is next evaluated (the --nbody
+    // clusters are moved by NBody instead)
+    void setPosition(size_t i, const glm::vec3& p) {
+        posX[i] = p.x;
+        posY[i] = p.y;
+        posZ[i] = p.z;
+    }
+    const glm::vec3& rotation(size_t i) const { return rot[i]; }
+    float scale(size_t i) const { return scales[i]; }
+    float collisionRadius(size_t i) const { return collisionRadii[i]; }
+
+    // About as far as asteroid i moves in one tick (its mean orbital speed)
+    float motionPerTick(size_t i) const { return motions[i]; }
+
+    // Kernel used by evaluate() on this machine (shared by every field)
+    static const char* pathName();
+    static void setLevel(SimdLevel level);
+
+    // Times the scalar and SIMD evaluation of `count` generated asteroids and
+    // checks that they agree exactly. Returns false on any mismatch.
+    static bool benchmark(size_t count, uint64_t seed);
+
+private:
+    size_t belt = 0;
+
+    // Hot: read every tick. For the belt these are the orbit around the sun;
+    // for cluster members the local orbit around their cluster centre.
+    std::vector<uint32_t> phase0;  // mean anomaly at tick 0, 2^32 = one turn
+    std::vector<uint32_t> rate;    // turns per tick, same units
+    std::vector<float> eccentricity;
+    std::vector<float> px, py, pz; // towards periapsis, times the semi-major axis
+    std::vector<float> qx, qy, qz; // 90 degrees ahead, times the semi-minor axis
+    std::vector<float> baseY;      // orbit height (+ cluster centre)
+    std::vector<float> centerX;    // cluster centre (zero for the belt, never read)
+    std::vector<float> centerZ;
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> posZ;
+
+    AsteroidKernels::OrbitArrays arrays(size_t first) const;
+
+    template <bool Centred>
+    void evaluateGathered(uint32_t tick, const uint32_t* indices, size_t count);
+
+    // Cold
+    std::vector<glm::vec3> rot;
+    std::vector<float> scales;
+    std::vector<float> collisionRadii;
+    std::vector<float> motions;
+};
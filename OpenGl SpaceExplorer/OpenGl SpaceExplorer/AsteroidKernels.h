@@ -0,0 +1,191 @@
+#pragma once
+// Batched asteroid orbit kernels, written once against the SimdPack interface
+// and instantiated per instruction set by AsteroidField.cpp /
+// AsteroidFieldAVX2.cpp / AsteroidFieldAVX512.cpp. They mirror the scalar path
+// in AsteroidField.cpp operation for operation, so every width produces
+// bit-identical positions. Only whole batches are handled here.
+//
+// Deliberately includes no standard headers (see NoiseKernels.h).
+
+// The helpers are called once per batch from a tight loop; a call there would
+// spill every register through the stack, so make sure they are inlined
+#if defined(_MSC_VER)
+#define ASTEROID_KERNEL_INLINE __forceinline
+#else
+#define ASTEROID_KERNEL_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace AsteroidKernels {
+
+// One range of orbits as parallel arrays (centerX/Z only used by clusters)
+struct OrbitArrays {
+    const uint32_t* phase0;
+    const uint32_t* rate;
+    const float* eccentricity;
+    const float* px;
+    const float* py;
+    const float* pz;
+    const float* qx;
+    const float* qy;
+    const float* qz;
+    const float* baseY;
+    const float* centerX;
+    const float* centerZ;
+};
+
+namespace constants {
+// pi/2 per 2^24 steps of the reduced phase (see sinCosPhase)
+const float QUARTER_TURN_STEP = 1.57079632679f / 16777216.0f;
+// one full turn per 2^32 steps of the phase
+const float TURN_STEP = 6.28318530718f / 4294967296.0f;
+
+// Newton steps for Kepler's equation. From E = M + e sin M the error is at most
+// ~0.06 for the generator's eccentricities (<= 0.3); Newton squares it each
+// step, so two steps are already below float precision.
+const int KEPLER_ITERATIONS = 2;
+
+// Minimax sin/cos coefficients on [-pi/4, pi/4]
+const float SIN_1 = -1.6666654611e-1f;
+const float SIN_2 = 8.3321608736e-3f;
+const float SIN_3 = -1.9515295891e-4f;
+const float COS_1 = 4.166664568298827e-2f;
+const float COS_2 = -1.388731625493765e-3f;
+const float COS_3 = 2.443315711809948e-5f;
+}
+
+// sin and cos of r in [-pi/4, pi/4]: two short polynomials
+template <class K>
+ASTEROID_KERNEL_INLINE void sinCosPoly(typename K::F r, typename K::F& s, typename K::F& c) {
+    using namespace constants;
+    typename K::F r2 = K::mul(r, r);
+    s = K::add(K::set1(SIN_2), K::mul(r2, K::set1(SIN_3)));
+    s = K::add(K::set1(SIN_1), K::mul(r2, s));
+    s = K::add(r, K::mul(K::mul(r, r2), s));
+
+    c = K::add(K::set1(COS_2), K::mul(r2, K::set1(COS_3)));
+    c = K::add(K::set1(COS_1), K::mul(r2, c));
+    c = K::add(K::sub(K::set1(1.0f), K::mul(K::set1(0.5f), r2)), K::mul(K::mul(r2, r2), c));
+}
+
+// sin and cos of r in [-pi/4, pi/4] rotated by quadrant qi: the quadrant picks
+// which polynomial is which and the signs (no branches, no tables)
+template <class K>
+ASTEROID_KERNEL_INLINE void sinCosQuadrant(typename K::F r, typename K::I qi, typename K::F& s, typename K::F& c) {
+    typename K::F ps, pc;
+    sinCosPoly<K>(r, ps, pc);
+
+    typename K::I one = K::iset1(1u);
+    typename K::I two = K::iset1(2u);
+    typename K::M swap = K::ieq(K::iand(qi, one), one);
+    typename K::F sv = K::select(swap, pc, ps);
+    typename K::F cv = K::select(swap, ps, pc);
+
+    // Quadrants 2-3 negate sin, quadrants 1-2 negate cos: move that bit to the sign
+    s = K::xorBits(sv, K::template isll<30>(K::iand(qi, two)));
+    c = K::xorBits(cv, K::template isll<30>(K::iand(K::iadd(qi, one), two)));
+}
+
+// sin and cos of a phase given as a fraction of a full turn in 32-bit fixed
+// point. Range reduction is exact integer work: after rounding by an eighth of
+// a turn the top two bits are the quadrant and the next 24 are the offset
+// within it.
+template <class K>
+ASTEROID_KERNEL_INLINE void sinCosPhase(typename K::I phase, typename K::F& s, typename K::F& c) {
+    using namespace constants;
+    typename K::I shifted = K::iadd(phase, K::iset1(1u << 29));
+    typename K::I qi = K::template isrl<30>(shifted);
+    typename K::I offset = K::template isrl<6>(K::iand(shifted, K::iset1((1u << 30) - 1u)));
+    typename K::F r = K::mul(K::sub(K::toFloat(offset), K::set1(8388608.0f)), K::set1(QUARTER_TURN_STEP));
+    sinCosQuadrant<K>(r, qi, s, c);
+}
+
+// Solves Kepler's equation M = E - e sin E for the eccentric anomaly with a
+// fixed number of Newton steps (no convergence test, so no divergent lanes),
+// and returns sin E and cos E. The phase is the mean anomaly in turns.
+//
+// Only M goes through a full sincos. Every later change to E is small (the
+// first is e sin M, at most e), so sin E and cos E are carried along by
+// rotating them through each step with the short polynomials alone.
+template <class K>
+ASTEROID_KERNEL_INLINE void solveKepler(typename K::I phase, typename K::F e, typename K::F& sinE, typename K::F& cosE) {
+    using namespace constants;
+    typename K::F sinM, cosM;
+    sinCosPhase<K>(phase, sinM, cosM);
+
+    // Signed turns -> [-pi, pi)
+    typename K::F M = K::mul(K::toFloat(phase), K::set1(TURN_STEP));
+    typename K::F d = K::mul(e, sinM);
+    typename K::F sd, cd;
+    sinCosPoly<K>(d, sd, cd);
+    typename K::F E = K::add(M, d);
+    sinE = K::add(K::mul(sinM, cd), K::mul(cosM, sd));
+    cosE = K::sub(K::mul(cosM, cd), K::mul(sinM, sd));
+
+    typename K::F one = K::set1(1.0f);
+    for (int k = 0; k < KEPLER_ITERATIONS; ++k) {
+        typename K::F f = K::sub(K::sub(E, K::mul(e, sinE)), M);
+        typename K::F df = K::sub(one, K::mul(e, cosE));
+        d = K::div(f, df);
+        sinCosPoly<K>(d, sd, cd);
+
+        // E - d
+        E = K::sub(E, d);
+        typename K::F s = K::sub(K::mul(sinE, cd), K::mul(cosE, sd));
+        cosE = K::add(K::mul(cosE, cd), K::mul(sinE, sd));
+        sinE = s;
+    }
+}
+
+// Keplerian orbit around the sun (belt) or around a per-asteroid centre
+// (clusters), evaluated directly at a tick: the mean anomaly is
+// phase0 + rate * tick, which wraps modulo a full turn for free. The orbit's
+// semi-axes and orientation are pre-multiplied into the two perifocal axes
+// (a * P, b * Q), so the position is focus + (cos E - e) * aP + sin E * bQ.
+template <class K, bool Centred>
+size_t evaluateOrbitsBatch(const OrbitArrays& o, uint32_t tick, float* x, float* y, float* z, size_t n) {
+    typename K::I vtick = K::iset1(tick);
+    size_t i = 0;
+    for (; i + K::Width <= n; i += K::Width) {
+        typename K::I phase = K::iadd(K::iload(o.phase0 + i), K::imul(K::iload(o.rate + i), vtick));
+        typename K::F e = K::load(o.eccentricity + i);
+
+        typename K::F s, c;
+        solveKepler<K>(phase, e, s, c);
+        typename K::F u = K::sub(c, e);
+
+        typename K::F px = K::add(K::mul(u, K::load(o.px + i)), K::mul(s, K::load(o.qx + i)));
+        typename K::F py = K::add(K::mul(u, K::load(o.py + i)), K::mul(s, K::load(o.qy + i)));
+        typename K::F pz = K::add(K::mul(u, K::load(o.pz + i)), K::mul(s, K::load(o.qz + i)));
+        py = K::add(K::load(o.baseY + i), py);
+        if (Centred) {
+            px = K::add(K::load(o.centerX + i), px);
+            pz = K::add(K::load(o.centerZ + i), pz);
+        }
+        K::store(x + i, px);
+        K::store(y + i, py);
+        K::store(z + i, pz);
+    }
+    return i;
+}
+
+// One entry per instruction set, filled in by the translation unit that owns it
+struct Table {
+    int width;
+    size_t (*evaluateBelt)(const OrbitArrays&, uint32_t, float*, float*, float*, size_t);
+    size_t (*evaluateClusters)(const OrbitArrays&, uint32_t, float*, float*, float*, size_t);
+};
+
+template <class K>
+Table makeTable() {
+    Table t;
+    t.width = K::Width;
+    t.evaluateBelt = &evaluateOrbitsBatch<K, false>;
+    t.evaluateClusters = &evaluateOrbitsBatch<K, true>;
+    return t;
+}
+
+// Defined in AsteroidFieldAVX2.cpp / AsteroidFieldAVX512.cpp (nullptr when not built for x86)
+const Table* avx2Table();
+const Table* avx512Table();
+
+} // namespace AsteroidKernels
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "EntityWorld.h"
+#include "SpatialGrid.h"
+#include "Components.h"
+
+// Gameplay queries on the home system's bodies, kept free of the game's
+// globals so the micro-benchmarks can run them on a world of their own.
+
+// Basic sphere-sphere collision test
+inline bool checkSphereCollision(
+    const glm::vec3& aPos, float aRadius,
+    const glm::vec3& bPos, float bRadius)
+{
+    return glm::length(aPos - bPos) < (aRadius + bRadius);
+}
+
+// The closest planet to pos that hasn't been scanned, or -1. grid holds the
+// bodies by their slot in gridEntities (see indexBodies in the main file).
+inline int nearestUnscannedPlanet(const EntityWorld& world, const SpatialGrid& grid,
+    const std::vector<Entity>& gridEntities, const glm::vec3& pos)
+{
+    uint32_t nearest = grid.nearest(pos, [&](uint32_t id) {
+        const Scannable* scannable = world.find<Scannable>(gridEntities[id]);
+        return scannable && !scannable->scanned;
+    });
+    if (nearest == SpatialGrid::NONE) return -1;
+    return world.find<Scannable>(gridEntities[nearest])->planet;
+}
@@ -4,9 +4,34 @@
 #include <GLFW/glfw3.h>
 #include <algorithm>
 
+// Movement keys held during a tick (from the window, or a recorded session)
+struct MoveKeys {
+    bool forward = false;
+    bool backward = false;
+    bool left = false;
+    bool right = false;
+    bool up = false;
+    bool down = false;
+    bool boost = false;
+
+    static MoveKeys sample(GLFWwindow* window) {
+        MoveKeys keys;
+        keys.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+        keys.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+        keys.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+        keys.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+        keys.up = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        keys.down = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
+        keys.boost = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+        return keys;
+    }
+};
+
 class Camera {
 public:
-    glm::vec3 Position;
+    // World position in double precision: far from the origin a float can't
+    // hold a small move (see camera-relative rendering in the main file)
+    glm::dvec3 Position;
     glm::vec3 Front;
     glm::vec3 Up;
     glm::vec3 Right;
@@ -21,25 +46,24 @@ public:
 
     glm::vec3 Velocity;
 
-    Camera(glm::vec3 startPos)
+    Camera(glm::dvec3 startPos)
         : Position(startPos), Front(0.0f, 0.0f, -1.0f), WorldUp(0.0f, 1.0f, 0.0f),
         Yaw(-90.0f), Pitch(0.0f), Speed(50.0f), BoostSpeed(120.0f),
         BoostAccel(40.0f), Sensitivity(0.1f), Velocity(0.0f) {
         updateCameraVectors();
     }
 
-    void ProcessKeyboard(GLFWwindow* window, float dt) {
+    void ProcessKeyboard(const MoveKeys& keys, float dt) {
         glm::vec3 dir(0.0f);
 
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) dir += Front;
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) dir -= Front;
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) dir -= Right;
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) dir += Right;
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) dir += WorldUp;
-        if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) dir -= WorldUp;
+        if (keys.forward) dir += Front;
+        if (keys.backward) dir -= Front;
+        if (keys.left) dir -= Right;
+        if (keys.right) dir += Right;
+        if (keys.up) dir += WorldUp;
+        if (keys.down) dir -= WorldUp;
 
-        float targetSpeed = (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-            ? BoostSpeed : Speed;
+        float targetSpeed = keys.boost ? BoostSpeed : Speed;
 
         glm::vec3 targetVel(0.0f);
         if (glm::length(dir) > 0.0f) {
@@ -54,7 +78,7 @@ public:
         }
 
         Velocity += diff;
-        Position += Velocity * dt;
+        Position += glm::dvec3(Velocity * dt);
     }
 
     void ProcessMouse(float xOffset, float yOffset) {
@@ -68,8 +92,17 @@ public:
         updateCameraVectors();
     }
 
+    // Looks the way a recorded session did (yaw and pitch in degrees)
+    void SetOrientation(float yaw, float pitch) {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
+    // Rotation only: the world is drawn relative to the camera, which sits
+    // at the origin of view space
     glm::mat4 GetViewMatrix() const {
-        return glm::lookAt(Position, Position + Front, Up);
+        return glm::lookAt(glm::vec3(0.0f), Front, Up);
     }
 
 private:
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "EntityWorld.h"
+#include "Orbits.h"
+
+// Components of the home system's bodies: planets, moons, probes and broken
+// probes all live in one EntityWorld. (The asteroids keep their own
+// structure-of-arrays field for the SIMD orbit kernels, see AsteroidField.)
+
+// Where the entity is as of the last tick
+struct Transform {
+    glm::vec3 position = glm::vec3(0.0f);
+    float spin = 0.0f;     // degrees about Y
+    float scale = 1.0f;
+};
+
+// Closed-form orbit around a parent entity's orbit, or around a fixed centre
+// when there's no parent. Circle orbits lie in the XZ plane at `height`.
+struct Orbit {
+    enum Shape : uint8_t { Circle, Kepler };
+
+    Shape shape = Circle;
+    Entity parent;
+    glm::vec3 centre = glm::vec3(0.0f);
+    float radius = 0.0f;          // semi-major axis for Kepler orbits
+    float speed = 0.0f;           // radians per second (mean motion)
+    float phase0 = 0.0f;          // phase (mean anomaly) at t = 0
+    float height = 0.0f;
+    float eccentricity = 0.0f;
+    float inclination = 0.0f;
+    float ascendingNode = 0.0f;
+    float periapsisArg = 0.0f;
+    float spin0 = 0.0f;           // degrees at t = 0
+    float spinSpeed = 0.0f;       // degrees per second
+};
+
+// Solid sphere the player collides with
+struct Collider {
+    float radius = 0.0f;
+};
+
+class TriangleBvh;
+
+// Model the player collides with triangle by triangle (probes). The mesh is
+// the model's own, shared by its instances, and placed by the Transform's
+// position and scale; radius bounds it in the world, for the broad phase.
+struct MeshCollider {
+    const TriangleBvh* mesh = nullptr;
+    float radius = 0.0f;
+};
+
+enum class RenderModel : uint8_t { Planet, Moon, Probe, BrokenProbe };
+
+struct Renderable {
+    RenderModel model = RenderModel::Planet;
+    int index = -1;               // the planet (g_planets) for RenderModel::Planet
+};
+
+// A planet the player can survey
+struct Scannable {
+    int planet = -1;
+    bool scanned = false;
+};
+
+// Blocks scanning of any planet within range
+struct Jammer {
+    float range = 0.0f;
+};
+
+// Flies itself as part of the probe flock (see Flock.h) instead of following
+// an orbit: patrols round its goal, `gap` outside the goal's collider, and is
+// carried along with the goal as it orbits
+struct Boid {
+    glm::vec3 velocity = glm::vec3(0.0f);
+    Entity home;                  // the planet it patrols
+    Entity goal;                  // home, or the planet it's converging on
+    glm::vec3 anchor = glm::vec3(0.0f);   // the goal's position as of the last tick
+    float gap = 0.0f;
+    float height = 0.0f;          // above the goal's centre
+    float turn = 1.0f;            // which way round (Flock::Goal::turn)
+    uint32_t steered = 0;         // SimLod tick it was last steered on
+};
+
+namespace Orbits {
+
+// Relative to the orbit's centre at time t
+inline glm::vec3 offset(const Orbit& orbit, double t) {
+    float phase = phaseAt(orbit.phase0, orbit.speed, t);
+    if (orbit.shape == Orbit::Kepler) {
+        return keplerOffset(orbit.radius, orbit.eccentricity, orbit.inclination, orbit.ascendingNode,
+            orbit.periapsisArg, phase) + glm::vec3(0.0f, orbit.height, 0.0f);
+    }
+    return circle(phase, orbit.radius, orbit.height);
+}
+
+// World position at time t. The parent is evaluated at the same time, so the
+// whole hierarchy stays closed-form and any entity can be evaluated on its own.
+inline glm::vec3 position(const EntityWorld& world, const Orbit& orbit, double t) {
+    glm::vec3 centre = orbit.centre;
+    if (const Orbit* parent = world.find<Orbit>(orbit.parent)) centre = position(world, *parent, t);
+    return centre + offset(orbit, t);
+}
+
+// Spin about Y at time t, in degrees
+inline float spin(const Orbit& orbit, double t) {
+    return phaseAt(orbit.spin0, orbit.spinSpeed, t, 360.0);
+}
+
+// A generated planet's orbit around the given centre (same path as planetOffset)
+inline Orbit planetOrbit(const Planet& planet, const glm::vec3& centre) {
+    Orbit orbit;
+    orbit.shape = Orbit::Kepler;
+    orbit.centre = centre;
+    orbit.radius = planet.distance;
+    orbit.speed = planet.speed;
+    orbit.phase0 = planet.angle;
+    orbit.height = planet.height;
+    orbit.eccentricity = planet.eccentricity;
+    orbit.inclination = planet.inclination;
+    orbit.ascendingNode = planet.ascendingNode;
+    orbit.periapsisArg = planet.periapsisArg;
+    orbit.spin0 = planet.rotationAngle;
+    orbit.spinSpeed = planet.rotationSpeed;
+    return orbit;
+}
+
+// Circle around another entity (moons, probes)
+inline Orbit circleOrbit(Entity parent, float radius, float speed, float phase0, float height) {
+    Orbit orbit;
+    orbit.parent = parent;
+    orbit.radius = radius;
+    orbit.speed = speed;
+    orbit.phase0 = phase0;
+    orbit.height = height;
+    return orbit;
+}
+
+} // namespace Orbits
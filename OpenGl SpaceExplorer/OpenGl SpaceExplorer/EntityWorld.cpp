@@ -0,0 +1,258 @@
+#include "EntityWorld.h"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+// Registered component types (ids index this; entries are never changed once added)
+ComponentInfo g_componentInfos[ComponentRegistry::MAX_COMPONENTS];
+std::atomic<int> g_componentCount{ 0 };
+std::mutex g_componentLock;
+
+size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+} // namespace
+
+int ComponentRegistry::add(const ComponentInfo& info) {
+    std::lock_guard<std::mutex> lock(g_componentLock);
+    int id = g_componentCount.load();
+    if (id >= MAX_COMPONENTS) throw std::runtime_error("Too many component types");
+    if (info.align > Archetype::COLUMN_ALIGN) throw std::runtime_error("Component alignment too large");
+    g_componentInfos[id] = info;
+    g_componentCount.store(id + 1);
+    return id;
+}
+
+const ComponentInfo& ComponentRegistry::info(int id) {
+    return g_componentInfos[id];
+}
+
+Archetype::Archetype(ComponentMask mask) : bits(mask) {
+    for (int id = 0; id < ComponentRegistry::MAX_COMPONENTS; ++id) {
+        offsets[id] = 0;
+        if (mask & (ComponentMask(1) << id)) ids.push_back(id);
+    }
+
+    // As many rows as fit once every column is padded out to a cache line
+    size_t rowBytes = sizeof(Entity);
+    for (int id : ids) rowBytes += ComponentRegistry::info(id).size;
+    size_t padding = COLUMN_ALIGN * (ids.size() + 1);
+    capacity = std::max<size_t>(1, (CHUNK_BYTES - padding) / rowBytes);
+
+    // Entity column first, then one column per component
+    size_t offset = alignUp(sizeof(Entity) * capacity, COLUMN_ALIGN);
+    for (int id : ids) {
+        offsets[id] = offset;
+        offset = alignUp(offset + ComponentRegistry::info(id).size * capacity, COLUMN_ALIGN);
+    }
+    chunkBytes = offset;
+}
+
+void* Archetype::component(int id, size_t row) {
+    Chunk& chunk = chunks[row / capacity];
+    return chunk.data + offsets[id] + ComponentRegistry::info(id).size * (row % capacity);
+}
+
+Entity Archetype::entity(size_t row) {
+    return entities(row / capacity)[row % capacity];
+}
+
+size_t Archetype::pushRow(Entity entity) {
+    size_t row = count;
+    if (row / capacity >= chunks.size()) {
+        // Chunks are kept once allocated, so a shrinking archetype can grow again for free
+        Chunk chunk;
+        chunk.storage.reset(new unsigned char[chunkBytes + COLUMN_ALIGN]);
+        uintptr_t base = reinterpret_cast<uintptr_t>(chunk.storage.get());
+        chunk.data = chunk.storage.get() + (alignUp(base, COLUMN_ALIGN) - base);
+        chunks.push_back(std::move(chunk));
+    }
+    entities(row / capacity)[row % capacity] = entity;
+    ++count;
+    return row;
+}
+
+Entity Archetype::removeRow(size_t row) {
+    size_t last = count - 1;
+    Entity moved;
+    if (row != last) {
+        for (int id : ids) {
+            ComponentRegistry::info(id).copy(component(id, row), component(id, last));
+        }
+        moved = entity(last);
+        entities(row / capacity)[row % capacity] = moved;
+    }
+    --count;
+    return moved;
+}
+
+Entity EntityWorld::allocate() {
+    Entity entity;
+    if (!freeIndices.empty()) {
+        entity.index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else {
+        entity.index = (uint32_t)records.size();
+        records.push_back(Record());
+    }
+    entity.generation = records[entity.index].generation;
+    return entity;
+}
+
+Archetype& EntityWorld::archetypeFor(ComponentMask mask) {
+    for (auto& archetype : archetypes) {
+        if (archetype->mask() == mask) return *archetype;
+    }
+    archetypes.push_back(std::make_unique<Archetype>(mask));
+    return *archetypes.back();
+}
+
+bool EntityWorld::alive(Entity entity) const {
+    return entity.index < records.size() && records[entity.index].archetype &&
+        records[entity.index].generation == entity.generation;
+}
+
+EntityWorld::Record& EntityWorld::recordOf(Entity entity) {
+    if (!alive(entity)) throw std::runtime_error("Entity is not alive");
+    return records[entity.index];
+}
+
+void* EntityWorld::findComponent(Entity entity, int id) {
+    if (!alive(entity)) return nullptr;
+    Record& record = records[entity.index];
+    if (!(record.archetype->mask() & (ComponentMask(1) << id))) return nullptr;
+    return record.archetype->component(id, record.row);
+}
+
+void EntityWorld::move(Entity entity, ComponentMask mask) {
+    Record& record = recordOf(entity);
+    Archetype& from = *record.archetype;
+    Archetype& to = archetypeFor(mask);
+
+    size_t row = to.pushRow(entity);
+    ComponentMask shared = from.mask() & to.mask();
+    for (int id = 0; id < ComponentRegistry::MAX_COMPONENTS; ++id) {
+        if (shared & (ComponentMask(1) << id)) {
+            ComponentRegistry::info(id).copy(to.component(id, row), from.component(id, record.row));
+        }
+    }
+
+    Entity moved = from.removeRow(record.row);
+    if (moved.valid()) records[moved.index].row = record.row;
+
+    record.archetype = &to;
+    record.row = row;
+}
+
+void EntityWorld::destroy(Entity entity) {
+    if (!alive(entity)) return;
+    Record& record = records[entity.index];
+
+    Entity moved = record.archetype->removeRow(record.row);
+    if (moved.valid()) records[moved.index].row = record.row;
+
+    record.archetype = nullptr;
+    ++record.generation;
+    freeIndices.push_back(entity.index);
+    --living;
+}
+
+void EntityWorld::clear() {
+    archetypes.clear();
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        if (records[i].archetype) {
+            records[i].archetype = nullptr;
+            ++records[i].generation;
+            freeIndices.push_back(i);
+        }
+    }
+    living = 0;
+}
+
+namespace {
+
+struct TestPosition { float x, y, z; };
+struct TestVelocity { float x, y, z; };
+struct TestTag { int value; };
+
+} // namespace
+
+bool EntityWorld::selfTest(unsigned int threads) {
+    JobSystem jobs(threads);
+    EntityWorld world;
+    bool ok = true;
+
+    // Three archetypes sharing TestPosition, enough entities for several chunks each
+    const int count = 30000;
+    std::vector<Entity> entities;
+    for (int i = 0; i < count; ++i) {
+        TestPosition p{ (float)i, 0.0f, 0.0f };
+        if (i % 3 == 0) entities.push_back(world.create(p));
+        else if (i % 3 == 1) entities.push_back(world.create(p, TestVelocity{ 1.0f, 0.0f, 0.0f }));
+        else entities.push_back(world.create(p, TestVelocity{ 2.0f, 0.0f, 0.0f }, TestTag{ i }));
+    }
+
+    bool counted = world.size() == (size_t)count && world.count<TestPosition>() == (size_t)count &&
+        world.count<TestVelocity>() == (size_t)(count - count / 3) && world.archetypeCount() == 3;
+    std::cout << "ECS selftest: create and count " << (counted ? "OK" : "FAILED") << std::endl;
+    ok = ok && counted;
+
+    // Columns start on cache lines
+    bool aligned = true;
+    for (auto& archetype : world.archetypes) {
+        for (size_t c = 0; c < archetype->chunkCount(); ++c) {
+            aligned = aligned && reinterpret_cast<uintptr_t>(archetype->entities(c)) % Archetype::COLUMN_ALIGN == 0;
+            if (archetype->mask() & (ComponentMask(1) << ComponentRegistry::id<TestVelocity>())) {
+                aligned = aligned && reinterpret_cast<uintptr_t>(archetype->column<TestVelocity>(c)) % Archetype::COLUMN_ALIGN == 0;
+            }
+        }
+    }
+    std::cout << "ECS selftest: column alignment " << (aligned ? "OK" : "FAILED") << std::endl;
+    ok = ok && aligned;
+
+    // A parallel system over two archetypes, then a serial check of every entity
+    world.parallelEach<TestPosition, const TestVelocity>(jobs, [](Entity, TestPosition& p, const TestVelocity& v) {
+        p.x += v.x;
+    });
+    bool moved = true;
+    for (int i = 0; i < count; ++i) {
+        float expected = (float)i + (i % 3 == 0 ? 0.0f : (float)(i % 3));
+        moved = moved && world.get<TestPosition>(entities[i]).x == expected;
+    }
+    std::cout << "ECS selftest: parallel query " << (moved ? "OK" : "FAILED") << std::endl;
+    ok = ok && moved;
+
+    // Destroy every other entity, then move some between archetypes
+    for (int i = 0; i < count; i += 2) world.destroy(entities[i]);
+    for (int i = 1; i < count; i += 6) world.add(entities[i], TestTag{ -i });
+    for (int i = 5; i < count; i += 6) world.remove<TestVelocity>(entities[i]);
+
+    bool intact = world.size() == (size_t)(count / 2);
+    for (int i = 0; i < count && intact; ++i) {
+        if (i % 2 == 0) {
+            intact = !world.alive(entities[i]) && world.find<TestPosition>(entities[i]) == nullptr;
+            continue;
+        }
+        float expected = (float)i + (float)(i % 3);
+        int expectedTag = i % 6 == 1 ? -i : (i % 3 == 2 ? i : 0);
+        const TestTag* tag = world.find<TestTag>(entities[i]);
+        intact = world.get<TestPosition>(entities[i]).x == expected &&
+            world.has<TestVelocity>(entities[i]) == (i % 3 != 0 && i % 6 != 5) &&
+            (expectedTag == 0 ? tag == nullptr : tag && tag->value == expectedTag);
+    }
+
+    // Reused indices get a new generation, so old handles stay dead
+    Entity reused = world.create(TestPosition{ 0.0f, 0.0f, 0.0f });
+    intact = intact && reused.index == entities[count - 2].index && !world.alive(entities[count - 2]);
+    std::cout << "ECS selftest: destroy, add, remove and stale handles " << (intact ? "OK" : "FAILED") << std::endl;
+    ok = ok && intact;
+
+    std::cout << "ECS selftest: " << world.archetypeCount() << " archetypes, "
+        << jobs.threadCount() << " threads" << std::endl;
+    return ok;
+}
@@ -0,0 +1,273 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#include "JobSystem.h"
+
+// Handle to an entity. The generation changes whenever an index is reused, so
+// a handle to a destroyed entity never refers to a newer one.
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != UINT32_MAX; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+typedef uint64_t ComponentMask;
+
+// Components are plain data structs. Each type gets a small id (its bit in a
+// ComponentMask) the first time it's used.
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+    void (*copy)(void* dst, const void* src);
+};
+
+class ComponentRegistry {
+public:
+    static const int MAX_COMPONENTS = 64;
+
+    template <typename T>
+    static int id() {
+        // Rows are moved by copying and then simply overwritten
+        static_assert(std::is_trivially_destructible<T>::value, "components must be plain data");
+        static const int value = add(ComponentInfo{ sizeof(T), alignof(T), &copyAs<T> });
+        return value;
+    }
+
+    static const ComponentInfo& info(int id);
+
+private:
+    template <typename T>
+    static void copyAs(void* dst, const void* src) {
+        new (dst) T(*static_cast<const T*>(src));
+    }
+
+    static int add(const ComponentInfo& info);
+};
+
+// Every entity with exactly the same set of components. The components are
+// stored column by column in fixed-size chunks: each column starts on its own
+// cache line and a chunk holds as many entities as fit, so a query streams
+// through only the columns it asks for. Entities stay packed (removing one
+// moves the last into its place), so every chunk but the last is full.
+class Archetype {
+public:
+    static const size_t CHUNK_BYTES = 16 * 1024;
+    static const size_t COLUMN_ALIGN = 64;
+
+    explicit Archetype(ComponentMask mask);
+
+    ComponentMask mask() const { return bits; }
+    size_t size() const { return count; }
+    size_t chunkCapacity() const { return capacity; }
+    size_t chunkCount() const { return (count + capacity - 1) / capacity; }
+    size_t chunkSize(size_t chunk) const { return std::min(capacity, count - chunk * capacity); }
+
+    Entity* entities(size_t chunk) { return reinterpret_cast<Entity*>(chunks[chunk].data); }
+
+    template <typename T>
+    T* column(size_t chunk) {
+        int id = ComponentRegistry::id<typename std::remove_const<T>::type>();
+        return reinterpret_cast<T*>(chunks[chunk].data + offsets[id]);
+    }
+
+    void* component(int id, size_t row);
+    Entity entity(size_t row);
+
+    // Appends a row for the entity (its components still to be written)
+    size_t pushRow(Entity entity);
+
+    // Removes a row by moving the last one into it. Returns the entity that
+    // moved (invalid if the removed row was the last).
+    Entity removeRow(size_t row);
+
+private:
+    struct Chunk {
+        std::unique_ptr<unsigned char[]> storage;
+        unsigned char* data;   // storage rounded up to COLUMN_ALIGN
+    };
+
+    ComponentMask bits;
+    std::vector<int> ids;
+    size_t offsets[ComponentRegistry::MAX_COMPONENTS];   // column start in a chunk, by component id
+    size_t capacity = 0;
+    size_t chunkBytes = 0;
+    size_t count = 0;
+    std::vector<Chunk> chunks;
+};
+
+// Archetype-based entity/component storage.
+//
+// Entities are created with any set of components and can gain or lose
+// components later (which moves them to another archetype). Systems are
+// queries: each<A, B>(fn) calls fn(entity, a, b) for every entity that has at
+// least A and B, chunk by chunk, whatever else it has. Ask for `const A` where
+// a system only reads. parallelEach() spreads the chunks over the job system.
+//
+// Entities can't be created, destroyed or change components while a query is
+// running; collect them and do it afterwards.
+class EntityWorld {
+public:
+    template <typename... Cs>
+    Entity create(const Cs&... components) {
+        Archetype& archetype = archetypeFor(maskOf<Cs...>());
+        Entity entity = allocate();
+        size_t row = archetype.pushRow(entity);
+        int construct[] = { 0, (new (archetype.component(ComponentRegistry::id<Cs>(), row)) Cs(components), 0)... };
+        (void)construct;
+        records[entity.index].archetype = &archetype;
+        records[entity.index].row = row;
+        ++living;
+        return entity;
+    }
+
+    void destroy(Entity entity);
+    bool alive(Entity entity) const;
+    void clear();
+
+    // Live entities
+    size_t size() const { return living; }
+    size_t archetypeCount() const { return archetypes.size(); }
+
+    // The entity's component, or nullptr if it has none (or is dead)
+    template <typename T>
+    T* find(Entity entity) {
+        return static_cast<T*>(findComponent(entity, ComponentRegistry::id<T>()));
+    }
+
+    template <typename T>
+    const T* find(Entity entity) const {
+        return static_cast<const T*>(const_cast<EntityWorld*>(this)->findComponent(entity, ComponentRegistry::id<T>()));
+    }
+
+    template <typename T>
+    T& get(Entity entity) {
+        T* component = find<T>(entity);
+        if (!component) throw std::runtime_error("Entity has no such component");
+        return *component;
+    }
+
+    template <typename T>
+    const T& get(Entity entity) const {
+        const T* component = find<T>(entity);
+        if (!component) throw std::runtime_error("Entity has no such component");
+        return *component;
+    }
+
+    template <typename T>
+    bool has(Entity entity) const { return find<T>(entity) != nullptr; }
+
+    // Adds (or overwrites) a component
+    template <typename T>
+    void add(Entity entity, const T& value) {
+        if (T* existing = find<T>(entity)) {
+            *existing = value;
+            return;
+        }
+        int id = ComponentRegistry::id<T>();
+        move(entity, recordOf(entity).archetype->mask() | (ComponentMask(1) << id));
+        const Record& record = records[entity.index];
+        new (record.archetype->component(id, record.row)) T(value);
+    }
+
+    template <typename T>
+    void remove(Entity entity) {
+        if (!has<T>(entity)) return;
+        move(entity, recordOf(entity).archetype->mask() & ~(ComponentMask(1) << ComponentRegistry::id<T>()));
+    }
+
+    // fn(Entity, Cs&...) for every entity with all of Cs
+    template <typename... Cs, typename Fn>
+    void each(Fn fn) {
+        ComponentMask required = maskOf<typename std::remove_const<Cs>::type...>();
+        for (auto& archetype : archetypes) {
+            if ((archetype->mask() & required) != required) continue;
+            for (size_t c = 0; c < archetype->chunkCount(); ++c) {
+                runChunk<Cs...>(*archetype, c, fn);
+            }
+        }
+    }
+
+    // Same, with the chunks spread over the job system (fn runs concurrently
+    // on different entities). Returns once every entity has been visited.
+    template <typename... Cs, typename Fn>
+    void parallelEach(JobSystem& jobs, Fn fn) {
+        ComponentMask required = maskOf<typename std::remove_const<Cs>::type...>();
+        std::vector<std::pair<Archetype*, size_t>> work;
+        for (auto& archetype : archetypes) {
+            if ((archetype->mask() & required) != required) continue;
+            for (size_t c = 0; c < archetype->chunkCount(); ++c) work.push_back(std::make_pair(archetype.get(), c));
+        }
+
+        JobCounter counter;
+        jobs.parallelFor(work.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) runChunk<Cs...>(*work[k].first, work[k].second, fn);
+        }, counter);
+        jobs.wait(counter);
+    }
+
+    // Entities with all of Cs
+    template <typename... Cs>
+    size_t count() const {
+        ComponentMask required = maskOf<typename std::remove_const<Cs>::type...>();
+        size_t total = 0;
+        for (const auto& archetype : archetypes) {
+            if ((archetype->mask() & required) == required) total += archetype->size();
+        }
+        return total;
+    }
+
+    // Checks creation, queries, component moves, stale handles and column
+    // alignment (--ecs-selftest). Returns false on any failure.
+    static bool selfTest(unsigned int threads);
+
+private:
+    struct Record {
+        Archetype* archetype = nullptr;
+        size_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    template <typename... Cs>
+    static ComponentMask maskOf() {
+        ComponentMask mask = 0;
+        int bits[] = { 0, ComponentRegistry::id<Cs>()... };
+        for (size_t i = 1; i < sizeof(bits) / sizeof(bits[0]); ++i) {
+            ComponentMask bit = ComponentMask(1) << bits[i];
+            if (mask & bit) throw std::runtime_error("Component listed twice");
+            mask |= bit;
+        }
+        return mask;
+    }
+
+    template <typename... Cs, typename Fn>
+    static void runChunk(Archetype& archetype, size_t chunk, Fn& fn) {
+        runRows<Cs...>(archetype.entities(chunk), archetype.chunkSize(chunk), fn, archetype.column<Cs>(chunk)...);
+    }
+
+    template <typename... Cs, typename Fn>
+    static void runRows(const Entity* entities, size_t n, Fn& fn, Cs*... columns) {
+        for (size_t i = 0; i < n; ++i) fn(entities[i], columns[i]...);
+    }
+
+    Entity allocate();
+    Archetype& archetypeFor(ComponentMask mask);
+    Record& recordOf(Entity entity);
+    void* findComponent(Entity entity, int id);
+    void move(Entity entity, ComponentMask mask);
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::vector<Record> records;
+    std::vector<uint32_t> freeIndices;
+    size_t living = 0;
+};
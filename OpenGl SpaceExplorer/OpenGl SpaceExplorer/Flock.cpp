@@ -0,0 +1,347 @@
+#include "Flock.h"
+#include "AsteroidField.h"
+#include "JobSystem.h"
+#include "Parallel.h"
+#include "PlanetGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+constexpr float Flock::NEIGHBOUR_RADIUS;
+constexpr float Flock::SEPARATION_RADIUS;
+constexpr float Flock::CRUISE_SPEED;
+constexpr float Flock::MAX_SPEED;
+constexpr float Flock::MAX_ACCELERATION;
+constexpr float Flock::LOOKAHEAD;
+
+namespace {
+
+const float SEPARATION_WEIGHT = 60.0f;
+const float ALIGNMENT_WEIGHT = 1.0f;
+const float COHESION_WEIGHT = 0.2f;
+const float GOAL_GAIN = 0.5f;          // speed per unit off the patrol circle
+const float GOAL_RESPONSE = 2.0f;      // how hard velocity is pulled to the patrol's
+const float AVOID_WEIGHT = 80.0f;
+const float AVOID_MARGIN = 4.0f;       // obstacles are felt this far out even when still
+const float LARGE_OBSTACLE = 12.0f;    // radius past which obstacles go in the coarse grid
+const float SKIN = 1.0e-3f;            // how far outside an obstacle a pushed agent is left
+
+// fn(begin, end) over [0, count), spread over the job system if there is one
+template <typename Fn>
+void forRanges(JobSystem* jobs, size_t count, size_t minBatch, Fn fn) {
+    if (count == 0) return;
+    if (!jobs) {
+        fn(0, count);
+        return;
+    }
+    JobCounter counter;
+    jobs->parallelFor(count, minBatch, fn, counter);
+    jobs->wait(counter);
+}
+
+glm::vec3 clampLength(const glm::vec3& v, float limit) {
+    float length = glm::length(v);
+    return length > limit ? v * (limit / length) : v;
+}
+
+// Distance from p to the goal's circle
+float offCircle(const glm::vec3& p, const Flock::Goal& goal) {
+    glm::vec3 offset = p - goal.centre;
+    float r = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+    return std::sqrt((r - goal.radius) * (r - goal.radius) + offset.y * offset.y);
+}
+
+} // namespace
+
+void Flock::resize(size_t count) {
+    positions.resize(count);
+    velocities.resize(count);
+    nextVelocities.resize(count);
+    ticks.resize(count, 1);
+    goals.resize(count);
+}
+
+float Flock::obstacleReach(float stepSeconds) {
+    return AVOID_MARGIN + MAX_SPEED * (LOOKAHEAD + stepSeconds);
+}
+
+void Flock::setAgent(size_t i, const glm::vec3& position, const glm::vec3& velocity, const Goal& goal) {
+    positions[i] = position;
+    velocities[i] = velocity;
+    goals[i] = goal;
+    ticks[i] = 1;
+}
+
+template <typename Fn>
+void Flock::forEachObstacle(const glm::vec3& p, float range, Fn fn) const {
+    auto visit = [&](uint32_t id, float distance) { fn(obstacles[id], distance); };
+    smallObstacles.forEachOverlap(p, range, visit);
+    largeObstacles.forEachOverlap(p, range, visit);
+}
+
+template <typename Neighbours>
+glm::vec3 Flock::steer(size_t i, Neighbours neighbours) const {
+    const glm::vec3 p = positions[i];
+    const glm::vec3 v = velocities[i];
+
+    // Separation falls off linearly to nothing at SEPARATION_RADIUS
+    glm::vec3 separation(0.0f), heading(0.0f), centre(0.0f);
+    int count = 0;
+    neighbours(p, [&](uint32_t j, float distance) {
+        if (j == i) return;
+        const glm::vec3& q = positions[j];
+        if (distance < SEPARATION_RADIUS && distance > 0.0f) {
+            separation += (p - q) * ((SEPARATION_RADIUS - distance) / (SEPARATION_RADIUS * distance));
+        }
+        heading += velocities[j];
+        centre += q;
+        ++count;
+    });
+    glm::vec3 acceleration = separation * SEPARATION_WEIGHT;
+    if (count > 0) {
+        acceleration += (heading / (float)count - v) * ALIGNMENT_WEIGHT;
+        acceleration += (centre / (float)count - p) * COHESION_WEIGHT;
+    }
+
+    // Patrol: round the circle, pulled back onto it (from any distance, so a
+    // far goal is simply flown to at full speed)
+    const Goal& goal = goals[i];
+    glm::vec3 offset = p - goal.centre;
+    glm::vec3 flat(offset.x, 0.0f, offset.z);
+    float r = glm::length(flat);
+    glm::vec3 out = r > 1.0e-4f ? flat / r : glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 along = glm::vec3(out.z, 0.0f, -out.x) * goal.turn;
+    glm::vec3 desired = along * CRUISE_SPEED + out * ((goal.radius - r) * GOAL_GAIN)
+        - glm::vec3(0.0f, offset.y * GOAL_GAIN, 0.0f);
+    acceleration += (clampLength(desired, MAX_SPEED) - v) * GOAL_RESPONSE;
+
+    // Obstacles push harder the closer they are, and are felt further out
+    // the faster the agent flies
+    float reach = AVOID_MARGIN + glm::length(v) * LOOKAHEAD;
+    forEachObstacle(p, reach, [&](const Sweep::Obstacle& obstacle, float distance) {
+        glm::vec3 away = distance > 0.0f ? (p - obstacle.center) / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+        float gap = std::max(distance - obstacle.radius, 0.0f);
+        acceleration += away * (AVOID_WEIGHT * (1.0f - gap / reach));
+    });
+
+    return clampLength(acceleration, MAX_ACCELERATION);
+}
+
+void Flock::pushOut(size_t i) {
+    // Straight out of one obstacle can be into another where they overlap,
+    // so the agent leaves along one ray, away from all it is in (for just
+    // one, onto the nearest point of its surface). A ray leaves a sphere
+    // once and for good, so stepping along it past every sphere it is still
+    // in ends clear of them all within a pass per obstacle.
+    glm::vec3& p = positions[i];
+    glm::vec3 out(0.0f);
+    bool inside = false;
+    forEachObstacle(p, 0.0f, [&](const Sweep::Obstacle& obstacle, float distance) {
+        glm::vec3 away = distance > 0.0f ? (p - obstacle.center) / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+        out += away * (obstacle.radius - distance);
+        inside = true;
+    });
+    if (!inside) return;
+    float length = glm::length(out);
+    out = length > 1.0e-6f ? out / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    for (size_t pass = 0; pass < obstacles.size(); ++pass) {
+        float exit = 0.0f;
+        forEachObstacle(p, 0.0f, [&](const Sweep::Obstacle& obstacle, float) {
+            glm::vec3 offset = p - obstacle.center;
+            float b = glm::dot(offset, out);
+            float c = glm::dot(offset, offset) - obstacle.radius * obstacle.radius;
+            exit = std::max(exit, std::sqrt(std::max(b * b - c, 0.0f)) - b);
+        });
+        if (exit <= 0.0f) break;
+        p += out * (exit + SKIN);
+    }
+    velocities[i] -= out * std::min(glm::dot(velocities[i], out), 0.0f);
+}
+
+void Flock::step(float dt, JobSystem* jobs) {
+    size_t n = size();
+
+    agentGrid.resize(n);
+    forRanges(jobs, n, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) agentGrid.set(i, (uint32_t)i, positions[i], 0.0f);
+    });
+    agentGrid.build();
+
+    smallObstacles.clear();
+    largeObstacles.clear();
+    for (size_t k = 0; k < obstacles.size(); ++k) {
+        SpatialGrid& grid = obstacles[k].radius > LARGE_OBSTACLE ? largeObstacles : smallObstacles;
+        grid.insert((uint32_t)k, obstacles[k].center, obstacles[k].radius);
+    }
+    smallObstacles.build();
+    largeObstacles.build();
+
+    // Steering only reads the start-of-step state...
+    auto hashed = [this](const glm::vec3& p, auto fn) { agentGrid.forEachInRadius(p, NEIGHBOUR_RADIUS, fn); };
+    forRanges(jobs, n, 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            nextVelocities[i] = ticks[i] == 0 ? velocities[i]
+                : clampLength(velocities[i] + steer(i, hashed) * (dt * ticks[i]), MAX_SPEED);
+        }
+    });
+
+    // ...so the moves wait until every agent has been steered
+    forRanges(jobs, n, 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            velocities[i] = nextVelocities[i];
+            positions[i] += velocities[i] * (dt * ticks[i]);
+            pushOut(i);
+        }
+    });
+}
+
+bool Flock::benchmark(size_t count, uint64_t seed) {
+    const float dt = 1.0f / 60.0f;
+    const float CLEARANCE = 3.0f;
+    EntityRng rng(seed, STREAM_SYSTEM, 44);
+
+    // Patrol circles spread out like the planets (each round a planet-sized
+    // obstacle), about a hundred agents to a circle, in an asteroid belt
+    Flock flock;
+    size_t goalCount = std::max<size_t>(4, count / 100);
+    std::vector<Goal> goalList;
+    for (size_t g = 0; g < goalCount; ++g) {
+        float angle = rng.uniform(0.0f, 6.28318531f);
+        float distance = rng.uniform(100.0f, 1500.0f);
+        float planet = rng.uniform(8.0f, 30.0f);
+        glm::vec3 centre(std::cos(angle) * distance, rng.uniform(-5.0f, 5.0f), std::sin(angle) * distance);
+        goalList.push_back(Goal{ centre, planet + rng.uniform(8.0f, 18.0f), rng.below(2) == 0 ? 1.0f : -1.0f });
+        flock.addObstacle(Sweep::Obstacle{ centre, planet + CLEARANCE });
+    }
+    std::vector<Asteroid> source;
+    PlanetGenerator::generateAsteroids(source, seed, 2000);
+    AsteroidField field;
+    field.build(source, dt);
+    for (size_t i = 0; i < field.size(); ++i) {
+        flock.addObstacle(Sweep::Obstacle{ field.position(i), field.collisionRadius(i) + CLEARANCE });
+    }
+
+    flock.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Goal& goal = goalList[i % goalCount];
+        float angle = rng.uniform(0.0f, 6.28318531f);
+        glm::vec3 out(std::cos(angle), 0.0f, std::sin(angle));
+        glm::vec3 p = goal.centre + out * goal.radius + glm::vec3(0.0f, rng.uniform(-2.0f, 2.0f), 0.0f);
+        flock.setAgent(i, p, glm::vec3(out.z, 0.0f, -out.x) * (goal.turn * CRUISE_SPEED), goal);
+    }
+
+    unsigned int maxThreads = std::max(1u, parallelThreadCount());
+    JobSystem setupJobs(maxThreads);
+    auto inside = [&]() {
+        int agents = 0;
+        for (size_t i = 0; i < flock.size(); ++i) {
+            bool hit = false;
+            flock.forEachObstacle(flock.positions[i], 0.0f, [&](const Sweep::Obstacle& obstacle, float distance) {
+                hit = hit || distance < obstacle.radius - 1.0e-3f;
+            });
+            if (hit) ++agents;
+        }
+        return agents;
+    };
+
+    // Settle into formation first
+    for (int s = 0; s < 120; ++s) flock.step(dt, &setupJobs);
+    int penetrations = inside();
+
+    // Hashed neighbours against every agent, on the same state
+    auto hashed = [&](const glm::vec3& p, auto fn) { flock.agentGrid.forEachInRadius(p, NEIGHBOUR_RADIUS, fn); };
+    auto everyAgent = [&](const glm::vec3& p, auto fn) {
+        for (size_t j = 0; j < flock.size(); ++j) {
+            float distance = glm::length(p - flock.positions[j]);
+            if (!(distance > NEIGHBOUR_RADIUS)) fn((uint32_t)j, distance);
+        }
+    };
+    flock.agentGrid.resize(count);
+    for (size_t i = 0; i < count; ++i) flock.agentGrid.set(i, (uint32_t)i, flock.positions[i], 0.0f);
+    flock.agentGrid.build();
+    int mismatches = 0;
+    for (size_t i = 0; i < count; i += std::max<size_t>(1, count / 256)) {
+        glm::vec3 a = flock.steer(i, hashed), b = flock.steer(i, everyAgent);
+        if (glm::length(a - b) > 1.0e-3f * (1.0f + glm::length(b))) ++mismatches;
+    }
+    auto start = std::chrono::steady_clock::now();
+    glm::vec3 sink(0.0f);
+    for (size_t i = 0; i < count; ++i) sink += flock.steer(i, everyAgent);
+    double scanUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    double neighbours = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        flock.agentGrid.forEachInRadius(flock.positions[i], NEIGHBOUR_RADIUS, [&](uint32_t, float) { neighbours += 1.0; });
+    }
+    std::cout << "Flock bench: " << count << " agents, " << goalCount << " patrols, " << flock.obstacles.size()
+        << " obstacles, " << neighbours / count - 1.0 << " neighbours each, " << mismatches
+        << " hashed/every-agent mismatches, " << penetrations << " inside obstacles" << std::endl;
+    std::cout << "Flock bench: steering against every agent " << scanUs / 1000.0 << " ms (1 thread"
+        << (std::isfinite(sink.x) ? "" : ", non-finite") << ")" << std::endl;
+
+    // Cost per tick at each thread count
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    double singleUs = 0.0;
+    for (unsigned int threads : threadCounts) {
+        JobSystem jobs(threads);
+        Flock run = flock;
+        for (int s = 0; s < 10; ++s) run.step(dt, &jobs);
+
+        const int steps = 120;
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s) run.step(dt, &jobs);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / steps;
+        if (threads == 1) singleUs = us;
+        std::cout << "Flock bench: " << threads << " threads, " << us << " us/tick, "
+            << singleUs / us << "x 1 thread" << std::endl;
+    }
+
+    // The agents of the three patrols nearest the first converge on it, as
+    // probes do on the planet the player is scanning. How many of them fly
+    // within reach of its circle depends on what else is on it (the belt's
+    // asteroids push them off as they go round), so they are measured against
+    // the same swarm started on the circle and flown as long.
+    const Goal& target = goalList[0];
+    std::vector<size_t> byDistance;
+    for (size_t g = 1; g < goalCount; ++g) byDistance.push_back(g);
+    std::sort(byDistance.begin(), byDistance.end(), [&](size_t a, size_t b) {
+        return glm::length(goalList[a].centre - target.centre) < glm::length(goalList[b].centre - target.centre);
+    });
+    byDistance.resize(3);
+    float furthest = glm::length(goalList[byDistance.back()].centre - target.centre);
+    Flock started = flock;
+    std::vector<size_t> swarm;
+    for (size_t i = 0; i < count; ++i) {
+        size_t g = i % goalCount;
+        if (g == 0 || std::find(byDistance.begin(), byDistance.end(), g) != byDistance.end()) {
+            flock.setGoal(i, target);
+            float angle = rng.uniform(0.0f, 6.28318531f);
+            glm::vec3 out(std::cos(angle), 0.0f, std::sin(angle));
+            started.setAgent(i, target.centre + out * target.radius,
+                glm::vec3(out.z, 0.0f, -out.x) * (target.turn * CRUISE_SPEED), target);
+            swarm.push_back(i);
+        }
+    }
+    float seconds = furthest / (0.8f * MAX_SPEED) + 20.0f;
+    for (int s = 0; s < (int)(seconds / dt); ++s) {
+        flock.step(dt, &setupJobs);
+        started.step(dt, &setupJobs);
+    }
+    size_t arrived = 0, onPatrol = 0;
+    for (size_t i : swarm) {
+        if (offCircle(flock.positions[i], target) < 15.0f) ++arrived;
+        if (offCircle(started.positions[i], target) < 15.0f) ++onPatrol;
+    }
+    int swarmPenetrations = inside();
+    bool converged = onPatrol > 0 && arrived * 10 >= onPatrol * 9;
+    std::cout << "Flock bench: " << arrived << " of " << swarm.size() << " agents converged from up to "
+        << furthest << " units in " << seconds << " s (" << onPatrol << " of those started on the patrol), "
+        << swarmPenetrations << " inside obstacles " << (converged ? "OK" : "NOT CONVERGED") << std::endl;
+
+    return mismatches == 0 && penetrations == 0 && swarmPenetrations == 0 && converged;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SpatialGrid.h"
+#include "Sweep.h"
+
+class JobSystem;
+
+// Flocking steering for the probes (Reynolds boids): every agent flies round
+// its goal's patrol circle while keeping apart from its neighbours (separation),
+// matching their heading (alignment), drifting towards them (cohesion) and
+// turning away from obstacles ahead of it.
+//
+// Neighbours come from a hashed grid of the agents, rebuilt at the start of
+// each step, so an agent only looks at the agents in the cells round it.
+// Obstacles come from two more grids, one for small ones (asteroids) and a
+// coarse one for the few big ones (planets, the sun): in one grid the big ones
+// would make every query cover many small cells.
+//
+// Every agent's new velocity is worked out from the positions at the start of
+// the step, so the agents are independent and are steered in parallel ranges,
+// then moved in a second pass. An agent that still ends up inside obstacles is
+// put back outside them all: every agent is checked, since a far agent moved
+// several ticks at once can pass through what it never had within reach.
+class Flock {
+public:
+    static constexpr float NEIGHBOUR_RADIUS = 8.0f;
+    static constexpr float SEPARATION_RADIUS = 4.0f;
+    static constexpr float CRUISE_SPEED = 8.0f;      // round the patrol circle
+    static constexpr float MAX_SPEED = 14.0f;
+    static constexpr float MAX_ACCELERATION = 40.0f;
+    static constexpr float LOOKAHEAD = 1.0f;         // seconds of flight checked for obstacles
+
+    // A circle in the horizontal plane through centre, flown round one way
+    // for turn = 1 and the other for -1
+    struct Goal {
+        glm::vec3 centre;
+        float radius;
+        float turn;
+    };
+
+    void resize(size_t count);
+    size_t size() const { return positions.size(); }
+
+    // Also resets the agent to being stepped once per step()
+    void setAgent(size_t i, const glm::vec3& position, const glm::vec3& velocity, const Goal& goal);
+    void setGoal(size_t i, const Goal& goal) { goals[i] = goal; }
+
+    // Has the next step() move agent i `ticks` steps' worth in one go (the
+    // simulation LOD's far agents); 0 leaves it where it is, still there for
+    // the others as a neighbour
+    void setTicks(size_t i, uint32_t count) { ticks[i] = (uint8_t)count; }
+    const glm::vec3& position(size_t i) const { return positions[i]; }
+    const glm::vec3& velocity(size_t i) const { return velocities[i]; }
+
+    // Spheres to keep out of (radius includes the agents' clearance); the
+    // set is replaced before each step
+    void clearObstacles() { obstacles.clear(); }
+
+    // How far past an agent an obstacle can still matter to it over a step
+    // of the given length (avoidance reach at full speed, plus the step):
+    // only obstacles within this of some agent need adding
+    static float obstacleReach(float stepSeconds);
+    void addObstacle(const Sweep::Obstacle& obstacle) { obstacles.push_back(obstacle); }
+
+    void step(float dt, JobSystem* jobs = nullptr);
+
+    // Checks the hashed neighbour steering against testing every agent and
+    // that no agent ends up inside an obstacle, times a step for ~count
+    // agents at each thread count and then has a swarm converge on one goal
+    // (--flock-bench). Returns false on a mismatch, an agent inside an
+    // obstacle or a swarm that doesn't arrive.
+    static bool benchmark(size_t count, uint64_t seed);
+
+private:
+    // Acceleration on agent i; neighbours(position, fn) calls fn(id, distance)
+    // for every agent within NEIGHBOUR_RADIUS of the position (itself included)
+    template <typename Neighbours>
+    glm::vec3 steer(size_t i, Neighbours neighbours) const;
+
+    // Moves agent i out of every obstacle it is inside, taking off the
+    // velocity back into them
+    void pushOut(size_t i);
+
+    // fn(obstacle, distance between centres) for every obstacle whose sphere
+    // comes within range of p
+    template <typename Fn>
+    void forEachObstacle(const glm::vec3& p, float range, Fn fn) const;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> velocities;
+    std::vector<glm::vec3> nextVelocities;
+    std::vector<uint8_t> ticks;
+    std::vector<Goal> goals;
+    std::vector<Sweep::Obstacle> obstacles;
+
+    // Cells two neighbour radii across: a query touches 8 of them rather than
+    // 27, which costs more than the extra agents it has to test
+    SpatialGrid agentGrid = SpatialGrid(2.0f * NEIGHBOUR_RADIUS);
+    SpatialGrid smallObstacles = SpatialGrid(32.0f);
+    SpatialGrid largeObstacles = SpatialGrid(256.0f);
+};
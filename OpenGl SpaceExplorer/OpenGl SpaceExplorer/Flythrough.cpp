@@ -0,0 +1,199 @@
+#include "Flythrough.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+const double MIN_SPAN_SECONDS = 1.0;
+const int LENGTH_SAMPLES = 16;   // per span, to measure it
+
+// Frame times and mean render counts over some frames
+struct Summary {
+    size_t frames = 0;
+    size_t rendered = 0;      // frames with render counts, which the means are over
+    std::vector<double> ms;   // timed frames, sorted
+    double drawCalls = 0.0;
+    double triangles = 0.0;
+    double uniformUploads = 0.0;
+
+    double percentile(double p) const {
+        if (ms.empty()) return 0.0;
+        return ms[std::min(ms.size() - 1, (size_t)(p * ms.size()))];
+    }
+
+    double mean() const {
+        double total = 0.0;
+        for (double t : ms) total += t;
+        return ms.empty() ? 0.0 : total / ms.size();
+    }
+};
+
+void writeSummary(std::ofstream& out, const Summary& summary, const char* indent) {
+    out << indent << "\"frames\": " << summary.frames << ",\n";
+    out << indent << "\"renderedFrames\": " << summary.rendered << ",\n";
+    out << indent << "\"frameMs\": { \"mean\": " << summary.mean()
+        << ", \"p50\": " << summary.percentile(0.5)
+        << ", \"p90\": " << summary.percentile(0.9)
+        << ", \"p99\": " << summary.percentile(0.99)
+        << ", \"max\": " << (summary.ms.empty() ? 0.0 : summary.ms.back()) << " },\n";
+    out << indent << "\"drawCalls\": " << summary.drawCalls << ",\n";
+    out << indent << "\"triangles\": " << summary.triangles << ",\n";
+    out << indent << "\"uniformUploads\": " << summary.uniformUploads << "\n";
+}
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+}
+
+void Flythrough::add(const std::string& segment, const glm::dvec3& offset, int anchor) {
+    if (segments.empty() || segments.back() != segment) segments.push_back(segment);
+    keys.push_back(Keyframe{ offset, anchor, segments.size() - 1 });
+}
+
+glm::dvec3 Flythrough::keyPosition(int k, double t) const {
+    const Keyframe& key = keys[k];
+    return key.anchor < 0 ? key.offset : anchorAt(key.anchor, t) + key.offset;
+}
+
+// Centripetal Catmull-Rom (knots spaced by the square root of the distance
+// between keyframes), which doesn't overshoot or loop where keyframes are
+// unevenly spaced. The ends continue the first and last spans in a straight line.
+glm::dvec3 Flythrough::spanPoint(size_t span, double u, double t) const {
+    int last = (int)keys.size() - 1;
+    int k = (int)span;
+    glm::dvec3 p1 = keyPosition(k, t);
+    glm::dvec3 p2 = keyPosition(std::min(k + 1, last), t);
+    glm::dvec3 p0 = k > 0 ? keyPosition(k - 1, t) : p1 * 2.0 - p2;
+    glm::dvec3 p3 = k + 2 <= last ? keyPosition(k + 2, t) : p2 * 2.0 - p1;
+
+    auto knot = [](const glm::dvec3& a, const glm::dvec3& b) {
+        return std::max(std::sqrt(glm::length(b - a)), 1e-6);
+    };
+    double t0 = 0.0;
+    double t1 = t0 + knot(p0, p1);
+    double t2 = t1 + knot(p1, p2);
+    double t3 = t2 + knot(p2, p3);
+    double s = t1 + (t2 - t1) * u;
+
+    glm::dvec3 a1 = p0 * ((t1 - s) / (t1 - t0)) + p1 * ((s - t0) / (t1 - t0));
+    glm::dvec3 a2 = p1 * ((t2 - s) / (t2 - t1)) + p2 * ((s - t1) / (t2 - t1));
+    glm::dvec3 a3 = p2 * ((t3 - s) / (t3 - t2)) + p3 * ((s - t2) / (t3 - t2));
+    glm::dvec3 b1 = a1 * ((t2 - s) / (t2 - t0)) + a2 * ((s - t0) / (t2 - t0));
+    glm::dvec3 b2 = a2 * ((t3 - s) / (t3 - t1)) + a3 * ((s - t1) / (t3 - t1));
+    return b1 * ((t2 - s) / (t2 - t1)) + b2 * ((s - t1) / (t2 - t1));
+}
+
+size_t Flythrough::finish(double tickSeconds) {
+    if (keys.size() < 2) throw std::runtime_error("A flythrough needs at least two keyframes");
+
+    // Each span takes its length at cruise speed, measured where its
+    // keyframes are when it starts
+    spanStart.assign(1, 0.0);
+    for (size_t span = 0; span + 1 < keys.size(); ++span) {
+        double t = spanStart.back();
+        double length = 0.0;
+        glm::dvec3 previous = spanPoint(span, 0.0, t);
+        for (int i = 1; i <= LENGTH_SAMPLES; ++i) {
+            glm::dvec3 p = spanPoint(span, (double)i / LENGTH_SAMPLES, t);
+            length += glm::length(p - previous);
+            previous = p;
+        }
+        spanStart.push_back(t + std::max(length / cruise, MIN_SPAN_SECONDS));
+    }
+
+    frameSeconds = tickSeconds;
+    frames.assign((size_t)std::ceil(duration() / tickSeconds), Frame());
+    return frames.size();
+}
+
+glm::dvec3 Flythrough::position(double t) const {
+    t = glm::clamp(t, 0.0, duration());
+    size_t span = (size_t)(std::upper_bound(spanStart.begin(), spanStart.end(), t) - spanStart.begin());
+    span = std::min(std::max(span, (size_t)1), keys.size() - 1) - 1;
+    double u = (t - spanStart[span]) / (spanStart[span + 1] - spanStart[span]);
+    return spanPoint(span, glm::clamp(u, 0.0, 1.0), t);
+}
+
+size_t Flythrough::segmentAt(double t) const {
+    size_t span = (size_t)(std::upper_bound(spanStart.begin(), spanStart.end(), t) - spanStart.begin());
+    return keys[std::min(std::max(span, (size_t)1), keys.size() - 1)].segment;
+}
+
+void Flythrough::writeReport(const std::string& path, const RunInfo& info) const {
+    std::vector<Summary> perSegment(segments.size());
+    Summary total;
+    for (const Frame& frame : frames) {
+        for (Summary* summary : { &perSegment[frame.segment], &total }) {
+            ++summary->frames;
+            if (frame.ms >= 0.0) summary->ms.push_back(frame.ms);
+            if (!frame.rendered) continue;
+            ++summary->rendered;
+            summary->drawCalls += (double)frame.render.drawCalls;
+            summary->triangles += (double)frame.render.triangles;
+            summary->uniformUploads += (double)frame.render.uniformUploads;
+        }
+    }
+    perSegment.push_back(total);
+    for (Summary& summary : perSegment) {
+        std::sort(summary.ms.begin(), summary.ms.end());
+        if (summary.rendered == 0) continue;
+        summary.drawCalls /= summary.rendered;
+        summary.triangles /= summary.rendered;
+        summary.uniformUploads /= summary.rendered;
+    }
+    total = perSegment.back();
+    perSegment.pop_back();
+
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write flythrough report: " + path);
+
+    out << "{\n";
+    out << "  \"seed\": " << info.seed << ",\n";
+    out << "  \"tickSeconds\": " << frameSeconds << ",\n";
+    out << "  \"seconds\": " << duration() << ",\n";
+    out << "  \"renderer\": " << quoted(info.renderer) << ",\n";
+    out << "  \"viewport\": [" << info.width << ", " << info.height << "],\n";
+    out << "  \"threads\": " << info.threads << ",\n";
+    out << "  \"noisePath\": " << quoted(info.noisePath) << ",\n";
+    out << "  \"asteroidPath\": " << quoted(info.asteroidPath) << ",\n";
+    out << "  \"total\": {\n";
+    writeSummary(out, total, "    ");
+    out << "  },\n";
+    out << "  \"segments\": [\n";
+    for (size_t s = 0; s < segments.size(); ++s) {
+        out << "    {\n";
+        out << "      \"name\": " << quoted(segments[s]) << ",\n";
+        writeSummary(out, perSegment[s], "      ");
+        out << "    }" << (s + 1 < segments.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    if (!out) throw std::runtime_error("Flythrough report write failed: " + path);
+
+    std::cout << "Flythrough: " << total.frames << " frames, " << total.mean() << " ms/frame mean, "
+        << total.percentile(0.5) << " median, " << total.percentile(0.99) << " 99th percentile, "
+        << total.drawCalls << " draw calls, " << total.triangles << " triangles, "
+        << total.uniformUploads << " uniform uploads a frame" << std::endl;
+    if (total.rendered < total.frames) {
+        std::cout << "  render counts are over the " << total.rendered << " frames drawn, of " << total.frames
+            << std::endl;
+    }
+    for (size_t s = 0; s < segments.size(); ++s) {
+        const Summary& summary = perSegment[s];
+        std::cout << "  " << segments[s] << ": " << summary.frames << " frames, "
+            << summary.percentile(0.5) << " ms median, " << summary.percentile(0.99) << " ms 99th, "
+            << summary.drawCalls << " draws, " << summary.triangles << " triangles" << std::endl;
+    }
+    std::cout << "Report written to " << path << std::endl;
+}
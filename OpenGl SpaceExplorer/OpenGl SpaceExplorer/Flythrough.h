@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <glm/glm.hpp>
+
+#include "RenderStats.h"
+
+// A scripted camera flight for benchmarking (--flythrough): a Catmull-Rom
+// spline through keyframes, flown at a set speed, one fixed tick per frame,
+// so every run of a build does the same work frame for frame. Keyframes can
+// hang off a moving anchor (a planet), so a dive still reaches the planet
+// wherever its orbit has taken it.
+//
+// Consecutive keyframes with the same segment name make one segment of the
+// report; the flight into a keyframe counts towards its segment. Each frame's
+// real time and render counts are kept, and the report gives frame-time
+// percentiles and the mean draw calls, triangles and uniform uploads per
+// frame for each segment and for the whole flight, as JSON. The means are
+// over the frames the render thread drew (all of them, unless it stopped
+// early), and the report says how many that was.
+class Flythrough {
+public:
+    // Where an anchor is at simulation time t
+    using AnchorFn = std::function<glm::dvec3(int anchor, double t)>;
+
+    // What the run was, for the report
+    struct RunInfo {
+        uint64_t seed = 0;
+        std::string renderer;
+        std::string noisePath;
+        std::string asteroidPath;
+        unsigned int threads = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // Flown at `speed` units a second (spans shorter than a second take a second)
+    Flythrough(double speed, AnchorFn anchors) : cruise(speed), anchorAt(anchors) {}
+
+    // A keyframe at `offset` from the anchor (from the world origin with -1)
+    void add(const std::string& segment, const glm::dvec3& offset, int anchor = -1);
+
+    // Times the flight (after the last keyframe) and returns how many frames
+    // of tickSeconds it takes
+    size_t finish(double tickSeconds);
+
+    double duration() const { return spanStart.empty() ? 0.0 : spanStart.back(); }
+    size_t frameCount() const { return frames.size(); }
+
+    // Where the camera is at simulation time t into the flight, and which
+    // segment that is
+    glm::dvec3 position(double t) const;
+    size_t segmentAt(double t) const;
+    const std::string& segmentName(size_t segment) const { return segments[segment]; }
+
+    // Frame i's results: its segment (main thread, as it's built), its real
+    // time (main thread, once the next one starts) and what drawing it sent
+    // to GL (render thread). Each writes its own fields.
+    void recordFrame(size_t frame, size_t segment) { frames[frame].segment = segment; }
+    void recordTime(size_t frame, double ms) { frames[frame].ms = ms; }
+    void recordRender(size_t frame, const RenderStats& stats) {
+        frames[frame].render = stats;
+        frames[frame].rendered = true;
+    }
+
+    // Writes the JSON report and prints a summary; throws std::runtime_error
+    // if the file can't be written
+    void writeReport(const std::string& path, const RunInfo& info) const;
+
+private:
+    struct Keyframe {
+        glm::dvec3 offset;
+        int anchor;
+        size_t segment;
+    };
+
+    struct Frame {
+        size_t segment = 0;
+        double ms = -1.0;   // not timed (the last frame)
+        RenderStats render;
+        bool rendered = false;
+    };
+
+    glm::dvec3 keyPosition(int k, double t) const;
+    glm::dvec3 spanPoint(size_t span, double u, double t) const;
+
+    double cruise;
+    double frameSeconds = 0.0;
+    AnchorFn anchorAt;
+    std::vector<Keyframe> keys;
+    std::vector<std::string> segments;
+    std::vector<double> spanStart;   // keyframe k is reached at spanStart[k]
+    std::vector<Frame> frames;
+};
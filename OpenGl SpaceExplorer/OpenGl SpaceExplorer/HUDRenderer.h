@@ -6,18 +6,19 @@
 #include <cmath>
 #include <cctype>
 
+#include "RenderStats.h"
+
 struct HUDVertex {
     glm::vec2 Position;
     glm::vec3 Color;
 };
 
-// Renders 2D HUD elements for the radar speedometer crosshair
-class HUDRenderer {
+// 2D HUD line geometry (radar, speedometer, crosshair, text). Pure CPU work with
+// no GL calls, so it can be built off the render thread and handed over.
+class HUDGeometry {
 private:
-    GLuint VAO, VBO, EBO;
     std::vector<HUDVertex> vertices;
     std::vector<unsigned int> indices;
-    unsigned int indexCount;
 
     void addLineInternal(const glm::vec2& p1, const glm::vec2& p2, const glm::vec3& color) {
         unsigned int start = (unsigned int)vertices.size();
@@ -300,18 +301,6 @@ private:
     }
 
 public:
-    HUDRenderer() : VAO(0), VBO(0), EBO(0), indexCount(0) {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-    }
-
-    ~HUDRenderer() {
-        if (VAO != 0) glDeleteVertexArrays(1, &VAO);
-        if (VBO != 0) glDeleteBuffers(1, &VBO);
-        if (EBO != 0) glDeleteBuffers(1, &EBO);
-    }
-
     void addLine(glm::vec2 p1, glm::vec2 p2, glm::vec3 color) {
         addLineInternal(p1, p2, color);
     }
@@ -355,7 +344,41 @@ public:
             pen.x += (charW + spacing) * scale;
         }
     }
-    void finalize() {
+
+    // Clear all HUD elements
+    void clear() {
+        vertices.clear();
+        indices.clear();
+    }
+
+    const std::vector<HUDVertex>& getVertices() const { return vertices; }
+    const std::vector<unsigned int>& getIndices() const { return indices; }
+};
+
+// Uploads HUD geometry and draws it as lines (needs the GL context)
+class HUDRenderer {
+private:
+    GLuint VAO, VBO, EBO;
+    unsigned int indexCount;
+
+public:
+    HUDRenderer() : VAO(0), VBO(0), EBO(0), indexCount(0) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
+
+    ~HUDRenderer() {
+        if (VAO != 0) glDeleteVertexArrays(1, &VAO);
+        if (VBO != 0) glDeleteBuffers(1, &VBO);
+        if (EBO != 0) glDeleteBuffers(1, &EBO);
+    }
+
+    // Upload this frame's HUD geometry to GPU buffers
+    void upload(const HUDGeometry& geometry) {
+        const std::vector<HUDVertex>& vertices = geometry.getVertices();
+        const std::vector<unsigned int>& indices = geometry.getIndices();
+
         glBindVertexArray(VAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -387,13 +410,7 @@ public:
     void render() {
         glBindVertexArray(VAO);
         glDrawElements(GL_LINES, indexCount, GL_UNSIGNED_INT, 0);
+        RenderStats::draw(0);
         glBindVertexArray(0);
     }
-
-    // Clear all HUD elements
-    void clear() {
-        vertices.clear();
-        indices.clear();
-        indexCount = 0;
-    }
 };
@@ -0,0 +1,250 @@
+#include "JobSystem.h"
+
+#include <iostream>
+
+namespace {
+
+// Which system's worker this thread is (any other thread counts as thread 0)
+thread_local const JobSystem* t_owner = nullptr;
+thread_local unsigned int t_index = 0;
+
+// Ranges per thread in a parallel-for: enough for stealing to balance them
+const size_t RANGES_PER_THREAD = 4;
+
+} // namespace
+
+JobSystem::JobSystem(unsigned int threads) {
+    if (threads == 0) threads = 1;
+    for (unsigned int i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 1; i < threads; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+unsigned int JobSystem::currentThread() const {
+    return t_owner == this ? t_index : 0;
+}
+
+void JobSystem::run(std::function<void()> fn, JobCounter* counter) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    Queue& q = *queues[currentThread()];
+    {
+        std::lock_guard<std::mutex> lock(q.lock);
+        q.jobs.push_back(Job{ std::move(fn), counter });
+    }
+    queued.fetch_add(1);
+
+    // Only take the sleep lock when someone is actually asleep
+    if (sleepers.load() > 0) {
+        { std::lock_guard<std::mutex> lock(sleepLock); }
+        wake.notify_one();
+    }
+}
+
+bool JobSystem::pop(unsigned int self, Job& job) {
+    Queue& q = *queues[self];
+    std::lock_guard<std::mutex> lock(q.lock);
+    if (q.jobs.empty()) return false;
+    job = std::move(q.jobs.back());
+    q.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::steal(unsigned int self, Job& job) {
+    unsigned int n = threadCount();
+    for (unsigned int k = 1; k < n; ++k) {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (q.jobs.empty()) continue;
+        job = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOne(unsigned int self) {
+    Job job;
+    if (!pop(self, job) && !steal(self, job)) return false;
+    queued.fetch_sub(1);
+
+    job.fn();
+    if (job.counter) job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    unsigned int self = currentThread();
+    while (!counter.done()) {
+        // Nothing left to run here: the last jobs are still running elsewhere
+        if (!runOne(self)) std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(unsigned int self) {
+    t_owner = this;
+    t_index = self;
+
+    while (!stopping) {
+        if (runOne(self)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepLock);
+        ++sleepers;
+        wake.wait(lock, [this]() { return stopping.load() || queued.load() > 0; });
+        --sleepers;
+    }
+}
+
+size_t JobSystem::rangeCount(size_t count, size_t minBatch) const {
+    if (minBatch == 0) minBatch = 1;
+    size_t ranges = (count + minBatch - 1) / minBatch;
+    return std::max<size_t>(1, std::min<size_t>(ranges, threadCount() * RANGES_PER_THREAD));
+}
+
+bool JobSystem::selfTest(unsigned int threads) {
+    JobSystem jobs(threads);
+    bool ok = true;
+
+    // Every index visited exactly once
+    const size_t count = 100003;
+    std::vector<std::atomic<int>> visits(count);
+    for (auto& v : visits) v = 0;
+    JobCounter loop;
+    jobs.parallelFor(count, 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) visits[i].fetch_add(1);
+    }, loop);
+    jobs.wait(loop);
+    bool once = true;
+    for (auto& v : visits) once = once && v.load() == 1;
+    std::cout << "Jobs selftest: parallelFor covers every index once " << (once ? "OK" : "FAILED") << std::endl;
+    ok = ok && once;
+
+    // Jobs that wait on work they queued themselves (nested parallel-for)
+    std::atomic<size_t> nestedSum{ 0 };
+    JobCounter outer;
+    jobs.parallelFor(64, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            JobCounter inner;
+            jobs.parallelFor(1000, 10, [&](size_t b, size_t e) { nestedSum.fetch_add(e - b); }, inner);
+            jobs.wait(inner);
+        }
+    }, outer);
+    jobs.wait(outer);
+    bool nested = nestedSum.load() == 64 * 1000;
+    std::cout << "Jobs selftest: nested waits " << (nested ? "OK" : "FAILED") << std::endl;
+    ok = ok && nested;
+
+    // A diamond, with a parallel-for in the middle: a -> (b, loop c) -> d
+    for (int round = 0; round < 100; ++round) {
+        std::atomic<int> step{ 0 };
+        int a = -1, b = -1, d = -1;
+        std::atomic<int> cMin{ 1 << 30 }, cMax{ -1 };
+        JobGraph graph;
+        JobGraph::Node na = graph.add([&]() { a = step++; });
+        JobGraph::Node nb = graph.add([&]() { b = step++; }, { na });
+        JobGraph::Node nc = graph.addParallelFor(5000, 100, [&](size_t, size_t) {
+            int s = step++;
+            int m = cMin.load();
+            while (s < m && !cMin.compare_exchange_weak(m, s)) {}
+            m = cMax.load();
+            while (s > m && !cMax.compare_exchange_weak(m, s)) {}
+        }, { na });
+        graph.add([&]() { d = step++; }, { nb, nc });
+        graph.run(jobs);
+
+        bool ordered = a == 0 && b > a && cMin.load() > a && d > b && d > cMax.load();
+        if (!ordered) {
+            std::cout << "Jobs selftest: dependency order FAILED in round " << round << std::endl;
+            ok = false;
+            break;
+        }
+    }
+    if (ok) std::cout << "Jobs selftest: dependency order OK" << std::endl;
+
+    std::cout << "Jobs selftest: " << jobs.threadCount() << " threads" << std::endl;
+    return ok;
+}
+
+JobGraph::Node JobGraph::addNode(std::unique_ptr<NodeData> node, std::initializer_list<Node> after) {
+    Node index = nodes.size();
+    node->dependencies = (int)after.size();
+    for (Node dep : after) nodes[dep]->successors.push_back(index);
+    nodes.push_back(std::move(node));
+    return index;
+}
+
+JobGraph::Node JobGraph::add(std::function<void()> fn, std::initializer_list<Node> after) {
+    std::unique_ptr<NodeData> node = std::make_unique<NodeData>();
+    node->fn = std::move(fn);
+    return addNode(std::move(node), after);
+}
+
+JobGraph::Node JobGraph::addParallelFor(size_t count, size_t minBatch, std::function<void(size_t, size_t)> fn,
+    std::initializer_list<Node> after) {
+    std::unique_ptr<NodeData> node = std::make_unique<NodeData>();
+    node->rangeFn = std::move(fn);
+    node->count = count;
+    node->minBatch = minBatch;
+    return addNode(std::move(node), after);
+}
+
+void JobGraph::run(JobSystem& jobs) {
+    system = &jobs;
+    for (auto& node : nodes) node->waitingOn = node->dependencies;
+    for (Node i = 0; i < nodes.size(); ++i) {
+        if (nodes[i]->dependencies == 0) start(i);
+    }
+
+    // Successors are queued from inside their last dependency's job, so the
+    // counter can't drain before the whole graph has run
+    jobs.wait(counter);
+}
+
+void JobGraph::start(Node index) {
+    NodeData& node = *nodes[index];
+
+    if (!node.rangeFn) {
+        system->run([this, index]() {
+            nodes[index]->fn();
+            finish(index);
+        }, &counter);
+        return;
+    }
+
+    if (node.count == 0) {
+        finish(index);
+        return;
+    }
+
+    size_t ranges = system->rangeCount(node.count, node.minBatch);
+    size_t chunk = (node.count + ranges - 1) / ranges;
+    node.rangesLeft = (node.count + chunk - 1) / chunk;
+    for (size_t begin = 0; begin < node.count; begin += chunk) {
+        size_t end = std::min(node.count, begin + chunk);
+        system->run([this, index, begin, end]() {
+            NodeData& n = *nodes[index];
+            n.rangeFn(begin, end);
+            if (n.rangesLeft.fetch_sub(1) == 1) finish(index);
+        }, &counter);
+    }
+}
+
+void JobGraph::finish(Node index) {
+    for (Node next : nodes[index]->successors) {
+        if (nodes[next]->waitingOn.fetch_sub(1) == 1) start(next);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Counts queued jobs that haven't finished yet. JobSystem::run() bumps it
+// before queueing and drops it once the job has run; JobSystem::wait() returns
+// when it reaches zero.
+class JobCounter {
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> pending{ 0 };
+};
+
+// Work-stealing scheduler for the per-frame work.
+//
+// Every thread (the one that created the system counts as thread 0) owns a
+// deque of jobs. A thread pushes and pops its own jobs at the back, so work it
+// just split up stays in its cache; when it runs dry it steals the oldest job
+// from the front of another thread's deque. Waiting never blocks: wait() keeps
+// running jobs (its own or stolen) until the counter drains, so a job can wait
+// on work it queued itself.
+//
+// Long-running background work (terrain chunks, sector generation) keeps its
+// own threads; this is for short jobs that have to finish within a frame.
+class JobSystem {
+public:
+    // threads includes the calling thread: threads - 1 workers are started
+    explicit JobSystem(unsigned int threads);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int threadCount() const { return (unsigned int)queues.size(); }
+
+    // Queues fn. The counter (if any) counts it until it has run.
+    void run(std::function<void()> fn, JobCounter* counter = nullptr);
+
+    // Splits [0, count) into contiguous ranges of at least minBatch and queues
+    // fn(begin, end) for each. A few ranges per thread, so stealing can even
+    // out ranges that turn out slower than others.
+    template <typename Fn>
+    void parallelFor(size_t count, size_t minBatch, Fn fn, JobCounter& counter) {
+        if (count == 0) return;
+        size_t ranges = rangeCount(count, minBatch);
+        size_t chunk = (count + ranges - 1) / ranges;
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            size_t end = std::min(count, begin + chunk);
+            run([fn, begin, end]() { fn(begin, end); }, &counter);
+        }
+    }
+
+    // Runs queued jobs on this thread until the counter reaches zero
+    void wait(JobCounter& counter);
+
+    // How many ranges parallelFor splits count items into
+    size_t rangeCount(size_t count, size_t minBatch) const;
+
+    // Checks ranges, dependencies and nested waits on the given thread count
+    // (--jobs-selftest). Returns false on any failure.
+    static bool selfTest(unsigned int threads);
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        JobCounter* counter = nullptr;
+    };
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    bool runOne(unsigned int self);
+    bool pop(unsigned int self, Job& job);
+    bool steal(unsigned int self, Job& job);
+    void workerLoop(unsigned int self);
+    unsigned int currentThread() const;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // Idle workers sleep here until something is queued
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> queued{ 0 };
+    std::atomic<int> sleepers{ 0 };
+    std::atomic<bool> stopping{ false };
+};
+
+// Jobs with dependencies, built up front and then run as a whole. A node is
+// queued as soon as the last node it depends on has finished (a parallel-for
+// node finishes with its last range), and run() returns once every node has
+// run. Nodes can only depend on nodes added before them.
+class JobGraph {
+public:
+    typedef size_t Node;
+
+    Node add(std::function<void()> fn, std::initializer_list<Node> after = {});
+
+    // fn(begin, end) over [0, count), split up like JobSystem::parallelFor
+    Node addParallelFor(size_t count, size_t minBatch, std::function<void(size_t, size_t)> fn,
+        std::initializer_list<Node> after = {});
+
+    // Runs the whole graph, helping out on this thread until it's done
+    void run(JobSystem& jobs);
+
+private:
+    struct NodeData {
+        std::function<void()> fn;
+        std::function<void(size_t, size_t)> rangeFn;
+        size_t count = 0;
+        size_t minBatch = 1;
+        std::vector<Node> successors;
+        int dependencies = 0;
+        std::atomic<int> waitingOn{ 0 };
+        std::atomic<size_t> rangesLeft{ 0 };
+    };
+
+    Node addNode(std::unique_ptr<NodeData> node, std::initializer_list<Node> after);
+    void start(Node node);
+    void finish(Node node);
+
+    std::vector<std::unique_ptr<NodeData>> nodes;
+    JobSystem* system = nullptr;
+    JobCounter counter;
+};
@@ -4,6 +4,8 @@
 #include <GL/glew.h>
 #include <cmath>
 
+#include "RenderStats.h"
+
 struct Vertex {
     glm::vec3 Position;
     glm::vec3 Normal;
@@ -55,11 +57,14 @@ public:
     void Draw() const {
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        RenderStats::draw(indices.size() / 3);
         glBindVertexArray(0);
     }
 };
 
-inline void generateUVSphere(Mesh& mesh, float radius, int slices, int stacks) {
+// The generators fill in the mesh's vertices and indices (no GL calls), and
+// the generate* wrappers then upload them
+inline void buildUVSphere(Mesh& mesh, float radius, int slices, int stacks) {
     mesh.vertices.clear();
     mesh.indices.clear();
 
@@ -101,11 +106,9 @@ inline void generateUVSphere(Mesh& mesh, float radius, int slices, int stacks) {
             k2++;
         }
     }
-
-    mesh.setupMesh();
 }
 
-inline void generateCube(Mesh& mesh, float size) {
+inline void buildCube(Mesh& mesh, float size) {
     mesh.vertices.clear();
     mesh.indices.clear();
 
@@ -157,6 +160,14 @@ inline void generateCube(Mesh& mesh, float size) {
         mesh.indices.push_back(base + 2);
         mesh.indices.push_back(base + 3);
     }
+}
 
+inline void generateUVSphere(Mesh& mesh, float radius, int slices, int stacks) {
+    buildUVSphere(mesh, radius, slices, stacks);
+    mesh.setupMesh();
+}
+
+inline void generateCube(Mesh& mesh, float size) {
+    buildCube(mesh, size);
     mesh.setupMesh();
 }
\ No newline at end of file
@@ -0,0 +1,485 @@
+#include "NBody.h"
+#include "AsteroidField.h"
+#include "JobSystem.h"
+#include "Orbits.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+constexpr float NBody::DEFAULT_THETA;
+constexpr float NBody::SUN_GM;
+constexpr float NBody::DENSITY;
+constexpr float NBody::SOFTENING;
+const uint32_t NBody::LEAF_SIZE;
+const int NBody::TOP_LEVELS;
+const int NBody::MAX_LEVEL;
+
+namespace {
+
+const size_t BUCKETS = (size_t)1 << (3 * 3);   // 8^TOP_LEVELS
+
+// fn(begin, end) over [0, count), spread over the job system if there is one
+template <typename Fn>
+void forRanges(JobSystem* jobs, size_t count, size_t minBatch, Fn fn) {
+    if (count == 0) return;
+    if (!jobs) {
+        fn(0, count);
+        return;
+    }
+    JobCounter counter;
+    jobs->parallelFor(count, minBatch, fn, counter);
+    jobs->wait(counter);
+}
+
+// The low 21 bits of v, two zero bits after each
+uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+// Octant of a key's cell among its parent's children, for a parent at this level
+int octantAt(uint64_t key, int level) {
+    return (int)((key >> (60 - 3 * level)) & 7);
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+void NBody::build(const std::vector<Asteroid>& source, const AsteroidField& field,
+    const glm::vec3& attractorPos, float gm, JobSystem* jobs) {
+    attractor = attractorPos;
+    attractorGM = gm;
+
+    // The field keeps the generator's order within the belt and the clusters
+    std::vector<const Asteroid*> members;
+    for (const Asteroid& a : source) if (a.clustered) members.push_back(&a);
+    size_t n = std::min(members.size(), field.clusterCount());
+    for (auto* v : { &px, &py, &pz, &vx, &vy, &vz, &ax, &ay, &az, &mass }) v->assign(n, 0.0f);
+    slot.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        size_t index = field.beltCount() + k;
+        glm::vec3 p = field.position(index);
+        px[k] = p.x;
+        py[k] = p.y;
+        pz[k] = p.z;
+        float s = field.scale(index);
+        mass[k] = DENSITY * s * s * s;
+        slot[k] = (uint32_t)index;
+    }
+
+    // Members of one cluster are consecutive and share its centre
+    std::vector<size_t> byRadius;
+    for (size_t begin = 0; begin < n;) {
+        size_t end = begin + 1;
+        while (end < n && members[end]->clusterCenter == members[begin]->clusterCenter) ++end;
+
+        float total = 0.0f;
+        glm::vec3 com(0.0f);
+        for (size_t k = begin; k < end; ++k) {
+            total += mass[k];
+            com += position(k) * mass[k];
+        }
+        com /= total;
+
+        // The cluster as a whole on a circle round the attractor
+        glm::vec3 out = com - attractor;
+        glm::vec3 along = glm::cross(glm::vec3(0.0f, -1.0f, 0.0f), out);
+        float distance = glm::length(out);
+        glm::vec3 bulk(0.0f);
+        if (glm::length(along) > 0.0f && distance > 0.0f) bulk = glm::normalize(along) * std::sqrt(gm / distance);
+
+        // Members on circles round the centre of mass in their generated
+        // orbit planes, fast enough for the mass inside them to hold them
+        byRadius.clear();
+        for (size_t k = begin; k < end; ++k) byRadius.push_back(k);
+        std::sort(byRadius.begin(), byRadius.end(), [&](size_t a, size_t b) {
+            return glm::length(position(a) - com) < glm::length(position(b) - com);
+        });
+        float inside = 0.0f;
+        for (size_t k : byRadius) {
+            glm::vec3 r = position(k) - com;
+            float r2 = glm::dot(r, r);
+            glm::vec3 P, Q;
+            Orbits::perifocalAxes(members[k]->inclination, members[k]->ascendingNode, members[k]->periapsisArg, P, Q);
+            glm::vec3 dir = glm::cross(glm::cross(P, Q), r);
+            if (glm::length(dir) == 0.0f) dir = glm::cross(glm::vec3(0.0f, -1.0f, 0.0f), r);
+            if (glm::length(dir) > 0.0f) dir = glm::normalize(dir);
+
+            float soft = r2 + SOFTENING * SOFTENING;
+            float speed = std::sqrt(inside * r2 / (soft * std::sqrt(soft)));
+            glm::vec3 v = bulk + dir * speed;
+            vx[k] = v.x;
+            vy[k] = v.y;
+            vz[k] = v.z;
+            inside += mass[k];
+        }
+        begin = end;
+    }
+
+    // The first kick needs the accelerations where the bodies start
+    buildTree(jobs);
+    computeAccelerations(jobs);
+}
+
+void NBody::step(float dt, JobSystem* jobs) {
+    size_t n = size();
+    float half = 0.5f * dt;
+    forRanges(jobs, n, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            vx[i] += ax[i] * half;
+            vy[i] += ay[i] * half;
+            vz[i] += az[i] * half;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    buildTree(jobs);
+    lastTreeMs = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    computeAccelerations(jobs);
+    lastForceMs = msSince(start);
+
+    forRanges(jobs, n, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            vx[i] += ax[i] * half;
+            vy[i] += ay[i] * half;
+            vz[i] += az[i] * half;
+        }
+    });
+}
+
+void NBody::store(AsteroidField& field, size_t begin, size_t end) const {
+    for (size_t i = begin; i < end; ++i) field.setPosition(slot[i], position(i));
+}
+
+void NBody::buildTree(JobSystem* jobs) {
+    size_t n = size();
+    nodes.clear();
+    if (n == 0) return;
+
+    // A cube round every body, a little oversized so nothing lands on the far faces
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (size_t i = 0; i < n; ++i) {
+        lo = glm::min(lo, position(i));
+        hi = glm::max(hi, position(i));
+    }
+    glm::vec3 extent = hi - lo;
+    rootSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1.0e-3f)) * 1.001f;
+    float toGrid = (float)(1 << MAX_LEVEL) / rootSize;
+
+    // Morton keys in parallel
+    keyed.resize(n);
+    forRanges(jobs, n, 4096, [&](size_t begin, size_t end) {
+        const float top = (float)((1 << MAX_LEVEL) - 1);
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 q = (position(i) - lo) * toGrid;
+            uint64_t x = (uint64_t)std::min(q.x, top);
+            uint64_t y = (uint64_t)std::min(q.y, top);
+            uint64_t z = (uint64_t)std::min(q.z, top);
+            keyed[i] = Keyed{ spreadBits(x) << 2 | spreadBits(y) << 1 | spreadBits(z), (uint32_t)i };
+        }
+    });
+
+    // Counting sort on the top levels (one cheap pass), then every bucket
+    // sorted on its own
+    bucketStart.assign(BUCKETS + 1, 0);
+    for (const Keyed& k : keyed) ++bucketStart[(k.key >> (63 - 3 * TOP_LEVELS)) + 1];
+    for (size_t b = 0; b < BUCKETS; ++b) bucketStart[b + 1] += bucketStart[b];
+    sortedKeys.resize(n);
+    {
+        std::vector<size_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (const Keyed& k : keyed) sortedKeys[fill[k.key >> (63 - 3 * TOP_LEVELS)]++] = k;
+    }
+    forRanges(jobs, BUCKETS, 8, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            std::sort(sortedKeys.begin() + bucketStart[b], sortedKeys.begin() + bucketStart[b + 1],
+                [](const Keyed& x, const Keyed& y) { return x.key < y.key || (x.key == y.key && x.body < y.body); });
+        }
+    });
+
+    // Bodies into key order
+    scratch.resize(n);
+    for (std::vector<float>* v : { &px, &py, &pz, &vx, &vy, &vz, &mass }) {
+        std::vector<float>& values = *v;
+        forRanges(jobs, n, 8192, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) scratch[i] = values[sortedKeys[i].body];
+        });
+        values.swap(scratch);
+    }
+    slotScratch.resize(n);
+    for (size_t i = 0; i < n; ++i) slotScratch[i] = slot[sortedKeys[i].body];
+    slot.swap(slotScratch);
+
+    // Each bucket's subtree on its own, then the top levels over them
+    subtrees.resize(BUCKETS);
+    forRanges(jobs, BUCKETS, 8, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            subtrees[b].clear();
+            if (bucketStart[b + 1] > bucketStart[b]) buildSubtree(subtrees[b], bucketStart[b], bucketStart[b + 1], TOP_LEVELS);
+        }
+    });
+    assemble(0, BUCKETS, 0);
+}
+
+void NBody::buildSubtree(std::vector<Node>& out, size_t begin, size_t end, int level) const {
+    uint32_t self = (uint32_t)out.size();
+    out.push_back(Node());
+
+    Node node;
+    node.size = std::ldexp(rootSize, -level);
+    if (end - begin <= LEAF_SIZE || level == MAX_LEVEL) {
+        node.mass = 0.0f;
+        node.com = glm::vec3(0.0f);
+        for (size_t i = begin; i < end; ++i) {
+            node.mass += mass[i];
+            node.com += position(i) * mass[i];
+        }
+        node.com /= node.mass;
+        node.first = (uint32_t)begin;
+        node.count = (uint32_t)(end - begin);
+    }
+    else {
+        // Keys are sorted, so each child cell is a run of them
+        uint32_t children[8];
+        int childCount = 0;
+        size_t childBegin = begin;
+        for (int o = 0; o < 8 && childBegin < end; ++o) {
+            size_t childEnd = std::partition_point(sortedKeys.begin() + childBegin, sortedKeys.begin() + end,
+                [&](const Keyed& k) { return octantAt(k.key, level) <= o; }) - sortedKeys.begin();
+            if (childEnd > childBegin) {
+                children[childCount++] = (uint32_t)out.size();
+                buildSubtree(out, childBegin, childEnd, level + 1);
+            }
+            childBegin = childEnd;
+        }
+        aggregate(node, children, childCount, out);
+        node.first = 0;
+        node.count = 0;
+    }
+    node.next = (uint32_t)out.size();
+    out[self] = node;
+}
+
+uint32_t NBody::assemble(size_t bucketBegin, size_t bucketEnd, int level) {
+    if (level == TOP_LEVELS) {
+        // One bucket's subtree, its links moved to where it lands
+        const std::vector<Node>& subtree = subtrees[bucketBegin];
+        uint32_t offset = (uint32_t)nodes.size();
+        for (Node node : subtree) {
+            node.next += offset;
+            nodes.push_back(node);
+        }
+        return offset;
+    }
+
+    uint32_t self = (uint32_t)nodes.size();
+    nodes.push_back(Node());
+
+    uint32_t children[8];
+    int childCount = 0;
+    size_t span = (bucketEnd - bucketBegin) / 8;
+    for (int o = 0; o < 8; ++o) {
+        size_t b = bucketBegin + o * span;
+        if (bucketStart[b + span] > bucketStart[b]) children[childCount++] = assemble(b, b + span, level + 1);
+    }
+
+    Node node;
+    node.size = std::ldexp(rootSize, -level);
+    aggregate(node, children, childCount, nodes);
+    node.first = 0;
+    node.count = 0;
+    node.next = (uint32_t)nodes.size();
+    nodes[self] = node;
+    return self;
+}
+
+void NBody::aggregate(Node& node, const uint32_t* children, int childCount, const std::vector<Node>& pool) const {
+    node.mass = 0.0f;
+    node.com = glm::vec3(0.0f);
+    for (int c = 0; c < childCount; ++c) {
+        const Node& child = pool[children[c]];
+        node.mass += child.mass;
+        node.com += child.com * child.mass;
+    }
+    node.com /= node.mass;
+}
+
+void NBody::computeAccelerations(JobSystem* jobs) {
+    forRanges(jobs, size(), 256, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 a = accelerationOf(i);
+            ax[i] = a.x;
+            ay[i] = a.y;
+            az[i] = a.z;
+        }
+    });
+}
+
+glm::vec3 NBody::accelerationOf(size_t i) const {
+    const float soft2 = SOFTENING * SOFTENING;
+    const float theta2 = theta * theta;
+    const float x = px[i], y = py[i], z = pz[i];
+    float sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f;
+
+    // Plain floats over the SoA arrays: this loop is nearly all of a step
+    uint32_t index = 0;
+    uint32_t count = (uint32_t)nodes.size();
+    while (index < count) {
+        const Node& node = nodes[index];
+        if (node.count > 0) {
+            for (uint32_t j = node.first; j < node.first + node.count; ++j) {
+                float dx = px[j] - x, dy = py[j] - y, dz = pz[j] - z;
+                float r2 = dx * dx + dy * dy + dz * dz + soft2;
+                float k = j == i ? 0.0f : mass[j] / (r2 * std::sqrt(r2));
+                sumX += dx * k;
+                sumY += dy * k;
+                sumZ += dz * k;
+            }
+            index = node.next;
+            continue;
+        }
+
+        float dx = node.com.x - x, dy = node.com.y - y, dz = node.com.z - z;
+        float r2 = dx * dx + dy * dy + dz * dz;
+        if (node.size * node.size < theta2 * r2) {
+            r2 += soft2;
+            float k = node.mass / (r2 * std::sqrt(r2));
+            sumX += dx * k;
+            sumY += dy * k;
+            sumZ += dz * k;
+            index = node.next;
+        }
+        else {
+            ++index;   // open it: the first child follows
+        }
+    }
+
+    glm::vec3 d = attractor - position(i);
+    float r2 = glm::dot(d, d) + soft2;
+    return glm::vec3(sumX, sumY, sumZ) + d * (attractorGM / (r2 * std::sqrt(r2)));
+}
+
+glm::vec3 NBody::directAcceleration(size_t i) const {
+    const float soft2 = SOFTENING * SOFTENING;
+    glm::vec3 p = position(i);
+    glm::vec3 a(0.0f);
+    for (size_t j = 0; j < size(); ++j) {
+        if (j == i) continue;
+        glm::vec3 d = position(j) - p;
+        float r2 = glm::dot(d, d) + soft2;
+        a += d * (mass[j] / (r2 * std::sqrt(r2)));
+    }
+    glm::vec3 d = attractor - p;
+    float r2 = glm::dot(d, d) + soft2;
+    return a + d * (attractorGM / (r2 * std::sqrt(r2)));
+}
+
+// Total energy (times G), with the same softened potential the forces use
+double NBody::energy() const {
+    const double soft2 = (double)SOFTENING * SOFTENING;
+    double total = 0.0;
+    for (size_t i = 0; i < size(); ++i) {
+        double v2 = (double)vx[i] * vx[i] + (double)vy[i] * vy[i] + (double)vz[i] * vz[i];
+        total += 0.5 * mass[i] * v2;
+        glm::dvec3 p(px[i], py[i], pz[i]);
+        glm::dvec3 s = p - glm::dvec3(attractor.x, attractor.y, attractor.z);
+        total -= (double)mass[i] * attractorGM / std::sqrt(glm::dot(s, s) + soft2);
+        for (size_t j = i + 1; j < size(); ++j) {
+            glm::dvec3 d = glm::dvec3(px[j], py[j], pz[j]) - p;
+            total -= (double)mass[i] * mass[j] / std::sqrt(glm::dot(d, d) + soft2);
+        }
+    }
+    return total;
+}
+
+bool NBody::benchmark(size_t count, uint64_t seed, float theta) {
+    const float tickSeconds = 1.0f / 60.0f;
+    auto generate = [&](size_t bodies, std::vector<Asteroid>& source, AsteroidField& field) {
+        source.clear();
+        int clusters = std::max(1, (int)(bodies / 40));
+        PlanetGenerator::generateAsteroidClusters(source, seed, clusters, 25, 55, 300.0f, 1400.0f);
+        field.build(source, tickSeconds);
+    };
+
+    std::vector<Asteroid> source;
+    AsteroidField field;
+    generate(count, source, field);
+    unsigned int maxThreads = std::max(1u, parallelThreadCount());
+    JobSystem setupJobs(maxThreads);
+    NBody system;
+    system.setTheta(theta);
+    system.build(source, field, glm::vec3(0.0f), SUN_GM, &setupJobs);
+    size_t n = system.size();
+
+    // Accuracy: the tree's accelerations against summing every body
+    std::vector<float> errors;
+    for (size_t i = 0; i < n; i += std::max<size_t>(1, n / 1000)) {
+        glm::vec3 exact = system.directAcceleration(i);
+        glm::vec3 tree(system.ax[i], system.ay[i], system.az[i]);
+        errors.push_back(glm::length(tree - exact) / std::max(glm::length(exact), 1.0e-20f));
+    }
+    std::sort(errors.begin(), errors.end());
+    float median = errors[errors.size() / 2];
+    float p99 = errors[errors.size() * 99 / 100];
+    bool accurate = theta > 1.0f || p99 < 0.05f;
+    std::cout << "N-body bench: theta " << theta << ", " << n << " bodies, acceleration error vs direct sum: median "
+        << median * 100.0f << "%, 99th percentile " << p99 * 100.0f << "%, max " << errors.back() * 100.0f << "% "
+        << (accurate ? "OK" : "TOO LARGE") << std::endl;
+
+    // Leapfrog on a small system: twenty simulated seconds at the game's tick
+    std::vector<Asteroid> smallSource;
+    AsteroidField smallField;
+    generate(2000, smallSource, smallField);
+    NBody small;
+    small.setTheta(theta);
+    small.build(smallSource, smallField, glm::vec3(0.0f), SUN_GM, &setupJobs);
+    double before = small.energy();
+    const int smallSteps = 1200;
+    for (int s = 0; s < smallSteps; ++s) small.step(tickSeconds, &setupJobs);
+    double drift = std::abs(small.energy() - before) / std::abs(before);
+    bool conserved = drift < 1.0e-3;
+    std::cout << "N-body bench: " << small.size() << " bodies, " << smallSteps << " steps, energy drift "
+        << drift * 100.0 << "% " << (conserved ? "OK" : "TOO LARGE") << std::endl;
+
+    // Cost per body per step at each thread count
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    double singleNs = 0.0;
+    for (unsigned int threads : threadCounts) {
+        JobSystem jobs(threads);
+        NBody run = system;
+        for (int s = 0; s < 2; ++s) run.step(tickSeconds, &jobs);
+
+        const int steps = 10;
+        double treeMs = 0.0, forceMs = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s) {
+            run.step(tickSeconds, &jobs);
+            treeMs += run.treeMs();
+            forceMs += run.forceMs();
+        }
+        double ns = msSince(start) * 1.0e6 / steps / (double)n;
+        if (threads == 1) singleNs = ns;
+        std::cout << "N-body bench: " << threads << " threads, " << ns << " ns/body/step (tree "
+            << treeMs / steps << " ms, forces " << forceMs / steps << " ms per step), "
+            << singleNs / ns << "x 1 thread" << std::endl;
+    }
+    return accurate && conserved;
+}
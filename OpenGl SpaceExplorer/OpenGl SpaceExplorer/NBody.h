@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "PlanetGenerator.h"
+
+class JobSystem;
+class AsteroidField;
+
+// Barnes-Hut gravity for the asteroid clusters (the optional --nbody mode):
+// cluster members attract each other and are pulled by the sun, instead of
+// circling fixed centres on closed-form orbits.
+//
+// Every step rebuilds an octree over the bodies. Bodies are sorted by the
+// Morton code of their position (the top three octree levels first, as 512
+// buckets, then each bucket in parallel), which makes every octree cell a
+// contiguous run of bodies: each bucket's subtree is built on its own thread
+// and the top levels are put together over them. Bodies are kept in that
+// order, so neighbours in space are neighbours in memory for the force pass.
+//
+// A cell whose size is under theta times its distance from a body acts on it
+// as a point mass at its centre of mass; anything closer is opened (leaves
+// are summed body by body). Nodes are stored depth first with a skip link
+// past each subtree, so the walk needs no stack. Integration is kick-drift-
+// kick leapfrog, which keeps orbits from gaining or losing energy over time.
+//
+// Masses are gravitational parameters (G is folded in), from the asteroid's
+// size. Forces are softened so close passes stay finite.
+class NBody {
+public:
+    static constexpr float DEFAULT_THETA = 0.5f;
+    static constexpr float SUN_GM = 5.0e4f;       // a cluster 800 units out goes round in about ten minutes
+    static constexpr float DENSITY = 20.0f;       // mass per cubed scale unit
+    static constexpr float SOFTENING = 1.0f;
+
+    // Takes over the field's cluster members (from the same generated list
+    // the field was built from) at their current positions. Each cluster is
+    // set moving on a circular orbit round the attractor, its members circling
+    // its centre of mass at the speed its own pull gives them.
+    void build(const std::vector<Asteroid>& source, const AsteroidField& field,
+        const glm::vec3& attractor, float attractorGM, JobSystem* jobs = nullptr);
+
+    void setTheta(float value) { theta = value; }
+    float openingAngle() const { return theta; }
+
+    // One leapfrog step; the tree is rebuilt for the new positions
+    void step(float dt, JobSystem* jobs = nullptr);
+
+    // Writes bodies [begin, end) into their asteroid slots in the field
+    // (disjoint ranges can run on different threads)
+    void store(AsteroidField& field, size_t begin, size_t end) const;
+
+    size_t size() const { return px.size(); }
+    glm::vec3 position(size_t i) const { return glm::vec3(px[i], py[i], pz[i]); }
+
+    // Time spent in the last step's tree build and force pass
+    double treeMs() const { return lastTreeMs; }
+    double forceMs() const { return lastForceMs; }
+
+    // Checks the tree's accelerations against direct summation and the energy
+    // drift of a small system, then times a step on ~count cluster bodies at
+    // each thread count up to the machine's (--nbody-bench). Returns false if
+    // the accelerations or the energy are off.
+    static bool benchmark(size_t count, uint64_t seed, float theta);
+
+private:
+    static const uint32_t LEAF_SIZE = 8;
+    static const int TOP_LEVELS = 3;          // 8^3 buckets built in parallel
+    static const int MAX_LEVEL = 21;          // bits per axis in a Morton code
+
+    struct Node {
+        glm::vec3 com;
+        float mass;
+        float size;         // cell edge length
+        uint32_t next;      // the node after this subtree
+        uint32_t first;     // leaf: first body
+        uint32_t count;     // leaf: bodies, 0 for an internal node (children follow it)
+    };
+
+    struct Keyed {
+        uint64_t key;
+        uint32_t body;
+    };
+
+    void buildTree(JobSystem* jobs);
+    void buildSubtree(std::vector<Node>& out, size_t begin, size_t end, int level) const;
+    uint32_t assemble(size_t bucketBegin, size_t bucketEnd, int level);
+    void aggregate(Node& node, const uint32_t* children, int childCount, const std::vector<Node>& pool) const;
+    void computeAccelerations(JobSystem* jobs);
+    glm::vec3 accelerationOf(size_t i) const;
+    glm::vec3 directAcceleration(size_t i) const;
+    double energy() const;
+
+    float theta = DEFAULT_THETA;
+    glm::vec3 attractor = glm::vec3(0.0f);
+    float attractorGM = 0.0f;
+
+    // Bodies, in Morton order as of the last tree build; slot[i] is the
+    // field index body i came from
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> ax, ay, az;
+    std::vector<float> mass;
+    std::vector<uint32_t> slot;
+
+    // Tree and its scratch (kept to save allocating every step)
+    std::vector<Node> nodes;
+    std::vector<Keyed> keyed;
+    std::vector<Keyed> sortedKeys;
+    std::vector<size_t> bucketStart;
+    std::vector<std::vector<Node>> subtrees;
+    std::vector<float> scratch;
+    std::vector<uint32_t> slotScratch;
+    float rootSize = 0.0f;
+
+    double lastTreeMs = 0.0;
+    double lastForceMs = 0.0;
+};
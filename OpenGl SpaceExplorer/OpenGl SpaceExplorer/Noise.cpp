@@ -0,0 +1,186 @@
+#include "Noise.h"
+#include "NoiseKernels.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+namespace Noise {
+
+namespace {
+
+const NoiseKernels::Table* sse2Table() {
+#if defined(SIMD_X86)
+    static const NoiseKernels::Table table = NoiseKernels::makeTable<SimdSse2>();
+    return &table;
+#else
+    return nullptr;
+#endif
+}
+
+struct Dispatch {
+    SimdLevel level;
+    const NoiseKernels::Table* table;
+};
+
+// Widest table at or below the requested level
+Dispatch pick(SimdLevel wanted) {
+    SimdLevel supported = detectSimdLevel();
+    if ((int)wanted > (int)supported) wanted = supported;
+
+    if (wanted == SimdLevel::AVX512 && NoiseKernels::avx512Table()) return { wanted, NoiseKernels::avx512Table() };
+    if ((int)wanted >= (int)SimdLevel::AVX2 && NoiseKernels::avx2Table()) return { SimdLevel::AVX2, NoiseKernels::avx2Table() };
+    if ((int)wanted >= (int)SimdLevel::SSE2 && sse2Table()) return { SimdLevel::SSE2, sse2Table() };
+    return { SimdLevel::Scalar, nullptr };
+}
+
+Dispatch& current() {
+    static Dispatch d = pick(SimdLevel::AVX512);
+    return d;
+}
+
+NoiseKernels::Params toParams(const FbmParams& p) {
+    NoiseKernels::Params k;
+    k.octaves = p.octaves;
+    k.lacunarity = p.lacunarity;
+    k.gain = p.gain;
+    k.seed = p.seed;
+    k.normalisation = ref::fbmNormalisation(p);
+    return k;
+}
+
+// fragment.glsl, transcribed as literally as possible (float sin, GLSL mix)
+float glslSmoothNoise(float uvx, float uvy) {
+    auto hash = [](float px, float py) {
+        float v = std::sin(px * 127.1f + py * 311.7f) * 43758.5453f;
+        return v - std::floor(v);
+    };
+    float ix = std::floor(uvx), iy = std::floor(uvy);
+    float fx = uvx - ix, fy = uvy - iy;
+
+    float a = hash(ix, iy);
+    float b = hash(ix + 1.0f, iy);
+    float c = hash(ix, iy + 1.0f);
+    float d = hash(ix + 1.0f, iy + 1.0f);
+
+    float ux = fx * fx * (3.0f - 2.0f * fx);
+    float uy = fy * fy * (3.0f - 2.0f * fy);
+    float ab = a * (1.0f - ux) + b * ux;
+    float cd = c * (1.0f - ux) + d * ux;
+    return ab * (1.0f - uy) + cd * uy;
+}
+
+} // namespace
+
+SimdLevel activeLevel() {
+    return current().level;
+}
+
+int batchWidth() {
+    return current().table ? current().table->width : 1;
+}
+
+void setLevel(SimdLevel level) {
+    current() = pick(level);
+}
+
+void smoothNoise(const float* x, const float* y, float* out, size_t n) {
+    const NoiseKernels::Table* t = current().table;
+    size_t i = t ? t->smoothNoise(x, y, out, n) : 0;
+    for (; i < n; ++i) out[i] = ref::smoothNoise(x[i], y[i]);
+}
+
+void gradient3D(const float* x, const float* y, const float* z, uint32_t seed, float* out, size_t n) {
+    const NoiseKernels::Table* t = current().table;
+    size_t i = t ? t->gradient3D(x, y, z, seed, out, n) : 0;
+    for (; i < n; ++i) out[i] = ref::gradient3D(x[i], y[i], z[i], seed);
+}
+
+void fbm3D(const float* x, const float* y, const float* z, const FbmParams& p, float* out, size_t n) {
+    const NoiseKernels::Table* t = current().table;
+    size_t i = t ? t->fbm3D(x, y, z, toParams(p), out, n) : 0;
+    for (; i < n; ++i) out[i] = ref::fbm3D(x[i], y[i], z[i], p);
+}
+
+void ridged3D(const float* x, const float* y, const float* z, const FbmParams& p, float* out, size_t n) {
+    const NoiseKernels::Table* t = current().table;
+    size_t i = t ? t->ridged3D(x, y, z, toParams(p), out, n) : 0;
+    for (; i < n; ++i) out[i] = ref::ridged3D(x[i], y[i], z[i], p);
+}
+
+bool selfTest() {
+    // Sample points spanning the ranges the planet shader feeds smoothNoise
+    // (tex coords * 2.5..7.5 plus noise offsets of up to +-10)
+    const size_t n = 4099; // deliberately not a multiple of any batch width
+    std::vector<float> xs(n), ys(n), zs(n);
+    uint32_t state = 0x2545F491u;
+    auto next01 = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return (float)(state >> 8) * (1.0f / 16777216.0f);
+    };
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = next01() * 60.0f - 30.0f;
+        ys[i] = next01() * 60.0f - 30.0f;
+        zs[i] = next01() * 60.0f - 30.0f;
+    }
+
+    bool ok = true;
+
+    // 1) Reference vs a literal transcription of fragment.glsl. The shader
+    //    uses float sin, so allow for its last-bit rounding being amplified by
+    //    the hash (a handful of samples may land on a different side of fract).
+    {
+        size_t outliers = 0;
+        float maxDiff = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            float diff = std::fabs(ref::smoothNoise(xs[i], ys[i]) - glslSmoothNoise(xs[i], ys[i]));
+            if (diff > 5e-3f) ++outliers;
+            else maxDiff = std::max(maxDiff, diff);
+        }
+        bool pass = outliers <= n / 1000;
+        std::cout << "Noise self-test: reference vs GLSL smoothNoise max diff " << maxDiff
+            << ", outliers " << outliers << "/" << n << (pass ? " OK" : " FAILED") << std::endl;
+        ok = ok && pass;
+    }
+
+    // 2) Every supported SIMD path vs the scalar reference (expected exact)
+    SimdLevel original = activeLevel();
+    SimdLevel levels[] = { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+    FbmParams fp;
+    fp.octaves = 4;
+    fp.seed = 1234u;
+
+    std::vector<float> simd(n);
+    for (SimdLevel level : levels) {
+        if ((int)level > (int)detectSimdLevel()) continue;
+        setLevel(level);
+        if (activeLevel() != level) continue;
+
+        float maxDiff = 0.0f;
+        auto compare = [&](float reference, float got) {
+            maxDiff = std::max(maxDiff, std::fabs(reference - got));
+        };
+
+        smoothNoise(xs.data(), ys.data(), simd.data(), n);
+        for (size_t i = 0; i < n; ++i) compare(ref::smoothNoise(xs[i], ys[i]), simd[i]);
+
+        gradient3D(xs.data(), ys.data(), zs.data(), 99u, simd.data(), n);
+        for (size_t i = 0; i < n; ++i) compare(ref::gradient3D(xs[i], ys[i], zs[i], 99u), simd[i]);
+
+        fbm3D(xs.data(), ys.data(), zs.data(), fp, simd.data(), n);
+        for (size_t i = 0; i < n; ++i) compare(ref::fbm3D(xs[i], ys[i], zs[i], fp), simd[i]);
+
+        ridged3D(xs.data(), ys.data(), zs.data(), fp, simd.data(), n);
+        for (size_t i = 0; i < n; ++i) compare(ref::ridged3D(xs[i], ys[i], zs[i], fp), simd[i]);
+
+        bool pass = maxDiff <= 1e-6f;
+        std::cout << "Noise self-test: " << simdLevelName(level) << " vs scalar max diff "
+            << maxDiff << (pass ? " OK" : " FAILED") << std::endl;
+        ok = ok && pass;
+    }
+
+    setLevel(original);
+    return ok;
+}
+
+} // namespace Noise
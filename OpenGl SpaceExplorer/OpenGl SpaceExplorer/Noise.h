@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include "SimdPack.h"
+
+// CPU-side procedural noise.
+//
+// Every function comes in two forms:
+//  - a scalar reference (Noise::ref), written to read like the GLSL it mirrors
+//  - a batched version that evaluates n samples at once with SSE2 / AVX2 /
+//    AVX-512 (4 / 8 / 16 lanes per step), picked at runtime for this CPU
+//
+// The batched kernels perform exactly the same float operations as the
+// references, so results are bit-identical whichever path runs.
+
+namespace Noise {
+
+struct FbmParams {
+    int octaves = 5;
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+    uint32_t seed = 0;
+};
+
+namespace ref {
+
+// GLSL mix(): x * (1 - a) + y * a
+inline float mixf(float x, float y, float a) {
+    return x * (1.0f - a) + y * a;
+}
+
+// fragment.glsl: fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453)
+// sin is evaluated in double and rounded, so every CPU path agrees exactly.
+inline float glslHash(float px, float py) {
+    float d = px * 127.1f + py * 311.7f;
+    float s = (float)std::sin((double)d);
+    float v = s * 43758.5453f;
+    return v - std::floor(v);
+}
+
+// fragment.glsl smoothNoise(uv): value noise with a smoothstep fade
+inline float smoothNoise(float x, float y) {
+    float ix = std::floor(x);
+    float iy = std::floor(y);
+    float fx = x - ix;
+    float fy = y - iy;
+
+    float a = glslHash(ix, iy);
+    float b = glslHash(ix + 1.0f, iy);
+    float c = glslHash(ix, iy + 1.0f);
+    float d = glslHash(ix + 1.0f, iy + 1.0f);
+
+    float ux = fx * fx * (3.0f - 2.0f * fx);
+    float uy = fy * fy * (3.0f - 2.0f * fy);
+    return mixf(mixf(a, b, ux), mixf(c, d, ux), uy);
+}
+
+// Integer lattice hash used by gradient noise
+inline uint32_t latticeHash(int32_t x, int32_t y, int32_t z, uint32_t seed) {
+    uint32_t h = (uint32_t)x * 0x8da6b343u;
+    h ^= (uint32_t)y * 0xd8163841u;
+    h ^= (uint32_t)z * 0xcb1ab31fu;
+    h ^= seed;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return h;
+}
+
+// Improved-Perlin gradient selection (12 cube edges, 16 entries)
+inline float grad(uint32_t h, float x, float y, float z) {
+    uint32_t g = h & 15u;
+    float u = (g < 8u) ? x : y;
+    float v = (g < 4u) ? y : ((g == 12u || g == 14u) ? x : z);
+    if (g & 1u) u = -u;
+    if (g & 2u) v = -v;
+    return u + v;
+}
+
+inline float lerpf(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+inline float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+// 3D gradient (Perlin) noise, roughly in [-1, 1]
+inline float gradient3D(float x, float y, float z, uint32_t seed) {
+    float fx0 = std::floor(x);
+    float fy0 = std::floor(y);
+    float fz0 = std::floor(z);
+    int32_t ix = (int32_t)fx0;
+    int32_t iy = (int32_t)fy0;
+    int32_t iz = (int32_t)fz0;
+    float fx = x - fx0;
+    float fy = y - fy0;
+    float fz = z - fz0;
+
+    float u = fade(fx);
+    float v = fade(fy);
+    float w = fade(fz);
+
+    float n000 = grad(latticeHash(ix, iy, iz, seed), fx, fy, fz);
+    float n100 = grad(latticeHash(ix + 1, iy, iz, seed), fx - 1.0f, fy, fz);
+    float n010 = grad(latticeHash(ix, iy + 1, iz, seed), fx, fy - 1.0f, fz);
+    float n110 = grad(latticeHash(ix + 1, iy + 1, iz, seed), fx - 1.0f, fy - 1.0f, fz);
+    float n001 = grad(latticeHash(ix, iy, iz + 1, seed), fx, fy, fz - 1.0f);
+    float n101 = grad(latticeHash(ix + 1, iy, iz + 1, seed), fx - 1.0f, fy, fz - 1.0f);
+    float n011 = grad(latticeHash(ix, iy + 1, iz + 1, seed), fx, fy - 1.0f, fz - 1.0f);
+    float n111 = grad(latticeHash(ix + 1, iy + 1, iz + 1, seed), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+
+    float x00 = lerpf(n000, n100, u);
+    float x10 = lerpf(n010, n110, u);
+    float x01 = lerpf(n001, n101, u);
+    float x11 = lerpf(n011, n111, u);
+    float y0 = lerpf(x00, x10, v);
+    float y1 = lerpf(x01, x11, v);
+    return lerpf(y0, y1, w);
+}
+
+// Sum of amplitudes, used to keep fBm in roughly [-1, 1]
+inline float fbmNormalisation(const FbmParams& p) {
+    float amp = 1.0f;
+    float total = 0.0f;
+    for (int o = 0; o < p.octaves; ++o) {
+        total += amp;
+        amp *= p.gain;
+    }
+    return total > 0.0f ? 1.0f / total : 0.0f;
+}
+
+// Fractal Brownian motion over gradient noise, roughly in [-1, 1]
+inline float fbm3D(float x, float y, float z, const FbmParams& p) {
+    float sum = 0.0f;
+    float amp = 1.0f;
+    float freq = 1.0f;
+    for (int o = 0; o < p.octaves; ++o) {
+        float n = gradient3D(x * freq, y * freq, z * freq, p.seed + (uint32_t)o);
+        sum = sum + n * amp;
+        freq *= p.lacunarity;
+        amp *= p.gain;
+    }
+    return sum * fbmNormalisation(p);
+}
+
+// Ridged multifractal: sharp crests where the noise crosses zero, in [0, 1]
+inline float ridged3D(float x, float y, float z, const FbmParams& p) {
+    float sum = 0.0f;
+    float amp = 1.0f;
+    float freq = 1.0f;
+    for (int o = 0; o < p.octaves; ++o) {
+        float n = gradient3D(x * freq, y * freq, z * freq, p.seed + (uint32_t)o);
+        float r = 1.0f - std::fabs(n);
+        sum = sum + r * r * amp;
+        freq *= p.lacunarity;
+        amp *= p.gain;
+    }
+    return sum * fbmNormalisation(p);
+}
+
+} // namespace ref
+
+// Instruction set the batched functions use on this machine
+SimdLevel activeLevel();
+int batchWidth();
+
+// Force a narrower path (e.g. to compare against the scalar reference)
+void setLevel(SimdLevel level);
+
+// Batched evaluation: out[i] = f(x[i], y[i] [, z[i]]) for i in [0, n)
+void smoothNoise(const float* x, const float* y, float* out, size_t n);
+void gradient3D(const float* x, const float* y, const float* z, uint32_t seed, float* out, size_t n);
+void fbm3D(const float* x, const float* y, const float* z, const FbmParams& p, float* out, size_t n);
+void ridged3D(const float* x, const float* y, const float* z, const FbmParams& p, float* out, size_t n);
+
+// Checks every available SIMD path against the scalar references (and the
+// references against a direct transcription of fragment.glsl). Prints a
+// summary and returns false on any mismatch beyond the tolerance.
+bool selfTest();
+
+} // namespace Noise
@@ -0,0 +1,42 @@
+// AVX2 instantiation of the noise kernels (8 lanes). Only reached through
+// Noise.cpp once detectSimdLevel() has confirmed AVX2 support.
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#endif
+
+#define SIMD_PACK_AVX2 1
+#include "SimdPack.h"
+#include "NoiseKernels.h"
+
+namespace NoiseKernels {
+
+const Table* avx2Table() {
+    static const Table table = makeTable<SimdAvx2>();
+    return &table;
+}
+
+} // namespace NoiseKernels
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+#include "NoiseKernels.h"
+
+namespace NoiseKernels {
+const Table* avx2Table() { return nullptr; }
+}
+
+#endif
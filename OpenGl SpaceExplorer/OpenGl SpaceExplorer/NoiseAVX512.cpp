@@ -0,0 +1,43 @@
+// AVX-512 instantiation of the noise kernels (16 lanes). Only reached through
+// Noise.cpp once detectSimdLevel() has confirmed AVX-512F support.
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC target("avx512f")
+// AVX-512F implies FMA; fused multiply-adds would break bit-exactness
+#pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#endif
+
+#define SIMD_PACK_AVX512 1
+#include "SimdPack.h"
+#include "NoiseKernels.h"
+
+namespace NoiseKernels {
+
+const Table* avx512Table() {
+    static const Table table = makeTable<SimdAvx512>();
+    return &table;
+}
+
+} // namespace NoiseKernels
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#else
+
+#include "NoiseKernels.h"
+
+namespace NoiseKernels {
+const Table* avx512Table() { return nullptr; }
+}
+
+#endif
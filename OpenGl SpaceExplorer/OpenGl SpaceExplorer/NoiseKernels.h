@@ -0,0 +1,210 @@
+#pragma once
+// Batched noise kernels, written once against the SimdPack interface and
+// instantiated per instruction set by Noise.cpp / NoiseAVX2.cpp /
+// NoiseAVX512.cpp. Each one mirrors the matching Noise::ref function operation
+// for operation; only whole batches are handled here, the caller finishes any
+// tail with the scalar reference.
+//
+// Deliberately includes no standard headers: in the AVX translation units
+// everything after this point is compiled for that instruction set.
+
+namespace NoiseKernels {
+
+struct Params {
+    int octaves;
+    float lacunarity;
+    float gain;
+    uint32_t seed;
+    float normalisation;
+};
+
+template <class K>
+typename K::F glslHash(typename K::F px, typename K::F py) {
+    typename K::F d = K::add(K::mul(px, K::set1(127.1f)), K::mul(py, K::set1(311.7f)));
+    typename K::F s = K::sinAccurate(d);
+    typename K::F v = K::mul(s, K::set1(43758.5453f));
+    return K::sub(v, K::floor(v));
+}
+
+template <class K>
+typename K::F mixf(typename K::F x, typename K::F y, typename K::F a) {
+    return K::add(K::mul(x, K::sub(K::set1(1.0f), a)), K::mul(y, a));
+}
+
+template <class K>
+typename K::F smoothNoise(typename K::F x, typename K::F y) {
+    typename K::F ix = K::floor(x);
+    typename K::F iy = K::floor(y);
+    typename K::F fx = K::sub(x, ix);
+    typename K::F fy = K::sub(y, iy);
+    typename K::F one = K::set1(1.0f);
+
+    typename K::F a = glslHash<K>(ix, iy);
+    typename K::F b = glslHash<K>(K::add(ix, one), iy);
+    typename K::F c = glslHash<K>(ix, K::add(iy, one));
+    typename K::F d = glslHash<K>(K::add(ix, one), K::add(iy, one));
+
+    typename K::F three = K::set1(3.0f);
+    typename K::F two = K::set1(2.0f);
+    typename K::F ux = K::mul(K::mul(fx, fx), K::sub(three, K::mul(two, fx)));
+    typename K::F uy = K::mul(K::mul(fy, fy), K::sub(three, K::mul(two, fy)));
+    return mixf<K>(mixf<K>(a, b, ux), mixf<K>(c, d, ux), uy);
+}
+
+template <class K>
+typename K::I latticeHash(typename K::I x, typename K::I y, typename K::I z, uint32_t seed) {
+    typename K::I h = K::imul(x, K::iset1(0x8da6b343u));
+    h = K::ixor(h, K::imul(y, K::iset1(0xd8163841u)));
+    h = K::ixor(h, K::imul(z, K::iset1(0xcb1ab31fu)));
+    h = K::ixor(h, K::iset1(seed));
+    h = K::ixor(h, K::template isrl<15>(h));
+    h = K::imul(h, K::iset1(0x2c1b3c6du));
+    h = K::ixor(h, K::template isrl<12>(h));
+    h = K::imul(h, K::iset1(0x297a2d39u));
+    h = K::ixor(h, K::template isrl<15>(h));
+    return h;
+}
+
+template <class K>
+typename K::F grad(typename K::I h, typename K::F x, typename K::F y, typename K::F z) {
+    typename K::I g = K::iand(h, K::iset1(15u));
+    typename K::F u = K::select(K::ilt(g, K::iset1(8u)), x, y);
+    typename K::M xMask = K::mor(K::ieq(g, K::iset1(12u)), K::ieq(g, K::iset1(14u)));
+    typename K::F v = K::select(K::ilt(g, K::iset1(4u)), y, K::select(xMask, x, z));
+
+    // Bit 0 negates u, bit 1 negates v (flip the IEEE sign bit)
+    u = K::xorBits(u, K::template isll<31>(K::iand(g, K::iset1(1u))));
+    v = K::xorBits(v, K::template isll<30>(K::iand(g, K::iset1(2u))));
+    return K::add(u, v);
+}
+
+template <class K>
+typename K::F lerpf(typename K::F a, typename K::F b, typename K::F t) {
+    return K::add(a, K::mul(t, K::sub(b, a)));
+}
+
+template <class K>
+typename K::F fade(typename K::F t) {
+    typename K::F inner = K::add(K::mul(t, K::sub(K::mul(t, K::set1(6.0f)), K::set1(15.0f))), K::set1(10.0f));
+    return K::mul(K::mul(K::mul(t, t), t), inner);
+}
+
+template <class K>
+typename K::F gradient3D(typename K::F x, typename K::F y, typename K::F z, uint32_t seed) {
+    typename K::F fx0 = K::floor(x);
+    typename K::F fy0 = K::floor(y);
+    typename K::F fz0 = K::floor(z);
+    typename K::I ix = K::toInt(fx0);
+    typename K::I iy = K::toInt(fy0);
+    typename K::I iz = K::toInt(fz0);
+    typename K::F fx = K::sub(x, fx0);
+    typename K::F fy = K::sub(y, fy0);
+    typename K::F fz = K::sub(z, fz0);
+
+    typename K::F u = fade<K>(fx);
+    typename K::F v = fade<K>(fy);
+    typename K::F w = fade<K>(fz);
+
+    typename K::I one = K::iset1(1u);
+    typename K::I ix1 = K::iadd(ix, one);
+    typename K::I iy1 = K::iadd(iy, one);
+    typename K::I iz1 = K::iadd(iz, one);
+    typename K::F fone = K::set1(1.0f);
+    typename K::F gx = K::sub(fx, fone);
+    typename K::F gy = K::sub(fy, fone);
+    typename K::F gz = K::sub(fz, fone);
+
+    typename K::F n000 = grad<K>(latticeHash<K>(ix, iy, iz, seed), fx, fy, fz);
+    typename K::F n100 = grad<K>(latticeHash<K>(ix1, iy, iz, seed), gx, fy, fz);
+    typename K::F n010 = grad<K>(latticeHash<K>(ix, iy1, iz, seed), fx, gy, fz);
+    typename K::F n110 = grad<K>(latticeHash<K>(ix1, iy1, iz, seed), gx, gy, fz);
+    typename K::F n001 = grad<K>(latticeHash<K>(ix, iy, iz1, seed), fx, fy, gz);
+    typename K::F n101 = grad<K>(latticeHash<K>(ix1, iy, iz1, seed), gx, fy, gz);
+    typename K::F n011 = grad<K>(latticeHash<K>(ix, iy1, iz1, seed), fx, gy, gz);
+    typename K::F n111 = grad<K>(latticeHash<K>(ix1, iy1, iz1, seed), gx, gy, gz);
+
+    typename K::F x00 = lerpf<K>(n000, n100, u);
+    typename K::F x10 = lerpf<K>(n010, n110, u);
+    typename K::F x01 = lerpf<K>(n001, n101, u);
+    typename K::F x11 = lerpf<K>(n011, n111, u);
+    typename K::F y0 = lerpf<K>(x00, x10, v);
+    typename K::F y1 = lerpf<K>(x01, x11, v);
+    return lerpf<K>(y0, y1, w);
+}
+
+// ridged = false: fBm, ridged = true: ridged multifractal
+template <class K, bool Ridged>
+typename K::F fractal3D(typename K::F x, typename K::F y, typename K::F z, const Params& p) {
+    typename K::F sum = K::set1(0.0f);
+    float amp = 1.0f;
+    float freq = 1.0f;
+    for (int o = 0; o < p.octaves; ++o) {
+        typename K::F f = K::set1(freq);
+        typename K::F n = gradient3D<K>(K::mul(x, f), K::mul(y, f), K::mul(z, f), p.seed + (uint32_t)o);
+        if (Ridged) {
+            typename K::F r = K::sub(K::set1(1.0f), K::abs(n));
+            sum = K::add(sum, K::mul(K::mul(r, r), K::set1(amp)));
+        }
+        else {
+            sum = K::add(sum, K::mul(n, K::set1(amp)));
+        }
+        freq *= p.lacunarity;
+        amp *= p.gain;
+    }
+    return K::mul(sum, K::set1(p.normalisation));
+}
+
+// Batch drivers: process floor(n / Width) * Width samples, return how many
+
+template <class K>
+size_t smoothNoiseBatch(const float* x, const float* y, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + K::Width <= n; i += K::Width) {
+        K::store(out + i, smoothNoise<K>(K::load(x + i), K::load(y + i)));
+    }
+    return i;
+}
+
+template <class K>
+size_t gradient3DBatch(const float* x, const float* y, const float* z, uint32_t seed, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + K::Width <= n; i += K::Width) {
+        K::store(out + i, gradient3D<K>(K::load(x + i), K::load(y + i), K::load(z + i), seed));
+    }
+    return i;
+}
+
+template <class K, bool Ridged>
+size_t fractal3DBatch(const float* x, const float* y, const float* z, const Params& p, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + K::Width <= n; i += K::Width) {
+        K::store(out + i, fractal3D<K, Ridged>(K::load(x + i), K::load(y + i), K::load(z + i), p));
+    }
+    return i;
+}
+
+// One entry per instruction set, filled in by the translation unit that owns it
+struct Table {
+    int width;
+    size_t (*smoothNoise)(const float*, const float*, float*, size_t);
+    size_t (*gradient3D)(const float*, const float*, const float*, uint32_t, float*, size_t);
+    size_t (*fbm3D)(const float*, const float*, const float*, const Params&, float*, size_t);
+    size_t (*ridged3D)(const float*, const float*, const float*, const Params&, float*, size_t);
+};
+
+template <class K>
+Table makeTable() {
+    Table t;
+    t.width = K::Width;
+    t.smoothNoise = &smoothNoiseBatch<K>;
+    t.gradient3D = &gradient3DBatch<K>;
+    t.fbm3D = &fractal3DBatch<K, false>;
+    t.ridged3D = &fractal3DBatch<K, true>;
+    return t;
+}
+
+// Defined in NoiseAVX2.cpp / NoiseAVX512.cpp (only called when supported)
+const Table* avx2Table();
+const Table* avx512Table();
+
+} // namespace NoiseKernels
@@ -6,6 +6,16 @@
 #include <ctime>
 #include <cmath>
 #include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <thread>
+#include <atomic>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -23,6 +33,28 @@
 #include "HUDRenderer.h"
 #include "GameState.h"
 #include "Texture.h"
+#include "SectorStreamer.h"
+#include "Noise.h"
+#include "PlanetBaker.h"
+#include "PlanetTerrain.h"
+#include "AsteroidField.h"
+#include "Orbits.h"
+#include "JobSystem.h"
+#include "RenderPacket.h"
+#include "EntityWorld.h"
+#include "SpatialGrid.h"
+#include "AabbTree.h"
+#include "Sweep.h"
+#include "TriangleBvh.h"
+#include "NBody.h"
+#include "Flock.h"
+#include "SimLod.h"
+#include "SessionLog.h"
+#include "Flythrough.h"
+#include "PerfGate.h"
+#include "RenderStats.h"
+#include "Components.h"
+#include "BodyQueries.h"
 
 // Assimp model wrapper for the probe models
 #include "ProbeModel.h"
@@ -45,7 +77,7 @@ static const char* biomeLabel(int t) {
 }
 
 // Forward declaration for render() (definition is later)
-void render(float deltaTime, const glm::mat4& view, const glm::mat4& projection);
+void render(const RenderPacket& packet);
 
 const int WINDOW_WIDTH = 1280;
 const int WINDOW_HEIGHT = 720;
@@ -62,12 +94,49 @@ bool g_firstMouse = true;
 std::unique_ptr<Shader> g_shader;      // main shader for planets/asteroids/probes
 std::unique_ptr<Shader> g_starShader;  // special shader for background stars
 std::unique_ptr<Shader> g_hudShader;   // 2D HUD shader
+std::unique_ptr<Shader> g_terrainShader; // CDLOD planet terrain (same fragment shader as planets)
+
+// Per-frame work (simulation tick, interpolation, render packet) runs as jobs here
+std::unique_ptr<JobSystem> g_jobs;
+
+// World seed (every procedural system is derived from this)
+uint64_t g_worldSeed = 0;
 
 // Procedural objects
 std::vector<Planet> g_planets;
-std::vector<Asteroid> g_asteroids;
+AsteroidField g_asteroidField;   // belt + cluster asteroids (SoA, SIMD orbit updates)
+
+// --nbody: cluster members move under Barnes-Hut gravity instead of closed-form
+// orbits (null otherwise). Steps are capped so high warp can't blow it up: past
+// that the clusters fall behind the world clock.
+bool g_nbodyClusters = false;
+float g_nbodyTheta = NBody::DEFAULT_THETA;
+const float NBODY_MAX_STEP = 10.0f / 60.0f;
+std::unique_ptr<NBody> g_clusterGravity;
 std::vector<Star> g_stars;
 
+// Planets, moons, probes and broken probes as entities (see Components.h).
+// g_planets keeps each planet's generated surface data; g_planetEntities[i]
+// is planet i's entity.
+EntityWorld g_world;
+std::vector<Entity> g_planetEntities;
+
+// Broad phase for collision, radar, jamming and targeting queries. Both grids
+// are rebuilt each tick once things have moved; body grid ids index
+// g_bodyGridEntities, asteroid grid ids are asteroid indices.
+SpatialGrid g_bodyGrid(64.0f);
+std::vector<Entity> g_bodyGridEntities;
+SpatialGrid g_asteroidGrid(50.0f);
+
+// Planet surfaces baked into cubemaps at generation time (--no-bake keeps
+// the per-fragment procedural shader instead)
+const int PLANET_SURFACE_FACE_SIZE = 256;
+bool g_bakePlanetSurfaces = true;
+std::vector<GLuint> g_planetSurfaceMaps;
+
+// Quadtree terrain that replaces the planet sphere on close approach
+std::unique_ptr<PlanetTerrain> g_planetTerrain;
+
 // Textyre for asteroids/moons
 std::unique_ptr<Texture> g_asteroidTexture;
 std::unique_ptr<Texture> g_moonTexture;
@@ -76,6 +145,10 @@ std::unique_ptr<Texture> g_moonTexture;
 // Main star in the scene
 Sun g_sun{ glm::vec3(0.f), 25.f };
 
+// Neighbouring star systems, streamed in around the camera
+std::unique_ptr<SectorStreamer> g_sectorStreamer;
+std::vector<const StarSystem*> g_visibleSystems;
+
 // Basic meshes (generated at runtime)
 Mesh* g_sphereMesh = nullptr;
 Mesh* g_cubeMesh = nullptr;
@@ -84,6 +157,20 @@ Mesh* g_cubeMesh = nullptr;
 StarRenderer* g_starRenderer = nullptr;
 HUDRenderer* g_hudRenderer = nullptr;
 
+// ---------------------------
+// Render thread
+// ---------------------------
+
+// The render thread owns the GL context while the game runs and only ever
+// reads render packets; the main thread simulates, polls input and builds the
+// next packet meanwhile.
+RenderPacketQueue g_renderPackets;
+uint64_t g_frameNumber = 0;
+
+// Latest framebuffer size (set by the resize callback, applied by the render thread)
+int g_framebufferWidth = WINDOW_WIDTH;
+int g_framebufferHeight = WINDOW_HEIGHT;
+
 // ---------------------------
 // Gameplay state (scanning / score / completion)
 // ---------------------------
@@ -93,72 +180,157 @@ std::unique_ptr<GameState> g_gameState;
 static float g_radarAngle = 0.0f;
 static float g_pulseTime = 0.0f;
 
+// Radar scan results, reused every frame
+static std::vector<uint32_t> g_radarHits;
+static std::vector<glm::vec3> g_radarContacts;
+
 // Assimp probe models (normal probe and broken probe)
 std::unique_ptr<ProbeModel> g_probeModel;
 std::unique_ptr<ProbeModel> g_brokenProbeModel;
 
-// A single “broken probe” placed in space
-struct BrokenProbeInstance {
-    glm::vec3 pos;
-    float scale;
+// Probes near a planet jam scanning within this range of it
+const float PROBE_JAM_RANGE = 18.0f;
+
+// Probes fly as a flock (see Flock.h), each patrolling a planet. While the
+// player is this close to the planet they're surveying, probes patrolling
+// within this range of it converge on it.
+const float PROBE_ALERT_RANGE = 150.0f;
+const float PROBE_CLEARANCE = 3.0f;   // kept from the sun, planets and asteroids
+Flock g_flock;
+std::vector<Entity> g_flockEntities;   // flock agent i is this entity
+static std::vector<uint32_t> g_probeObstacles;   // asteroids near any probe this tick
+
+// ---------------------------
+// Fixed-step simulation
+// ---------------------------
+
+// All state updates run at a fixed rate; rendering interpolates between the
+// last two ticks so motion stays smooth whatever the frame rate. Orbits are
+// closed-form in the absolute time, so only the player is actually stepped.
+// The player's move is swept (see Sweep.h), so a long tick can't carry it
+// through anything and the rate only has to be high enough for input.
+const float SIM_DT = 1.0f / 60.0f;
+const float MAX_FRAME_TIME = 0.25f;   // longer frames (hitches) are clamped, not caught up
+
+uint64_t g_simTick = 0;   // world ticks (advances by the time warp each tick)
+double g_simTime = 0.0;   // g_simTick * SIM_DT
+
+// Time warp: each tick moves the world on by this many ticks while the player
+// still flies in real time. Orbits are closed-form and the asteroid field is
+// evaluated directly at a tick, so a warped tick costs the same as a normal one.
+const uint32_t TIME_WARP_LEVELS[] = { 1, 10, 100, 1000, 10000, 100000 };
+const int TIME_WARP_LEVEL_COUNT = sizeof(TIME_WARP_LEVELS) / sizeof(TIME_WARP_LEVELS[0]);
+int g_timeWarpLevel = 0;
+
+uint32_t timeWarp() {
+    return TIME_WARP_LEVELS[g_timeWarpLevel];
+}
+
+// Far and out-of-view things only update every few ticks (see SimLod.h;
+// --no-sim-lod turns it off). g_asteroidPeriods[i] is asteroid i's period.
+SimLod g_simLod(SIM_DT);
+std::vector<uint8_t> g_asteroidPeriods;
+
+// A session being recorded (--record FILE) or replayed (--replay FILE); see
+// SessionLog.h. A replay drives the frame times, the camera's orientation,
+// the time warp and every tick's keys, and live input is ignored.
+std::unique_ptr<SessionLog::Recorder> g_recorder;
+std::unique_ptr<SessionLog::Replay> g_replay;
+
+// The world the self-tests, benches, flythrough and perf gate run on, unless
+// a seed is given
+const uint64_t BENCHMARK_SEED = 1;
+
+// The benchmark flight (--flythrough [FILE]): one tick a frame along a
+// spline, no vsync, and live input ignored
+const double FLYTHROUGH_SPEED = 250.0;       // units a second
+const double FLYTHROUGH_LOOK_AHEAD = 0.5;    // seconds of path the camera faces towards
+std::unique_ptr<Flythrough> g_flythrough;
+
+// A drawable entity as of one tick
+struct BodyState {
+    Entity entity;
+    RenderModel model = RenderModel::Planet;
+    int index = -1;               // Renderable::index
+    glm::vec3 position = glm::vec3(0.0f);
+    float spin = 0.0f;            // degrees
+    float scale = 1.0f;
 };
 
-// Many broken probes scattered in the world
-std::vector<BrokenProbeInstance> g_brokenProbes;
-
-// Probe that orbits a specific planet (used for scan jamming)
-struct ProbeEntity {
-    int planetIndex = -1;        // which planet this probe belongs to
-    float orbitRadius = 0.0f;    // distance from planet centre
-    float orbitSpeed = 0.0f;     // radians per second
-    float orbitAngle = 0.0f;     // current orbit angle
-    float yOffset = 0.0f;        // small vertical offset to avoid all probes being flat
-    glm::vec3 pos = glm::vec3(0.0f);
+// Where everything that moves is, captured after each tick
+struct WorldSnapshot {
+    uint64_t tick = 0;
+    double time = 0.0;
+    glm::dvec3 cameraPos = glm::dvec3(0.0);
+    std::vector<BodyState> bodies;       // every Renderable entity, in query order
+    std::vector<glm::vec3> asteroidPos;
 };
 
-std::vector<ProbeEntity> g_probes;
+WorldSnapshot g_prevSnapshot;
+WorldSnapshot g_currSnapshot;
+WorldSnapshot g_renderSnapshot;   // interpolated; render packets are built from it
 
 // ---------------------------
 // Collision helpers
 // ---------------------------
 
-// Basic sphere-sphere collision test
-bool checkSphereCollision(
-    const glm::vec3& aPos, float aRadius,
-    const glm::vec3& bPos, float bRadius)
-{
-    return glm::length(aPos - bPos) < (aRadius + bRadius);
+const float PLAYER_RADIUS = 2.0f;
+
+// Planet orbit at simulation time t as a world position
+glm::vec3 getPlanetWorldPosition(const Planet& planet, double t) {
+    return g_sun.pos + Orbits::planetOffset(planet, t);
 }
 
-// Convert planet orbit parameters into a world position (in XZ plane)
-glm::vec3 getPlanetWorldPosition(const Planet& planet) {
-    float x = g_sun.pos.x + cos(planet.angle) * planet.distance;
-    float z = g_sun.pos.z + sin(planet.angle) * planet.distance;
-    return glm::vec3(x, 0.0f, z);
+// The player's position in the home system. Everything simulated there (its
+// bodies, asteroids and grids) stays within a few thousand units of the
+// origin, where a float is good to well under a millimetre; only the camera
+// and the streamed sectors, which go on for ever, are kept in doubles.
+glm::vec3 playerPosition() {
+    return glm::vec3(g_camera->Position);
 }
 
-// Finds the closest planet that has not been scanned yet
-int findNearestUnscannedPlanet(const glm::vec3& playerPos) {
-    float bestDist = FLT_MAX;
-    int bestIndex = -1;
+// The camera's perspective projection
+glm::mat4 cameraProjection() {
+    return glm::perspective(
+        glm::radians(60.0f),
+        (float)WINDOW_WIDTH / WINDOW_HEIGHT,
+        0.1f,
+        50000.0f
+    );
+}
 
-    for (int i = 0; i < (int)g_planets.size(); ++i) {
-        if (g_planets[i].scanned) continue;
+// Camera-relative rendering: render packets position everything relative to
+// the camera, subtracted in double precision, and their view matrix only
+// rotates. What's near the camera then has small coordinates on the GPU
+// however far from the origin it is, so float matrices and shaders lose
+// nothing there (a million units out, a float world position is only good
+// to 0.06 units, and a close-up model would shake).
+glm::vec3 offsetFrom(const glm::dvec3& position, const glm::dvec3& origin) {
+    return glm::vec3(position - origin);
+}
 
-        glm::vec3 pos = getPlanetWorldPosition(g_planets[i]);
-        float d = glm::distance(playerPos, pos);
+glm::vec3 offsetFrom(const glm::vec3& position, const glm::dvec3& origin) {
+    return offsetFrom(glm::dvec3(position), origin);
+}
 
-        if (d < bestDist) {
-            bestDist = d;
-            bestIndex = i;
-        }
-    }
-    return bestIndex;
+// Position + spin, without the scale (terrain chunks are in world units)
+glm::mat4 getBodyFrame(const glm::vec3& position, float spin) {
+    glm::mat4 frame = glm::translate(glm::mat4(1.0f), position);
+    return glm::rotate(frame, glm::radians(spin), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+bool isPlanetScanned(int planet) {
+    return g_world.get<Scannable>(g_planetEntities[planet]).scanned;
+}
+
+// Finds the closest planet that has not been scanned yet
+int findNearestUnscannedPlanet(const glm::vec3& playerPos) {
+    return nearestUnscannedPlanet(g_world, g_bodyGrid, g_bodyGridEntities, playerPos);
 }
 
 // Checks if the cameara is aiming within aimDegrees of the target
 bool isLookingAtTarget(const glm::vec3& targetPos, float aimDegrees) {
-    glm::vec3 toTarget = glm::normalize(targetPos - g_camera->Position);
+    glm::vec3 toTarget = glm::normalize(targetPos - playerPosition());
     glm::vec3 forward = glm::normalize(g_camera->Front);
 
     float cosThreshold = cos(glm::radians(aimDegrees));
@@ -176,9 +348,42 @@ static int rollProbeCount() {
     return 3;
 }
 
-// Spawn orbiting probes around some planets (these can jam scanning)
+// Planets (with their moons) as entities, at the current simulation time
+static void spawnBodies() {
+    g_world.clear();
+    g_planetEntities.clear();
+
+    for (int i = 0; i < (int)g_planets.size(); ++i) {
+        const Planet& planet = g_planets[i];
+
+        Orbit orbit = Orbits::planetOrbit(planet, g_sun.pos);
+        Transform transform{ Orbits::position(g_world, orbit, g_simTime), Orbits::spin(orbit, g_simTime), planet.size };
+        Entity entity = g_world.create(transform, orbit, Collider{ planet.collisionRadius },
+            Renderable{ RenderModel::Planet, i }, Scannable{ i, false });
+        g_planetEntities.push_back(entity);
+
+        for (const auto& moon : planet.moons) {
+            Orbit moonOrbit = Orbits::circleOrbit(entity, moon.distance, moon.speed, moon.angle, 0.0f);
+            g_world.create(Transform{ Orbits::position(g_world, moonOrbit, g_simTime), 0.0f, moon.size },
+                moonOrbit, Renderable{ RenderModel::Moon, -1 });
+        }
+    }
+}
+
+// Gives an entity exact collision against a model's triangles (nothing if
+// the model isn't loaded, as in the headless benchmarks)
+static void addMeshCollider(Entity entity, const std::unique_ptr<ProbeModel>& model, float scale) {
+    if (!model || !model->loaded()) return;
+    const TriangleBvh& mesh = model->collisionMesh();
+    g_world.add(entity, MeshCollider{ &mesh, mesh.boundingRadius() * scale });
+}
+
+// Spawn patrolling probes around some planets (these can jam scanning)
 static void spawnProbesForPlanets() {
-    g_probes.clear();
+    // Any probes from the last run go first
+    std::vector<Entity> old;
+    g_world.each<const Jammer>([&](Entity entity, const Jammer&) { old.push_back(entity); });
+    for (Entity entity : old) g_world.destroy(entity);
 
     for (int i = 0; i < (int)g_planets.size(); ++i) {
         const Planet& planet = g_planets[i];
@@ -189,35 +394,31 @@ static void spawnProbesForPlanets() {
         int count = rollProbeCount();
 
         for (int k = 0; k < count; ++k) {
-            ProbeEntity p;
-            p.planetIndex = i;
-
-            // Orbit a bit outside the planet collision radius so it doesn't clip
-            float base = planet.collisionRadius + 6.0f;
-            p.orbitRadius = base + randf(2.0f, 12.0f);
-            p.orbitSpeed = randf(0.4f, 1.2f);
-            p.orbitAngle = randf(0.0f, glm::two_pi<float>());
-            p.yOffset = randf(-2.0f, 2.0f);
-
-            // Convert orbit values into an initial position
-            glm::vec3 center = getPlanetWorldPosition(planet);
-            p.pos = center + glm::vec3(
-                cos(p.orbitAngle) * p.orbitRadius,
-                p.yOffset,
-                sin(p.orbitAngle) * p.orbitRadius
-            );
-
-            g_probes.push_back(p);
+            // Patrol a bit outside the planet collision radius so it doesn't clip
+            Boid boid;
+            boid.home = boid.goal = g_planetEntities[i];
+            boid.anchor = g_world.get<Transform>(boid.home).position;
+            boid.gap = 6.0f + randf(2.0f, 12.0f);
+            boid.turn = rand01() < 0.5f ? 1.0f : -1.0f;
+            boid.steered = g_simLod.tick();
+            float angle = randf(0.0f, glm::two_pi<float>());
+            boid.height = randf(-2.0f, 2.0f);   // small offset so the probes aren't all flat
+
+            glm::vec3 out(std::cos(angle), 0.0f, std::sin(angle));
+            glm::vec3 position = boid.anchor + out * (planet.collisionRadius + boid.gap) + glm::vec3(0.0f, boid.height, 0.0f);
+            boid.velocity = glm::vec3(out.z, 0.0f, -out.x) * (boid.turn * Flock::CRUISE_SPEED);
+            Entity probe = g_world.create(Transform{ position, 0.0f, 2.0f }, boid,
+                Renderable{ RenderModel::Probe, -1 }, Jammer{ PROBE_JAM_RANGE });
+            addMeshCollider(probe, g_probeModel, 2.0f);
         }
     }
 
-    std::cout << "Spawned probes: " << g_probes.size() << std::endl;
+    std::cout << "Spawned probes: " << g_world.count<Jammer>() << std::endl;
 }
 
 // Scatter “broken probes” in the scene (static decoration)
 static void spawnBrokenProbes()
 {
-    g_brokenProbes.clear();
 
     // Random amount each run
     int count = 5 + rand() % 12;
@@ -231,43 +432,24 @@ static void spawnBrokenProbes()
         float dist = randf(minDist, maxDist);
         float height = randf(-15.0f, 15.0f);
 
-        BrokenProbeInstance bp;
-        bp.pos = glm::vec3(
+        glm::vec3 pos = glm::vec3(
             cos(angle) * dist,
             height,
             sin(angle) * dist
         );
-        bp.scale = randf(1.5f, 3.5f);
+        float scale = randf(1.5f, 3.5f);
 
-        g_brokenProbes.push_back(bp);
+        Entity probe = g_world.create(Transform{ pos, 0.0f, scale }, Renderable{ RenderModel::BrokenProbe, -1 });
+        addMeshCollider(probe, g_brokenProbeModel, scale);
     }
 
-    std::cout << "Spawned broken probes: " << g_brokenProbes.size() << std::endl;
-}
-
-// Update orbiting probes each frame (simple circular motion)
-static void updateProbes(float dt) {
-    for (auto& p : g_probes) {
-        if (p.planetIndex < 0 || p.planetIndex >= (int)g_planets.size()) continue;
-
-        p.orbitAngle += p.orbitSpeed * dt;
-        if (p.orbitAngle > glm::two_pi<float>())
-            p.orbitAngle -= glm::two_pi<float>();
-
-        glm::vec3 center = getPlanetWorldPosition(g_planets[p.planetIndex]);
-
-        p.pos = center + glm::vec3(
-            cos(p.orbitAngle) * p.orbitRadius,
-            p.yOffset,
-            sin(p.orbitAngle) * p.orbitRadius
-        );
-    }
+    std::cout << "Spawned broken probes: " << count << std::endl;
 }
 
 // Render orbiting probes (reuses the main shader but sets neutral values)
-static void renderProbes() {
+static void renderProbes(const RenderPacket& packet) {
     if (!g_probeModel || !g_probeModel->loaded()) return;
-    if (g_probes.empty()) return;
+    if (packet.probes.empty()) return;
 
     g_shader->Use();
 
@@ -283,10 +465,7 @@ static void renderProbes() {
     g_shader->SetInt("planetType", 0);
     g_shader->SetFloat("surfaceNoise", 0.0f);
 
-    for (const auto& p : g_probes) {
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), p.pos);
-        model = glm::scale(model, glm::vec3(2.0f));
-
+    for (const glm::mat4& model : packet.probes) {
         g_shader->SetMat4("model", model);
         g_probeModel->draw();
     }
@@ -296,20 +475,17 @@ static void renderProbes() {
 }
 
 // Render broken probes (static objects)
-static void renderBrokenProbes()
+static void renderBrokenProbes(const RenderPacket& packet)
 {
     if (!g_brokenProbeModel || !g_brokenProbeModel->loaded()) return;
-    if (g_brokenProbes.empty()) return;
+    if (packet.brokenProbes.empty()) return;
 
     g_shader->Use();
 
     g_shader->SetVec3("baseColor", glm::vec3(0.6f, 0.6f, 0.65f));
     g_shader->SetFloat("isEmissive", 0.0f);
 
-    for (const auto& bp : g_brokenProbes) {
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), bp.pos);
-        model = glm::scale(model, glm::vec3(bp.scale));
-
+    for (const glm::mat4& model : packet.brokenProbes) {
         g_shader->SetMat4("model", model);
         g_brokenProbeModel->draw();
     }
@@ -342,6 +518,7 @@ void GLAPIENTRY glDebugOutput(GLenum source, GLenum type, GLuint id, GLenum seve
 
 // Mouse move => update camera look direction
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+    if (g_replay || g_flythrough) return;
     try {
         if (g_firstMouse) {
             g_lastX = (float)xpos;
@@ -362,16 +539,25 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     }
 }
 
-// Window resize => update viewport so rendering scales correctly
+// Window resize => update viewport so rendering scales correctly (the render
+// thread applies it with the next packet, it's the one with the GL context)
 void framebuffer_size_callback(GLFWwindow* window, int w, int h) {
-    glViewport(0, 0, w, h);
+    g_framebufferWidth = w;
+    g_framebufferHeight = h;
 }
 
-// Basic key handler (escape to quit)
+// Basic key handler (escape to quit, . and , to speed time up / slow it down)
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
+    if (g_replay || g_flythrough) return;
+    if (key == GLFW_KEY_PERIOD && action == GLFW_PRESS && g_timeWarpLevel + 1 < TIME_WARP_LEVEL_COUNT) {
+        ++g_timeWarpLevel;
+    }
+    if (key == GLFW_KEY_COMMA && action == GLFW_PRESS && g_timeWarpLevel > 0) {
+        --g_timeWarpLevel;
+    }
 }
 
 // Initialization functions
@@ -435,6 +621,9 @@ void initializeOpenGL() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    // Filter across cube faces so baked planet surfaces have no visible edges
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
     // Dark space background
     glClearColor(0.0f, 0.0f, 0.02f, 1.0f);
 
@@ -445,8 +634,20 @@ void initializeOpenGL() {
 void initializeShaders() {
     try {
         g_shader = std::make_unique<Shader>("vertex.glsl", "fragment.glsl");
+
+        // Baked planet cubemaps live on unit 1 so they never share a unit with diffuseMap
+        g_shader->Use();
+        g_shader->SetInt("surfaceMap", 1);
+        g_shader->SetFloat("useBakedSurface", 0.0f);
+
         g_starShader = std::make_unique<Shader>("star_vertex.glsl", "star_fragment.glsl");
         g_hudShader = std::make_unique<Shader>("hud_vertex.glsl", "hud_fragment.glsl");
+
+        g_terrainShader = std::make_unique<Shader>("terrain_vertex.glsl", "fragment.glsl");
+        g_terrainShader->Use();
+        g_terrainShader->SetInt("surfaceMap", 1);
+        g_terrainShader->SetFloat("isEmissive", 0.0f);
+        g_terrainShader->SetFloat("isAsteroid", 0.0f);
         std::cout << "Shaders loaded successfully" << std::endl;
     }
     catch (const std::exception& e) {
@@ -472,34 +673,66 @@ void initializeGeometry() {
     }
 }
 
+// Hands the cluster members over to the N-body simulation (--nbody), starting
+// from where the field has them
+void buildClusterGravity(const std::vector<Asteroid>& asteroids) {
+    g_clusterGravity.reset();
+    if (!g_nbodyClusters) return;
+    g_clusterGravity = std::make_unique<NBody>();
+    g_clusterGravity->setTheta(g_nbodyTheta);
+    g_clusterGravity->build(asteroids, g_asteroidField, g_sun.pos, NBody::SUN_GM, g_jobs.get());
+}
+
 // Generates all procedural content and loads models/textures
 void initializeScene() {
     try {
-        // Seed randomness so each run is different
-        srand((unsigned)time(0));
+        // Remaining rand() users (probe spawning) also follow the world seed
+        srand((unsigned)g_worldSeed);
 
         // Procedural generation (planets, asteroids, stars, clusters)
-        PlanetGenerator::generatePlanets(g_planets, 600.0f);
-        PlanetGenerator::generateAsteroids(g_asteroids, 120);
-        PlanetGenerator::generateStars(g_stars, 2000);
-        PlanetGenerator::generateAsteroidClusters(g_asteroids, 4, 25, 55, 300.0f, 1400.0f);
-
-        // Give each planet a random noise offset so surfaces look different
-        for (auto& planet : g_planets) {
-            planet.noiseOffset = glm::vec3(
-                randf(-1000.0f, 1000.0f),
-                randf(-1000.0f, 1000.0f),
-                randf(-1000.0f, 1000.0f)
-            );
+        auto genStart = std::chrono::steady_clock::now();
+
+        std::vector<Asteroid> asteroids;
+        PlanetGenerator::generatePlanets(g_planets, g_worldSeed);
+        PlanetGenerator::generateAsteroids(asteroids, g_worldSeed, 120);
+        PlanetGenerator::generateStars(g_stars, g_worldSeed, 2000);
+        PlanetGenerator::generateAsteroidClusters(asteroids, g_worldSeed, 4, 25, 55, 300.0f, 1400.0f);
+        g_asteroidField.build(asteroids, SIM_DT);
+        buildClusterGravity(asteroids);
+        if (g_clusterGravity) {
+            std::cout << "N-body clusters: " << g_clusterGravity->size() << " bodies, theta "
+                << g_clusterGravity->openingAngle() << std::endl;
         }
 
-        // Star renderer uses positions only (cheap GPU instancing style draw)
-        g_starRenderer = new StarRenderer();
-        std::vector<glm::vec3> starPositions;
-        for (const auto& star : g_stars) {
-            starPositions.push_back(star.pos);
+        double genMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - genStart).count();
+        std::cout << "Generation took " << genMs << " ms on "
+            << parallelThreadCount() << " threads" << std::endl;
+
+        if (g_bakePlanetSurfaces) {
+            auto bakeStart = std::chrono::steady_clock::now();
+
+            std::vector<PlanetSurfaceBake> bakes;
+            PlanetBaker::bakeSurfaces(g_planets, PLANET_SURFACE_FACE_SIZE, bakes);
+            for (const auto& bake : bakes) {
+                g_planetSurfaceMaps.push_back(PlanetBaker::uploadCubemap(bake));
+            }
+
+            double bakeMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - bakeStart).count();
+            std::cout << "Baked " << bakes.size() << " planet surfaces (" << PLANET_SURFACE_FACE_SIZE
+                << "px faces, " << simdLevelName(Noise::activeLevel()) << ") in " << bakeMs << " ms" << std::endl;
         }
-        g_starRenderer->loadStars(starPositions);
+
+        // Terrain chunks are built on demand as the camera approaches a planet
+        g_planetTerrain = std::make_unique<PlanetTerrain>(g_planets);
+
+        // Everything beyond the home system is streamed in sector by sector
+        g_sectorStreamer = std::make_unique<SectorStreamer>(g_worldSeed);
+
+        // Star renderer draws the whole starfield as one point list
+        g_starRenderer = new StarRenderer();
+        g_starRenderer->loadStars(g_stars);
 
         // HUD + gameplay state
         g_hudRenderer = new HUDRenderer();
@@ -519,12 +752,13 @@ void initializeScene() {
         g_brokenProbeModel = std::make_unique<ProbeModel>("assets/models/probe/Brokenprobe.obj");
 
         // Spawn decorative + gameplay objects
+        spawnBodies();
         spawnBrokenProbes();
         spawnProbesForPlanets();
 
         std::cout << "Scene generated: "
             << g_planets.size() << " planets, "
-            << g_asteroids.size() << " asteroids, "
+            << g_asteroidField.size() << " asteroids, "
             << g_stars.size() << " stars\n";
     }
     catch (const std::exception& e) {
@@ -552,15 +786,16 @@ void renderStars(const glm::mat4& view, const glm::mat4& projection) {
     g_starRenderer->render();
 }
 
-// Draw sun + simple glow by blending a bigger sphere
-void renderSun() {
+// Draw sun + simple glow by blending a bigger sphere (the home sun is the
+// packet's light)
+void renderSun(const RenderPacket& packet) {
     if (!g_sphereMesh) return;
 
     g_shader->Use();
     g_shader->SetFloat("surfaceNoise", 0.0f);
 
     // Core sphere
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), g_sun.pos);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), packet.lightPos);
     model = glm::scale(model, glm::vec3(g_sun.radius));
 
     g_shader->SetMat4("model", model);
@@ -572,7 +807,7 @@ void renderSun() {
     // Glow pass using additive blending
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 
-    glm::mat4 glowModel = glm::translate(glm::mat4(1.0f), g_sun.pos);
+    glm::mat4 glowModel = glm::translate(glm::mat4(1.0f), packet.lightPos);
     glowModel = glm::scale(glowModel, glm::vec3(g_sun.radius * 1.6f));
 
     g_shader->SetMat4("model", glowModel);
@@ -585,99 +820,116 @@ void renderSun() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
-// Draw planets, update their orbit + rotation, and apply scan highlight if targeted
-void renderPlanets(float deltaTime) {
+// Draw the streamed-in neighbouring systems (sun + planets, lit by their own sun)
+void renderSectors(const RenderPacket& packet) {
+    if (!g_sphereMesh || packet.sectorSuns.empty()) return;
+
     g_shader->Use();
+    g_shader->SetFloat("surfaceNoise", 0.0f);
     g_shader->SetFloat("scanHighlight", 0.0f);
+    g_shader->SetFloat("isAsteroid", 0.0f);
 
-    for (int i = 0; i < (int)g_planets.size(); ++i) {
-        Planet& planet = g_planets[i];
-
-        // Orbit around the sun
-        planet.angle += planet.speed * deltaTime;
-        if (planet.angle > glm::two_pi<float>())
-            planet.angle -= glm::two_pi<float>();
+    for (const SectorSunDraw& sun : packet.sectorSuns) {
+        // Sun
+        g_shader->SetMat4("model", sun.model);
+        g_shader->SetVec3("baseColor", sun.color);
+        g_shader->SetFloat("isEmissive", 1.0f);
+        g_sphereMesh->Draw();
 
-        float x = g_sun.pos.x + cos(planet.angle) * planet.distance;
-        float z = g_sun.pos.z + sin(planet.angle) * planet.distance;
-        glm::vec3 planetPos = glm::vec3(x, 0.0f, z);
+        // Planets are lit by this system's sun, not ours
+        g_shader->SetFloat("isEmissive", 0.0f);
+        g_shader->SetVec3("lightPos", sun.lightPos);
 
-        // Spin planet around its axis
-        planet.rotationAngle += planet.rotationSpeed * deltaTime;
-        if (planet.rotationAngle > 360.0f)
-            planet.rotationAngle -= 360.0f;
+        for (size_t p = sun.firstPlanet; p < sun.firstPlanet + sun.planetCount; ++p) {
+            const SectorPlanetDraw& planet = packet.sectorPlanets[p];
 
-        // Model transform: translate -> rotate -> scale
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), planetPos);
-        model = glm::rotate(model, glm::radians(planet.rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(planet.size));
+            g_shader->SetMat4("model", planet.model);
+            g_shader->SetVec3("noiseOffset", planet.noiseOffset);
+            g_shader->SetFloat("planetSeed", planet.seed);
+            g_shader->SetInt("planetType", planet.biomeType);
+            g_shader->SetVec3("baseColor", planet.color);
+            g_sphereMesh->Draw();
+        }
+    }
 
-        g_shader->Use();
-        g_shader->SetMat4("model", model);
+    // Back to the home sun for everything else
+    g_shader->SetVec3("lightPos", packet.lightPos);
+}
 
-        // Planet surface noise setup
-        g_shader->SetVec3("noiseOffset", planet.noiseOffset);
-        g_shader->SetFloat("planetSeed", (float)planet.seed);
-        g_shader->SetInt("planetType", planet.biomeType);
+// Draw one planet's CDLOD terrain with the same surface uniforms as its sphere
+// (its frame is relative to the camera, so the camera is at the origin)
+bool renderPlanetTerrain(const PlanetDraw& planet, bool baked) {
+    g_terrainShader->Use();
+    g_terrainShader->SetVec3("noiseOffset", planet.noiseOffset);
+    g_terrainShader->SetFloat("planetSeed", planet.seed);
+    g_terrainShader->SetInt("planetType", planet.biomeType);
+    g_terrainShader->SetVec3("baseColor", planet.color);
+    g_terrainShader->SetFloat("scanHighlight", planet.highlight);
+    g_terrainShader->SetFloat("useBakedSurface", baked ? 1.0f : 0.0f);
 
-        int slice = planet.seed % (int)planet.surfaceVariation.size();
-        float variation = planet.surfaceVariation[slice];
+    bool drawn = g_planetTerrain->draw(planet.index, planet.frame, glm::vec3(0.0f), *g_terrainShader);
 
-        g_shader->SetFloat("surfaceNoise", variation);
+    g_shader->Use();
+    return drawn;
+}
 
-        glm::vec3 surfaceColor = PlanetGenerator::getPlanetSurfaceColor(planet, variation);
-        g_shader->SetVec3("baseColor", surfaceColor);
+// Draw planets at their interpolated orbit/spin, with the scan highlight worked out in the packet
+void renderPlanets(const RenderPacket& packet) {
+    g_shader->Use();
+    g_shader->SetFloat("scanHighlight", 0.0f);
+    g_shader->SetFloat("isEmissive", 0.0f);
 
-        g_shader->SetFloat("isEmissive", 0.0f);
+    for (const PlanetDraw& planet : packet.planets) {
+        g_shader->Use();
+        g_shader->SetMat4("model", planet.model);
 
-        // Scan highlight if this is the current target and player is aiming + in range
-        float highlight = 0.0f;
+        // Planet surface noise setup
+        g_shader->SetVec3("noiseOffset", planet.noiseOffset);
+        g_shader->SetFloat("planetSeed", planet.seed);
+        g_shader->SetInt("planetType", planet.biomeType);
+        g_shader->SetFloat("surfaceNoise", planet.surfaceNoise);
+        g_shader->SetVec3("baseColor", planet.color);
+
+        // Baked surface: the fragment shader just samples the cubemap
+        bool baked = planet.index < (int)g_planetSurfaceMaps.size();
+        g_shader->SetFloat("useBakedSurface", baked ? 1.0f : 0.0f);
+        if (baked) {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, g_planetSurfaceMaps[planet.index]);
+            glActiveTexture(GL_TEXTURE0);
+        }
 
-        if (g_gameState && g_gameState->currentTarget == i && !planet.scanned) {
-            float distance = glm::distance(g_camera->Position, planetPos);
-            float scanRange = planet.collisionRadius + 12.0f;
-            bool aimed = isLookingAtTarget(planetPos, 6.0f);
+        g_shader->SetFloat("scanHighlight", planet.highlight);
 
-            if (aimed && distance < scanRange) {
-                highlight = g_gameState->isScanning ? 0.25f : 0.15f;
-            }
+        // Close up, the quadtree terrain replaces the sphere once its root chunks are ready
+        if (planet.terrain && renderPlanetTerrain(planet, baked)) {
+            continue;
         }
 
-        g_shader->SetFloat("scanHighlight", highlight);
-
         g_sphereMesh->Draw();
     }
 
-    // Reset highlight so it doesn't affect later draws
+    // Reset highlight/bake flag so they don't affect later draws
     g_shader->Use();
     g_shader->SetFloat("scanHighlight", 0.0f);
+    g_shader->SetFloat("useBakedSurface", 0.0f);
 }
 
-// Draw moons using asteroid texture and sphere mesh
-void renderMoons(Planet& planet, const glm::vec3& planetPos, float deltaTime) {
+// Draw every planet's moons using the moon texture and sphere mesh
+void renderMoons(const RenderPacket& packet) {
     g_shader->Use();
 
     g_shader->SetInt("diffuseMap", 0);
     g_shader->SetFloat("isAsteroid", 1.0f);
     g_shader->SetFloat("scanHighlight", 0.0f);
     g_shader->SetFloat("surfaceNoise", 0.0f);
+    g_shader->SetVec3("baseColor", glm::vec3(1.0f));
+    g_shader->SetFloat("isEmissive", 0.0f);
 
     g_moonTexture->Bind(0);
 
-    for (int i = 0; i < (int)planet.moons.size(); ++i) {
-        Moon& moon = planet.moons[i];
-
-        float mx = cos(moon.angle) * moon.distance;
-        float mz = sin(moon.angle) * moon.distance;
-
-        glm::vec3 moonWorldPos = planetPos + glm::vec3(mx, 0.0f, mz);
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), moonWorldPos);
-        model = glm::scale(model, glm::vec3(moon.size));
-
+    for (const glm::mat4& model : packet.moons) {
         g_shader->SetMat4("model", model);
-        g_shader->SetVec3("baseColor", glm::vec3(1.0f));
-        g_shader->SetFloat("isEmissive", 0.0f);
-
         g_sphereMesh->Draw();
     }
 
@@ -685,52 +937,18 @@ void renderMoons(Planet& planet, const glm::vec3& planetPos, float deltaTime) {
     g_shader->SetFloat("isAsteroid", 0.0f);
 }
 
-// Draw asteroids (some orbit around origin, others orbit around cluster centers)
-void renderAsteroids(float currentTime, float deltaTime) {
+// Draw asteroids (matrices were built with the packet, tumbling with sim time)
+void renderAsteroids(const RenderPacket& packet) {
     g_shader->Use();
     g_shader->SetInt("diffuseMap", 0);
     g_shader->SetFloat("isAsteroid", 1.0f);
     g_shader->SetFloat("scanHighlight", 0.0f);
+    g_shader->SetVec3("baseColor", glm::vec3(1.0f));
+    g_shader->SetFloat("isEmissive", 0.0f);
     g_asteroidTexture->Bind(0);
 
-    for (int i = 0; i < (int)g_asteroids.size(); ++i) {
-        Asteroid& asteroid = g_asteroids[i];
-
-        // Clustered asteroids orbit within a local cluster
-        if (asteroid.clustered) {
-            asteroid.localAngle += asteroid.localSpeed * deltaTime;
-            if (asteroid.localAngle > glm::two_pi<float>())
-                asteroid.localAngle -= glm::two_pi<float>();
-
-            asteroid.pos = asteroid.clusterCenter + glm::vec3(
-                cos(asteroid.localAngle) * asteroid.localRadius,
-                asteroid.orbitHeight,
-                sin(asteroid.localAngle) * asteroid.localRadius
-            );
-        }
-        // Non-clustered asteroids orbit around origin
-        else {
-            asteroid.orbitAngle += asteroid.orbitSpeed * deltaTime;
-            if (asteroid.orbitAngle > glm::two_pi<float>()) {
-                asteroid.orbitAngle -= glm::two_pi<float>();
-            }
-
-            float x = cos(asteroid.orbitAngle) * asteroid.orbitRadius;
-            float z = sin(asteroid.orbitAngle) * asteroid.orbitRadius;
-            float y = asteroid.orbitHeight;
-
-            asteroid.pos = glm::vec3(x, y, z);
-        }
-
-        // Model transform: translate -> rotate -> scale
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), asteroid.pos);
-        model = glm::rotate(model, glm::radians(asteroid.rot.x + currentTime * 10.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(asteroid.rot.y + currentTime * 15.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(asteroid.scale));
-
+    for (const glm::mat4& model : packet.asteroids) {
         g_shader->SetMat4("model", model);
-        g_shader->SetVec3("baseColor", glm::vec3(1.0f));
-        g_shader->SetFloat("isEmissive", 0.0f);
 
         // Cube mesh for asteroids (cheap geometry)
         g_cubeMesh->Draw();
@@ -741,15 +959,27 @@ void renderAsteroids(float currentTime, float deltaTime) {
     g_shader->SetFloat("isAsteroid", 0.0f);
 }
 
-// Builds the 2D HUD geometry each frame (radar, speedometer, scan info, etc.)
-void buildHUD(float deltaTime) {
-    // Animate radar sweep + a general pulse timer for blinking effects
-    g_radarAngle += 2.0f * 3.1415926f * deltaTime * 0.1f;
-    if (g_radarAngle > 2.0f * 3.1415926f) g_radarAngle -= 2.0f * 3.1415926f;
-    g_pulseTime += deltaTime;
+// Asteroids within range of the player, as offsets from it, in the field's
+// order. Which ones are in range comes from the asteroid grid (the latest
+// tick); the offsets use the interpolated positions that are drawn.
+static void findRadarContacts(float range, std::vector<glm::vec3>& contacts) {
+    const std::vector<glm::vec3>& asteroids = g_renderSnapshot.asteroidPos;
+    glm::vec3 player = playerPosition();
+
+    g_radarHits.clear();
+    g_asteroidGrid.forEachInRadius(player, range, [](uint32_t id, float) { g_radarHits.push_back(id); });
+    std::sort(g_radarHits.begin(), g_radarHits.end());
+
+    contacts.clear();
+    for (uint32_t id : g_radarHits) {
+        if (id < asteroids.size()) contacts.push_back(asteroids[id] - player);
+    }
+}
 
+// Builds the 2D HUD geometry each frame (radar, speedometer, scan info, etc.)
+void buildHUD(HUDGeometry& hud) {
     // Clear last frame's HUD draw calls
-    g_hudRenderer->clear();
+    hud.clear();
 
     const float PI2 = 2.0f * 3.1415926f;
 
@@ -765,8 +995,8 @@ void buildHUD(float deltaTime) {
     float speedRatio = glm::clamp(glm::length(g_camera->Velocity) / g_camera->BoostSpeed, 0.0f, 1.0f);
 
     // Outer rings
-    g_hudRenderer->addCircle(glm::vec2(cx, cy), radius + 3, glm::vec3(0.0f, 1.0f, 0.8f), 64);
-    g_hudRenderer->addCircle(glm::vec2(cx, cy), radius, glm::vec3(0.0f, 0.7f, 1.0f), 64);
+    hud.addCircle(glm::vec2(cx, cy), radius + 3, glm::vec3(0.0f, 1.0f, 0.8f), 64);
+    hud.addCircle(glm::vec2(cx, cy), radius, glm::vec3(0.0f, 0.7f, 1.0f), 64);
 
     // Draw arc segments depending on speed
     float speedColor = speedRatio < 0.7f ? (1.0f - speedRatio * 0.5f) : 1.0f;
@@ -775,12 +1005,12 @@ void buildHUD(float deltaTime) {
         float angle2 = PI2 * (i + 1) / 32;
         glm::vec2 p1 = glm::vec2(cx, cy) + glm::vec2(cos(angle1) * radius, sin(angle1) * radius);
         glm::vec2 p2 = glm::vec2(cx, cy) + glm::vec2(cos(angle2) * radius, sin(angle2) * radius);
-        g_hudRenderer->addLine(p1, p2, glm::vec3(0.0f, speedColor, 0.3f));
+        hud.addLine(p1, p2, glm::vec3(0.0f, speedColor, 0.3f));
     }
 
     // Center marker
-    g_hudRenderer->addLine(glm::vec2(cx - 8, cy), glm::vec2(cx + 8, cy), glm::vec3(0.0f, 1.0f, 0.8f));
-    g_hudRenderer->addLine(glm::vec2(cx, cy - 8), glm::vec2(cx, cy + 8), glm::vec3(0.0f, 1.0f, 0.8f));
+    hud.addLine(glm::vec2(cx - 8, cy), glm::vec2(cx + 8, cy), glm::vec3(0.0f, 1.0f, 0.8f));
+    hud.addLine(glm::vec2(cx, cy - 8), glm::vec2(cx, cy + 8), glm::vec3(0.0f, 1.0f, 0.8f));
 
     // Radar (bottom left)
 
@@ -788,32 +1018,28 @@ void buildHUD(float deltaTime) {
     float radarRadius = 70.f;
 
     // Radar rings
-    g_hudRenderer->addCircle(glm::vec2(rx, ry), radarRadius, glm::vec3(0.0f, 0.6f, 1.0f), 64);
-    g_hudRenderer->addCircle(glm::vec2(rx, ry), radarRadius * 0.75f, glm::vec3(0.0f, 0.3f, 0.6f), 32);
-    g_hudRenderer->addCircle(glm::vec2(rx, ry), radarRadius * 0.5f, glm::vec3(0.0f, 0.3f, 0.6f), 32);
-    g_hudRenderer->addCircle(glm::vec2(rx, ry), radarRadius * 0.25f, glm::vec3(0.0f, 0.3f, 0.6f), 32);
-    g_hudRenderer->addLine(glm::vec2(rx, ry + radarRadius + 5), glm::vec2(rx, ry + radarRadius + 15), glm::vec3(0.0f, 0.5f, 1.0f));
+    hud.addCircle(glm::vec2(rx, ry), radarRadius, glm::vec3(0.0f, 0.6f, 1.0f), 64);
+    hud.addCircle(glm::vec2(rx, ry), radarRadius * 0.75f, glm::vec3(0.0f, 0.3f, 0.6f), 32);
+    hud.addCircle(glm::vec2(rx, ry), radarRadius * 0.5f, glm::vec3(0.0f, 0.3f, 0.6f), 32);
+    hud.addCircle(glm::vec2(rx, ry), radarRadius * 0.25f, glm::vec3(0.0f, 0.3f, 0.6f), 32);
+    hud.addLine(glm::vec2(rx, ry + radarRadius + 5), glm::vec2(rx, ry + radarRadius + 15), glm::vec3(0.0f, 0.5f, 1.0f));
 
     // Faded sweep trail
     for (int trail = 3; trail > 0; --trail) {
         float trailAngle = g_radarAngle - (trail * 0.15f);
         glm::vec2 sweepEnd = glm::vec2(rx, ry) + glm::vec2(sin(trailAngle) * radarRadius, cos(trailAngle) * radarRadius);
         glm::vec3 trailColor = glm::vec3(0.2f, 1.0f, 0.4f) * (1.0f - (trail / 3.0f)) * 0.6f;
-        g_hudRenderer->addLine(glm::vec2(rx, ry), sweepEnd, trailColor);
+        hud.addLine(glm::vec2(rx, ry), sweepEnd, trailColor);
     }
 
     // Main sweep line
     glm::vec2 mainSweepEnd = glm::vec2(rx, ry) + glm::vec2(sin(g_radarAngle) * radarRadius, cos(g_radarAngle) * radarRadius);
-    g_hudRenderer->addLine(glm::vec2(rx, ry), mainSweepEnd, glm::vec3(0.0f, 1.0f, 0.5f));
+    hud.addLine(glm::vec2(rx, ry), mainSweepEnd, glm::vec3(0.0f, 1.0f, 0.5f));
 
     // Detect asteroids near the player and plot them on radar
     float radarDetectionRange = 150.0f;
-    for (const auto& a : g_asteroids) {
-        glm::vec3 offset = a.pos - g_camera->Position;
-        float distance = glm::length(offset);
-
-        if (distance > radarDetectionRange) continue;
-
+    findRadarContacts(radarDetectionRange, g_radarContacts);
+    for (const glm::vec3& offset : g_radarContacts) {
         // Convert world-space direction to a radar angle relative to camera yaw
         float asteroidAngle = atan2f(offset.x, offset.z) - cameraYaw;
         float asteroidDistance = glm::length(glm::vec2(offset.x, offset.z));
@@ -838,14 +1064,14 @@ void buildHUD(float deltaTime) {
         float asteroidRadius = 3.0f;
         glm::vec2 asteroidPos = glm::vec2(rx + radarX, ry + radarY);
         glm::vec3 asteroidColor = glm::vec3(1.0f, isHighlighted ? 1.0f : 0.6f, 0.0f) * blinkAlpha;
-        g_hudRenderer->addCircle(asteroidPos, asteroidRadius, asteroidColor, 16);
+        hud.addCircle(asteroidPos, asteroidRadius, asteroidColor, 16);
     }
 
     // Crosshair (screen centre)
 
     float centerX = 640.0f, centerY = 360.0f;
-    g_hudRenderer->addLine(glm::vec2(centerX - 10, centerY), glm::vec2(centerX + 10, centerY), glm::vec3(0.0f, 1.0f, 1.0f));
-    g_hudRenderer->addLine(glm::vec2(centerX, centerY - 10), glm::vec2(centerX, centerY + 10), glm::vec3(0.0f, 1.0f, 1.0f));
+    hud.addLine(glm::vec2(centerX - 10, centerY), glm::vec2(centerX + 10, centerY), glm::vec3(0.0f, 1.0f, 1.0f));
+    hud.addLine(glm::vec2(centerX, centerY - 10), glm::vec2(centerX, centerY + 10), glm::vec3(0.0f, 1.0f, 1.0f));
 
 
     // Target info (name/class) if aimed / scanning
@@ -853,9 +1079,9 @@ void buildHUD(float deltaTime) {
     if (g_gameState && g_gameState->currentTarget != -1) {
         Planet& target = g_planets[g_gameState->currentTarget];
 
-        if (!target.scanned) {
-            glm::vec3 targetPos = getPlanetWorldPosition(target);
-            float distance = glm::distance(g_camera->Position, targetPos);
+        if (!isPlanetScanned(g_gameState->currentTarget)) {
+            glm::vec3 targetPos = getPlanetWorldPosition(target, g_renderSnapshot.time);
+            float distance = glm::distance(playerPosition(), targetPos);
             float scanRange = target.collisionRadius + 50.0f;
 
             bool aimed = isLookingAtTarget(targetPos, 6.0f);
@@ -869,13 +1095,13 @@ void buildHUD(float deltaTime) {
                 );
                 glm::vec3 textCol(0.8f, 0.95f, 1.0f);
 
-                g_hudRenderer->addText(namePos, 16.0f, textCol, target.name);
+                hud.addText(namePos, 16.0f, textCol, target.name);
 
                 std::string cls = std::string("CLASS: ") + biomeLabel(target.biomeType);
-                g_hudRenderer->addText(glm::vec2(namePos.x, namePos.y - 22.0f), 14.0f, textCol, cls);
+                hud.addText(glm::vec2(namePos.x, namePos.y - 22.0f), 14.0f, textCol, cls);
 
                 if (g_gameState->scanJammed) {
-                    g_hudRenderer->addText(glm::vec2(namePos.x, namePos.y - 44.0f), 14.0f,
+                    hud.addText(glm::vec2(namePos.x, namePos.y - 44.0f), 14.0f,
                         glm::vec3(1.0f, 0.2f, 0.2f), "JAMMED");
                 }
             }
@@ -885,11 +1111,25 @@ void buildHUD(float deltaTime) {
     // Big warning ring around crosshair when jammed
     if (g_gameState && g_gameState->scanJammed) {
         float pulse = 0.35f + 0.65f * (0.5f + 0.5f * sinf(g_pulseTime * 8.0f));
-        g_hudRenderer->addCircle(glm::vec2(centerX, centerY), 28.0f,
+        hud.addCircle(glm::vec2(centerX, centerY), 28.0f,
             glm::vec3(1.0f, 0.1f, 0.1f) * pulse, 48);
     }
 
 
+    // Time warp readout (top right)
+    if (timeWarp() > 1) {
+        hud.addText(glm::vec2(WINDOW_WIDTH - 260.0f, 680.0f), 16.0f, glm::vec3(1.0f, 0.8f, 0.2f),
+            "TIME WARP " + std::to_string(timeWarp()) + "X");
+    }
+
+    // Simulation LOD readout (top right, small): updates made per second
+    // against updating everything every tick
+    if (g_simLod.fullRatePerSecond() > 0.0) {
+        hud.addText(glm::vec2(WINDOW_WIDTH - 260.0f, 660.0f), 8.0f, glm::vec3(0.45f, 0.6f, 0.65f),
+            "SIM UPDATES/S " + std::to_string((long long)g_simLod.updatesPerSecond()) +
+            " OF " + std::to_string((long long)g_simLod.fullRatePerSecond()));
+    }
+
     // Scanned planets indicator (top left)
 
     int total = g_gameState ? g_gameState->totalPlanets : (int)g_planets.size();
@@ -902,18 +1142,18 @@ void buildHUD(float deltaTime) {
 
     for (int i = 0; i < total; ++i) {
         glm::vec3 c = (i < scanned) ? glm::vec3(0.0f, 1.0f, 0.6f) : glm::vec3(0.15f, 0.25f, 0.35f);
-        g_hudRenderer->addCircle(glm::vec2(dotsX + i * gap, dotsY), dotR, c, 20);
+        hud.addCircle(glm::vec2(dotsX + i * gap, dotsY), dotR, c, 20);
     }
 
     // Scan progress bar (top middle)
 
     if (g_gameState && g_gameState->currentTarget != -1 &&
-        !g_planets[g_gameState->currentTarget].scanned)
+        !isPlanetScanned(g_gameState->currentTarget))
     {
         Planet& target = g_planets[g_gameState->currentTarget];
-        glm::vec3 targetPos = getPlanetWorldPosition(target);
+        glm::vec3 targetPos = getPlanetWorldPosition(target, g_renderSnapshot.time);
 
-        float distance = glm::distance(g_camera->Position, targetPos);
+        float distance = glm::distance(playerPosition(), targetPos);
         float scanRange = target.collisionRadius + 30.0f;
         bool aimed = isLookingAtTarget(targetPos, 6.0f);
 
@@ -927,7 +1167,7 @@ void buildHUD(float deltaTime) {
             float progress = g_gameState->scanProgress;
 
             // Background track
-            g_hudRenderer->addLine(
+            hud.addLine(
                 glm::vec2(barX, barY),
                 glm::vec2(barX + barW, barY),
                 glm::vec3(0.08f, 0.15f, 0.2f)
@@ -942,7 +1182,7 @@ void buildHUD(float deltaTime) {
                 ? glm::vec3(0.0f, 1.0f, 0.85f) * pulse
                 : glm::vec3(0.0f, 0.6f, 0.9f);
 
-            g_hudRenderer->addLine(
+            hud.addLine(
                 glm::vec2(barX, barY),
                 glm::vec2(barX + barW * progress, barY),
                 scanColor
@@ -951,7 +1191,7 @@ void buildHUD(float deltaTime) {
             // Little cap at the end of the progress
             if (progress > 0.01f) {
                 float capX = barX + barW * progress;
-                g_hudRenderer->addLine(
+                hud.addLine(
                     glm::vec2(capX, barY - 3),
                     glm::vec2(capX, barY + 3),
                     scanColor
@@ -971,31 +1211,31 @@ void buildHUD(float deltaTime) {
         glm::vec3 dimCol = glm::vec3(0.08f, 0.16f, 0.22f);
 
         // Decorative rings
-        g_hudRenderer->addCircle(glm::vec2(cx, cy), 140.0f, frameCol, 96);
-        g_hudRenderer->addCircle(glm::vec2(cx, cy), 110.0f, dimCol, 96);
-        g_hudRenderer->addCircle(glm::vec2(cx, cy), 90.0f, frameCol * 0.8f, 96);
+        hud.addCircle(glm::vec2(cx, cy), 140.0f, frameCol, 96);
+        hud.addCircle(glm::vec2(cx, cy), 110.0f, dimCol, 96);
+        hud.addCircle(glm::vec2(cx, cy), 90.0f, frameCol * 0.8f, 96);
 
         // Cross lines
-        g_hudRenderer->addLine(glm::vec2(cx - 160, cy), glm::vec2(cx + 160, cy), dimCol);
-        g_hudRenderer->addLine(glm::vec2(cx, cy - 120), glm::vec2(cx, cy + 120), dimCol);
+        hud.addLine(glm::vec2(cx - 160, cy), glm::vec2(cx + 160, cy), dimCol);
+        hud.addLine(glm::vec2(cx, cy - 120), glm::vec2(cx, cy + 120), dimCol);
 
         // Title
         glm::vec3 titleCol(0.85f, 1.0f, 1.0f);
-        g_hudRenderer->addText(glm::vec2(cx - 170.0f, cy + 50.0f), 20.0f, titleCol, "SURVEY COMPLETE");
+        hud.addText(glm::vec2(cx - 170.0f, cy + 50.0f), 20.0f, titleCol, "SURVEY COMPLETE");
 
         // Stats
         std::string scoreLine = "SCORE: " + std::to_string(g_gameState->score);
         std::string planetsLine = "PLANETS: " + std::to_string(g_gameState->scannedPlanets) +
             "/" + std::to_string(g_gameState->totalPlanets);
 
-        g_hudRenderer->addText(glm::vec2(cx - 120.0f, cy + 10.0f), 16.0f, titleCol, scoreLine);
-        g_hudRenderer->addText(glm::vec2(cx - 120.0f, cy - 15.0f), 16.0f, titleCol, planetsLine);
+        hud.addText(glm::vec2(cx - 120.0f, cy + 10.0f), 16.0f, titleCol, scoreLine);
+        hud.addText(glm::vec2(cx - 120.0f, cy - 15.0f), 16.0f, titleCol, planetsLine);
 
         // Prompts
         float blink = (sinf(g_pulseTime * 4.0f) > 0.0f) ? 1.0f : 0.35f;
         glm::vec3 promptCol = glm::vec3(0.0f, 1.0f, 0.85f) * blink;
-        g_hudRenderer->addText(glm::vec2(cx - 150.0f, cy - 70.0f), 14.0f, promptCol, "PRESS R TO RESTART");
-        g_hudRenderer->addText(glm::vec2(cx - 120.0f, cy - 92.0f), 12.0f, dimCol * 1.3f, "ESC TO QUIT");
+        hud.addText(glm::vec2(cx - 150.0f, cy - 70.0f), 14.0f, promptCol, "PRESS R TO RESTART");
+        hud.addText(glm::vec2(cx - 120.0f, cy - 92.0f), 12.0f, dimCol * 1.3f, "ESC TO QUIT");
 
         // Signature (top right)
 
@@ -1016,19 +1256,14 @@ void buildHUD(float deltaTime) {
                 (float)WINDOW_HEIGHT - 25.0f
             );
 
-            g_hudRenderer->addText(pos, fontSize, sigCol, sig);
+            hud.addText(pos, fontSize, sigCol, sig);
         }
 
     }
-
-    // Upload HUD geometry to GPU buffers
-    g_hudRenderer->finalize();
-
-
 }
 
 // Draw the HUD (2D overlay)
-void renderHUD() {
+void renderHUD(const RenderPacket& packet) {
     glDisable(GL_DEPTH_TEST);
 
     // Simple orthographic projection for screen-space drawing
@@ -1041,239 +1276,1853 @@ void renderHUD() {
     g_hudShader->Use();
     g_hudShader->SetMat4("projection", projection);
 
+    // Upload this frame's HUD geometry to GPU buffers
+    g_hudRenderer->upload(packet.hud);
     g_hudRenderer->render();
 
     glEnable(GL_DEPTH_TEST);
 }
 
-// Master render function called once per frame
-void render(float deltaTime, const glm::mat4& view, const glm::mat4& projection) {
+// Master render function, called once per packet on the render thread
+void render(const RenderPacket& packet) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Background first
-    renderStars(view, projection);
+    renderStars(packet.view, packet.projection);
 
-    // Setup main shader camera/light uniforms once
+    // Setup main shader camera/light uniforms once (positions are relative
+    // to the camera, so the viewer is at the origin)
+    g_shader->Use();
+    g_shader->SetMat4("view", packet.view);
+    g_shader->SetMat4("projection", packet.projection);
+    g_shader->SetVec3("lightPos", packet.lightPos);
+    g_shader->SetVec3("viewPos", glm::vec3(0.0f));
+
+    g_terrainShader->Use();
+    g_terrainShader->SetMat4("view", packet.view);
+    g_terrainShader->SetMat4("projection", packet.projection);
+    g_terrainShader->SetVec3("lightPos", packet.lightPos);
+    g_terrainShader->SetVec3("viewPos", glm::vec3(0.0f));
     g_shader->Use();
-    g_shader->SetMat4("view", view);
-    g_shader->SetMat4("projection", projection);
-    g_shader->SetVec3("lightPos", g_sun.pos);
-    g_shader->SetVec3("viewPos", g_camera->Position);
 
     // World objects
-    renderSun();
-    renderPlanets(deltaTime);
-
-    for (auto& planet : g_planets) {
-        glm::vec3 planetPos = getPlanetWorldPosition(planet);
-        renderMoons(planet, planetPos, deltaTime);
-    }
-
-    renderAsteroids((float)glfwGetTime(), deltaTime);
+    renderSun(packet);
+    renderSectors(packet);
+    renderPlanets(packet);
+    renderMoons(packet);
+    renderAsteroids(packet);
 
     // Probes are drawn after planets/asteroids so they stand out slightly
-    renderProbes();
-    renderBrokenProbes();
+    renderProbes(packet);
+    renderBrokenProbes(packet);
 
     // UI last
-    buildHUD(deltaTime);
-    renderHUD();
+    renderHUD(packet);
 
     GL_CHECK();
 }
 
-// Separate moon update (note: you also update moons inside renderMoons)
-void updateMoons(float deltaTime) {
-    for (auto& planet : g_planets) {
-        for (auto& moon : planet.moons) {
-            moon.angle += moon.speed * deltaTime;
+// Simulation (runs in fixed SIM_DT steps; nothing here touches GL)
+
+// Asteroids orbit the origin, or a local point if they belong to a cluster.
+// The ones in [begin, end) the LOD has due are evaluated for this tick by the
+// field's SIMD kernels (so a skipped asteroid catches up exactly), given their
+// next period and put in their grid slots; the rest keep their positions and
+// slots from their last update. Ranges can run on different threads.
+//
+// Runs of 16 share a stagger key, so due asteroids come in runs that share
+// cache lines; a chunk that's mostly due is cheaper evaluated whole than
+// gathered, which only leaves the others more up to date.
+void updateAsteroids(uint64_t tick, size_t begin, size_t end) {
+    float warp = (float)timeWarp();
+    const size_t CHUNK = 1024;
+    uint32_t due[CHUNK];
+    size_t updated = 0;
+    for (size_t first = begin; first < end; first += CHUNK) {
+        size_t last = std::min(end, first + CHUNK);
+        size_t n = 0;
+        for (size_t i = first; i < last; ++i) {
+            due[n] = (uint32_t)i;   // kept only if due (no branch to mispredict)
+            n += g_simLod.due(g_asteroidPeriods[i], (uint32_t)(i / 16)) ? 1 : 0;
+        }
+        if (2 * n >= last - first) {
+            g_asteroidField.evaluate(tick, first, last);
+            updated += last - first;
+        }
+        else {
+            g_asteroidField.evaluateListed(tick, due, n);
+            updated += n;
+        }
+
+        for (size_t k = 0; k < n; ++k) {
+            uint32_t i = due[k];
+            glm::vec3 position = g_asteroidField.position(i);
+            float radius = g_asteroidField.collisionRadius(i);
+            g_asteroidPeriods[i] = (uint8_t)g_simLod.period(position, radius, g_asteroidField.motionPerTick(i) * warp);
+            g_asteroidGrid.set(i, i, position, radius);
         }
     }
+    g_simLod.count(updated, end - begin);
 }
 
-// Main program
+// Radar sweep + a general pulse timer for blinking HUD effects
+void updateHUDAnimation(float dt) {
+    g_radarAngle += 2.0f * 3.1415926f * dt * 0.1f;
+    if (g_radarAngle > 2.0f * 3.1415926f) g_radarAngle -= 2.0f * 3.1415926f;
+    g_pulseTime += dt;
+}
 
-int main() {
-    try {
-        std::cout << "=== Initializing Space Explorer ===" << std::endl;
+// Keys held for a tick, read on the main thread before it (GLFW input can only
+// be polled there; the tick itself runs on the job system)
+struct TickInput {
+    MoveKeys move;
+    bool scan = false;          // E held
+    bool completeAll = false;   // K (debug)
+    bool restart = false;       // R
+};
 
-        GLFWwindow* window = initializeWindow();
-        std::cout << "Window created" << std::endl;
+TickInput sampleTickInput(GLFWwindow* window) {
+    TickInput input;
+    input.move = MoveKeys::sample(window);
+    input.scan = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+    input.completeAll = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+    input.restart = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+    return input;
+}
 
-        initializeGLEW();
-        std::cout << "GLEW initialized" << std::endl;
+// A tick's keys as one bit each, for session logs
+uint16_t packTickInput(const TickInput& input) {
+    const bool keys[] = {
+        input.move.forward, input.move.backward, input.move.left, input.move.right,
+        input.move.up, input.move.down, input.move.boost,
+        input.scan, input.completeAll, input.restart
+    };
+    uint16_t bits = 0;
+    for (int i = 0; i < (int)(sizeof(keys) / sizeof(keys[0])); ++i) {
+        if (keys[i]) bits |= (uint16_t)(1u << i);
+    }
+    return bits;
+}
 
-        initializeOpenGL();
-        std::cout << "OpenGL context ready" << std::endl;
+TickInput unpackTickInput(uint16_t bits) {
+    TickInput input;
+    bool* keys[] = {
+        &input.move.forward, &input.move.backward, &input.move.left, &input.move.right,
+        &input.move.up, &input.move.down, &input.move.boost,
+        &input.scan, &input.completeAll, &input.restart
+    };
+    for (int i = 0; i < (int)(sizeof(keys) / sizeof(keys[0])); ++i) {
+        *keys[i] = (bits >> i) & 1u;
+    }
+    return input;
+}
 
-        // Start camera a bit above the plane looking into the scene
-        g_camera = std::make_unique<Camera>(glm::vec3(0.0f, 30.0f, 100.0f));
+// Scanning, jamming, scoring and restart
+void updateGameplay(const TickInput& input, float dt, int& lastTarget) {
+    // Always target the nearest unscanned planet
+    g_gameState->currentTarget = findNearestUnscannedPlanet(playerPosition());
 
-        initializeShaders();
-        initializeGeometry();
-        initializeScene();
+    // If the target changes, reset scan progress
+    if (g_gameState->currentTarget != lastTarget) {
+        g_gameState->resetScan();
+        lastTarget = g_gameState->currentTarget;
+    }
 
-        std::cout << "=== Initialization complete. Starting main loop ===" << std::endl;
+    // Default: not jammed, then we check probes below
+    g_gameState->scanJammed = false;
 
-        float lastTime = (float)glfwGetTime();
-        int lastTarget = -1;
+    if (g_gameState->currentTarget != -1 && timeWarp() > 1) {
+        // Nothing holds still long enough to scan while time is warped
+        g_gameState->resetScan();
+    }
+    else if (g_gameState->currentTarget != -1) {
+        Entity targetEntity = g_planetEntities[g_gameState->currentTarget];
+        Scannable& target = g_world.get<Scannable>(targetEntity);
+        glm::vec3 planetPos = g_world.get<Transform>(targetEntity).position;
+
+        float distance = glm::distance(playerPosition(), planetPos);
+        float scanRange = g_world.get<Collider>(targetEntity).radius + 12.0f;
+
+        bool aimed = isLookingAtTarget(planetPos, 6.0f);
+        bool inRange = distance < scanRange;
+
+        // Jamming: if any jammer (probe) is close to the target planet, scanning is blocked
+        bool jammed = false;
+        g_bodyGrid.forEachInRadius(planetPos, PROBE_JAM_RANGE, [&](uint32_t id, float distance) {
+            const Jammer* jammer = g_world.find<Jammer>(g_bodyGridEntities[id]);
+            if (jammer && distance < jammer->range) jammed = true;
+        });
+        g_gameState->scanJammed = jammed;
+
+        // Hold E to scan (only works if not jammed, aimed, and in range)
+        if (!jammed && aimed && inRange && input.scan) {
+            g_gameState->isScanning = true;
+        }
+        else {
+            g_gameState->isScanning = false;
+        }
 
-        while (!glfwWindowShouldClose(window))
-        {
-            // Delta time for frame-rate independent movement
-            float currentTime = (float)glfwGetTime();
-            float deltaTime = currentTime - lastTime;
-            lastTime = currentTime;
+        // Update scan progress over time
+        g_gameState->updateScan(dt);
 
-            // Save old position in case we need to undo movement due to collision
-            glm::vec3 oldPos = g_camera->Position;
+        // When scan finishes, mark planet scanned and award points
+        if (g_gameState->scanProgress >= 1.0f && !target.scanned) {
+            target.scanned = true;
+            g_gameState->scannedPlanets++;
+            g_gameState->score += 100;
+            g_gameState->resetScan();
+        }
+    }
+
+    // If all planets are scanned, show completion UI
+    if (g_gameState->scannedPlanets == g_gameState->totalPlanets) {
+        g_gameState->surveyComplete = true;
+    }
+
+    // Debug shortcut: press K to instantly complete the game
+    if (input.completeAll) {
+        g_world.each<Scannable>([](Entity, Scannable& scannable) { scannable.scanned = true; });
+        g_gameState->scannedPlanets = g_gameState->totalPlanets;
+        g_gameState->surveyComplete = true;
+        g_gameState->resetScan();
+    }
+
+    // Restart game on completion (press R)
+    if (g_gameState && g_gameState->surveyComplete && input.restart) {
+        g_gameState->surveyComplete = false;
+        g_gameState->score = 0;
+        g_gameState->scannedPlanets = 0;
+        g_gameState->resetScan();
+
+        g_world.each<Scannable>([](Entity, Scannable& scannable) { scannable.scanned = false; });
+
+        // Re-roll probes so the new run feels different
+        spawnProbesForPlanets();
+    }
+}
+
+// Moves the player to just outside a sphere
+static void pushOutOfSphere(const glm::vec3& center, float radius) {
+    glm::vec3 offset = playerPosition() - center;
+    float distance = glm::length(offset);
+    glm::vec3 dir = distance > 0.0f ? offset / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+    g_camera->Position = glm::dvec3(center + dir * radius);
+}
 
-            // Input-driven movement (WASD etc. handled inside Camera)
-            g_camera->ProcessKeyboard(window, deltaTime);
+// Whether a planet's surface is close enough to collide with its terrain
+// rather than its collision sphere
+static bool collidesWithTerrain(const Renderable& renderable, float distance) {
+    return renderable.model == RenderModel::Planet && g_planetTerrain && g_planetTerrain->isActive(renderable.index, distance);
+}
 
-            // Update orbiting probes around planets
-            updateProbes(deltaTime);
+// Everything the player's move could touch this tick, reused
+static std::vector<Sweep::Obstacle> g_sweepObstacles;
+
+// Sweeps the player's move from oldPos to where input put it against the sun,
+// planets and asteroids where this tick put them, sliding along whatever it
+// meets. Only what's within the move's length of oldPos can be reached, so
+// that's all the grids are asked for. The sweep is done relative to oldPos
+// and added back on in double precision, so a move far from the origin isn't
+// rounded to what a float can hold there.
+void sweepPlayer(const glm::dvec3& oldPos) {
+    glm::vec3 delta = glm::vec3(g_camera->Position - oldPos);
+    float reach = glm::length(delta);
+    if (reach == 0.0f) return;
+
+    glm::vec3 from = glm::vec3(oldPos);
+    g_sweepObstacles.clear();
+    if (checkSphereCollision(from, reach + PLAYER_RADIUS, g_sun.pos, g_sun.radius)) {
+        g_sweepObstacles.push_back(Sweep::Obstacle{ offsetFrom(g_sun.pos, oldPos), g_sun.radius + PLAYER_RADIUS });
+    }
+    g_bodyGrid.forEachOverlap(from, reach + PLAYER_RADIUS, [&](uint32_t id, float distance) {
+        Entity entity = g_bodyGridEntities[id];
+        const Collider* collider = g_world.find<Collider>(entity);
+        if (!collider || collidesWithTerrain(g_world.get<Renderable>(entity), distance)) return;
+        g_sweepObstacles.push_back(Sweep::Obstacle{ offsetFrom(g_world.get<Transform>(entity).position, oldPos), collider->radius + PLAYER_RADIUS });
+    });
+    g_asteroidGrid.forEachOverlap(from, reach + PLAYER_RADIUS, [&](uint32_t id, float) {
+        g_sweepObstacles.push_back(Sweep::Obstacle{ offsetFrom(g_asteroidField.position(id), oldPos), g_asteroidField.collisionRadius(id) + PLAYER_RADIUS });
+    });
+
+    g_camera->Position = oldPos + glm::dvec3(Sweep::slide(glm::vec3(0.0f), delta, g_sweepObstacles));
+}
 
-            // Scanning logic
+// Bodies the player overlaps this tick, reused
+static std::vector<uint32_t> g_bodyHits;
+
+// Pushes the player out of a model's triangles. The player's sphere goes into
+// the model's space, where the shared mesh is, and the push comes back out;
+// a few passes settle it in a corner between faces.
+static void resolveMeshCollision(const MeshCollider& collider, const Transform& transform) {
+    float toModel = 1.0f / transform.scale;
+    float radius = PLAYER_RADIUS * toModel;
+    for (int pass = 0; pass < 3; ++pass) {
+        glm::vec3 local = (playerPosition() - transform.position) * toModel;
+        TriangleBvh::Contact contact;
+        if (!collider.mesh->closestPoint(local, radius, contact)) return;
+
+        glm::vec3 away = local - contact.point;
+        glm::vec3 dir = contact.distance > 0.0f ? away / contact.distance : glm::vec3(0.0f, 1.0f, 0.0f);
+        local = contact.point + dir * (radius + Sweep::CONTACT_GAP * toModel);
+        g_camera->Position = glm::dvec3(transform.position + local * transform.scale);
+    }
+}
 
-            // Always target the nearest unscanned planet
-            g_gameState->currentTarget = findNearestUnscannedPlanet(g_camera->Position);
+// Keeps the player out of the sun and planets once it has moved. The sweep
+// stops the player's own move at a surface, so anything still overlapping
+// moved into the player (an orbit, or a warped tick carrying a body onto or
+// straight past it): push out.
+void resolveBodyCollisions() {
+    // Sun collision
+    if (checkSphereCollision(playerPosition(), PLAYER_RADIUS, g_sun.pos, g_sun.radius)) {
+        pushOutOfSphere(g_sun.pos, g_sun.radius + PLAYER_RADIUS);
+    }
 
-            // If the target changes, reset scan progress
-            if (g_gameState->currentTarget != lastTarget) {
-                g_gameState->resetScan();
-                lastTarget = g_gameState->currentTarget;
+    // Planet (and any other collider) collision: of the bodies the player
+    // overlaps, the first in grid order (the entity query order) wins. The
+    // terrain never reaches past a planet's collision radius. Probes are only
+    // tested triangle by triangle once their bounds overlap the player.
+    g_bodyHits.clear();
+    g_bodyGrid.forEachOverlap(playerPosition(), PLAYER_RADIUS, [](uint32_t id, float) { g_bodyHits.push_back(id); });
+    std::sort(g_bodyHits.begin(), g_bodyHits.end());
+
+    for (uint32_t id : g_bodyHits) {
+        Entity entity = g_bodyGridEntities[id];
+        if (const MeshCollider* mesh = g_world.find<MeshCollider>(entity)) {
+            resolveMeshCollision(*mesh, g_world.get<Transform>(entity));
+            continue;
+        }
+        const Collider* collider = g_world.find<Collider>(entity);
+        if (!collider) continue;
+        const Transform& transform = g_world.get<Transform>(entity);
+        const Renderable& renderable = g_world.get<Renderable>(entity);
+
+        glm::vec3 bodyPos = transform.position;
+        glm::vec3 offset = playerPosition() - bodyPos;
+        float distance = glm::length(offset);
+
+        // Near a planet, collide with the terrain itself
+        if (collidesWithTerrain(renderable, distance) && distance > 0.0f) {
+            const Planet& surface = g_planets[renderable.index];
+            glm::vec3 dir = offset / distance;
+            glm::vec3 localDir = glm::vec3(glm::inverse(getBodyFrame(bodyPos, transform.spin)) * glm::vec4(bodyPos + dir, 1.0f));
+            float height = surface.size + PlanetTerrain::surfaceHeight(surface, localDir) + PLAYER_RADIUS;
+            if (distance < height) {
+                g_camera->Position = glm::dvec3(bodyPos + dir * height);
+                return;
             }
+        }
+        else if (checkSphereCollision(playerPosition(), PLAYER_RADIUS, bodyPos, collider->radius)) {
+            pushOutOfSphere(bodyPos, collider->radius + PLAYER_RADIUS);
+            return;
+        }
+    }
+}
 
-            // Default: not jammed, then we check probes below
-            g_gameState->scanJammed = false;
+// Lowest-index asteroid the player overlaps, or SIZE_MAX
+size_t findAsteroidHit() {
+    size_t hit = SIZE_MAX;
+    g_asteroidGrid.forEachOverlap(playerPosition(), PLAYER_RADIUS, [&](uint32_t id, float) {
+        hit = std::min(hit, (size_t)id);
+    });
+    return hit;
+}
 
-            if (g_gameState->currentTarget != -1) {
-                Planet& target = g_planets[g_gameState->currentTarget];
-                glm::vec3 planetPos = getPlanetWorldPosition(target);
+void resolveAsteroidHit(size_t hit) {
+    if (hit == SIZE_MAX) return;
+    pushOutOfSphere(g_asteroidField.position(hit), g_asteroidField.collisionRadius(hit) + PLAYER_RADIUS);
+}
 
-                float distance = glm::distance(g_camera->Position, planetPos);
-                float scanRange = target.collisionRadius + 12.0f;
+// About as far as an orbit can carry its body in the given time: its fastest
+// speed (at periapsis, roughly) plus its parent's
+static float orbitMotion(const Orbit& orbit, float seconds) {
+    float motion = std::fabs(orbit.speed) * orbit.radius * (1.0f + orbit.eccentricity) * seconds;
+    if (const Orbit* parent = g_world.find<Orbit>(orbit.parent)) motion += orbitMotion(*parent, seconds);
+    return motion;
+}
 
-                bool aimed = isLookingAtTarget(planetPos, 6.0f);
-                bool inRange = distance < scanRange;
+// Moves every orbiting entity the LOD has due to time t (planets and moons
+// are closed-form, so chunks are evaluated in parallel and in any order, and
+// one that was skipped lands exactly where it would have been)
+void updateOrbits(double t) {
+    float tickSeconds = SIM_DT * timeWarp();
+    std::atomic<size_t> updated(0);
+    g_world.parallelEach<Transform, const Orbit>(*g_jobs, [&](Entity entity, Transform& transform, const Orbit& orbit) {
+        uint32_t period = g_simLod.period(transform.position, transform.scale, orbitMotion(orbit, tickSeconds));
+        if (!g_simLod.due(period, entity.index)) return;
+        transform.position = Orbits::position(g_world, orbit, t);
+        transform.spin = Orbits::spin(orbit, t);
+        updated.fetch_add(1, std::memory_order_relaxed);
+    });
+    g_simLod.count(updated.load(), g_world.count<Orbit>());
+}
 
-                // Jamming: if any probe is close to the target planet, scanning is blocked
-                bool jammed = false;
-                for (const auto& pr : g_probes) {
-                    float d = glm::distance(pr.pos, planetPos);
-                    if (d < 18.0f) {
-                        jammed = true;
-                        break;
-                    }
-                }
-                g_gameState->scanJammed = jammed;
+// Flies the probes for one tick. Each is first carried along with the planet
+// it's patrolling (so orbits and time warp take it with them), then steers
+// with the flock in real time. While the player is within PROBE_ALERT_RANGE of
+// the planet they're surveying, probes patrolling within that range of it
+// converge on it. Every probe is carried each tick, keeping the swarms in
+// their planets' frames, but only those the LOD has due are steered, flying
+// the ticks since they last were in one step.
+void updateProbes(float dt) {
+    Entity alert;
+    glm::vec3 alertPos(0.0f);
+    int target = g_gameState ? g_gameState->currentTarget : -1;
+    if (target != -1) {
+        alertPos = g_world.get<Transform>(g_planetEntities[target]).position;
+        if (glm::distance(playerPosition(), alertPos) < PROBE_ALERT_RANGE) alert = g_planetEntities[target];
+    }
 
-                // Hold E to scan (only works if not jammed, aimed, and in range)
-                if (!jammed && aimed && inRange && glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
-                    g_gameState->isScanning = true;
-                }
-                else {
-                    g_gameState->isScanning = false;
-                }
+    g_flock.resize(g_world.count<Boid>());
+    g_flockEntities.clear();
+    size_t steered = 0;
+    g_world.each<Transform, Boid>([&](Entity entity, Transform& transform, Boid& boid) {
+        const glm::vec3& home = g_world.get<Transform>(boid.home).position;
+        Entity goal = alert.valid() && glm::distance(home, alertPos) < PROBE_ALERT_RANGE ? alert : boid.home;
+        const glm::vec3& goalPos = g_world.get<Transform>(goal).position;
+        if (goal != boid.goal) {
+            boid.goal = goal;
+            boid.anchor = goalPos;
+        }
+        transform.position += goalPos - boid.anchor;
+        boid.anchor = goalPos;
+
+        Flock::Goal patrol{ goalPos + glm::vec3(0.0f, boid.height, 0.0f), g_world.get<Collider>(goal).radius + boid.gap, boid.turn };
+        g_flock.setAgent(g_flockEntities.size(), transform.position, boid.velocity, patrol);
+        if (g_simLod.due(g_simLod.period(transform.position, 0.0f, glm::length(boid.velocity) * dt), entity.index)) {
+            g_flock.setTicks(g_flockEntities.size(), std::min(g_simLod.tick() - boid.steered, SimLod::MAX_PERIOD));
+            boid.steered = g_simLod.tick();
+            ++steered;
+        }
+        else {
+            g_flock.setTicks(g_flockEntities.size(), 0);
+        }
+        g_flockEntities.push_back(entity);
+    });
+    g_simLod.count(steered, g_flockEntities.size());
+
+    // Asteroids only matter near a probe, so only those are looked up (from
+    // the asteroid grid, so this costs the same however big the field is)
+    g_flock.clearObstacles();
+    g_flock.addObstacle(Sweep::Obstacle{ g_sun.pos, g_sun.radius + PROBE_CLEARANCE });
+    g_world.each<const Transform, const Collider>([](Entity, const Transform& transform, const Collider& collider) {
+        g_flock.addObstacle(Sweep::Obstacle{ transform.position, collider.radius + PROBE_CLEARANCE });
+    });
+    float reach = Flock::obstacleReach(dt * SimLod::MAX_PERIOD) + PROBE_CLEARANCE;
+    g_probeObstacles.clear();
+    for (size_t i = 0; i < g_flock.size(); ++i) {
+        g_asteroidGrid.forEachOverlap(g_flock.position(i), reach, [](uint32_t id, float) { g_probeObstacles.push_back(id); });
+    }
+    std::sort(g_probeObstacles.begin(), g_probeObstacles.end());
+    g_probeObstacles.erase(std::unique(g_probeObstacles.begin(), g_probeObstacles.end()), g_probeObstacles.end());
+    for (uint32_t i : g_probeObstacles) {
+        g_flock.addObstacle(Sweep::Obstacle{ g_asteroidField.position(i), g_asteroidField.collisionRadius(i) + PROBE_CLEARANCE });
+    }
 
-                // Update scan progress over time
-                g_gameState->updateScan(deltaTime);
+    g_flock.step(dt, g_jobs.get());
 
-                // When scan finishes, mark planet scanned and award points
-                if (g_gameState->scanProgress >= 1.0f && !target.scanned) {
-                    target.scanned = true;
-                    g_gameState->scannedPlanets++;
-                    g_gameState->score += 100;
-                    g_gameState->resetScan();
-                }
+    for (size_t i = 0; i < g_flockEntities.size(); ++i) {
+        Transform& transform = g_world.get<Transform>(g_flockEntities[i]);
+        Boid& boid = g_world.get<Boid>(g_flockEntities[i]);
+        transform.position = g_flock.position(i);
+        boid.velocity = g_flock.velocity(i);
+        transform.spin = glm::degrees(std::atan2(boid.velocity.x, boid.velocity.z));   // facing where it flies
+    }
+}
+
+// Re-indexes every entity with a transform (bodies without a collider go in
+// as points, meshes as their bounding spheres). Queries look entities up
+// through their handles, so entries for probes destroyed by a restart later
+// in the tick are simply skipped.
+void indexBodies() {
+    g_bodyGridEntities.clear();
+    g_bodyGrid.clear();
+    g_world.each<const Transform>([](Entity entity, const Transform& transform) {
+        float radius = 0.0f;
+        if (const Collider* collider = g_world.find<Collider>(entity)) radius = collider->radius;
+        else if (const MeshCollider* mesh = g_world.find<MeshCollider>(entity)) radius = mesh->radius;
+        g_bodyGrid.insert((uint32_t)g_bodyGridEntities.size(), transform.position, radius);
+        g_bodyGridEntities.push_back(entity);
+    });
+    g_bodyGrid.build();
+}
+
+// Puts asteroids [begin, end) in their grid slots at their current positions
+// (the grid has been resized to the field; ranges can run on different
+// threads). The grid is built once every slot is set.
+void indexAsteroids(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        g_asteroidGrid.set(i, (uint32_t)i, g_asteroidField.position(i), g_asteroidField.collisionRadius(i));
+    }
+}
+
+// Copies every drawable entity into a snapshot (reusing its vector, so this
+// doesn't allocate once warmed up)
+void captureBodies(WorldSnapshot& snap) {
+    snap.bodies.clear();
+    g_world.each<const Transform, const Renderable>([&](Entity entity, const Transform& transform, const Renderable& renderable) {
+        BodyState body;
+        body.entity = entity;
+        body.model = renderable.model;
+        body.index = renderable.index;
+        body.position = transform.position;
+        body.spin = transform.spin;
+        body.scale = transform.scale;
+        snap.bodies.push_back(body);
+    });
+}
+
+// Re-evaluates a snapshot's orbiting bodies at time t (exact, not blended).
+// Probes go wherever their goal is at t, less the flight they still have to
+// make before the snapshot (lag seconds of real time); anything else stays
+// where it is.
+void evaluateOrbits(double t, float lag, std::vector<BodyState>& bodies) {
+    for (BodyState& body : bodies) {
+        if (const Orbit* orbit = g_world.find<Orbit>(body.entity)) {
+            body.position = Orbits::position(g_world, *orbit, t);
+            body.spin = Orbits::spin(*orbit, t);
+        }
+        else if (const Boid* boid = g_world.find<Boid>(body.entity)) {
+            if (const Orbit* goal = g_world.find<Orbit>(boid->goal)) {
+                body.position += Orbits::position(g_world, *goal, t) - boid->anchor - boid->velocity * lag;
             }
+        }
+    }
+}
+
+// Captures the current state in one go (the initial snapshot; ticks capture
+// theirs as part of the tick graph)
+void captureSnapshot(WorldSnapshot& snap) {
+    snap.tick = g_simTick;
+    snap.time = g_simTime;
+    snap.cameraPos = g_camera->Position;
 
-            // If all planets are scanned, show completion UI
-            if (g_gameState->scannedPlanets == g_gameState->totalPlanets) {
-                g_gameState->surveyComplete = true;
+    snap.asteroidPos.resize(g_asteroidField.size());
+    for (size_t i = 0; i < g_asteroidField.size(); ++i) {
+        snap.asteroidPos[i] = g_asteroidField.position(i);
+    }
+
+    updateOrbits(g_simTime);
+    captureBodies(snap);
+
+    indexBodies();
+    g_asteroidGrid.resize(g_asteroidField.size());
+    indexAsteroids(0, g_asteroidField.size());
+    g_asteroidGrid.build();
+}
+
+// One fixed simulation step, run as a job graph: the only place world state
+// changes. Input has already moved the player (from oldPos); the world clock
+// advances by the time warp, and the new state ends up in g_currSnapshot (the
+// old one moves to g_prevSnapshot).
+//
+//   asteroids + grid slots (ranges) --+--> asteroid grid --+---------------------------------------+
+//   N-body clusters ------------------+--> asteroid snapshot (ranges)                              |
+//                                                          v                                       v
+//   orbits ------------------------------------------> probes --> body grid --> gameplay --> player sweep --> sun/planet push-out --> asteroid push-out --> camera snapshot
+//                                                                                   '------> body snapshot
+//   HUD animation
+void runSimulationTick(const glm::dvec3& oldPos, const TickInput& input, float dt, int& lastTarget) {
+    g_simTick += timeWarp();
+    g_simTime = (double)g_simTick * SIM_DT;
+
+    std::swap(g_prevSnapshot, g_currSnapshot);
+    WorldSnapshot& snap = g_currSnapshot;
+    snap.tick = g_simTick;
+    snap.time = g_simTime;
+    snap.asteroidPos.resize(g_asteroidField.size());
+    g_asteroidGrid.resize(g_asteroidField.size());
+    g_asteroidPeriods.resize(g_asteroidField.size(), 1);
+    g_simLod.beginTick(playerPosition(), g_camera->Front, g_camera->BoostSpeed * SIM_DT);
+
+    uint64_t tick = g_simTick;
+    size_t asteroidCount = g_asteroidField.size();
+
+    JobGraph graph;
+
+    // World motion: the orbiting entities and the asteroid field, whatever of
+    // them the LOD has due evaluated directly at the new tick (each asteroid
+    // goes straight into its grid slot while it's still in cache)
+    size_t closedForm = g_clusterGravity ? g_asteroidField.beltCount() : asteroidCount;
+    JobGraph::Node asteroids = graph.addParallelFor(closedForm, 4096, [tick](size_t begin, size_t end) {
+        updateAsteroids(tick, begin, end);
+    });
+
+    // With --nbody the clusters take a gravity step instead (its tree build
+    // and force pass fan out over the job system themselves; the bodies pull
+    // on each other, so all of them step every tick), then go into their
+    // field and grid slots
+    JobGraph::Node clusters = asteroids;
+    if (g_clusterGravity) {
+        float step = std::min(SIM_DT * (float)timeWarp(), NBODY_MAX_STEP);
+        JobGraph::Node stepped = graph.add([step]() {
+            g_clusterGravity->step(step, g_jobs.get());
+            g_simLod.count(g_clusterGravity->size(), g_clusterGravity->size());
+        });
+        JobGraph::Node stored = graph.addParallelFor(g_clusterGravity->size(), 4096, [](size_t begin, size_t end) {
+            g_clusterGravity->store(g_asteroidField, begin, end);
+        }, { stepped });
+        clusters = graph.addParallelFor(asteroidCount - closedForm, 4096, [closedForm](size_t begin, size_t end) {
+            indexAsteroids(closedForm + begin, closedForm + end);
+        }, { stored });
+    }
+    JobGraph::Node orbits = graph.add([&]() { updateOrbits(snap.time); });
+
+    // The broad phase, once everything is where this tick puts it
+    JobGraph::Node asteroidGrid = graph.add([]() { g_asteroidGrid.build(); }, { asteroids, clusters });
+    // Probes fly among the moved planets and asteroids
+    JobGraph::Node probes = graph.add([dt]() { updateProbes(dt); }, { orbits, asteroidGrid });
+    JobGraph::Node bodyGrid = graph.add([]() { indexBodies(); }, { probes });
+
+    // Gameplay comes before anything that reads the probes (a restart re-rolls
+    // them) or moves the player
+    JobGraph::Node gameplay = graph.add([&]() { updateGameplay(input, dt, lastTarget); }, { bodyGrid });
+    graph.add([&]() { captureBodies(snap); }, { gameplay });
+
+    JobGraph::Node swept = graph.add([&]() { sweepPlayer(oldPos); }, { gameplay, asteroidGrid });
+    JobGraph::Node bodies = graph.add([&]() { resolveBodyCollisions(); }, { swept });
+    JobGraph::Node resolved = graph.add([&]() { resolveAsteroidHit(findAsteroidHit()); }, { bodies });
+    graph.add([&]() { snap.cameraPos = g_camera->Position; }, { resolved });
+
+    graph.addParallelFor(asteroidCount, 4096, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) snap.asteroidPos[i] = g_asteroidField.position(i);
+    }, { asteroids, clusters });
+
+    graph.add([dt]() { updateHUDAnimation(dt); });
+
+    graph.run(*g_jobs);
+    g_simLod.endTick();
+}
+
+// Moves the player (input is polled on the main thread), then runs the tick
+void simulationTick(const TickInput& input, float dt, int& lastTarget) {
+    // The tick sweeps the player's move from here
+    glm::dvec3 oldPos = g_camera->Position;
+
+    // Input-driven movement (WASD etc. handled inside Camera), always real time
+    g_camera->ProcessKeyboard(input.move, dt);
+
+    runSimulationTick(oldPos, input, dt, lastTarget);
+}
+
+// What a session's checksums cover: the world clock, the player, every body
+// and asteroid as the latest tick left them, and the score
+uint64_t stateChecksum() {
+    const WorldSnapshot& snap = g_currSnapshot;
+    uint64_t h = SessionLog::hash(&snap.tick, sizeof(snap.tick));
+    h = SessionLog::hash(&g_camera->Position, sizeof(g_camera->Position), h);
+    h = SessionLog::hash(&g_camera->Velocity, sizeof(g_camera->Velocity), h);
+    for (const BodyState& body : snap.bodies) {
+        h = SessionLog::hash(&body.position, sizeof(body.position), h);
+    }
+    h = SessionLog::hash(snap.asteroidPos.data(), snap.asteroidPos.size() * sizeof(glm::vec3), h);
+    if (g_gameState) {
+        int score[2] = { g_gameState->score, g_gameState->scannedPlanets };
+        h = SessionLog::hash(score, sizeof(score), h);
+    }
+    return h;
+}
+
+// Starts a frame: adds its real time to the accumulator and works out how
+// many fixed ticks it runs. A replay's next frame replaces the frame time and
+// sets the camera's orientation and the time warp (false once it's over); a
+// recording writes them down.
+bool beginFrame(SessionLog::Frame& frame, double& accumulator) {
+    if (g_replay) {
+        if (!g_replay->frame(frame)) return false;
+        g_camera->SetOrientation(frame.yaw, frame.pitch);
+        g_timeWarpLevel = std::min((int)frame.warpLevel, TIME_WARP_LEVEL_COUNT - 1);
+    }
+
+    accumulator += frame.seconds;
+    int ticks = 0;
+    while (accumulator >= SIM_DT) {
+        accumulator -= SIM_DT;
+        ++ticks;
+    }
+    if (g_replay && ticks != frame.ticks) {
+        throw std::runtime_error("Session log was recorded at a different tick rate");
+    }
+    frame.ticks = (uint8_t)ticks;
+
+    if (g_recorder) {
+        frame.yaw = g_camera->Yaw;
+        frame.pitch = g_camera->Pitch;
+        frame.warpLevel = (uint8_t)g_timeWarpLevel;
+        g_recorder->frame(frame);
+    }
+    return true;
+}
+
+// One fixed tick of a frame. A replay's recorded keys replace the given
+// input; a recording writes them down. Every SessionLog::CHECK_INTERVAL ticks
+// the state is checksummed, and a replay reports the first time it differs.
+void runSessionTick(TickInput input, int& lastTarget) {
+    if (g_replay) input = unpackTickInput(g_replay->tick());
+    if (g_recorder) g_recorder->tick(packTickInput(input));
+
+    simulationTick(input, SIM_DT, lastTarget);
+
+    if (g_recorder && SessionLog::checksummed(g_recorder->ticks())) {
+        g_recorder->checksum(stateChecksum());
+    }
+    if (g_replay && SessionLog::checksummed(g_replay->ticks())) {
+        bool first = !g_replay->diverged();
+        if (!g_replay->checksum(stateChecksum()) && first) {
+            std::cerr << "Replay diverged from the recording by tick " << g_replay->ticks() << std::endl;
+        }
+    }
+}
+
+// Blends the last two ticks; alpha is how far we are into the next one.
+// Orbits are evaluated exactly at the in-between time rather than blended.
+void interpolateSnapshot(const WorldSnapshot& prev, const WorldSnapshot& curr, float alpha, WorldSnapshot& out) {
+    out.time = glm::mix(prev.time, curr.time, (double)alpha);
+    out.cameraPos = glm::mix(prev.cameraPos, curr.cameraPos, (double)alpha);
+
+    JobGraph graph;
+
+    // Asteroids are blended across a single world tick only: a warped tick
+    // moves them far along their (curved) orbits, so a straight blend would
+    // cut across them. Show the latest tick instead (also if the count changed).
+    if (curr.tick - prev.tick == 1 && prev.asteroidPos.size() == curr.asteroidPos.size()) {
+        out.asteroidPos.resize(curr.asteroidPos.size());
+        graph.addParallelFor(curr.asteroidPos.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                out.asteroidPos[i] = glm::mix(prev.asteroidPos[i], curr.asteroidPos[i], alpha);
             }
+        });
+    }
+    else {
+        out.asteroidPos = curr.asteroidPos;
+    }
+    graph.add([&]() {
+        out.bodies = curr.bodies;
+        evaluateOrbits(out.time, (1.0f - alpha) * SIM_DT, out.bodies);
+    });
+
+    graph.run(*g_jobs);
+}
+
+// Render packets (built on the main thread, nothing here touches GL)
+
+// One home-system planet: transform, surface uniforms and the scan highlight
+static void buildPlanetDraw(const BodyState& body, RenderPacket& packet) {
+    const WorldSnapshot& snap = g_renderSnapshot;
+    const Planet& planet = g_planets[body.index];
+    glm::vec3 offset = offsetFrom(body.position, snap.cameraPos);
+    float distance = glm::length(offset);
+
+    PlanetDraw draw;
+    draw.index = body.index;
+
+    // Model transform: translate -> rotate -> scale
+    draw.frame = getBodyFrame(offset, body.spin);
+    draw.model = glm::scale(draw.frame, glm::vec3(body.scale));
+
+    draw.noiseOffset = planet.noiseOffset;
+    draw.seed = (float)planet.seed;
+    draw.biomeType = planet.biomeType;
 
-            // Debug shortcut: press K to instantly complete the game
-            if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS) {
-                for (auto& p : g_planets) p.scanned = true;
-                g_gameState->scannedPlanets = g_gameState->totalPlanets;
-                g_gameState->surveyComplete = true;
-                g_gameState->resetScan();
+    int slice = planet.seed % (int)planet.surfaceVariation.size();
+    draw.surfaceNoise = planet.surfaceVariation[slice];
+    draw.color = PlanetGenerator::getPlanetSurfaceColor(planet, draw.surfaceNoise);
+
+    // Scan highlight if this is the current target and player is aiming + in range
+    draw.highlight = 0.0f;
+
+    const Scannable* scannable = g_world.find<Scannable>(body.entity);
+    if (g_gameState && g_gameState->currentTarget == body.index && scannable && !scannable->scanned) {
+        float scanRange = planet.collisionRadius + 12.0f;
+        bool aimed = isLookingAtTarget(body.position, 6.0f);
+
+        if (aimed && distance < scanRange) {
+            draw.highlight = g_gameState->isScanning ? 0.25f : 0.15f;
+        }
+    }
+
+    draw.terrain = g_planetTerrain && g_planetTerrain->isActive(body.index, distance);
+    packet.planets.push_back(draw);
+}
+
+// Planets, moons and probes from the snapshot's bodies
+static void buildBodyDraws(RenderPacket& packet) {
+    packet.planets.clear();
+    packet.moons.clear();
+    packet.probes.clear();
+    packet.brokenProbes.clear();
+
+    for (const BodyState& body : g_renderSnapshot.bodies) {
+        if (body.model == RenderModel::Planet) {
+            buildPlanetDraw(body, packet);
+            continue;
+        }
+
+        glm::vec3 offset = offsetFrom(body.position, g_renderSnapshot.cameraPos);
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), offset), glm::vec3(body.scale));
+        if (body.model == RenderModel::Moon) packet.moons.push_back(model);
+        else if (body.model == RenderModel::Probe) packet.probes.push_back(model);
+        else packet.brokenProbes.push_back(model);
+    }
+}
+
+// Neighbouring systems, copied out of the streamer's cache (which may evict
+// them while the render thread is drawing)
+static void buildSectorDraws(RenderPacket& packet) {
+    double t = g_renderSnapshot.time;
+    packet.sectorSuns.clear();
+    packet.sectorPlanets.clear();
+
+    for (const StarSystem* sys : g_visibleSystems) {
+        glm::vec3 sunPos = offsetFrom(sys->origin + glm::dvec3(sys->sun.pos), g_renderSnapshot.cameraPos);
+
+        SectorSunDraw sun;
+        sun.model = glm::scale(glm::translate(glm::mat4(1.0f), sunPos), glm::vec3(sys->sun.radius));
+        sun.color = sys->sunColor;
+        sun.lightPos = sunPos;
+        sun.firstPlanet = packet.sectorPlanets.size();
+        sun.planetCount = sys->planets.size();
+        packet.sectorSuns.push_back(sun);
+
+        for (const auto& planet : sys->planets) {
+            glm::vec3 planetPos = sunPos + Orbits::planetOffset(planet, t);
+
+            SectorPlanetDraw draw;
+            draw.model = glm::translate(glm::mat4(1.0f), planetPos);
+            draw.model = glm::rotate(draw.model, glm::radians(Orbits::planetSpin(planet, t)), glm::vec3(0.0f, 1.0f, 0.0f));
+            draw.model = glm::scale(draw.model, glm::vec3(planet.size));
+            draw.noiseOffset = planet.noiseOffset;
+            draw.seed = (float)planet.seed;
+            draw.biomeType = planet.biomeType;
+            draw.color = planet.color;
+            packet.sectorPlanets.push_back(draw);
+        }
+    }
+}
+
+// Fills a packet from the interpolated snapshot, the camera and the game state,
+// relative to the snapshot's camera position (view only rotates).
+// The asteroid matrices are by far the most work and are built on the job system.
+void buildRenderPacket(RenderPacket& packet, const glm::mat4& view, const glm::mat4& projection) {
+    const WorldSnapshot& snap = g_renderSnapshot;
+    const glm::dvec3& eye = snap.cameraPos;
+
+    packet.frame = ++g_frameNumber;
+    packet.viewportWidth = g_framebufferWidth;
+    packet.viewportHeight = g_framebufferHeight;
+    packet.view = view;
+    packet.projection = projection;
+    packet.lightPos = offsetFrom(g_sun.pos, eye);
+
+    JobGraph graph;
+
+    // Asteroids at their interpolated positions (tumbling with sim time)
+    float currentTime = (float)snap.time;
+    size_t asteroidCount = std::min(g_asteroidField.size(), snap.asteroidPos.size());
+    packet.asteroids.resize(asteroidCount);
+    graph.addParallelFor(asteroidCount, 1024, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const glm::vec3& rot = g_asteroidField.rotation(i);
+
+            // Model transform: translate -> rotate -> scale
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), offsetFrom(snap.asteroidPos[i], eye));
+            model = glm::rotate(model, glm::radians(rot.x + currentTime * 10.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+            model = glm::rotate(model, glm::radians(rot.y + currentTime * 15.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            packet.asteroids[i] = glm::scale(model, glm::vec3(g_asteroidField.scale(i)));
+        }
+    });
+
+    graph.add([&]() {
+        buildBodyDraws(packet);
+        buildSectorDraws(packet);
+    });
+
+    // The HUD's radar is a grid query
+    graph.add([&]() { buildHUD(packet.hud); });
+
+    graph.run(*g_jobs);
+}
+
+// Render thread body: takes the GL context, then draws each packet as it
+// arrives (one frame behind the main thread) until the queue is stopped
+void renderThreadMain(GLFWwindow* window) {
+    glfwMakeContextCurrent(window);
+
+    try {
+        int viewportWidth = 0, viewportHeight = 0;
+
+        while (const RenderPacket* packet = g_renderPackets.acquire()) {
+            if (packet->viewportWidth != viewportWidth || packet->viewportHeight != viewportHeight) {
+                viewportWidth = packet->viewportWidth;
+                viewportHeight = packet->viewportHeight;
+                glViewport(0, 0, viewportWidth, viewportHeight);
+            }
+
+            // Upload finished terrain chunks, queue the ones selection asked for
+            g_planetTerrain->update();
+
+            render(*packet);
+            if (g_flythrough && packet->frame <= g_flythrough->frameCount()) {
+                g_flythrough->recordRender((size_t)packet->frame - 1, RenderStats::take());
             }
 
-            // Restart game on completion (press R)
-            if (g_gameState && g_gameState->surveyComplete && glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
-                g_gameState->surveyComplete = false;
-                g_gameState->score = 0;
-                g_gameState->scannedPlanets = 0;
-                g_gameState->resetScan();
+            // Everything is submitted: the main thread can refill the packet
+            // while we wait on the swap
+            g_renderPackets.release();
+            glfwSwapBuffers(window);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Render thread error: " << e.what() << std::endl;
+        glfwSetWindowShouldClose(window, true);
+        g_renderPackets.stop();
+    }
 
-                for (auto& p : g_planets) p.scanned = false;
+    glfwMakeContextCurrent(nullptr);
+}
 
-                // Re-roll probes so the new run feels different
-                spawnProbesForPlanets();
+// The benchmarks' world: the game's planets and probes, with a belt of the
+// given size and clusters to match
+static void buildBenchmarkWorld(int beltAsteroids, std::vector<Asteroid>& asteroids) {
+    srand((unsigned)g_worldSeed);
+
+    PlanetGenerator::generatePlanets(g_planets, g_worldSeed);
+    PlanetGenerator::generateAsteroids(asteroids, g_worldSeed, beltAsteroids);
+    PlanetGenerator::generateAsteroidClusters(asteroids, g_worldSeed, std::max(4, beltAsteroids / 30), 25, 55, 300.0f, 1400.0f);
+    g_asteroidField.build(asteroids, SIM_DT);
+
+    if (!g_jobs) g_jobs = std::make_unique<JobSystem>(parallelThreadCount());
+    spawnBodies();
+    spawnProbesForPlanets();
+    g_gameState = std::make_unique<GameState>();
+    g_gameState->totalPlanets = (int)g_planets.size();
+}
+
+// Headless time-warp benchmark (--warp-bench): runs the per-tick world work
+// (the tick graph without player input, then interpolation) at every warp level
+// and checks the cost stays flat and the orbits stay on their ellipses.
+// beltAsteroids scales the field up from the game's 120.
+bool benchmarkTimeWarp(int beltAsteroids) {
+    std::vector<Asteroid> asteroids;
+    buildBenchmarkWorld(beltAsteroids, asteroids);
+    int lastTarget = -1;
+
+    // The simulation LOD updates more in view under warp, on purpose (and
+    // has its own bench); this measures the warp alone
+    bool lod = g_simLod.isEnabled();
+    g_simLod.setEnabled(false);
+
+    const int ticks = 1200;
+    bool ok = true;
+    double baseMs = 0.0, worstRatio = 0.0;
+
+    // Level -1 is an untimed 1x pass that warms up the snapshot vectors
+    for (int level = -1; level < TIME_WARP_LEVEL_COUNT; ++level) {
+        g_timeWarpLevel = std::max(level, 0);
+        g_simTick = 0;
+        g_simTime = 0.0;
+        g_camera = std::make_unique<Camera>(glm::dvec3(0.0, 30.0, 100.0));
+
+        // --nbody clusters start every level from the generated field
+        g_asteroidField.evaluate(0);
+        buildClusterGravity(asteroids);
+        captureSnapshot(g_currSnapshot);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            runSimulationTick(g_camera->Position, TickInput(), SIM_DT, lastTarget);
+            interpolateSnapshot(g_prevSnapshot, g_currSnapshot, 0.5f, g_renderSnapshot);
+        }
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count() / ticks;
+        if (level < 0) continue;
+        if (level == 0) baseMs = ms;
+        double ratio = baseMs > 0.0 ? ms / baseMs : 0.0;
+        worstRatio = std::max(worstRatio, ratio);
+
+        // Every planet must still be between periapsis and apoapsis
+        bool stable = true;
+        for (const BodyState& body : g_currSnapshot.bodies) {
+            if (body.model != RenderModel::Planet) continue;
+            const Planet& p = g_planets[body.index];
+            glm::vec3 offset = body.position - g_sun.pos - glm::vec3(0.0f, p.height, 0.0f);
+            float r = glm::length(offset);
+            if (!(r > p.distance * (1.0f - p.eccentricity) * 0.999f && r < p.distance * (1.0f + p.eccentricity) * 1.001f)) {
+                stable = false;
             }
+        }
+        for (const glm::vec3& a : g_currSnapshot.asteroidPos) {
+            if (!std::isfinite(a.x) || !std::isfinite(a.y) || !std::isfinite(a.z)) stable = false;
+        }
 
-            // Collision checks
+        // ...and every probe still patrolling near its planet
+        g_world.each<const Transform, const Boid>([&](Entity, const Transform& transform, const Boid& boid) {
+            float patrol = g_world.get<Collider>(boid.goal).radius + boid.gap;
+            if (!(glm::distance(transform.position, boid.anchor) < 2.0f * patrol)) stable = false;
+        });
 
-            float playerRadius = 2.0f;
+        std::cout << "Warp bench: " << timeWarp() << "x, " << g_asteroidField.size() << " asteroids, "
+            << (g_simTime / 86400.0) << " days simulated, " << ms << " ms/tick ("
+            << ratio << "x the 1x cost), " << (stable ? "orbits stable" : "ORBITS UNSTABLE") << std::endl;
+        ok = ok && stable;
+    }
+
+    // Timing noise aside, no level should cost noticeably more than 1x
+    bool flat = worstRatio < 1.5;
+    std::cout << "Warp bench: worst level " << worstRatio << "x the 1x cost"
+        << (flat ? " (flat)" : " (NOT FLAT)") << std::endl;
+    g_simLod.setEnabled(lod);
+    return ok && flat;
+}
 
-            // Sun collision
-            if (checkSphereCollision(g_camera->Position, playerRadius, g_sun.pos, g_sun.radius)) {
-                g_camera->Position = oldPos;
+// Per-tick cost and entity updates per second with the simulation LOD off and
+// on, from inside the belt, from out past it and from there facing away. With
+// it on, asteroids near the camera must be exactly where updating every tick
+// puts them, those in view no more than a pixel off, and probes on long
+// periods still patrolling their planets.
+bool benchmarkSimLod(int beltAsteroids) {
+    std::vector<Asteroid> asteroids;
+    buildBenchmarkWorld(beltAsteroids, asteroids);
+    int lastTarget = -1;
+
+    struct View {
+        const char* name;
+        glm::vec3 position;
+        bool facingAway;
+    };
+    const View views[] = {
+        { "in the belt", glm::vec3(0.0f, 30.0f, 100.0f), false },
+        { "out past the belt", glm::vec3(0.0f, 60.0f, 1000.0f), false },
+        { "out past the belt, facing away", glm::vec3(0.0f, 60.0f, 1000.0f), true },
+    };
+    const int ticks = 600;
+    const float PIXEL = glm::radians(60.0f) / WINDOW_HEIGHT;
+    size_t exactCount = g_nbodyClusters ? g_asteroidField.beltCount() : g_asteroidField.size();
+    bool ok = true;
+
+    for (const View& view : views) {
+        double ms[2] = { 0.0, 0.0 };
+        for (int lod = 0; lod < 2; ++lod) {
+            g_simLod.setEnabled(lod == 1);
+            g_timeWarpLevel = 0;
+            g_simTick = 0;
+            g_simTime = 0.0;
+            g_camera = std::make_unique<Camera>(glm::dvec3(view.position));
+            if (view.facingAway) g_camera->ProcessMouse(180.0f / g_camera->Sensitivity, 0.0f);
+
+            g_asteroidField.evaluate(0);
+            buildClusterGravity(asteroids);
+            captureSnapshot(g_currSnapshot);
+
+            // A second untimed, so the periods settle and the rates fill in
+            for (int t = 0; t < 60; ++t) runSimulationTick(g_camera->Position, TickInput(), SIM_DT, lastTarget);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < ticks; ++t) {
+                runSimulationTick(g_camera->Position, TickInput(), SIM_DT, lastTarget);
+                interpolateSnapshot(g_prevSnapshot, g_currSnapshot, 0.5f, g_renderSnapshot);
             }
+            ms[lod] = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count() / ticks;
 
-            // Planet collision
-            for (const auto& planet : g_planets) {
-                glm::vec3 planetPos = getPlanetWorldPosition(planet);
-                if (checkSphereCollision(g_camera->Position, playerRadius, planetPos, planet.collisionRadius)) {
-                    g_camera->Position = oldPos;
-                    break;
-                }
+            std::cout << "LOD bench: " << view.name << ", LOD " << (lod ? "on" : "off") << ": "
+                << ms[lod] << " ms/tick, " << (long long)g_simLod.updatesPerSecond() << " updates/s of "
+                << (long long)g_simLod.fullRatePerSecond() << std::endl;
+        }
+
+        float nearError = 0.0f, viewPixels = 0.0f;
+        glm::vec3 eye = playerPosition();
+        for (size_t i = 0; i < exactCount; ++i) {
+            glm::vec3 exact = g_asteroidField.positionAt(i, g_simTick);
+            float error = glm::distance(g_asteroidField.position(i), exact);
+            float centre = glm::distance(exact, eye);
+            if (centre - g_asteroidField.collisionRadius(i) < SimLod::NEAR_DISTANCE) {
+                nearError = std::max(nearError, error);
+            }
+            else if (glm::dot(exact - eye, g_camera->Front) > std::cos(glm::radians(SimLod::VIEW_HALF_ANGLE)) * centre) {
+                viewPixels = std::max(viewPixels, error / centre / PIXEL);
             }
+        }
+        bool patrolling = true;
+        g_world.each<const Transform, const Boid>([&](Entity, const Transform& transform, const Boid& boid) {
+            float patrol = g_world.get<Collider>(boid.goal).radius + boid.gap;
+            if (!(glm::distance(transform.position, boid.anchor) < 2.0f * patrol)) patrolling = false;
+        });
+
+        bool accurate = nearError == 0.0f && viewPixels <= 1.0f && patrolling;
+        std::cout << "LOD bench: " << view.name << ": " << (ms[1] > 0.0 ? ms[0] / ms[1] : 0.0)
+            << "x faster, near asteroids off by " << nearError << ", in view by " << viewPixels << " px, "
+            << (patrolling ? "probes patrolling" : "PROBES LOST") << (accurate ? "" : " (FAILED)") << std::endl;
+        ok = ok && accurate;
+    }
+
+    g_simLod.setEnabled(true);
+    return ok;
+}
+
+// Camera-relative rendering and double-precision movement far from the origin
+// (--origin-selftest). At each distance, points a few units in front of the
+// camera have to land on screen within a hundredth of a pixel of where exact
+// maths puts them (drawing in world space with floats, as before, is printed
+// for comparison), and a minute of slow flight through sweepPlayer has to
+// cover the distance it was given.
+bool originSelfTest() {
+    const double distances[] = { 1.0e3, 1.0e5, 1.0e6, 1.0e7 };
+    const glm::vec3 nearby[] = {
+        glm::vec3(3.0f, -1.0f, -10.0f), glm::vec3(-2.0f, 1.5f, -4.0f), glm::vec3(0.2f, 0.1f, -1.5f)
+    };
+    const glm::vec3 corner(0.5f);   // of a unit cube, in model space
+    const glm::vec3 velocity(0.3f, 0.0f, -0.2f);
+    const int ticks = 60 * 60;
+    glm::mat4 projection = cameraProjection();
+    bool ok = true;
+
+    for (double distance : distances) {
+        glm::dvec3 start = glm::normalize(glm::dvec3(1.0, 0.3, -0.7)) * distance;
+        g_camera = std::make_unique<Camera>(start);
+        g_camera->ProcessMouse(300.0f, -120.0f);
+        const Camera& camera = *g_camera;
+
+        // Exact: view space in doubles, then the projection's x and y scales
+        glm::dvec3 right(camera.Right), up(camera.Up), back(-camera.Front);
+        double sx = projection[0][0], sy = projection[1][1];
+
+        float relativePixels = 0.0f, worldPixels = 0.0f;
+        for (const glm::vec3& offset : nearby) {
+            glm::dvec3 position = camera.Position + glm::dvec3(offset);
+            glm::dvec3 v = position + glm::dvec3(corner) - camera.Position;
+            glm::dvec3 view(glm::dot(v, right), glm::dot(v, up), glm::dot(v, back));
+            glm::dvec2 exact(sx * view.x / -view.z, sy * view.y / -view.z);
+
+            glm::mat4 relativeModel = glm::translate(glm::mat4(1.0f), offsetFrom(position, camera.Position));
+            glm::vec4 relative = projection * camera.GetViewMatrix() * relativeModel * glm::vec4(corner, 1.0f);
+
+            glm::vec3 eye = glm::vec3(camera.Position);
+            glm::mat4 worldView = glm::lookAt(eye, eye + camera.Front, camera.Up);
+            glm::mat4 worldModel = glm::translate(glm::mat4(1.0f), glm::vec3(position));
+            glm::vec4 world = projection * worldView * worldModel * glm::vec4(corner, 1.0f);
+
+            auto pixels = [&](const glm::vec4& clip) {
+                glm::dvec2 ndc(clip.x / clip.w, clip.y / clip.w);
+                return (float)(glm::length(ndc - exact) * 0.5 * WINDOW_HEIGHT);
+            };
+            relativePixels = std::max(relativePixels, pixels(relative));
+            worldPixels = std::max(worldPixels, pixels(world));
+        }
+
+        // A minute at walking pace, one tick's move at a time
+        glm::vec3 startFloat = glm::vec3(start);
+        glm::vec3 floatPos = startFloat;
+        for (int t = 0; t < ticks; ++t) {
+            glm::dvec3 oldPos = g_camera->Position;
+            g_camera->Position += glm::dvec3(velocity * SIM_DT);
+            sweepPlayer(oldPos);
+            floatPos += velocity * SIM_DT;
+        }
+        double expected = glm::length(velocity) * SIM_DT * ticks;
+        double flown = glm::length(g_camera->Position - start);
+        double floatFlown = glm::length(glm::dvec3(floatPos) - glm::dvec3(startFloat));
+
+        bool good = relativePixels < 0.01f && std::abs(flown - expected) < 1.0e-6 * expected;
+        std::cout << "Origin selftest: " << distance << " units out: camera-relative off by " << relativePixels
+            << " px (world-space floats: " << worldPixels << " px), flew " << flown << " of " << expected
+            << " (floats: " << floatFlown << ")" << (good ? "" : " (FAILED)") << std::endl;
+        ok = ok && good;
+    }
+
+    g_camera.reset();
+    std::cout << (ok ? "Origin selftest passed" : "Origin selftest FAILED") << std::endl;
+    return ok;
+}
 
-            // Asteroid collision
-            for (const auto& asteroid : g_asteroids) {
-                if (checkSphereCollision(g_camera->Position, playerRadius, asteroid.pos, asteroid.collisionRadius)) {
-                    g_camera->Position = oldPos;
-                    break;
+// Puts the benchmark world back as it was generated, as a fresh run would
+// start it: clock, LOD schedule, camera, asteroids, orbits, probes and score
+static void restartBenchmarkWorld(const std::vector<Asteroid>& asteroids, int& lastTarget) {
+    g_timeWarpLevel = 0;
+    g_simTick = 0;
+    g_simTime = 0.0;
+    g_simLod.reset();
+    g_camera = std::make_unique<Camera>(glm::dvec3(0.0, 30.0, 100.0));
+
+    g_asteroidField.evaluate(0);
+    g_asteroidPeriods.assign(g_asteroidField.size(), 1);
+    buildClusterGravity(asteroids);
+
+    // A fresh world rather than a patched one, so entities are stored (and
+    // so visited) in the order the recording's were
+    srand((unsigned)g_worldSeed);
+    spawnBodies();
+    spawnProbesForPlanets();
+    g_gameState = std::make_unique<GameState>();
+    g_gameState->totalPlanets = (int)g_planets.size();
+    lastTarget = -1;
+
+    captureSnapshot(g_currSnapshot);
+    g_prevSnapshot = g_currSnapshot;
+}
+
+// Replays whatever is in g_replay from the restarted benchmark world; after
+// nudgeAfter ticks the player is moved a hair off the recorded path
+static uint64_t replayBenchmarkSession(const std::vector<Asteroid>& asteroids, uint64_t nudgeAfter) {
+    int lastTarget = -1;
+    restartBenchmarkWorld(asteroids, lastTarget);
+    double accumulator = 0.0;
+    SessionLog::Frame frame;
+    while (beginFrame(frame, accumulator)) {
+        for (int t = 0; t < frame.ticks; ++t) {
+            runSessionTick(TickInput(), lastTarget);
+            if (g_replay->ticks() == nudgeAfter) g_camera->Position.x += 1.0e-4;
+        }
+    }
+    return stateChecksum();
+}
+
+// Records a scripted session on the benchmark world (uneven frame times, flying
+// and turning, boosting, scanning, time warp up and back down), then checks
+// that replaying it matches every checksum and ends in the same state, and
+// that a replay knocked off course by a tenth of a millimetre is caught
+// within one checksum interval (--replay-selftest).
+bool replaySelfTest() {
+    const char* path = "replay-selftest.session";
+    std::vector<Asteroid> asteroids;
+    buildBenchmarkWorld(2000, asteroids);
+    int lastTarget = -1;
+    restartBenchmarkWorld(asteroids, lastTarget);
+
+    SessionLog::Header header;
+    header.seed = g_worldSeed;
+    header.nbody = g_nbodyClusters;
+    header.nbodyTheta = g_nbodyTheta;
+    header.simLod = g_simLod.isEnabled();
+    header.asteroidPath = AsteroidField::pathName();
+    g_recorder = std::make_unique<SessionLog::Recorder>(path, header);
+
+    EntityRng rng(g_worldSeed, STREAM_SECTOR, 47);
+    const int frames = 1500;
+    double accumulator = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        // What the window's events would have done since the last frame
+        g_camera->ProcessMouse(rng.uniform(-4.0f, 6.0f), rng.uniform(-3.0f, 3.0f));
+        g_timeWarpLevel = (f >= 600 && f < 800) ? 3 : 0;
+
+        SessionLog::Frame frame;
+        frame.seconds = std::min(SIM_DT * rng.uniform(0.5f, 2.5f) + (f % 300 == 299 ? 0.2f : 0.0f), MAX_FRAME_TIME);
+        beginFrame(frame, accumulator);
+        for (int t = 0; t < frame.ticks; ++t) {
+            TickInput input;
+            input.move.forward = f % 400 < 300;
+            input.move.boost = f % 400 >= 150 && f % 400 < 200;
+            input.move.left = f % 250 < 40;
+            input.move.up = f % 500 >= 450;
+            input.scan = f >= 1000;
+            runSessionTick(input, lastTarget);
+        }
+    }
+    uint64_t recordedTicks = g_recorder->ticks();
+    uint64_t recordedState = stateChecksum();
+    g_recorder.reset();
+
+    g_replay = std::make_unique<SessionLog::Replay>(path);
+    uint64_t replayedState = replayBenchmarkSession(asteroids, 0);
+    bool matched = !g_replay->diverged() && g_replay->ticks() == recordedTicks && replayedState == recordedState;
+
+    const uint64_t nudgeAfter = recordedTicks / 2;
+    g_replay = std::make_unique<SessionLog::Replay>(path);
+    replayBenchmarkSession(asteroids, nudgeAfter);
+    bool caught = g_replay->diverged() && g_replay->mismatchTick() > nudgeAfter
+        && g_replay->mismatchTick() <= nudgeAfter + SessionLog::CHECK_INTERVAL;
+    uint64_t caughtAt = g_replay->mismatchTick();
+    g_replay.reset();
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    double bytes = (double)file.tellg();
+    file.close();
+    std::remove(path);
+
+    std::cout << "Replay selftest: " << frames << " frames, " << recordedTicks << " ticks, "
+        << bytes / recordedTicks << " bytes/tick logged; replay "
+        << (matched ? "matched every checksum and the final state" : "DIVERGED") << "; nudged after tick "
+        << nudgeAfter << ", " << (caught ? "caught" : "NOT CAUGHT") << " at the checksum after tick " << caughtAt << std::endl;
+    return matched && caught;
+}
+
+// A replay's real frame times as a performance capture
+static void reportReplay(std::vector<double>& frameMs) {
+    if (frameMs.empty()) return;
+    std::sort(frameMs.begin(), frameMs.end());
+    double total = 0.0;
+    for (double ms : frameMs) total += ms;
+    auto percentile = [&](double p) { return frameMs[std::min(frameMs.size() - 1, (size_t)(p * frameMs.size()))]; };
+
+    std::cout << "Replay: " << frameMs.size() << " frames, " << g_replay->ticks() << " ticks, "
+        << total / frameMs.size() << " ms/frame mean, " << percentile(0.5) << " median, "
+        << percentile(0.99) << " 99th percentile, " << frameMs.back() << " worst; ";
+    if (g_replay->diverged()) std::cout << "DIVERGED by tick " << g_replay->mismatchTick() << std::endl;
+    else std::cout << "every checksum matched" << std::endl;
+}
+
+// The perf gate's scenarios (see PerfGate.h), each timed per run in ms:
+//   generation_ms      generating the world and baking its planets, as at start-up
+//   sim_tick_ms        a tick of the benchmark world with the player flying and turning
+//   render_packet_ms   a frame's render packet (instances, HUD) from the main
+//                      thread; the GL side needs a window (see --flythrough)
+//   hud_build_ms       the HUD geometry alone
+const int PERF_BELT_ASTEROIDS = 5000;
+const int PERF_TICKS = 120;
+const int PERF_FRAMES = 120;
+const int PERF_HUD_BUILDS = 500;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<PerfGate::Metric> runPerfScenarios(int runs) {
+    std::vector<PerfGate::Metric> metrics;
+
+    metrics.push_back(PerfGate::measure("generation_ms", runs, []() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Planet> planets;
+        std::vector<Asteroid> asteroids;
+        std::vector<Star> stars;
+        PlanetGenerator::generatePlanets(planets, g_worldSeed);
+        PlanetGenerator::generateAsteroids(asteroids, g_worldSeed, 120);
+        PlanetGenerator::generateStars(stars, g_worldSeed, 2000);
+        PlanetGenerator::generateAsteroidClusters(asteroids, g_worldSeed, 4, 25, 55, 300.0f, 1400.0f);
+        std::vector<PlanetSurfaceBake> bakes;
+        PlanetBaker::bakeSurfaces(planets, PLANET_SURFACE_FACE_SIZE, bakes);
+        return millisecondsSince(start);
+    }));
+
+    std::vector<Asteroid> asteroids;
+    buildBenchmarkWorld(PERF_BELT_ASTEROIDS, asteroids);
+    int lastTarget = -1;
+
+    metrics.push_back(PerfGate::measure("sim_tick_ms", runs, [&]() {
+        restartBenchmarkWorld(asteroids, lastTarget);
+        TickInput input;
+        input.move.forward = true;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < PERF_TICKS; ++t) {
+            g_camera->ProcessMouse(2.0f, 0.0f);
+            simulationTick(input, SIM_DT, lastTarget);
+        }
+        return millisecondsSince(start) / PERF_TICKS;
+    }));
+
+    RenderPacket packet;
+    metrics.push_back(PerfGate::measure("render_packet_ms", runs, [&]() {
+        restartBenchmarkWorld(asteroids, lastTarget);
+        simulationTick(TickInput(), SIM_DT, lastTarget);
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < PERF_FRAMES; ++f) {
+            g_camera->ProcessMouse(4.0f, 0.0f);
+            interpolateSnapshot(g_prevSnapshot, g_currSnapshot, 0.5f, g_renderSnapshot);
+            buildRenderPacket(packet, g_camera->GetViewMatrix(), cameraProjection());
+        }
+        return millisecondsSince(start) / PERF_FRAMES;
+    }));
+
+    HUDGeometry hud;
+    metrics.push_back(PerfGate::measure("hud_build_ms", runs, [&]() {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < PERF_HUD_BUILDS; ++i) buildHUD(hud);
+        return millisecondsSince(start) / PERF_HUD_BUILDS;
+    }));
+
+    return metrics;
+}
+
+// What the perf scenarios are run under; a baseline only compares with
+// runs under the same
+static PerfGate::Config perfConfig() {
+    PerfGate::Config config;
+    config.seed = g_worldSeed;
+    config.threads = g_jobs->threadCount();
+    config.build = PerfGate::buildName();
+    config.noisePath = simdLevelName(Noise::activeLevel());
+    config.asteroidPath = AsteroidField::pathName();
+    config.scenarios = "belt " + std::to_string(PERF_BELT_ASTEROIDS) + ", " + std::to_string(PERF_TICKS)
+        + " ticks, " + std::to_string(PERF_FRAMES) + " frames, " + std::to_string(PERF_HUD_BUILDS)
+        + " HUD builds, n-body " + (g_nbodyClusters ? "theta " + std::to_string(g_nbodyTheta) : std::string("off"))
+        + ", sim LOD " + (g_simLod.isEnabled() ? "on" : "off");
+    return config;
+}
+
+// Runs the perf scenarios, then either checks them against the baseline
+// (exit code 1 if any regressed, 2 if it was measured under a different
+// configuration, without running them) or writes them as the new baseline
+static int runPerfGate(const std::string& baselinePath, bool writeBaseline, int runs) {
+    PerfGate::Baseline baseline;
+    if (!writeBaseline || std::ifstream(baselinePath)) baseline = PerfGate::loadBaseline(baselinePath);
+
+    g_jobs = std::make_unique<JobSystem>(parallelThreadCount());
+    PerfGate::Config config = perfConfig();
+    std::cout << "Perf gate: seed " << config.seed << ", " << runs << " runs a scenario, " << config.threads
+        << " job threads, " << config.build << ", asteroid path " << config.asteroidPath << std::endl;
+    if (!writeBaseline) {
+        std::vector<std::string> mismatches = PerfGate::configMismatches(baseline, config);
+        if (!mismatches.empty()) {
+            std::cout << "Perf gate: " << baselinePath << " wasn't measured under this configuration:" << std::endl;
+            for (const std::string& mismatch : mismatches) std::cout << "  " << mismatch << std::endl;
+            std::cout << "Not comparing: run with the baseline's options, or refresh it with --perf-baseline" << std::endl;
+            return 2;
+        }
+    }
+    std::vector<PerfGate::Metric> metrics = runPerfScenarios(runs);
+
+    if (writeBaseline) {
+        PerfGate::writeBaseline(baselinePath, config, metrics, runs, baseline.metrics);
+        return 0;
+    }
+    std::cout << "Perf gate against " << baselinePath << ":" << std::endl;
+    return PerfGate::compare(metrics, baseline.metrics) ? 0 : 1;
+}
+
+// The benchmark flight: from the start position a lap of the sun just
+// outside the belt, a pass over each asteroid cluster (taken in order round
+// the sun), then a dive at each planet in turn, down to skim its pole and
+// back out. The dives' keyframes move with their planets.
+static std::unique_ptr<Flythrough> buildFlythrough() {
+    auto flight = std::make_unique<Flythrough>(FLYTHROUGH_SPEED, [](int planet, double t) {
+        return glm::dvec3(getPlanetWorldPosition(g_planets[planet], t));
+    });
+    glm::dvec3 sun(g_sun.pos);
+
+    flight->add("sun lap", g_camera->Position);
+    const int lapPoints = 8;
+    for (int i = 1; i <= lapPoints; ++i) {
+        double angle = glm::two_pi<double>() * i / lapPoints + glm::half_pi<double>();
+        flight->add("sun lap", sun + glm::dvec3(std::cos(angle) * 140.0, i % 2 ? 25.0 : -10.0, std::sin(angle) * 140.0));
+    }
+
+    // Clusters are told apart by their centres; each is passed over at
+    // clearance above its furthest member
+    struct ClusterPass {
+        glm::vec3 center;
+        float reach;
+    };
+    std::vector<ClusterPass> clusters;
+    for (size_t i = g_asteroidField.beltCount(); i < g_asteroidField.size(); ++i) {
+        glm::vec3 center = g_asteroidField.clusterCenter(i);
+        auto same = [&](const ClusterPass& c) { return c.center.x == center.x && c.center.z == center.z; };
+        auto cluster = std::find_if(clusters.begin(), clusters.end(), same);
+        if (cluster == clusters.end()) cluster = clusters.insert(clusters.end(), ClusterPass{ center, 0.0f });
+        cluster->reach = std::max(cluster->reach, glm::length(g_asteroidField.position(i) - cluster->center));
+    }
+    std::sort(clusters.begin(), clusters.end(), [](const ClusterPass& a, const ClusterPass& b) {
+        return std::atan2(a.center.z, a.center.x) < std::atan2(b.center.z, b.center.x);
+    });
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        glm::dvec3 over(0.0, clusters[c].reach + 10.0f, 0.0);
+        flight->add("cluster " + std::to_string(c), glm::dvec3(clusters[c].center) + over);
+    }
+
+    for (int p = 0; p < (int)g_planets.size(); ++p) {
+        double radius = g_planets[p].collisionRadius;
+        std::string segment = "planet " + std::to_string(p) + " dive";
+        flight->add(segment, glm::dvec3(-4.0 * radius, 3.0 * radius, 0.0), p);
+        flight->add(segment, glm::dvec3(0.0, 1.4 * radius, 0.0), p);
+        flight->add(segment, glm::dvec3(4.0 * radius, 3.0 * radius, 0.0), p);
+    }
+
+    size_t frames = flight->finish(SIM_DT);
+    std::cout << "Flythrough: " << frames << " frames (" << flight->duration() << " s at a fixed "
+        << SIM_DT * 1000.0f << " ms tick)" << std::endl;
+    return flight;
+}
+
+// One frame of the benchmark flight: puts the camera where the path is after
+// the frame's tick, facing along it, and runs the tick (sweeping the player
+// over the move, as flying there would)
+static void flythroughTick(size_t frame, int& lastTarget) {
+    double t = (double)(frame + 1) * SIM_DT;
+    glm::dvec3 oldPos = g_camera->Position;
+    glm::dvec3 pos = g_flythrough->position(t);
+    glm::dvec3 ahead = g_flythrough->position(t + FLYTHROUGH_LOOK_AHEAD) - pos;
+    if (glm::length(ahead) > 1e-6) {
+        glm::dvec3 facing = glm::normalize(ahead);
+        float yaw = (float)glm::degrees(std::atan2(facing.z, facing.x));
+        float pitch = glm::clamp((float)glm::degrees(std::asin(facing.y)), -89.0f, 89.0f);
+        g_camera->SetOrientation(yaw, pitch);
+    }
+    g_camera->Position = pos;
+    g_camera->Velocity = glm::vec3((pos - oldPos) / (double)SIM_DT);
+
+    g_flythrough->recordFrame(frame, g_flythrough->segmentAt(t));
+    runSimulationTick(oldPos, TickInput(), SIM_DT, lastTarget);
+}
+
+// What the command line asks for. Everything is parsed before anything runs,
+// so an option applies wherever it appears: --flock-bench 5000 --seed 2 is
+// the same run as --seed 2 --flock-bench 5000.
+struct CommandLine {
+    uint64_t seed = 0;
+    bool seedGiven = false;
+    int threads = -1;                     // -1: not given
+    bool bake = true;
+    bool nbody = false;
+    float nbodyTheta = NBody::DEFAULT_THETA;
+    bool simLod = true;
+    std::string recordPath;
+    std::string replayPath;
+    std::string flythroughPath;
+    std::string perfPath;
+    bool perfWriteBaseline = false;
+    int perfRuns = PerfGate::DEFAULT_RUNS;
+    std::string test;                     // self-test or bench to run instead of the game
+    std::string testArg;                  // its count, if one was given
+};
+
+// Self-tests take no argument; benches take an optional count
+static const char* const SELF_TESTS[] = {
+    "--replay-selftest", "--noise-selftest", "--jobs-selftest", "--ecs-selftest",
+    "--grid-selftest", "--sweep-selftest", "--origin-selftest", "--mesh-selftest",
+};
+static const char* const BENCHES[] = {
+    "--bvh-bench", "--nbody-bench", "--flock-bench", "--warp-bench", "--lod-bench", "--asteroid-bench",
+};
+
+static CommandLine parseCommandLine(int argc, char** argv) {
+    CommandLine options;
+
+    // The next argument if it's a value rather than another option, else ""
+    auto optionalValue = [&](int& i) {
+        return i + 1 < argc && argv[i + 1][0] != '-' ? std::string(argv[++i]) : std::string();
+    };
+    auto requiredValue = [&](int& i) {
+        if (i + 1 >= argc) throw std::runtime_error(std::string(argv[i]) + " needs a value");
+        return argv[++i];
+    };
+    auto selectTest = [&](const char* name, const std::string& arg) {
+        if (!options.test.empty()) {
+            throw std::runtime_error("Only one self-test or bench can run at a time (" + options.test + ", " + name + ")");
+        }
+        options.test = name;
+        options.testArg = arg;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--seed") == 0) {
+            options.seed = std::strtoull(requiredValue(i), nullptr, 10);
+            options.seedGiven = true;
+        }
+        else if (std::strcmp(arg, "--threads") == 0) {
+            options.threads = std::max(0, std::atoi(requiredValue(i)));
+        }
+        else if (std::strcmp(arg, "--record") == 0) {
+            options.recordPath = requiredValue(i);
+        }
+        else if (std::strcmp(arg, "--replay") == 0) {
+            options.replayPath = requiredValue(i);
+        }
+        else if (std::strcmp(arg, "--flythrough") == 0) {
+            // Benchmark flight along a spline, reported as JSON (default flythrough.json)
+            options.flythroughPath = optionalValue(i);
+            if (options.flythroughPath.empty()) options.flythroughPath = "flythrough.json";
+        }
+        else if (std::strcmp(arg, "--perf-gate") == 0 || std::strcmp(arg, "--perf-baseline") == 0) {
+            // Time the standard scenarios against (or as) the baseline (default perf-baseline.json)
+            options.perfWriteBaseline = std::strcmp(arg, "--perf-baseline") == 0;
+            options.perfPath = optionalValue(i);
+            if (options.perfPath.empty()) options.perfPath = "perf-baseline.json";
+        }
+        else if (std::strcmp(arg, "--perf-runs") == 0) {
+            options.perfRuns = std::max(1, std::atoi(requiredValue(i)));
+        }
+        else if (std::strcmp(arg, "--no-bake") == 0) {
+            options.bake = false;
+        }
+        else if (std::strcmp(arg, "--nbody") == 0) {
+            // Barnes-Hut gravity for the asteroid clusters, optionally with an opening angle
+            options.nbody = true;
+            std::string theta = optionalValue(i);
+            if (!theta.empty()) options.nbodyTheta = (float)std::atof(theta.c_str());
+        }
+        else if (std::strcmp(arg, "--no-sim-lod") == 0) {
+            options.simLod = false;
+        }
+        else if (std::find_if(std::begin(SELF_TESTS), std::end(SELF_TESTS),
+            [&](const char* name) { return std::strcmp(arg, name) == 0; }) != std::end(SELF_TESTS)) {
+            selectTest(arg, "");
+        }
+        else if (std::find_if(std::begin(BENCHES), std::end(BENCHES),
+            [&](const char* name) { return std::strcmp(arg, name) == 0; }) != std::end(BENCHES)) {
+            selectTest(arg, optionalValue(i));
+        }
+        else {
+            // A typo shouldn't quietly run something else (a random seed for --sed)
+            throw std::runtime_error(std::string("Unknown option: ") + arg);
+        }
+    }
+    return options;
+}
+
+// Runs the self-test or bench the command line chose, once the seed, thread
+// count and simulation options are applied; returns the exit code. The seed
+// is printed first, so a failure can be rerun with --seed.
+static int runSelfTestOrBench(const CommandLine& options) {
+    const std::string& test = options.test;
+    auto count = [&](unsigned long long fallback) {
+        return options.testArg.empty() ? fallback : std::strtoull(options.testArg.c_str(), nullptr, 10);
+    };
+    std::cout << "World seed: " << g_worldSeed << std::endl;
+
+    bool ok = false;
+    if (test == "--replay-selftest") {
+        // Record a scripted session, replay it, and catch a replay knocked off course
+        ok = replaySelfTest();
+    }
+    else if (test == "--noise-selftest") {
+        // Checks the SIMD noise paths against the scalar/GLSL reference, no window needed
+        ok = Noise::selfTest();
+    }
+    else if (test == "--jobs-selftest") {
+        // At least 4 threads, so stealing gets exercised even on small machines
+        ok = JobSystem::selfTest(std::max(4u, parallelThreadCount()));
+    }
+    else if (test == "--ecs-selftest") {
+        // Entity storage: queries, archetype moves, stale handles
+        ok = EntityWorld::selfTest(std::max(4u, parallelThreadCount()));
+    }
+    else if (test == "--grid-selftest") {
+        // Broad-phase queries against brute force on the game's distributions
+        ok = SpatialGrid::selfTest(g_worldSeed);
+    }
+    else if (test == "--sweep-selftest") {
+        // Swept-sphere time of impact and sliding on fast moves through an asteroid field
+        ok = Sweep::selfTest(g_worldSeed);
+    }
+    else if (test == "--origin-selftest") {
+        // Camera-relative rendering and movement precision far from the origin
+        ok = originSelfTest();
+    }
+    else if (test == "--mesh-selftest") {
+        // Triangle BVH closest-point queries against testing every triangle
+        ok = TriangleBvh::selfTest(g_worldSeed);
+    }
+    else if (test == "--bvh-bench") {
+        // Dynamic AABB tree: correctness, then refit vs rebuild vs grid from 10k up to N asteroids (default 1M)
+        ok = AabbTree::benchmark((size_t)count(1000000), g_worldSeed);
+    }
+    else if (test == "--nbody-bench") {
+        // N-body accuracy, energy drift and ns/body/step per thread count (default 100k bodies)
+        ok = NBody::benchmark((size_t)count(100000), g_worldSeed, g_nbodyTheta);
+    }
+    else if (test == "--flock-bench") {
+        // Probe flocking: hashed vs every-agent steering, obstacle clearance, cost per thread count (default 5000 probes)
+        ok = Flock::benchmark((size_t)count(5000), g_worldSeed);
+    }
+    else if (test == "--warp-bench") {
+        // Per-tick world cost at every time-warp level (default: the game's asteroid count)
+        ok = benchmarkTimeWarp((int)count(120));
+    }
+    else if (test == "--lod-bench") {
+        // Simulation LOD off vs on from three viewpoints (default belt 30k asteroids, clusters to match)
+        ok = benchmarkSimLod((int)count(30000));
+    }
+    else if (test == "--asteroid-bench") {
+        // Times the asteroid orbit kernels (default 1M asteroids) and checks SIMD == scalar
+        ok = AsteroidField::benchmark((size_t)count(1000000), g_worldSeed);
+    }
+    return ok ? 0 : 1;
+}
+
+// Main program
+
+int main(int argc, char** argv) {
+    try {
+        std::cout << "=== Initializing Space Explorer ===" << std::endl;
+
+        CommandLine options = parseCommandLine(argc, argv);
+
+        // Each run is different unless a seed is given (--seed N)
+        g_worldSeed = options.seedGiven ? options.seed : (uint64_t)time(0);
+        if (options.threads >= 0) setParallelThreadCount((unsigned int)options.threads);
+        g_bakePlanetSurfaces = options.bake;
+        g_nbodyClusters = options.nbody;
+        g_nbodyTheta = options.nbodyTheta;
+        g_simLod.setEnabled(options.simLod);
+
+        if (!options.test.empty()) {
+            if (!options.seedGiven) g_worldSeed = BENCHMARK_SEED;
+            return runSelfTestOrBench(options);
+        }
+
+        const std::string& recordPath = options.recordPath;
+        const std::string& flythroughPath = options.flythroughPath;
+        if (!options.replayPath.empty()) g_replay = std::make_unique<SessionLog::Replay>(options.replayPath);
+        if (g_replay) {
+            // The recording's world, whatever the command line says
+            const SessionLog::Header& header = g_replay->header();
+            g_worldSeed = header.seed;
+            g_nbodyClusters = header.nbody;
+            g_nbodyTheta = header.nbodyTheta;
+            g_simLod.setEnabled(header.simLod);
+            if (header.asteroidPath != AsteroidField::pathName()) {
+                std::cout << "Replay: recorded on the " << header.asteroidPath << " asteroid path (its rounding may differ)" << std::endl;
+            }
+        }
+        if (!recordPath.empty()) {
+            if (g_replay) throw std::runtime_error("--record and --replay can't be used together");
+            SessionLog::Header header;
+            header.seed = g_worldSeed;
+            header.nbody = g_nbodyClusters;
+            header.nbodyTheta = g_nbodyTheta;
+            header.simLod = g_simLod.isEnabled();
+            header.asteroidPath = AsteroidField::pathName();
+            g_recorder = std::make_unique<SessionLog::Recorder>(recordPath, header);
+        }
+        if (!flythroughPath.empty()) {
+            if (g_replay || g_recorder) throw std::runtime_error("--flythrough can't be recorded or replayed");
+            if (!options.seedGiven) g_worldSeed = BENCHMARK_SEED;
+        }
+        if (!options.perfPath.empty()) {
+            if (!options.seedGiven) g_worldSeed = BENCHMARK_SEED;
+            return runPerfGate(options.perfPath, options.perfWriteBaseline, options.perfRuns);
+        }
+
+        std::cout << "Noise SIMD path: " << simdLevelName(Noise::activeLevel()) << std::endl;
+        std::cout << "Asteroid SIMD path: " << AsteroidField::pathName() << std::endl;
+
+        g_jobs = std::make_unique<JobSystem>(parallelThreadCount());
+        std::cout << "Job threads: " << g_jobs->threadCount() << std::endl;
+        std::cout << "World seed: " << g_worldSeed << std::endl;
+
+        GLFWwindow* window = initializeWindow();
+        std::cout << "Window created" << std::endl;
+
+        // The flight measures frames as fast as they go
+        if (!flythroughPath.empty()) glfwSwapInterval(0);
+
+        initializeGLEW();
+        std::cout << "GLEW initialized" << std::endl;
+
+        initializeOpenGL();
+        std::cout << "OpenGL context ready" << std::endl;
+
+        // Start camera a bit above the plane looking into the scene
+        g_camera = std::make_unique<Camera>(glm::dvec3(0.0, 30.0, 100.0));
+
+        initializeShaders();
+        initializeGeometry();
+        initializeScene();
+        if (!flythroughPath.empty()) g_flythrough = buildFlythrough();
+
+        std::cout << "=== Initialization complete. Starting main loop ===" << std::endl;
+
+        // From here on GL belongs to the render thread
+        glfwGetFramebufferSize(window, &g_framebufferWidth, &g_framebufferHeight);
+        glfwMakeContextCurrent(nullptr);
+        RenderStats::take();
+        std::thread renderThread(renderThreadMain, window);
+
+        // Both snapshots start out as the initial world
+        captureSnapshot(g_currSnapshot);
+        g_prevSnapshot = g_currSnapshot;
+
+        double lastTime = glfwGetTime();
+        double accumulator = 0.0;
+        int lastTarget = -1;
+        std::vector<double> replayFrameMs;
+
+        while (!glfwWindowShouldClose(window))
+        {
+            // Real time since last frame, clamped so a hitch can't trigger a burst of ticks
+            double currentTime = glfwGetTime();
+            double frameMs = (currentTime - lastTime) * 1000.0;
+            SessionLog::Frame frame;
+            frame.seconds = std::min(currentTime - lastTime, (double)MAX_FRAME_TIME);
+            if (g_replay && g_frameNumber > 0) replayFrameMs.push_back(frameMs);
+            lastTime = currentTime;
+
+            if (g_flythrough) {
+                // The benchmark flight runs one tick a frame, however long
+                // the frames take, and stops at the end of the path
+                size_t flown = (size_t)g_frameNumber;
+                if (flown > 0) g_flythrough->recordTime(flown - 1, frameMs);
+                if (flown == g_flythrough->frameCount()) break;
+                flythroughTick(flown, lastTarget);
+            }
+            else {
+                // Run as many fixed ticks as real time allows (a replay runs the
+                // recorded frame's, as fast as it can, and stops at the end)
+                if (!beginFrame(frame, accumulator)) break;
+                for (int t = 0; t < frame.ticks; ++t) {
+                    runSessionTick(sampleTickInput(window), lastTarget);
                 }
             }
 
-            // Update moons (note: this is duplicated with renderMoons updates)
-            updateMoons(deltaTime);
+            // Render between the last two ticks (the flight shows its latest)
+            float alpha = g_flythrough ? 1.0f : (float)(accumulator / SIM_DT);
+            interpolateSnapshot(g_prevSnapshot, g_currSnapshot, alpha, g_renderSnapshot);
 
-            // Camera matrices + render
+            // Stream neighbouring sectors in/out around the camera
+            g_sectorStreamer->update(g_renderSnapshot.cameraPos);
+            g_sectorStreamer->collectVisible(g_visibleSystems);
 
-            glm::mat4 projection = glm::perspective(
-                glm::radians(60.0f),
-                (float)WINDOW_WIDTH / WINDOW_HEIGHT,
-                0.1f,
-                50000.0f
-            );
+            // Camera matrices
+            glm::mat4 projection = cameraProjection();
 
+            // Live mouse look; the packet is built relative to the
+            // interpolated position
             glm::mat4 view = g_camera->GetViewMatrix();
 
-            render(deltaTime, view, projection);
+            // Hand the frame to the render thread, which draws it while we
+            // simulate the next one
+            RenderPacket& packet = g_renderPackets.beginBuild();
+            buildRenderPacket(packet, view, projection);
+            g_renderPackets.submit();
 
-            glfwSwapBuffers(window);
             glfwPollEvents();
         }
 
+        // Let the render thread finish its frame, then take the context back for cleanup
+        g_renderPackets.stop();
+        renderThread.join();
+        glfwMakeContextCurrent(window);
+
         // Clean up heap allocations (could be converted to unique_ptr for safety)
         delete g_sphereMesh;
         delete g_cubeMesh;
         delete g_starRenderer;
         delete g_hudRenderer;
 
+        if (!g_planetSurfaceMaps.empty()) {
+            glDeleteTextures((GLsizei)g_planetSurfaceMaps.size(), g_planetSurfaceMaps.data());
+        }
+
+        if (g_flythrough) {
+            Flythrough::RunInfo info;
+            info.seed = g_worldSeed;
+            const GLubyte* renderer = glGetString(GL_RENDERER);
+            if (renderer) info.renderer = reinterpret_cast<const char*>(renderer);
+            info.noisePath = simdLevelName(Noise::activeLevel());
+            info.asteroidPath = AsteroidField::pathName();
+            info.threads = g_jobs->threadCount();
+            info.width = g_framebufferWidth;
+            info.height = g_framebufferHeight;
+            g_flythrough->writeReport(flythroughPath, info);
+            g_flythrough.reset();
+        }
+
+        bool diverged = false;
+        if (g_replay) {
+            reportReplay(replayFrameMs);
+            diverged = g_replay->diverged();
+        }
+        g_recorder.reset();
+
         g_gameState.reset();
+        g_sectorStreamer.reset();
+        g_planetTerrain.reset();
+        g_jobs.reset();
 
         glfwDestroyWindow(window);
         glfwTerminate();
 
         std::cout << "=== Space Explorer closed successfully ===" << std::endl;
-        return 0;
+        return diverged ? 1 : 0;
     }
     catch (const std::exception& e) {
         std::cerr << "FATAL ERROR: " << e.what() << std::endl;
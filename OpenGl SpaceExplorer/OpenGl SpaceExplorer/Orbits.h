@@ -0,0 +1,87 @@
+#pragma once
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "PlanetGenerator.h"
+
+// Closed-form orbits. Every body's phase is its phase at t = 0 plus its speed
+// times the absolute simulation time, so the system can be evaluated at any
+// time directly: nothing is accumulated per tick, nothing drifts, and the
+// result doesn't depend on how the simulation got there. The sum is formed in
+// double so long sessions keep full float precision in the wrapped phase.
+//
+// (Asteroids use the same idea in fixed point, see AsteroidField.)
+namespace Orbits {
+
+const double TWO_PI = 6.283185307179586;
+
+// phase0 + speed * t, wrapped into [0, period)
+inline float phaseAt(float phase0, float speed, double t, double period = TWO_PI) {
+    double a = std::fmod((double)phase0 + (double)speed * t, period);
+    if (a < 0.0) a += period;
+    return (float)a;
+}
+
+// Point on a circle in the XZ plane
+inline glm::vec3 circle(float phase, float radius, float height) {
+    return glm::vec3(std::cos(phase) * radius, height, std::sin(phase) * radius);
+}
+
+// Eccentric anomaly E from the mean anomaly M (Kepler: M = E - e sin E).
+// Newton-Raphson from E = M + e sin M; a fixed count is plenty for e < 0.5.
+inline double solveKepler(double M, double e) {
+    double E = M + e * std::sin(M);
+    for (int k = 0; k < 5; ++k) {
+        E -= (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+    }
+    return E;
+}
+
+// Unit vectors towards periapsis (P) and 90 degrees ahead of it in the
+// orbital plane (Q), rotated by the inclination, ascending node and argument
+// of periapsis. The reference plane is XZ with +Y up: with all three angles
+// zero, P = +X and Q = +Z, matching circle().
+inline void perifocalAxes(float inclination, float ascendingNode, float periapsisArg,
+    glm::vec3& P, glm::vec3& Q) {
+    double ci = std::cos(inclination), si = std::sin(inclination);
+    double cO = std::cos(ascendingNode), sO = std::sin(ascendingNode);
+    double cw = std::cos(periapsisArg), sw = std::sin(periapsisArg);
+
+    // Textbook (z-up) components, then swapped into y-up
+    double px = cO * cw - sO * sw * ci, py = sO * cw + cO * sw * ci, pz = sw * si;
+    double qx = -cO * sw - sO * cw * ci, qy = -sO * sw + cO * cw * ci, qz = cw * si;
+    P = glm::vec3((float)px, (float)pz, (float)py);
+    Q = glm::vec3((float)qx, (float)qz, (float)qy);
+}
+
+// Position relative to the focus for semi-major axis a at mean anomaly M
+inline glm::vec3 keplerOffset(float a, float e, float inclination, float ascendingNode,
+    float periapsisArg, double M) {
+    double E = solveKepler(M, e);
+    double u = a * (std::cos(E) - e);
+    double v = a * std::sqrt(1.0 - (double)e * e) * std::sin(E);
+
+    glm::vec3 P, Q;
+    perifocalAxes(inclination, ascendingNode, periapsisArg, P, Q);
+    return P * (float)u + Q * (float)v;
+}
+
+// Relative to the sun. Planet::angle (mean anomaly) and Planet::rotationAngle
+// are the values at t = 0; Planet::height lifts the whole orbit.
+inline glm::vec3 planetOffset(const Planet& planet, double t) {
+    glm::vec3 offset = keplerOffset(planet.distance, planet.eccentricity, planet.inclination,
+        planet.ascendingNode, planet.periapsisArg, phaseAt(planet.angle, planet.speed, t));
+    return offset + glm::vec3(0.0f, planet.height, 0.0f);
+}
+
+// Spin about the planet's Y axis, in degrees
+inline float planetSpin(const Planet& planet, double t) {
+    return phaseAt(planet.rotationAngle, planet.rotationSpeed, t, 360.0);
+}
+
+// Relative to the planet centre; Moon::angle is the value at t = 0
+inline glm::vec3 moonOffset(const Moon& moon, double t) {
+    return circle(phaseAt(moon.angle, moon.speed, t), moon.distance, 0.0f);
+}
+
+} // namespace Orbits
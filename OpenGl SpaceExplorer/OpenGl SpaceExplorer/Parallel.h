@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+// Number of threads parallelFor is allowed to use (0 = one per hardware core)
+inline unsigned int& parallelThreadSetting() {
+    static unsigned int threads = 0;
+    return threads;
+}
+
+inline void setParallelThreadCount(unsigned int threads) {
+    parallelThreadSetting() = threads;
+}
+
+inline unsigned int parallelThreadCount() {
+    unsigned int n = parallelThreadSetting();
+    if (n == 0) n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Splits [0, count) into contiguous ranges and runs fn(begin, end) on each one.
+// Ranges never overlap, so fn may write to its own slice of a pre-sized vector.
+template <typename Fn>
+void parallelFor(size_t count, size_t minBatch, Fn fn) {
+    if (count == 0) return;
+    if (minBatch == 0) minBatch = 1;
+
+    size_t maxWorkers = (count + minBatch - 1) / minBatch;
+    size_t workers = std::min<size_t>(parallelThreadCount(), maxWorkers);
+
+    // Not worth spinning up threads for small jobs
+    if (workers <= 1) {
+        fn(size_t(0), count);
+        return;
+    }
+
+    size_t chunk = (count + workers - 1) / workers;
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    for (size_t w = 1; w < workers; ++w) {
+        size_t begin = w * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if (begin >= end) break;
+        threads.emplace_back([=]() { fn(begin, end); });
+    }
+
+    // Calling thread takes the first range
+    fn(size_t(0), std::min(count, chunk));
+
+    for (auto& t : threads) t.join();
+}
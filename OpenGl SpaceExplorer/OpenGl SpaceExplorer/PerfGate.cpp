@@ -0,0 +1,332 @@
+#include "PerfGate.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace PerfGate {
+
+namespace {
+
+double medianOf(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    double upper = values[mid];
+    if (values.size() % 2) return upper;
+    return 0.5 * (upper + *std::max_element(values.begin(), values.begin() + mid));
+}
+
+// Just enough JSON for a baseline: objects, strings, numbers, and any other
+// value skipped over
+class Reader {
+public:
+    Reader(const std::string& text, const std::string& path) : text(text), path(path) {}
+
+    Baseline baseline() {
+        Baseline result;
+        std::vector<BaselineEntry>& entries = result.metrics;
+        object([&](const std::string& key) {
+            if (key == "config") {
+                result.hasConfig = true;
+                Config& config = result.config;
+                return object([&](const std::string& field) {
+                    if (field == "seed") config.seed = integer();
+                    else if (field == "threads") config.threads = (unsigned int)integer();
+                    else if (field == "build") config.build = string();
+                    else if (field == "noisePath") config.noisePath = string();
+                    else if (field == "asteroidPath") config.asteroidPath = string();
+                    else if (field == "scenarios") config.scenarios = string();
+                    else skip();
+                });
+            }
+            if (key != "metrics") return skip();
+            object([&](const std::string& name) {
+                BaselineEntry entry;
+                entry.name = name;
+                object([&](const std::string& field) {
+                    if (field == "median") entry.median = number();
+                    else if (field == "mad") entry.mad = number();
+                    else if (field == "threshold") entry.threshold = number();
+                    else skip();
+                });
+                entries.push_back(entry);
+            });
+        });
+        return result;
+    }
+
+private:
+    void fail(const char* what) {
+        throw std::runtime_error("Bad baseline " + path + " (" + what + " at offset " + std::to_string(at) + ")");
+    }
+
+    char peek() {
+        while (at < text.size() && std::isspace((unsigned char)text[at])) ++at;
+        if (at == text.size()) fail("unexpected end");
+        return text[at];
+    }
+
+    void expect(char c) {
+        if (peek() != c) fail("unexpected character");
+        ++at;
+    }
+
+    template <typename Member>
+    void object(Member member) {
+        expect('{');
+        if (peek() == '}') { ++at; return; }
+        for (;;) {
+            std::string key = string();
+            expect(':');
+            member(key);
+            if (peek() == ',') { ++at; continue; }
+            expect('}');
+            return;
+        }
+    }
+
+    std::string string() {
+        expect('"');
+        std::string out;
+        while (at < text.size() && text[at] != '"') {
+            if (text[at] == '\\' && at + 1 < text.size()) ++at;
+            out += text[at++];
+        }
+        expect('"');
+        return out;
+    }
+
+    double number() {
+        peek();
+        const char* begin = text.c_str() + at;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin) fail("expected a number");
+        at += end - begin;
+        return value;
+    }
+
+    // Seeds are 64-bit, past what a double holds exactly
+    uint64_t integer() {
+        peek();
+        const char* begin = text.c_str() + at;
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(begin, &end, 10);
+        if (end == begin) fail("expected an integer");
+        at += end - begin;
+        return value;
+    }
+
+    void skip() {
+        char c = peek();
+        if (c == '{') object([&](const std::string&) { skip(); });
+        else if (c == '"') string();
+        else if (c == '[') {
+            ++at;
+            if (peek() == ']') { ++at; return; }
+            for (;;) {
+                skip();
+                if (peek() == ',') { ++at; continue; }
+                expect(']');
+                return;
+            }
+        }
+        else if (c == 't' || c == 'f' || c == 'n') {
+            while (at < text.size() && std::isalpha((unsigned char)text[at])) ++at;
+        }
+        else number();
+    }
+
+    const std::string& text;
+    std::string path;
+    size_t at = 0;
+};
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+std::string percent(double fraction) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%+.1f%%", fraction * 100.0);
+    return buffer;
+}
+
+}
+
+Stats summarize(const std::vector<double>& samples) {
+    Stats stats;
+    if (samples.empty()) return stats;
+    stats.median = medianOf(samples);
+
+    std::vector<double> deviations;
+    for (double sample : samples) deviations.push_back(std::fabs(sample - stats.median));
+    stats.mad = medianOf(deviations);
+
+    std::mt19937_64 rng(0x9e3779b97f4a7c15ull);
+    std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+    std::vector<double> medians(BOOTSTRAP_RESAMPLES);
+    std::vector<double> resample(samples.size());
+    for (double& median : medians) {
+        for (double& value : resample) value = samples[pick(rng)];
+        median = medianOf(resample);
+    }
+    std::sort(medians.begin(), medians.end());
+    stats.ciLow = medians[(size_t)(0.025 * (medians.size() - 1))];
+    stats.ciHigh = medians[(size_t)(0.975 * (medians.size() - 1))];
+    return stats;
+}
+
+Metric measure(const std::string& name, int runs, const std::function<double()>& run) {
+    Metric metric;
+    metric.name = name;
+    run();
+    for (int i = 0; i < runs; ++i) metric.samples.push_back(run());
+    metric.stats = summarize(metric.samples);
+    std::cout << "Perf: " << name << " " << metric.stats.median << " ms median over " << runs
+        << " runs (MAD " << metric.stats.mad << ")" << std::endl;
+    return metric;
+}
+
+std::string buildName() {
+#if defined(_DEBUG)
+    std::string name = "Debug";
+#elif defined(NDEBUG) || defined(__OPTIMIZE__)
+    std::string name = "Release";
+#else
+    std::string name = "Debug";
+#endif
+#if defined(_MSC_VER)
+    name += " MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+    name += " Clang " + std::to_string(__clang_major__) + "." + std::to_string(__clang_minor__);
+#elif defined(__GNUC__)
+    name += " GCC " + std::to_string(__GNUC__) + "." + std::to_string(__GNUC_MINOR__);
+#endif
+#if defined(_M_X64) || defined(__x86_64__)
+    name += " x64";
+#elif defined(_M_IX86) || defined(__i386__)
+    name += " x86";
+#elif defined(_M_ARM64) || defined(__aarch64__)
+    name += " ARM64";
+#endif
+    return name;
+}
+
+Baseline loadBaseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Cannot open perf baseline: " + path + " (record one with --perf-baseline)");
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    return Reader(text, path).baseline();
+}
+
+void writeBaseline(const std::string& path, const Config& config, const std::vector<Metric>& metrics, int runs,
+    const std::vector<BaselineEntry>& previous) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write perf baseline: " + path);
+
+    out << "{\n";
+    out << "  \"config\": {\n";
+    out << "    \"seed\": " << config.seed << ",\n";
+    out << "    \"threads\": " << config.threads << ",\n";
+    out << "    \"build\": " << quoted(config.build) << ",\n";
+    out << "    \"noisePath\": " << quoted(config.noisePath) << ",\n";
+    out << "    \"asteroidPath\": " << quoted(config.asteroidPath) << ",\n";
+    out << "    \"scenarios\": " << quoted(config.scenarios) << "\n";
+    out << "  },\n";
+    out << "  \"runs\": " << runs << ",\n  \"metrics\": {\n";
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        const Metric& metric = metrics[i];
+        double threshold = DEFAULT_THRESHOLD;
+        for (const BaselineEntry& entry : previous) {
+            if (entry.name == metric.name) threshold = entry.threshold;
+        }
+        out << "    \"" << metric.name << "\": { \"median\": " << metric.stats.median
+            << ", \"mad\": " << metric.stats.mad << ", \"threshold\": " << threshold << " }"
+            << (i + 1 < metrics.size() ? "," : "") << "\n";
+    }
+    out << "  }\n}\n";
+    if (!out) throw std::runtime_error("Perf baseline write failed: " + path);
+    std::cout << "Perf baseline written to " << path << std::endl;
+}
+
+std::vector<std::string> configMismatches(const Baseline& baseline, const Config& current) {
+    std::vector<std::string> mismatches;
+    if (!baseline.hasConfig) {
+        mismatches.push_back("the baseline doesn't record what it was measured under");
+        return mismatches;
+    }
+    auto check = [&](const char* field, const std::string& was, const std::string& now) {
+        if (was != now) mismatches.push_back(std::string(field) + ": " + was + " in the baseline, " + now + " now");
+    };
+    const Config& was = baseline.config;
+    check("seed", std::to_string(was.seed), std::to_string(current.seed));
+    check("threads", std::to_string(was.threads), std::to_string(current.threads));
+    check("build", was.build, current.build);
+    check("noise path", was.noisePath, current.noisePath);
+    check("asteroid path", was.asteroidPath, current.asteroidPath);
+    check("scenarios", was.scenarios, current.scenarios);
+    return mismatches;
+}
+
+bool compare(const std::vector<Metric>& metrics, const std::vector<BaselineEntry>& baseline) {
+    bool ok = true;
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-22s %10s %10s %23s %8s %7s",
+        "metric", "baseline", "median", "95% interval", "change", "limit");
+    std::cout << line << std::endl;
+
+    for (const Metric& metric : metrics) {
+        const Stats& s = metric.stats;
+        const BaselineEntry* entry = nullptr;
+        for (const BaselineEntry& candidate : baseline) {
+            if (candidate.name == metric.name) entry = &candidate;
+        }
+        if (!entry || entry->median <= 0.0) {
+            std::snprintf(line, sizeof(line), "  %-22s %10s %10.4f  [%9.4f, %9.4f] %8s %7s  new",
+                metric.name.c_str(), "-", s.median, s.ciLow, s.ciHigh, "", "");
+            std::cout << line << std::endl;
+            continue;
+        }
+
+        double change = s.median / entry->median - 1.0;
+        const char* verdict = "ok";
+        if (s.ciLow > entry->median * (1.0 + entry->threshold)) {
+            verdict = "REGRESSED";
+            ok = false;
+        }
+        else if (s.ciHigh < entry->median * (1.0 - entry->threshold)) {
+            verdict = "faster (refresh the baseline?)";
+        }
+        std::snprintf(line, sizeof(line), "  %-22s %10.4f %10.4f  [%9.4f, %9.4f] %8s %7s  %s",
+            metric.name.c_str(), entry->median, s.median, s.ciLow, s.ciHigh,
+            percent(change).c_str(), percent(entry->threshold).c_str(), verdict);
+        std::cout << line << std::endl;
+    }
+
+    for (const BaselineEntry& entry : baseline) {
+        bool measured = false;
+        for (const Metric& metric : metrics) measured = measured || metric.name == entry.name;
+        if (!measured) std::cout << "  " << entry.name << ": in the baseline but no longer measured" << std::endl;
+    }
+
+    std::cout << (ok ? "Perf gate passed" : "Perf gate FAILED: a metric's whole interval is past its limit") << std::endl;
+    return ok;
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Performance regression gate (--perf-gate, --perf-baseline): standard
+// scenarios are each timed over several runs, summarised with statistics that
+// a stray slow run can't move, and compared with a baseline JSON checked in
+// next to the project.
+//
+// A metric is a time in ms; lower is better. Its summary is the median of the
+// runs, their median absolute deviation (MAD) and a 95% bootstrap confidence
+// interval for the median. It regresses when even the low end of that
+// interval is slower than the baseline median by more than the metric's
+// threshold (a fraction, kept in the baseline so it can be tuned per metric),
+// so noise alone doesn't fail the gate. No baseline is checked in: one is
+// recorded with --perf-baseline on the machine and build the gate runs on.
+//
+// The baseline also records what it was measured under (seed, job threads,
+// build, SIMD paths, scenario sizes), and the gate won't compare against one
+// taken under anything else: those numbers measure different work.
+//
+// Baseline format:
+//   { "config": { "seed": 1, "threads": 8, "build": "Release MSVC 1929 x64", "noisePath": "AVX2",
+//                 "asteroidPath": "AVX2", "scenarios": "..." },
+//     "runs": 9, "metrics": { "name": { "median": 1.2, "mad": 0.03, "threshold": 0.15 }, ... } }
+namespace PerfGate {
+
+const int DEFAULT_RUNS = 9;
+const double DEFAULT_THRESHOLD = 0.15;
+const int BOOTSTRAP_RESAMPLES = 2000;
+
+struct Stats {
+    double median = 0.0;
+    double mad = 0.0;
+    double ciLow = 0.0;     // 95% bootstrap interval for the median
+    double ciHigh = 0.0;
+};
+
+struct Metric {
+    std::string name;
+    std::vector<double> samples;   // ms, one per run
+    Stats stats;
+};
+
+// Median, MAD and the bootstrap interval (resampled with a fixed seed, so the
+// same samples always give the same interval)
+Stats summarize(const std::vector<double>& samples);
+
+// Runs a scenario once untimed (caches, allocations), then `runs` times;
+// run() returns the run's time in ms
+Metric measure(const std::string& name, int runs, const std::function<double()>& run);
+
+// What a set of timings was measured under
+struct Config {
+    uint64_t seed = 0;
+    unsigned int threads = 0;
+    std::string build;          // buildName()
+    std::string noisePath;
+    std::string asteroidPath;
+    std::string scenarios;      // the scenarios' sizes and world options
+};
+
+// This binary's configuration, compiler and target, e.g. "Release MSVC 1929 x64"
+std::string buildName();
+
+struct BaselineEntry {
+    std::string name;
+    double median = 0.0;
+    double mad = 0.0;
+    double threshold = DEFAULT_THRESHOLD;
+};
+
+struct Baseline {
+    bool hasConfig = false;     // baselines written before it was recorded have none
+    Config config;
+    std::vector<BaselineEntry> metrics;
+};
+
+// Throws std::runtime_error if the file is missing or isn't a baseline
+Baseline loadBaseline(const std::string& path);
+
+// Writes the metrics as a new baseline measured under `config`, keeping the
+// thresholds of any metric already in `previous`
+void writeBaseline(const std::string& path, const Config& config, const std::vector<Metric>& metrics, int runs,
+    const std::vector<BaselineEntry>& previous);
+
+// How the baseline's configuration differs from `current`, a line per
+// field ("seed: 1 in the baseline, 7 now"); empty if they match
+std::vector<std::string> configMismatches(const Baseline& baseline, const Config& current);
+
+// Prints a table of every metric against the baseline and returns false if
+// any regressed. Metrics new to the baseline are shown but can't fail.
+bool compare(const std::vector<Metric>& metrics, const std::vector<BaselineEntry>& baseline);
+
+}
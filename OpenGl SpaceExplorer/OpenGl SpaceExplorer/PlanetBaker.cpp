@@ -0,0 +1,147 @@
+#include "PlanetBaker.h"
+#include "Parallel.h"
+#include "Noise.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+float smoothstepf(float edge0, float edge1, float x) {
+    float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+uint8_t toByte(float v) {
+    return (uint8_t)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// Largest value continent + detail can reach (1 + 0.15)
+const float MAX_HEIGHT = 1.15f;
+
+} // namespace
+
+void PlanetBaker::bakeSurfaces(const std::vector<Planet>& planets, int faceSize,
+    std::vector<PlanetSurfaceBake>& out) {
+    out.assign(planets.size(), PlanetSurfaceBake());
+    for (auto& bake : out) {
+        bake.faceSize = faceSize;
+        for (auto& face : bake.faces) face.resize((size_t)faceSize * faceSize * 4);
+    }
+
+    // One work item per face row, across every planet
+    size_t rowsPerPlanet = (size_t)6 * faceSize;
+    parallelFor(planets.size() * rowsPerPlanet, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t planet = i / rowsPerPlanet;
+            int face = (int)((i % rowsPerPlanet) / faceSize);
+            int row = (int)(i % faceSize);
+            uint8_t* dst = out[planet].faces[face].data() + (size_t)row * faceSize * 4;
+            bakeRow(planets[planet], face, row, faceSize, dst);
+        }
+    });
+}
+
+void PlanetBaker::bakeRow(const Planet& planet, int face, int row, int faceSize, uint8_t* dst) {
+    std::vector<float> texV(faceSize);
+    std::vector<float> uvx(faceSize), uvy(faceSize);
+    std::vector<float> ax(faceSize), ay(faceSize);
+    std::vector<float> continent(faceSize), detail(faceSize), desert(faceSize);
+
+    // Same constants the shader derives from its uniforms. The GPU's cos/sin of
+    // a large planetSeed won't match the CPU's to the last bit, so the
+    // continents may sit at a slightly different rotation than the live shader.
+    float angle = (float)planet.seed * 0.75f;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    glm::vec3 off = planet.noiseOffset;
+
+    float t = ((float)row + 0.5f) / (float)faceSize * 2.0f - 1.0f;
+    for (int x = 0; x < faceSize; ++x) {
+        float sc = ((float)x + 0.5f) / (float)faceSize * 2.0f - 1.0f;
+        glm::vec3 d = glm::normalize(cubeDirection(face, sc, t));
+
+        // Inverse of generateUVSphere's mapping: direction -> TexCoord
+        float u = std::atan2(d.z, d.x) / glm::two_pi<float>();
+        if (u < 0.0f) u += 1.0f;
+        float v = std::acos(std::min(std::max(d.y, -1.0f), 1.0f)) / glm::pi<float>();
+        texV[x] = v;
+
+        // uv = rot2(planetSeed * 0.75) * (TexCoord * 2.5 + noiseOffset.xy * 0.01)
+        float px = u * 2.5f + off.x * 0.01f;
+        float py = v * 2.5f + off.y * 0.01f;
+        uvx[x] = c * px + s * py;
+        uvy[x] = -s * px + c * py;
+    }
+
+    Noise::smoothNoise(uvx.data(), uvy.data(), continent.data(), faceSize);
+
+    for (int x = 0; x < faceSize; ++x) {
+        ax[x] = uvx[x] * 3.0f + off.z * 0.01f;
+        ay[x] = uvy[x] * 3.0f + off.z * 0.01f;
+    }
+    Noise::smoothNoise(ax.data(), ay.data(), detail.data(), faceSize);
+
+    for (int x = 0; x < faceSize; ++x) {
+        ax[x] = uvx[x] * 1.5f + off.x * 0.01f;
+        ay[x] = uvy[x] * 1.5f + off.x * 0.01f;
+    }
+    Noise::smoothNoise(ax.data(), ay.data(), desert.data(), faceSize);
+
+    // Per-planet colour the shader would receive as baseColor
+    int slice = planet.seed % (int)planet.surfaceVariation.size();
+    glm::vec3 baseColor = PlanetGenerator::getPlanetSurfaceColor(planet, planet.surfaceVariation[slice]);
+
+    for (int x = 0; x < faceSize; ++x) {
+        float height = continent[x] + detail[x] * 0.15f;
+        glm::vec3 color;
+        float alpha;
+
+        if (planet.biomeType == 1) {
+            // Lava: crust/lava mix, the shader adds the glow from the mask
+            float cracks = smoothstepf(0.55f, 0.7f, continent[x]);
+            color = glm::mix(glm::vec3(0.08f, 0.02f, 0.01f), glm::vec3(1.2f, 0.35f, 0.05f), cracks);
+            alpha = cracks;
+        }
+        else {
+            float latitude = std::fabs(texV[x] - 0.5f);
+            float ocean = smoothstepf(0.35f, 0.42f, height);
+            float mountain = smoothstepf(0.68f, 0.75f, height);
+            float ice = smoothstepf(0.42f, 0.48f, latitude);
+            float sand = smoothstepf(0.65f, 0.72f, desert[x]);
+
+            if (ocean < 0.5f)          color = glm::vec3(0.0f, 0.15f, 0.35f);
+            else if (ice > 0.75f)      color = glm::vec3(0.85f, 0.9f, 0.95f);
+            else if (mountain > 0.7f)  color = glm::vec3(0.4f);
+            else if (sand > 0.75f)     color = glm::vec3(0.7f, 0.65f, 0.4f);
+            else                       color = baseColor;
+            alpha = height / MAX_HEIGHT;
+        }
+
+        dst[x * 4 + 0] = toByte(color.x);
+        dst[x * 4 + 1] = toByte(color.y);
+        dst[x * 4 + 2] = toByte(color.z);
+        dst[x * 4 + 3] = toByte(alpha);
+    }
+}
+
+GLuint PlanetBaker::uploadCubemap(const PlanetSurfaceBake& bake) {
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+
+    for (int face = 0; face < 6; ++face) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8,
+            bake.faceSize, bake.faceSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, bake.faces[face].data());
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    return id;
+}
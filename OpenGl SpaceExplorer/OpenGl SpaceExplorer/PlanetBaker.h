@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include "PlanetGenerator.h"
+
+// Six RGBA8 faces of one planet's baked surface, in GL cubemap face order
+// (+X, -X, +Y, -Y, +Z, -Z). RGB is the unlit surface colour; A is the height
+// (continent + detail) for normal planets, or the crack mask for lava planets.
+struct PlanetSurfaceBake {
+    int faceSize = 0;
+    std::vector<uint8_t> faces[6];
+};
+
+// Evaluates the planet surface function from fragment.glsl once, on the CPU,
+// so the shader only has to sample a cubemap instead of re-running the noise
+// for every fragment every frame.
+class PlanetBaker {
+public:
+    // Bakes every planet, spreading rows across worker threads
+    static void bakeSurfaces(const std::vector<Planet>& planets, int faceSize,
+        std::vector<PlanetSurfaceBake>& out);
+
+    // Creates a mipmapped cubemap from a bake (needs a GL context)
+    static GLuint uploadCubemap(const PlanetSurfaceBake& bake);
+
+    // Direction through point (s, t) of a cubemap face, s/t in [-1, 1]
+    static glm::vec3 cubeDirection(int face, float s, float t) {
+        switch (face) {
+        case 0:  return glm::vec3(1.0f, -t, -s);
+        case 1:  return glm::vec3(-1.0f, -t, s);
+        case 2:  return glm::vec3(s, 1.0f, t);
+        case 3:  return glm::vec3(s, -1.0f, -t);
+        case 4:  return glm::vec3(s, -t, 1.0f);
+        default: return glm::vec3(-s, -t, -1.0f);
+        }
+    }
+
+private:
+    static void bakeRow(const Planet& planet, int face, int row, int faceSize, uint8_t* dst);
+};
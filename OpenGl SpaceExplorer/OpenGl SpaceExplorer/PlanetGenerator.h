@@ -4,7 +4,11 @@
 #include <string>
 #include <glm/glm.hpp>
 #include <cstdlib>
+#include <cstdint>
 #include <cmath>
+#include <algorithm>
+
+#include "Parallel.h"
 
 struct Star {
     glm::vec3 pos;
@@ -36,7 +40,13 @@ struct Planet {
     float rotationAngle;
     float height;
 
-    bool scanned = false;
+    // Keplerian orbit: distance is the semi-major axis, angle the mean anomaly
+    // at t = 0 and speed the mean motion. All zero is the old circular orbit
+    // in the XZ plane.
+    float eccentricity = 0.0f;
+    float inclination = 0.0f;       // radians
+    float ascendingNode = 0.0f;     // longitude of the ascending node, radians
+    float periapsisArg = 0.0f;      // argument of periapsis, radians
 
     int biomeType;
     unsigned int seed;
@@ -67,6 +77,13 @@ struct Asteroid {
     float localRadius = 0.0f;
     float localAngle = 0.0f;
     float localSpeed = 0.0f;
+
+    // Shape/orientation of the orbit (around the sun for the belt, around the
+    // cluster centre for cluster members); radius is the semi-major axis
+    float eccentricity = 0.0f;
+    float inclination = 0.0f;
+    float ascendingNode = 0.0f;
+    float periapsisArg = 0.0f;
 };
 
 inline float fract(float x) {
@@ -103,6 +120,88 @@ inline int randRange(unsigned int& state, int minV, int maxV) {
     return minV + (int)(r % (unsigned int)span);
 }
 
+// COUNTER-BASED RNG
+//
+// Squares (Widynski 2020): the output is a pure function of (counter, key), so
+// entity i can be generated on any thread without touching a shared state.
+// Results are therefore identical no matter how the work is split up.
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline unsigned int squares32(uint64_t ctr, uint64_t key) {
+    uint64_t x = ctr * key;
+    uint64_t y = x;
+    uint64_t z = y + key;
+    x = x * x + y; x = (x >> 32) | (x << 32);
+    x = x * x + z; x = (x >> 32) | (x << 32);
+    x = x * x + y; x = (x >> 32) | (x << 32);
+    return (unsigned int)((x * x + z) >> 32);
+}
+
+// Independent random streams, one per kind of generated entity
+enum GenStream : uint32_t {
+    STREAM_SYSTEM = 1,
+    STREAM_PLANET_ORBITS,
+    STREAM_PLANETS,
+    STREAM_ASTEROIDS,
+    STREAM_CLUSTERS,
+    STREAM_CLUSTER_MEMBERS,
+    STREAM_STARS,
+    STREAM_SECTOR
+};
+
+// Random sequence for one entity: keyed by (world seed, stream), counter
+// starts at the entity index so every entity gets its own 2^32 draws.
+struct EntityRng {
+    uint64_t key;
+    uint64_t ctr;
+
+    EntityRng(uint64_t worldSeed, uint32_t stream, uint64_t index)
+        : key(splitmix64(worldSeed ^ splitmix64(stream)) | 1ull), ctr(index << 32) {}
+
+    unsigned int next() {
+        return squares32(ctr++, key);
+    }
+
+    // Integer in [0, n) - stands in for the old "rand() % n"
+    int below(int n) {
+        return (int)(next() % (unsigned int)n);
+    }
+
+    int range(int minV, int maxV) {
+        return minV + below(maxV - minV + 1);
+    }
+
+    float uniform(float minV, float maxV) {
+        return minV + (float)(next() >> 8) * (1.0f / 16777216.0f) * (maxV - minV);
+    }
+};
+
+// Generated angles are whole degrees, so their sin/cos come from a table
+// instead of being recomputed for every one of (possibly millions of) entities
+struct DegreeTable {
+    float sinDeg[360];
+    float cosDeg[360];
+
+    DegreeTable() {
+        for (int d = 0; d < 360; ++d) {
+            float a = d * 3.14159265f / 180.0f;
+            sinDeg[d] = std::sin(a);
+            cosDeg[d] = std::cos(a);
+        }
+    }
+};
+
+inline const DegreeTable& degreeTable() {
+    static const DegreeTable table;
+    return table;
+}
+
 // PLANET GENERATOR
 
 class PlanetGenerator {
@@ -140,191 +239,276 @@ public:
         return name;
     }
 
-    static void generatePlanets(std::vector<Planet>& planets, int minCount = 4, int maxCount = 9, float minSunDistance = 1500.0f) {
+    // detail: the surface variation table and moons. Streamed sector systems,
+    // drawn as distant spheres, go without; the rest of each planet is the same.
+    static void generatePlanets(std::vector<Planet>& planets, uint64_t worldSeed, int minCount = 4, int maxCount = 9,
+        float minSunDistance = 1500.0f, bool detail = true) {
         int biomeTypes[] = { 0, 1, 2 };
-        float currentDistance = minSunDistance;
 
-        // Randomly determine how many planets to generate between 4 and 9
-        int planetCount = 4 + (rand() % 6);
+        // Randomly determine how many planets to generate between minCount and maxCount
+        EntityRng systemRng(worldSeed, STREAM_SYSTEM, 0);
+        int planetCount = systemRng.range(minCount, maxCount);
+
+        // ORBIT LAYOUT
+        // Each orbit sits just outside the previous one, so sizes and spacings are
+        // drawn first and turned into distances with a (cheap) running sum.
+        std::vector<float> sizes(planetCount);
+        std::vector<float> distances(planetCount);
+        float currentDistance = minSunDistance;
 
         for (int i = 0; i < planetCount; ++i) {
-            Planet p;
-            p.biomeType = biomeTypes[i % 3];
+            EntityRng r(worldSeed, STREAM_PLANET_ORBITS, i);
 
             // BIOME-SPECIFIC SIZE
-            switch (p.biomeType) {
-            case 0: p.size = 15.0f + (rand() % 6); break;  // Green
-            case 1: p.size = 10.0f + (rand() % 6); break;  // Rocky
-            case 2: p.size = 12.0f + (rand() % 6); break;  // Ice
+            switch (biomeTypes[i % 3]) {
+            case 0: sizes[i] = 15.0f + r.below(6); break;  // Green
+            case 1: sizes[i] = 10.0f + r.below(6); break;  // Rocky
+            case 2: sizes[i] = 12.0f + r.below(6); break;  // Ice
             }
 
-            p.distance = currentDistance;
+            distances[i] = currentDistance;
 
-            // change the planets height on the Y position
-            p.height = randFloat(-120.0f, 120.0f);
+            // CALCULATE NEXT DISTANCE
+            float spacing = 80.0f + r.below(60);
+            currentDistance = distances[i] + sizes[i] + spacing;
+        }
 
-            // PROCEDURAL SURFACE VARIATION
-            int resolution = 64;
-            p.surfaceVariation.resize(resolution);
+        size_t base = planets.size();
+        planets.resize(base + planetCount);
 
-            p.seed = rand();
+        parallelFor((size_t)planetCount, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Planet& p = planets[base + i];
+                EntityRng r(worldSeed, STREAM_PLANETS, i);
 
-            for (int k = 0; k < resolution; ++k) {
-                float latitude = float(k) / resolution; 
-                float baseNoise = noise1D(k, p.seed) * 0.5f + 0.5f;
+                p.biomeType = biomeTypes[i % 3];
+                p.size = sizes[i];
+                p.distance = distances[i];
 
-                // Biome shaping
-                if (p.biomeType == 0) { // Green
-                    baseNoise = glm::smoothstep(0.2f, 0.8f, baseNoise);
-                }
-                else if (p.biomeType == 1) { // Rocky
-                    baseNoise = std::pow(baseNoise, 0.6f);
-                }
-                else if (p.biomeType == 2) { // Ice
-                    baseNoise = glm::mix(baseNoise, 1.0f, latitude * 0.6f);
+                // change the planets height on the Y position
+                p.height = r.uniform(-120.0f, 120.0f);
+
+                // PROCEDURAL SURFACE VARIATION
+                int resolution = detail ? 64 : 0;
+                p.surfaceVariation.resize(resolution);
+
+                p.seed = r.next();
+
+                for (int k = 0; k < resolution; ++k) {
+                    float latitude = float(k) / resolution;
+                    float baseNoise = noise1D(k, p.seed) * 0.5f + 0.5f;
+
+                    // Biome shaping
+                    if (p.biomeType == 0) { // Green
+                        baseNoise = glm::smoothstep(0.2f, 0.8f, baseNoise);
+                    }
+                    else if (p.biomeType == 1) { // Rocky
+                        baseNoise = std::pow(baseNoise, 0.6f);
+                    }
+                    else if (p.biomeType == 2) { // Ice
+                        baseNoise = glm::mix(baseNoise, 1.0f, latitude * 0.6f);
+                    }
+
+                    p.surfaceVariation[k] = baseNoise;
                 }
 
-                p.surfaceVariation[k] = baseNoise;
-            }
+                // RANDOM ORBIT SPEED
+                p.speed = 0.01f + static_cast<float>(r.below(50)) / 1000.0f;
+
+                // RANDOM ANGLE
+                p.angle = r.below(360) * 3.14159265f / 180.0f;
+                p.collisionRadius = p.size * 1.5f;
+
+                // ROTATION
+                p.rotationAngle = 0.0f;
+                p.rotationSpeed = 20.0f + r.below(40);
+
+                // BIOME COLORS
+                switch (p.biomeType) {
+                case 0: // Green
+                    p.color = glm::vec3(0.0f, 0.6f + r.below(20) / 100.0f, 0.0f);
+                    p.secondaryColor = glm::vec3(0.0f, 0.3f, 0.4f); // water
+                    break;
+                case 1: // Rocky
+                    p.color = glm::vec3(0.5f, 0.4f, 0.3f);
+                    p.secondaryColor = glm::vec3(0.3f, 0.3f, 0.3f);
+                    break;
+                case 2: // Ice
+                    p.color = glm::vec3(0.8f, 0.9f, 1.0f);
+                    p.secondaryColor = glm::vec3(0.6f, 0.7f, 0.9f);
+                    break;
+                }
 
-            // CALCULATE NEXT DISTANCE
-            float spacing = 80.0f + (rand() % 60);
-            currentDistance = p.distance + p.size + spacing;
-
-            // RANDOM ORBIT SPEED
-            p.speed = 0.01f + static_cast<float>(rand() % 50) / 1000.0f;
-
-            // RANDOM ANGLE
-            p.angle = (rand() % 360) * 3.14159265f / 180.0f;
-            p.collisionRadius = p.size * 1.5f;
-
-            // ROTATION
-            p.rotationAngle = 0.0f;
-            p.rotationSpeed = 20.0f + rand() % 40;
-
-            // BIOME COLORS
-            switch (p.biomeType) {
-            case 0: // Green
-                p.color = glm::vec3(0.0f, 0.6f + (rand() % 20) / 100.0f, 0.0f);
-                p.secondaryColor = glm::vec3(0.0f, 0.3f, 0.4f); // water
-                break;
-            case 1: // Rocky
-                p.color = glm::vec3(0.5f, 0.4f, 0.3f);
-                p.secondaryColor = glm::vec3(0.3f, 0.3f, 0.3f);
-                break;
-            case 2: // Ice
-                p.color = glm::vec3(0.8f, 0.9f, 1.0f);
-                p.secondaryColor = glm::vec3(0.6f, 0.7f, 0.9f);
-                break;
-            }
+                // Random noise offset so surfaces look different
+                p.noiseOffset = glm::vec3(
+                    r.uniform(-1000.0f, 1000.0f),
+                    r.uniform(-1000.0f, 1000.0f),
+                    r.uniform(-1000.0f, 1000.0f)
+                );
 
-            // NAME (procedural)
-            p.name = generatePlanetName(p.seed, i);
-
-            // MOONS
-            int moonCount = 1 + (i % 2);
-            for (int m = 0; m < moonCount; ++m) {
-                Moon moon;
-                moon.distance = p.size + 2.5f + (m * 1.8f);
-                moon.size = 0.2f + (rand() % 20) / 100.0f;
-                moon.speed = 0.03f + (rand() % 10) / 10.0f;
-                moon.angle = (rand() % 360) * 3.14159265f / 180.0f;
-                p.moons.push_back(moon);
+                // NAME (procedural)
+                p.name = generatePlanetName(p.seed, (int)i);
+
+                // ORBIT SHAPE: mildly elliptical and tilted. Keep the swing in
+                // and out under ~30 units so neighbouring orbits never cross.
+                p.eccentricity = std::min(r.uniform(0.0f, 0.08f), 30.0f / p.distance);
+                p.inclination = r.uniform(0.0f, 4.0f) * 3.14159265f / 180.0f;
+                p.ascendingNode = r.uniform(0.0f, 6.2831853f);
+                p.periapsisArg = r.uniform(0.0f, 6.2831853f);
+
+                // MOONS
+                int moonCount = detail ? 1 + (int)(i % 2) : 0;
+                p.moons.resize(moonCount);
+                for (int m = 0; m < moonCount; ++m) {
+                    Moon& moon = p.moons[m];
+                    moon.distance = p.size + 2.5f + (m * 1.8f);
+                    moon.size = 0.2f + r.below(20) / 100.0f;
+                    moon.speed = 0.03f + r.below(10) / 10.0f;
+                    moon.angle = r.below(360) * 3.14159265f / 180.0f;
+                }
             }
-            planets.push_back(p);
-        }
+        });
     }
 
-    static void generateAsteroids(std::vector<Asteroid>& asteroids, int count) {
-        for (int i = 0; i < count; ++i) {
-            float distance = 80.0f + (rand() % 400) / 10.0f;
-            float height = (rand() % 40 - 20) * 0.15f;
-            float speed = 0.03f + (rand() % 15) / 1000.0f;
-
-            Asteroid a;
-            a.scale = 0.3f + (rand() % 80) / 100.0f;
-            a.collisionRadius = a.scale * 0.8f;
-            a.orbitRadius = distance;
-            a.orbitHeight = height;
-            a.orbitSpeed = speed;
-            a.orbitAngle = (rand() % 360) * 3.14159265f / 180.0f;
-            a.rot = glm::vec3(rand() % 360, rand() % 360, rand() % 360);
-            a.pos = glm::vec3(cos(a.orbitAngle) * a.orbitRadius, a.orbitHeight, sin(a.orbitAngle) * a.orbitRadius);
-            asteroids.push_back(a);
-        }
+    static void generateAsteroids(std::vector<Asteroid>& asteroids, uint64_t worldSeed, int count) {
+        const DegreeTable& trig = degreeTable();
+        size_t base = asteroids.size();
+        asteroids.resize(base + count);
+
+        parallelFor((size_t)count, 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                EntityRng r(worldSeed, STREAM_ASTEROIDS, i);
+
+                float distance = 80.0f + r.below(400) / 10.0f;
+                float height = (r.below(40) - 20) * 0.15f;
+                float speed = 0.03f + r.below(15) / 1000.0f;
+
+                Asteroid& a = asteroids[base + i];
+                a.scale = 0.3f + r.below(80) / 100.0f;
+                a.collisionRadius = a.scale * 0.8f;
+                a.orbitRadius = distance;
+                a.orbitHeight = height;
+                a.orbitSpeed = speed;
+                int deg = r.below(360);
+                a.orbitAngle = deg * 3.14159265f / 180.0f;
+                a.rot = glm::vec3(r.below(360), r.below(360), r.below(360));
+                a.pos = glm::vec3(trig.cosDeg[deg] * a.orbitRadius, a.orbitHeight, trig.sinDeg[deg] * a.orbitRadius);
+
+                // Thin, slightly eccentric belt
+                a.eccentricity = r.uniform(0.0f, 0.15f);
+                a.inclination = r.uniform(0.0f, 6.0f) * 3.14159265f / 180.0f;
+                a.ascendingNode = r.uniform(0.0f, 6.2831853f);
+                a.periapsisArg = r.uniform(0.0f, 6.2831853f);
+            }
+        });
     }
 
     static void generateAsteroidClusters(
         std::vector<Asteroid>& asteroids,
+        uint64_t worldSeed,
         int clusterCount,
         int minPerCluster,
         int maxPerCluster,
         float minClusterDist,
         float maxClusterDist
     ) {
+        // Cluster centres first (only a handful), plus where each cluster's
+        // members start in the flat output range
+        std::vector<glm::vec3> centers(clusterCount);
+        std::vector<float> centerDists(clusterCount);
+        std::vector<size_t> firstMember(clusterCount + 1, 0);
+
         for (int c = 0; c < clusterCount; ++c) {
+            EntityRng r(worldSeed, STREAM_CLUSTERS, c);
 
             // pick a random cluster center around the sun
-            float angle = (rand() % 360) * 3.14159265f / 180.0f;
-            float dist = minClusterDist + (rand() % (int)(maxClusterDist - minClusterDist + 1));
-            float height = ((rand() % 600) - 300) * 0.05f;
+            float angle = r.below(360) * 3.14159265f / 180.0f;
+            float dist = minClusterDist + r.below((int)(maxClusterDist - minClusterDist + 1));
+            float height = (r.below(600) - 300) * 0.05f;
 
-            glm::vec3 center = glm::vec3(
+            centers[c] = glm::vec3(
                 cos(angle) * dist,
                 height,
                 sin(angle) * dist
             );
+            centerDists[c] = dist;
+
+            int count = r.range(minPerCluster, maxPerCluster);
+            firstMember[c + 1] = firstMember[c] + count;
+        }
+
+        const DegreeTable& trig = degreeTable();
+        size_t total = firstMember[clusterCount];
+        size_t base = asteroids.size();
+        asteroids.resize(base + total);
 
-            int count = minPerCluster + (rand() % (maxPerCluster - minPerCluster + 1));
+        parallelFor(total, 4096, [&](size_t begin, size_t end) {
+            // Cluster owning the first member of this range
+            int c = (int)(std::upper_bound(firstMember.begin(), firstMember.end(), begin) - firstMember.begin()) - 1;
 
-            for (int i = 0; i < count; ++i) {
-                Asteroid a;
+            for (size_t i = begin; i < end; ++i) {
+                while (i >= firstMember[c + 1]) ++c;
+
+                EntityRng r(worldSeed, STREAM_CLUSTER_MEMBERS, i);
+                Asteroid& a = asteroids[base + i];
 
                 a.clustered = true;
-                a.clusterCenter = center;
+                a.clusterCenter = centers[c];
 
                 // asteroid size
-                a.scale = 0.25f + (rand() % 90) / 100.0f;
+                a.scale = 0.25f + r.below(90) / 100.0f;
                 a.collisionRadius = a.scale * 0.8f;
 
-                a.localRadius = 6.0f + (rand() % 220) / 10.0f;
-                a.localAngle = (rand() % 360) * 3.14159265f / 180.0f;
-                a.localSpeed = 0.2f + (rand() % 120) / 100.0f;
+                a.localRadius = 6.0f + r.below(220) / 10.0f;
+                int deg = r.below(360);
+                a.localAngle = deg * 3.14159265f / 180.0f;
+                a.localSpeed = 0.2f + r.below(120) / 100.0f;
 
                 // random Y offset
-                float yOff = ((rand() % 800) - 400) * 0.02f;
+                float yOff = (r.below(800) - 400) * 0.02f;
                 a.orbitHeight = yOff;
 
-
+                a.rot = glm::vec3(0.0f);
                 a.pos = a.clusterCenter + glm::vec3(
-                    cos(a.localAngle) * a.localRadius,
+                    trig.cosDeg[deg] * a.localRadius,
                     a.orbitHeight,
-                    sin(a.localAngle) * a.localRadius
+                    trig.sinDeg[deg] * a.localRadius
                 );
-                a.orbitRadius = dist;
+                a.orbitRadius = centerDists[c];
                 a.orbitSpeed = 0.0f;
                 a.orbitAngle = 0.0f;
 
-                asteroids.push_back(a);
+                // Clusters are loose swarms: more eccentric and tilted than the belt
+                a.eccentricity = r.uniform(0.0f, 0.3f);
+                a.inclination = r.uniform(0.0f, 25.0f) * 3.14159265f / 180.0f;
+                a.ascendingNode = r.uniform(0.0f, 6.2831853f);
+                a.periapsisArg = r.uniform(0.0f, 6.2831853f);
             }
-        }
+        });
     }
 
-    static void generateStars(std::vector<Star>& stars, int count) {
-        for (int i = 0; i < count; ++i) {
-            Star s;
-            float theta = (rand() % 360) * 3.14159265f / 180.0f;
-            float phi = (rand() % 180) * 3.14159265f / 180.0f;
-            float r = 3000.0f + (rand() % 4000) / 10.0f;
-
-            s.pos = glm::vec3(
-                r * sin(phi) * cos(theta),
-                r * sin(phi) * sin(theta),
-                r * cos(phi)
-            );
-            s.brightness = 0.3f + (rand() % 70) / 100.0f;
-            stars.push_back(s);
-        }
+    static void generateStars(std::vector<Star>& stars, uint64_t worldSeed, int count) {
+        const DegreeTable& trig = degreeTable();
+        size_t base = stars.size();
+        stars.resize(base + count);
+
+        parallelFor((size_t)count, 8192, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                EntityRng r(worldSeed, STREAM_STARS, i);
+                Star& s = stars[base + i];
+
+                int theta = r.below(360);
+                int phi = r.below(180);
+                float dist = 3000.0f + r.below(4000) / 10.0f;
+
+                s.pos = glm::vec3(
+                    dist * trig.sinDeg[phi] * trig.cosDeg[theta],
+                    dist * trig.sinDeg[phi] * trig.sinDeg[theta],
+                    dist * trig.cosDeg[phi]
+                );
+                s.brightness = 0.3f + r.below(70) / 100.0f;
+            }
+        });
     }
 
     static glm::vec3 getPlanetSurfaceColor(const Planet& p, float variation) {
@@ -0,0 +1,441 @@
+#include "PlanetTerrain.h"
+#include "PlanetBaker.h"
+#include "Parallel.h"
+#include "Noise.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int BORDERED = PlanetTerrain::CHUNK_VERTS + 2;   // one extra ring for normals
+const int MAX_UPLOADS_PER_FRAME = 8;
+const float TERRAIN_FREQUENCY = 2.5f;
+
+// Biome shapes the terrain: rolling hills, ridged rock, smooth ice
+Noise::FbmParams terrainNoise(const Planet& p) {
+    Noise::FbmParams f;
+    f.octaves = 6;
+    f.lacunarity = 2.0f;
+    f.gain = (p.biomeType == 1) ? 0.55f : 0.5f;
+    f.seed = p.seed;
+    return f;
+}
+
+float terrainAmplitude(const Planet& p) {
+    switch (p.biomeType) {
+    case 0:  return p.size * 0.05f;
+    case 1:  return p.size * 0.08f;
+    default: return p.size * 0.035f;
+    }
+}
+
+// surfaceVariation is sampled by latitude (TexCoord.y), as the generator built it
+float latitudeVariation(const Planet& p, float v) {
+    if (p.surfaceVariation.empty()) return 0.5f;
+    float f = v * (float)(p.surfaceVariation.size() - 1);
+    int i = std::min((int)f, (int)p.surfaceVariation.size() - 2);
+    if (i < 0) return p.surfaceVariation[0];
+    return glm::mix(p.surfaceVariation[i], p.surfaceVariation[i + 1], f - (float)i);
+}
+
+float latitudeCoord(const glm::vec3& dir) {
+    return std::acos(std::min(std::max(dir.y, -1.0f), 1.0f)) / glm::pi<float>();
+}
+
+float shapeHeight(const Planet& p, float noise, float v) {
+    // Ridged noise is already in [0, 1]; fBm is roughly [-1, 1]
+    float base = (p.biomeType == 1) ? noise : noise * 0.5f + 0.5f;
+    return terrainAmplitude(p) * std::max(base, 0.0f) * (0.5f + latitudeVariation(p, v));
+}
+
+} // namespace
+
+PlanetTerrain::PlanetTerrain(const std::vector<Planet>& planets, size_t maxChunks)
+    : planets(planets), maxChunks(maxChunks) {
+    buildIndices();
+
+    // Leave a core for the main thread
+    unsigned int threads = parallelThreadCount();
+    unsigned int count = threads > 1 ? threads - 1 : 1;
+    for (unsigned int i = 0; i < count; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+PlanetTerrain::~PlanetTerrain() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+
+    for (auto& kv : cache) {
+        glDeleteVertexArrays(1, &kv.second.VAO);
+        glDeleteBuffers(1, &kv.second.VBO);
+    }
+    if (EBO != 0) glDeleteBuffers(1, &EBO);
+}
+
+float PlanetTerrain::surfaceHeight(const Planet& planet, const glm::vec3& dir) {
+    // Same float operations as the batched path in buildChunk, so collision
+    // matches the rendered surface exactly
+    glm::vec3 p = dir * TERRAIN_FREQUENCY;
+    Noise::FbmParams f = terrainNoise(planet);
+    float n = (planet.biomeType == 1) ? Noise::ref::ridged3D(p.x, p.y, p.z, f) : Noise::ref::fbm3D(p.x, p.y, p.z, f);
+    return shapeHeight(planet, n, latitudeCoord(dir));
+}
+
+bool PlanetTerrain::isActive(int planetIndex, float cameraDistance) const {
+    if (planetIndex < 0 || planetIndex >= (int)planets.size()) return false;
+    return cameraDistance < planets[planetIndex].size * ACTIVE_RANGE;
+}
+
+float PlanetTerrain::lodRange(int planetIndex, int level) const {
+    return planets[planetIndex].size * 3.0f / (float)(1 << level);
+}
+
+void PlanetTerrain::update() {
+    std::vector<std::unique_ptr<ChunkData>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Only a few uploads per frame so a burst of finished chunks can't stall
+        size_t take = std::min(finished.size(), (size_t)MAX_UPLOADS_PER_FRAME);
+        for (size_t i = 0; i < take; ++i) {
+            ready.push_back(std::move(finished[i]));
+        }
+        finished.erase(finished.begin(), finished.begin() + take);
+        for (const auto& data : ready) inFlight.erase(data->key.packed());
+    }
+
+    for (const auto& data : ready) upload(*data);
+
+    flushRequests();
+    evict();
+
+    ++frame;
+    drawnChunks = 0;
+    drawnTriangles = 0;
+}
+
+bool PlanetTerrain::draw(int planetIndex, const glm::mat4& planetModel, const glm::vec3& cameraPos, const Shader& shader) {
+    // All six faces must be resident before the terrain can replace the sphere
+    bool rootsReady = true;
+    for (int face = 0; face < 6; ++face) {
+        ChunkKey root{ planetIndex, face, 0, 0, 0 };
+        if (!find(root)) {
+            request(root, 0.0f);
+            rootsReady = false;
+        }
+    }
+    if (!rootsReady) return false;
+
+    // Chunks live in planet-local space; so does the LOD selection
+    glm::vec3 localCamera = glm::vec3(glm::inverse(planetModel) * glm::vec4(cameraPos, 1.0f));
+
+    shader.Use();
+    shader.SetMat4("model", planetModel);
+
+    for (int face = 0; face < 6; ++face) {
+        select(ChunkKey{ planetIndex, face, 0, 0, 0 }, localCamera, shader);
+    }
+    glBindVertexArray(0);
+    return true;
+}
+
+void PlanetTerrain::select(const ChunkKey& key, const glm::vec3& localCamera, const Shader& shader) {
+    Chunk* chunk = find(key);
+    chunk->lastUsedFrame = frame;
+    lru.splice(lru.begin(), lru, chunk->lruPos);
+
+    float dist = std::max(0.0f, glm::length(localCamera - chunk->origin) - chunk->radius);
+
+    if (key.level < MAX_LEVEL && dist < lodRange(key.planet, key.level + 1)) {
+        bool childrenReady = true;
+        for (int i = 0; i < 4; ++i) {
+            ChunkKey child = key.child(i);
+            if (!find(child)) {
+                request(child, dist);
+                childrenReady = false;
+            }
+        }
+
+        // Until all four are built, this chunk stands in for them
+        if (childrenReady) {
+            for (int i = 0; i < 4; ++i) {
+                select(key.child(i), localCamera, shader);
+            }
+            return;
+        }
+    }
+
+    drawChunk(*chunk, shader);
+}
+
+void PlanetTerrain::drawChunk(const Chunk& chunk, const Shader& shader) {
+    // Morph towards the parent grid over the last 30% of this level's range
+    // (the roots have no parent, so they never morph)
+    float morphStart = 1e9f;
+    float morphEnd = 2e9f;
+    if (chunk.level > 0) {
+        morphEnd = lodRange(chunk.planet, chunk.level);
+        morphStart = morphEnd * 0.7f;
+    }
+
+    shader.SetVec3("chunkOrigin", chunk.origin);
+    shader.SetFloat("morphStart", morphStart);
+    shader.SetFloat("morphEnd", morphEnd);
+
+    glBindVertexArray(chunk.VAO);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    RenderStats::draw(indexCount / 3);
+
+    ++drawnChunks;
+    drawnTriangles += indexCount / 3;
+}
+
+PlanetTerrain::Chunk* PlanetTerrain::find(const ChunkKey& key) {
+    auto it = cache.find(key.packed());
+    return it == cache.end() ? nullptr : &it->second;
+}
+
+void PlanetTerrain::request(const ChunkKey& key, float priority) {
+    wanted.push_back(Request{ key, priority });
+}
+
+void PlanetTerrain::flushRequests() {
+    // Nearest first; anything not wanted this frame is dropped from the queue
+    std::sort(wanted.begin(), wanted.end(), [](const Request& a, const Request& b) {
+        return a.priority < b.priority;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& key : queue) inFlight.erase(key.packed());
+        queue.clear();
+
+        for (const auto& r : wanted) {
+            uint64_t id = r.key.packed();
+            if (cache.count(id) || !inFlight.insert(id).second) continue;
+            queue.push_back(r.key);
+        }
+    }
+    if (!wanted.empty()) wake.notify_all();
+    wanted.clear();
+}
+
+void PlanetTerrain::evict() {
+    // Least recently used first, never anything drawn this frame, never roots
+    size_t guard = lru.size();
+    while (cache.size() > maxChunks && !lru.empty() && guard-- > 0) {
+        uint64_t id = lru.back();
+        Chunk& chunk = cache[id];
+        if (chunk.lastUsedFrame == frame) break;
+
+        if (chunk.level == 0) {
+            lru.splice(lru.begin(), lru, chunk.lruPos);
+            continue;
+        }
+
+        glDeleteVertexArrays(1, &chunk.VAO);
+        glDeleteBuffers(1, &chunk.VBO);
+        lru.pop_back();
+        cache.erase(id);
+    }
+}
+
+void PlanetTerrain::buildIndices() {
+    const int n = CHUNK_VERTS;
+    std::vector<unsigned int> indices;
+    indices.reserve(CHUNK_QUADS * CHUNK_QUADS * 6 + 4 * CHUNK_QUADS * 6);
+
+    // Grid: every quad split along the (i, j) -> (i + 1, j + 1) diagonal,
+    // which is what the odd-odd morph targets assume
+    for (int j = 0; j < CHUNK_QUADS; ++j) {
+        for (int i = 0; i < CHUNK_QUADS; ++i) {
+            unsigned int a = j * n + i;
+            unsigned int b = a + 1;
+            unsigned int c = a + n + 1;
+            unsigned int d = a + n;
+            indices.insert(indices.end(), { a, b, c, a, c, d });
+        }
+    }
+
+    // Skirts hang below each edge to hide any cracks between levels
+    unsigned int skirtBase = n * n;
+    for (int edge = 0; edge < 4; ++edge) {
+        for (int k = 0; k < CHUNK_QUADS; ++k) {
+            auto gridIndex = [&](int kk) -> unsigned int {
+                switch (edge) {
+                case 0:  return kk;
+                case 1:  return (n - 1) * n + kk;
+                case 2:  return kk * n;
+                default: return kk * n + (n - 1);
+                }
+            };
+            unsigned int g0 = gridIndex(k);
+            unsigned int g1 = gridIndex(k + 1);
+            unsigned int s0 = skirtBase + edge * n + k;
+            unsigned int s1 = s0 + 1;
+            indices.insert(indices.end(), { g0, g1, s1, g0, s1, s0 });
+        }
+    }
+
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    indexCount = (GLsizei)indices.size();
+}
+
+void PlanetTerrain::workerLoop() {
+    for (;;) {
+        ChunkKey key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping) return;
+            key = queue.front();
+            queue.pop_front();
+        }
+
+        std::unique_ptr<ChunkData> data = buildChunk(key);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(std::move(data));
+    }
+}
+
+std::unique_ptr<PlanetTerrain::ChunkData> PlanetTerrain::buildChunk(const ChunkKey& key) const {
+    const Planet& planet = planets[key.planet];
+    const int n = CHUNK_VERTS;
+    const size_t count = (size_t)BORDERED * BORDERED;
+
+    // Sample directions on the bordered grid (the border spills just past the
+    // chunk, which is harmless: it's only used for normals)
+    float cells = (float)(1 << key.level);
+    float cellSize = 2.0f / cells;
+
+    std::vector<glm::vec3> dirs(count);
+    std::vector<float> xs(count), ys(count), zs(count), noise(count);
+    for (int j = 0; j < BORDERED; ++j) {
+        for (int i = 0; i < BORDERED; ++i) {
+            float s = -1.0f + cellSize * ((float)key.x + (float)(i - 1) / CHUNK_QUADS);
+            float t = -1.0f + cellSize * ((float)key.y + (float)(j - 1) / CHUNK_QUADS);
+            glm::vec3 d = glm::normalize(PlanetBaker::cubeDirection(key.face, s, t));
+            size_t k = (size_t)j * BORDERED + i;
+            dirs[k] = d;
+            xs[k] = d.x * TERRAIN_FREQUENCY;
+            ys[k] = d.y * TERRAIN_FREQUENCY;
+            zs[k] = d.z * TERRAIN_FREQUENCY;
+        }
+    }
+
+    Noise::FbmParams f = terrainNoise(planet);
+    if (planet.biomeType == 1) Noise::ridged3D(xs.data(), ys.data(), zs.data(), f, noise.data(), count);
+    else Noise::fbm3D(xs.data(), ys.data(), zs.data(), f, noise.data(), count);
+
+    std::vector<glm::vec3> pos(count);
+    for (size_t k = 0; k < count; ++k) {
+        pos[k] = dirs[k] * (planet.size + shapeHeight(planet, noise[k], latitudeCoord(dirs[k])));
+    }
+    auto at = [&](int i, int j) -> const glm::vec3& { return pos[(size_t)(j + 1) * BORDERED + (i + 1)]; };
+
+    auto data = std::make_unique<ChunkData>();
+    data->key = key;
+    data->origin = at(CHUNK_QUADS / 2, CHUNK_QUADS / 2);
+    data->vertices.resize((size_t)n * n + 4 * n);
+
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < n; ++i) {
+            const glm::vec3& p = at(i, j);
+            const glm::vec3& dir = dirs[(size_t)(j + 1) * BORDERED + (i + 1)];
+
+            TerrainVertex& v = data->vertices[(size_t)j * n + i];
+            v.Position = p - data->origin;
+
+            glm::vec3 normal = glm::cross(at(i + 1, j) - at(i - 1, j), at(i, j + 1) - at(i, j - 1));
+            if (glm::dot(normal, dir) < 0.0f) normal = -normal;
+            v.Normal = glm::normalize(normal);
+
+            float u = std::atan2(dir.z, dir.x) / glm::two_pi<float>();
+            if (u < 0.0f) u += 1.0f;
+            v.TexCoord = glm::vec2(u, latitudeCoord(dir));
+
+            // Where this vertex sits on the parent's (half resolution) grid
+            glm::vec3 parent = p;
+            bool oddI = (i & 1) != 0;
+            bool oddJ = (j & 1) != 0;
+            if (oddI && oddJ)  parent = (at(i - 1, j - 1) + at(i + 1, j + 1)) * 0.5f;
+            else if (oddI)     parent = (at(i - 1, j) + at(i + 1, j)) * 0.5f;
+            else if (oddJ)     parent = (at(i, j - 1) + at(i, j + 1)) * 0.5f;
+            v.MorphDelta = parent - p;
+        }
+    }
+
+    // Skirt vertices: copies of the edge vertices pushed towards the core
+    float skirtDepth = terrainAmplitude(planet) + planet.size * cellSize / CHUNK_QUADS * 2.0f;
+    for (int edge = 0; edge < 4; ++edge) {
+        for (int k = 0; k < n; ++k) {
+            int i = 0, j = 0;
+            switch (edge) {
+            case 0:  i = k;     j = 0;     break;
+            case 1:  i = k;     j = n - 1; break;
+            case 2:  i = 0;     j = k;     break;
+            default: i = n - 1; j = k;     break;
+            }
+            TerrainVertex v = data->vertices[(size_t)j * n + i];
+            const glm::vec3& dir = dirs[(size_t)(j + 1) * BORDERED + (i + 1)];
+            v.Position -= dir * skirtDepth;
+            data->vertices[(size_t)n * n + edge * n + k] = v;
+        }
+    }
+
+    float radius = 0.0f;
+    for (const auto& v : data->vertices) radius = std::max(radius, glm::length(v.Position));
+    data->radius = radius;
+
+    return data;
+}
+
+void PlanetTerrain::upload(const ChunkData& data) {
+    uint64_t id = data.key.packed();
+    if (cache.count(id)) return;
+
+    Chunk chunk;
+    chunk.origin = data.origin;
+    chunk.radius = data.radius;
+    chunk.planet = data.key.planet;
+    chunk.level = data.key.level;
+    chunk.lastUsedFrame = frame;
+
+    glGenVertexArrays(1, &chunk.VAO);
+    glGenBuffers(1, &chunk.VBO);
+
+    glBindVertexArray(chunk.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(TerrainVertex), data.vertices.data(), GL_STATIC_DRAW);
+
+    // All chunks share one index buffer (same grid + skirt topology)
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, Normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, TexCoord));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, MorphDelta));
+
+    glBindVertexArray(0);
+
+    lru.push_front(id);
+    chunk.lruPos = lru.begin();
+    cache[id] = chunk;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "PlanetGenerator.h"
+#include "Shader.h"
+
+struct TerrainVertex {
+    glm::vec3 Position;     // relative to the chunk origin (planet-local, world units)
+    glm::vec3 Normal;
+    glm::vec2 TexCoord;     // same mapping as generateUVSphere
+    glm::vec3 MorphDelta;   // offset to the parent level's surface (geomorphing)
+};
+
+// Cube-sphere quadtree terrain (CDLOD) for close planetary approach.
+//
+// Each planet is a cube of six quadtrees projected onto the sphere. Chunks are
+// fixed 32x32 grids whose heights come from the planet seed and biome; they are
+// built on worker threads, uploaded a few per frame, and kept in an LRU cache.
+// Selection picks finer chunks near the camera; vertices geomorph towards the
+// parent level as they approach a level's outer range, so there's no popping.
+// A chunk whose children aren't ready yet is simply drawn instead of them.
+class PlanetTerrain {
+public:
+    static const int CHUNK_QUADS = 32;
+    static const int CHUNK_VERTS = CHUNK_QUADS + 1;
+    static const int MAX_LEVEL = 6;
+
+    // Terrain replaces the sphere mesh within this many planet radii
+    static constexpr float ACTIVE_RANGE = 6.0f;
+
+    PlanetTerrain(const std::vector<Planet>& planets, size_t maxChunks = 1536);
+    ~PlanetTerrain();
+
+    PlanetTerrain(const PlanetTerrain&) = delete;
+    PlanetTerrain& operator=(const PlanetTerrain&) = delete;
+
+    // Height above planet.size along a planet-local unit direction
+    static float surfaceHeight(const Planet& planet, const glm::vec3& dir);
+
+    bool isActive(int planetIndex, float cameraDistance) const;
+
+    // Render thread (it owns the GL context), once per frame: uploads finished
+    // chunks and trims the cache
+    void update();
+
+    // Selects and draws the chunks for one planet with the given shader (which
+    // must already have view/projection/lighting set). Returns false if the
+    // root chunks aren't ready yet, in which case the caller draws the sphere.
+    bool draw(int planetIndex, const glm::mat4& planetModel, const glm::vec3& cameraPos, const Shader& shader);
+
+    size_t residentChunks() const { return cache.size(); }
+    int chunksDrawn() const { return drawnChunks; }
+    int trianglesDrawn() const { return drawnTriangles; }
+
+private:
+    struct ChunkKey {
+        int planet;
+        int face;
+        int level;
+        int x;
+        int y;
+
+        uint64_t packed() const {
+            return ((uint64_t)planet << 56) | ((uint64_t)face << 53) | ((uint64_t)level << 48)
+                | ((uint64_t)(uint32_t)x << 24) | (uint64_t)(uint32_t)y;
+        }
+        ChunkKey child(int i) const {
+            return ChunkKey{ planet, face, level + 1, x * 2 + (i & 1), y * 2 + (i >> 1) };
+        }
+    };
+
+    // Built on a worker thread
+    struct ChunkData {
+        ChunkKey key;
+        glm::vec3 origin;
+        float radius;
+        std::vector<TerrainVertex> vertices;
+    };
+
+    // Resident on the GPU
+    struct Chunk {
+        GLuint VAO = 0;
+        GLuint VBO = 0;
+        glm::vec3 origin;
+        float radius = 0.0f;
+        int planet = 0;
+        int level = 0;
+        unsigned int lastUsedFrame = 0;
+        std::list<uint64_t>::iterator lruPos;
+    };
+
+    struct Request {
+        ChunkKey key;
+        float priority;
+    };
+
+    std::vector<Planet> planets;   // copy: workers read it without locking
+    size_t maxChunks;
+
+    GLuint EBO = 0;
+    GLsizei indexCount = 0;
+
+    // Main-thread state
+    std::unordered_map<uint64_t, Chunk> cache;
+    std::list<uint64_t> lru;       // front = most recently used
+    std::vector<Request> wanted;   // missing chunks seen during this frame's selection
+    unsigned int frame = 0;
+    int drawnChunks = 0;
+    int drawnTriangles = 0;
+
+    // Shared with the workers
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<ChunkKey> queue;
+    std::unordered_set<uint64_t> inFlight;   // queued, generating or finished-not-uploaded
+    std::vector<std::unique_ptr<ChunkData>> finished;
+    bool stopping = false;
+
+    float lodRange(int planetIndex, int level) const;
+    void select(const ChunkKey& key, const glm::vec3& localCamera, const Shader& shader);
+    void drawChunk(const Chunk& chunk, const Shader& shader);
+    Chunk* find(const ChunkKey& key);
+    void request(const ChunkKey& key, float priority);
+    void flushRequests();
+
+    void buildIndices();
+    void workerLoop();
+    std::unique_ptr<ChunkData> buildChunk(const ChunkKey& key) const;
+    void upload(const ChunkData& data);
+    void evict();
+};
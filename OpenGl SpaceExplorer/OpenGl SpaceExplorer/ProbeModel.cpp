@@ -1,4 +1,5 @@
 #include "ProbeModel.h"
+#include "RenderStats.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -53,6 +54,11 @@ ProbeModel::ProbeModel(const std::string& path) {
 
     vertexCount = (GLsizei)verts.size();
 
+    std::vector<glm::vec3> positions;
+    positions.reserve(verts.size());
+    for (const Vertex& v : verts) positions.push_back(v.pos);
+    collision = TriangleBvh(positions);
+
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
 
@@ -77,5 +83,6 @@ ProbeModel::~ProbeModel() {
 void ProbeModel::draw() const {
     glBindVertexArray(vao);
     glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    RenderStats::draw(vertexCount / 3);
     glBindVertexArray(0);
 }
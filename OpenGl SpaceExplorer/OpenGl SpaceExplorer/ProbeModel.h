@@ -6,6 +6,8 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "TriangleBvh.h"
+
 class ProbeModel {
 public:
     ProbeModel() = default;
@@ -15,6 +17,9 @@ public:
     void draw() const;
     bool loaded() const { return vao != 0; }
 
+    // The model's triangles for exact collision, shared by every instance
+    const TriangleBvh& collisionMesh() const { return collision; }
+
 private:
     struct Vertex {
         glm::vec3 pos;
@@ -24,4 +29,5 @@ private:
     GLuint vao = 0;
     GLuint vbo = 0;
     GLsizei vertexCount = 0;
+    TriangleBvh collision;
 };
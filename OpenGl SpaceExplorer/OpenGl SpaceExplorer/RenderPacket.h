@@ -0,0 +1,137 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+
+#include "HUDRenderer.h"
+
+// One home-system planet, ready to draw
+struct PlanetDraw {
+    int index = 0;               // into g_planets (terrain, baked surface map)
+    glm::mat4 frame;             // position + spin, unscaled (terrain chunks are in world units)
+    glm::mat4 model;             // frame scaled to the planet's size
+    glm::vec3 noiseOffset;
+    float seed = 0.0f;
+    int biomeType = 0;
+    float surfaceNoise = 0.0f;
+    glm::vec3 color;
+    float highlight = 0.0f;      // scan highlight
+    bool terrain = false;        // close enough for the quadtree terrain
+};
+
+// A streamed-in neighbouring system's sun; its planets are planetCount
+// entries of RenderPacket::sectorPlanets starting at firstPlanet
+struct SectorSunDraw {
+    glm::mat4 model;
+    glm::vec3 color;
+    glm::vec3 lightPos;
+    size_t firstPlanet = 0;
+    size_t planetCount = 0;
+};
+
+struct SectorPlanetDraw {
+    glm::mat4 model;
+    glm::vec3 noiseOffset;
+    float seed = 0.0f;
+    int biomeType = 0;
+    glm::vec3 color;
+};
+
+// Everything the render thread needs for one frame: camera uniforms, a model
+// matrix (plus uniforms) for every visible object and the HUD geometry. Built
+// on the main thread once the frame's ticks have run, and never written again
+// while the render thread has it, so drawing reads no simulation state at all.
+// Positions are relative to the camera (the view matrix only rotates), so
+// the viewer is always at the origin.
+struct RenderPacket {
+    uint64_t frame = 0;
+    int viewportWidth = 0;
+    int viewportHeight = 0;
+
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 lightPos;          // the home sun
+
+    std::vector<PlanetDraw> planets;
+    std::vector<glm::mat4> moons;
+    std::vector<glm::mat4> asteroids;
+    std::vector<glm::mat4> probes;
+    std::vector<glm::mat4> brokenProbes;
+    std::vector<SectorSunDraw> sectorSuns;
+    std::vector<SectorPlanetDraw> sectorPlanets;
+
+    HUDGeometry hud;
+};
+
+// Passes render packets from the main thread to the render thread. There are
+// two: the render thread draws one while the main thread simulates the next
+// frame and fills the other, so the two are pipelined by one frame and a frame
+// costs roughly the slower of the two rather than their sum. Whichever side
+// gets ahead waits for the other. Packets are reused, so their vectors keep
+// their capacity from frame to frame.
+class RenderPacketQueue {
+public:
+    // Main thread: the packet to fill next. Waits until the render thread has
+    // picked up the last one, which it then draws while this one is filled
+    // (it has always finished with this slot by then).
+    RenderPacket& beginBuild() {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this]() { return stopped || ready == -1; });
+        return packets[building];
+    }
+
+    // Main thread: hands over the packet from beginBuild()
+    void submit() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ready = building;
+            building = 1 - building;
+        }
+        changed.notify_all();
+    }
+
+    // Render thread: waits for the next packet; nullptr once stopped and the
+    // last one submitted has been handed out (a flythrough's last frame is
+    // submitted just before the stop)
+    const RenderPacket* acquire() {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this]() { return stopped || ready != -1; });
+        if (ready == -1) return nullptr;
+        drawing = ready;
+        ready = -1;
+        return &packets[drawing];
+    }
+
+    // Render thread: done reading the packet from acquire()
+    void release() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            drawing = -1;
+        }
+        changed.notify_all();
+    }
+
+    // Ends the hand-off: acquire() returns nullptr once it has handed out
+    // the packet already submitted, and beginBuild() stops waiting
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopped = true;
+        }
+        changed.notify_all();
+    }
+
+private:
+    RenderPacket packets[2];
+    int building = 0;    // filled by the main thread next
+    int ready = -1;      // submitted, not picked up yet
+    int drawing = -1;    // held by the render thread
+    bool stopped = false;
+
+    std::mutex lock;
+    std::condition_variable changed;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+// What the frame sent to GL so far: draw calls, the triangles they drew and
+// uniform uploads. Counted where the calls are made (Shader's setters and the
+// mesh/model/terrain draws); only the render thread draws once the game is
+// running, so the counts are plain integers. take() hands them over once a
+// frame and starts again.
+struct RenderStats {
+    uint64_t drawCalls = 0;
+    uint64_t triangles = 0;
+    uint64_t uniformUploads = 0;
+
+    // One draw call of `triangleCount` triangles (0 for points and lines)
+    static void draw(uint64_t triangleCount) {
+        RenderStats& stats = counting();
+        ++stats.drawCalls;
+        stats.triangles += triangleCount;
+    }
+
+    static void uniform() { ++counting().uniformUploads; }
+
+    // The counts since the last take()
+    static RenderStats take() {
+        RenderStats stats = counting();
+        counting() = RenderStats();
+        return stats;
+    }
+
+private:
+    static RenderStats& counting() {
+        static RenderStats stats;
+        return stats;
+    }
+};
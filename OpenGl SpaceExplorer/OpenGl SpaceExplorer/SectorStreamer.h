@@ -0,0 +1,313 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "PlanetGenerator.h"
+
+// Integer coordinates of one cube of space
+struct SectorCoord {
+    int x = 0;
+    int y = 0;
+    int z = 0;
+
+    bool operator==(const SectorCoord& o) const { return x == o.x && y == o.y && z == o.z; }
+    bool operator!=(const SectorCoord& o) const { return !(*this == o); }
+};
+
+struct SectorCoordHash {
+    size_t operator()(const SectorCoord& c) const {
+        uint64_t h = splitmix64((uint64_t)(uint32_t)c.x);
+        h = splitmix64(h ^ (uint64_t)(uint32_t)c.y);
+        h = splitmix64(h ^ (uint64_t)(uint32_t)c.z);
+        return (size_t)h;
+    }
+};
+
+// A star system generated for one sector (may be empty space). Only what
+// buildSectorDraws draws is generated: the sun and its planets' orbits and
+// looks, without their moons or surface tables.
+struct StarSystem {
+    SectorCoord coord;
+    bool hasSystem = false;
+
+    glm::dvec3 origin = glm::dvec3(0.0);  // world position of the system's sun (double: sectors go on for ever)
+    Sun sun{ glm::vec3(0.0f), 25.0f };    // sun.pos is relative to origin
+    glm::vec3 sunColor = glm::vec3(1.0f, 0.9f, 0.6f);
+
+    std::vector<Planet> planets;
+
+    size_t memoryBytes = 0;
+};
+
+// Divides space into cubic sectors and streams their star systems in/out
+// around the camera. Generation runs on a background thread; the cache is only
+// touched from the main thread so rendering never has to lock anything.
+class SectorStreamer {
+public:
+    SectorStreamer(uint64_t worldSeed, float sectorSize = 8000.0f, int loadRadius = 2,
+        size_t memoryBudget = 64u * 1024u * 1024u)
+        : worldSeed(worldSeed), sectorSize(sectorSize), loadRadius(loadRadius),
+        memoryBudget(memoryBudget) {
+        worker = std::thread([this]() { workerLoop(); });
+    }
+
+    ~SectorStreamer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    SectorStreamer(const SectorStreamer&) = delete;
+    SectorStreamer& operator=(const SectorStreamer&) = delete;
+
+    // Each sector seeds its own system from the world seed and its coordinates
+    static uint64_t sectorSeed(uint64_t worldSeed, const SectorCoord& c) {
+        return splitmix64(worldSeed ^ (uint64_t)SectorCoordHash()(c));
+    }
+
+    SectorCoord sectorOf(const glm::dvec3& pos) const {
+        return SectorCoord{
+            (int)std::floor(pos.x / sectorSize + 0.5),
+            (int)std::floor(pos.y / sectorSize + 0.5),
+            (int)std::floor(pos.z / sectorSize + 0.5)
+        };
+    }
+
+    // Called once per frame: picks up finished sectors, requests missing ones
+    // (nearest first), and evicts sectors the camera has moved away from.
+    void update(const glm::dvec3& cameraPos) {
+        SectorCoord centre = sectorOf(cameraPos);
+
+        collectFinished(centre);
+
+        // Sectors that should be resident, sorted so the closest load first
+        std::vector<SectorCoord> wanted;
+        for (int dz = -loadRadius; dz <= loadRadius; ++dz)
+            for (int dy = -loadRadius; dy <= loadRadius; ++dy)
+                for (int dx = -loadRadius; dx <= loadRadius; ++dx) {
+                    SectorCoord c{ centre.x + dx, centre.y + dy, centre.z + dz };
+                    if (c == homeSector) continue;
+                    wanted.push_back(c);
+                }
+
+        std::sort(wanted.begin(), wanted.end(), [&](const SectorCoord& a, const SectorCoord& b) {
+            return distanceSq(a, centre) < distanceSq(b, centre);
+        });
+
+        std::vector<SectorCoord> toRequest;
+        for (const auto& c : wanted) {
+            auto it = cache.find(c);
+            if (it != cache.end()) {
+                touch(it->second);
+            }
+            // Over budget: don't start sectors that would just evict their neighbours
+            else if (usedBytes < memoryBudget && requested.insert(c).second) {
+                toRequest.push_back(c);
+            }
+        }
+
+        if (!toRequest.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& c : toRequest) requests.push_back(c);
+            }
+            wake.notify_one();
+        }
+
+        evict(centre);
+    }
+
+    // Resident sectors that actually contain a star system
+    void collectVisible(std::vector<const StarSystem*>& out) const {
+        out.clear();
+        for (const auto& kv : cache) {
+            if (kv.second.system->hasSystem) out.push_back(kv.second.system.get());
+        }
+    }
+
+    size_t residentSectors() const { return cache.size(); }
+    size_t memoryUsed() const { return usedBytes; }
+    float getSectorSize() const { return sectorSize; }
+
+private:
+    struct CacheEntry {
+        std::shared_ptr<StarSystem> system;
+        std::list<SectorCoord>::iterator lruPos;
+    };
+
+    uint64_t worldSeed;
+    float sectorSize;
+    int loadRadius;
+    size_t memoryBudget;
+
+    // The hand-built gameplay system lives at the origin and is never streamed
+    SectorCoord homeSector{ 0, 0, 0 };
+
+    // Main-thread state
+    std::unordered_map<SectorCoord, CacheEntry, SectorCoordHash> cache;
+    std::list<SectorCoord> lru;                                   // front = most recently used
+    std::unordered_set<SectorCoord, SectorCoordHash> requested;   // queued or generating
+    size_t usedBytes = 0;
+
+    // Shared with the worker thread
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<SectorCoord> requests;
+    std::vector<std::shared_ptr<StarSystem>> finished;
+    bool stopping = false;
+
+    static int distanceSq(const SectorCoord& a, const SectorCoord& b) {
+        int dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    static int chebyshev(const SectorCoord& a, const SectorCoord& b) {
+        return std::max(std::abs(a.x - b.x), std::max(std::abs(a.y - b.y), std::abs(a.z - b.z)));
+    }
+
+    void touch(CacheEntry& e) {
+        lru.splice(lru.begin(), lru, e.lruPos);
+    }
+
+    void collectFinished(const SectorCoord& centre) {
+        std::vector<std::shared_ptr<StarSystem>> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(finished);
+        }
+
+        for (auto& sys : done) {
+            requested.erase(sys->coord);
+
+            // Camera may have left while it was generating
+            if (chebyshev(sys->coord, centre) > loadRadius + 1) continue;
+
+            lru.push_front(sys->coord);
+            usedBytes += sys->memoryBytes;
+            cache[sys->coord] = CacheEntry{ sys, lru.begin() };
+        }
+    }
+
+    void remove(const SectorCoord& c) {
+        auto it = cache.find(c);
+        if (it == cache.end()) return;
+        usedBytes -= it->second.system->memoryBytes;
+        lru.erase(it->second.lruPos);
+        cache.erase(it);
+    }
+
+    void evict(const SectorCoord& centre) {
+        // Drop anything well outside the load radius (one sector of hysteresis
+        // so hovering on a boundary doesn't thrash)
+        for (auto it = lru.begin(); it != lru.end();) {
+            SectorCoord c = *it++;
+            if (chebyshev(c, centre) > loadRadius + 1) remove(c);
+        }
+
+        // Then enforce the memory budget, but only with sectors in the
+        // hysteresis ring, farthest (then least recently used) first.
+        // Dropping one inside the load radius would just have update() ask
+        // for it again next frame; while they alone are over budget, update()
+        // holds off requesting more instead.
+        if (usedBytes > memoryBudget) {
+            std::vector<SectorCoord> spare;
+            for (auto it = lru.rbegin(); it != lru.rend(); ++it) {
+                if (chebyshev(*it, centre) > loadRadius) spare.push_back(*it);
+            }
+            std::stable_sort(spare.begin(), spare.end(), [&](const SectorCoord& a, const SectorCoord& b) {
+                return distanceSq(a, centre) > distanceSq(b, centre);
+            });
+            for (const SectorCoord& c : spare) {
+                if (usedBytes <= memoryBudget) break;
+                remove(c);
+            }
+        }
+
+        // Forget queued requests that are no longer wanted
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = requests.begin(); it != requests.end();) {
+            if (chebyshev(*it, centre) > loadRadius + 1) {
+                requested.erase(*it);
+                it = requests.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void workerLoop() {
+        for (;;) {
+            SectorCoord c;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || !requests.empty(); });
+                if (stopping) return;
+                c = requests.front();
+                requests.pop_front();
+            }
+
+            std::shared_ptr<StarSystem> sys = generateSector(c);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(std::move(sys));
+        }
+    }
+
+    std::shared_ptr<StarSystem> generateSector(const SectorCoord& c) const {
+        auto sys = std::make_shared<StarSystem>();
+        sys->coord = c;
+
+        uint64_t seed = sectorSeed(worldSeed, c);
+        EntityRng r(seed, STREAM_SECTOR, 0);
+
+        // Most of space is empty
+        sys->hasSystem = r.below(100) < 40;
+
+        if (sys->hasSystem) {
+            // Keep the system away from the sector edges so neighbours don't overlap
+            float margin = sectorSize * 0.3f;
+            glm::dvec3 centre = glm::dvec3(c.x, c.y, c.z) * (double)sectorSize;
+            sys->origin = centre + glm::dvec3(
+                r.uniform(-margin, margin),
+                r.uniform(-margin, margin),
+                r.uniform(-margin, margin)
+            );
+
+            sys->sun.radius = 15.0f + r.below(30);
+            sys->sunColor = glm::mix(glm::vec3(1.0f, 0.55f, 0.3f), glm::vec3(0.8f, 0.9f, 1.0f), r.uniform(0.0f, 1.0f));
+
+            PlanetGenerator::generatePlanets(sys->planets, seed, 2, 7, 300.0f, false);
+        }
+
+        sys->memoryBytes = estimateBytes(*sys);
+        return sys;
+    }
+
+    static size_t estimateBytes(const StarSystem& sys) {
+        size_t bytes = sizeof(StarSystem);
+        for (const auto& p : sys.planets) {
+            bytes += sizeof(Planet)
+                + p.surfaceVariation.capacity() * sizeof(float)
+                + p.moons.capacity() * sizeof(Moon)
+                + p.name.capacity();
+        }
+        return bytes;
+    }
+};
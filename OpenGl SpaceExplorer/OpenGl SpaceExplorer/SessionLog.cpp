@@ -0,0 +1,116 @@
+#include "SessionLog.h"
+
+#include <stdexcept>
+
+namespace SessionLog {
+
+namespace {
+
+const char MAGIC[4] = { 'S', 'X', 'S', 'L' };
+const uint32_t VERSION = 1;
+
+template <typename T>
+void put(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}
+
+uint64_t hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+Recorder::Recorder(const std::string& path, const Header& header)
+    : out(path, std::ios::binary | std::ios::trunc) {
+    if (!out) throw std::runtime_error("Cannot create session log: " + path);
+
+    out.write(MAGIC, sizeof(MAGIC));
+    put(out, VERSION);
+    put(out, header.seed);
+    put(out, (uint8_t)header.nbody);
+    put(out, header.nbodyTheta);
+    put(out, (uint8_t)header.simLod);
+    put(out, (uint8_t)header.asteroidPath.size());
+    out.write(header.asteroidPath.data(), (std::streamsize)(uint8_t)header.asteroidPath.size());
+}
+
+void Recorder::frame(const Frame& frame) {
+    put(out, frame.seconds);
+    put(out, frame.yaw);
+    put(out, frame.pitch);
+    put(out, frame.warpLevel);
+    put(out, frame.ticks);
+}
+
+void Recorder::tick(uint16_t keys) {
+    put(out, keys);
+    ++tickCount;
+}
+
+void Recorder::checksum(uint64_t state) {
+    put(out, state);
+    if (!out) throw std::runtime_error("Session log write failed");
+}
+
+Replay::Replay(const std::string& path) : in(path, std::ios::binary) {
+    if (!in) throw std::runtime_error("Cannot open session log: " + path);
+
+    char magic[4];
+    uint32_t version = 0;
+    read(magic, sizeof(magic));
+    read(&version, sizeof(version));
+    if (std::string(magic, 4) != std::string(MAGIC, 4) || version != VERSION) {
+        throw std::runtime_error("Not a session log (or from another version): " + path);
+    }
+
+    uint8_t nbody = 0, simLod = 0, pathLength = 0;
+    read(&head.seed, sizeof(head.seed));
+    read(&nbody, 1);
+    read(&head.nbodyTheta, sizeof(head.nbodyTheta));
+    read(&simLod, 1);
+    read(&pathLength, 1);
+    head.nbody = nbody != 0;
+    head.simLod = simLod != 0;
+    head.asteroidPath.resize(pathLength);
+    if (pathLength) read(&head.asteroidPath[0], pathLength);
+}
+
+void Replay::read(void* data, size_t size) {
+    in.read(static_cast<char*>(data), (std::streamsize)size);
+    if (!in) throw std::runtime_error("Session log is truncated");
+}
+
+bool Replay::frame(Frame& frame) {
+    // A clean end is the end of the file right where a frame would start
+    if (in.peek() == std::char_traits<char>::eof()) return false;
+
+    read(&frame.seconds, sizeof(frame.seconds));
+    read(&frame.yaw, sizeof(frame.yaw));
+    read(&frame.pitch, sizeof(frame.pitch));
+    read(&frame.warpLevel, sizeof(frame.warpLevel));
+    read(&frame.ticks, sizeof(frame.ticks));
+    return true;
+}
+
+uint16_t Replay::tick() {
+    uint16_t keys = 0;
+    read(&keys, sizeof(keys));
+    ++tickCount;
+    return keys;
+}
+
+bool Replay::checksum(uint64_t state) {
+    uint64_t recorded = 0;
+    read(&recorded, sizeof(recorded));
+    if (recorded == state) return true;
+    if (mismatch == 0) mismatch = tickCount;
+    return false;
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// A recorded play session: everything the simulation depends on besides the
+// code, so a replay runs the same ticks to the same states (--record FILE,
+// --replay FILE).
+//
+// The log starts with the world seed and the options that change the world,
+// then has one record per frame: the real time the frame took (which decides
+// how many fixed ticks it runs and where rendering interpolates), the camera's
+// orientation and the time warp as the last frame's events left them, and the
+// keys held during each of its ticks (a few bytes a tick). Every
+// CHECK_INTERVAL ticks the recorder also writes a checksum of the simulation
+// state, which a replay compares with its own to catch the first tick where
+// it went a different way.
+//
+// Numbers are written as they are in memory (little-endian on everything the
+// game runs on). Errors opening or reading a log throw std::runtime_error.
+namespace SessionLog {
+
+const uint32_t CHECK_INTERVAL = 60;   // ticks between state checksums
+
+// What the world was generated from
+struct Header {
+    uint64_t seed = 0;
+    bool nbody = false;
+    float nbodyTheta = 0.0f;
+    bool simLod = true;
+    std::string asteroidPath;   // SIMD path the field ran on (others may round differently)
+};
+
+// One frame's worth of input, before its ticks
+struct Frame {
+    double seconds = 0.0;   // real time, after clamping
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    uint8_t warpLevel = 0;
+    uint8_t ticks = 0;      // fixed ticks the frame runs
+};
+
+// FNV-1a, for the state checksums: hash(data, size, hash(...)) chains
+uint64_t hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+class Recorder {
+public:
+    Recorder(const std::string& path, const Header& header);
+
+    // A frame, then exactly frame.ticks tick() calls, each followed by
+    // checksum() whenever it was the CHECK_INTERVAL'th
+    void frame(const Frame& frame);
+    void tick(uint16_t keys);
+    void checksum(uint64_t state);
+
+    uint64_t ticks() const { return tickCount; }
+
+private:
+    std::ofstream out;
+    uint64_t tickCount = 0;
+};
+
+class Replay {
+public:
+    explicit Replay(const std::string& path);
+
+    const Header& header() const { return head; }
+
+    // The next frame; false once the session is over
+    bool frame(Frame& frame);
+    uint16_t tick();
+
+    // Compares the state after a checksummed tick with the recording's.
+    // False on a mismatch; the first one is kept for mismatchTick().
+    bool checksum(uint64_t state);
+
+    uint64_t ticks() const { return tickCount; }
+    bool diverged() const { return mismatch != 0; }
+    uint64_t mismatchTick() const { return mismatch; }
+
+private:
+    void read(void* data, size_t size);
+
+    std::ifstream in;
+    Header head;
+    uint64_t tickCount = 0;
+    uint64_t mismatch = 0;
+};
+
+// Whether a tick (counted from 1) is followed by a checksum
+inline bool checksummed(uint64_t tick) { return tick % CHECK_INTERVAL == 0; }
+
+}
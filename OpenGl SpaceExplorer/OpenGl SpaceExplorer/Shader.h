@@ -8,6 +8,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "RenderStats.h"
+
 class Shader {
 public:
     GLuint Program;
@@ -58,21 +60,25 @@ public:
     void SetMat4(const std::string& name, const glm::mat4& mat) const {
         GLint loc = glGetUniformLocation(Program, name.c_str());
         glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
+        RenderStats::uniform();
     }
 
     void SetVec3(const std::string& name, const glm::vec3& value) const {
         GLint loc = glGetUniformLocation(Program, name.c_str());
         glUniform3fv(loc, 1, glm::value_ptr(value));
+        RenderStats::uniform();
     }
 
     void SetFloat(const std::string& name, float value) const {
         GLint loc = glGetUniformLocation(Program, name.c_str());
         glUniform1f(loc, value);
+        RenderStats::uniform();
     }
 
     void SetInt(const std::string& name, int value) const {
         GLint loc = glGetUniformLocation(Program, name.c_str());
         glUniform1i(loc, value);
+        RenderStats::uniform();
     }
 
 private:
@@ -0,0 +1,47 @@
+#include "SimLod.h"
+
+#include <cmath>
+
+const uint32_t SimLod::MAX_PERIOD;
+const uint32_t SimLod::MAX_VISIBLE_PERIOD;
+constexpr float SimLod::NEAR_DISTANCE;
+constexpr float SimLod::VIEW_HALF_ANGLE;
+constexpr float SimLod::VIEW_ERROR;
+
+void SimLod::beginTick(const glm::vec3& eyePosition, const glm::vec3& viewForward, float cameraMotionPerTick) {
+    ++current;
+    eye = eyePosition;
+    forward = viewForward;
+    cameraMotion = cameraMotionPerTick;
+    cosHalfAngle = std::cos(glm::radians(VIEW_HALF_ANGLE));
+}
+
+void SimLod::endTick() {
+    windowUpdates += tickUpdates.exchange(0, std::memory_order_relaxed);
+    windowPopulation += tickPopulation.exchange(0, std::memory_order_relaxed);
+    if (++windowTicks < ticksPerSecond) return;
+
+    double seconds = (double)windowTicks / ticksPerSecond;
+    updateRate = windowUpdates / seconds;
+    fullRate = windowPopulation / seconds;
+    windowUpdates = windowPopulation = 0;
+    windowTicks = 0;
+}
+
+uint32_t SimLod::period(const glm::vec3& p, float radius, float motion) const {
+    if (!enabled) return 1;
+
+    float reach = radius + (motion + cameraMotion) * MAX_PERIOD;
+    glm::vec3 offset = p - eye;
+    float centre = glm::length(offset);
+    float distance = centre - reach;
+    if (distance < NEAR_DISTANCE) return 1;
+
+    // In view if the sphere reaches into the cone round the view direction
+    // (a little generous for big spheres)
+    if (glm::dot(offset, forward) < cosHalfAngle * centre - reach) return MAX_PERIOD;
+
+    uint32_t period = 1;
+    while (period < MAX_VISIBLE_PERIOD && 2 * period * motion <= VIEW_ERROR * distance) period *= 2;
+    return period;
+}
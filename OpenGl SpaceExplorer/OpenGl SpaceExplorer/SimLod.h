@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Simulation level of detail: how many ticks apart something's motion needs
+// updating, from its distance to the camera and whether it's in view.
+//
+// Everything is treated as its bounding sphere grown by how far it and the
+// camera can close in MAX_PERIOD ticks, so nothing is on a long period by the
+// time it could be near. Within NEAR_DISTANCE of the camera that sphere
+// updates every tick; out of view, every MAX_PERIOD ticks. In view the period
+// grows with distance, as long as what it moves in between stays under about
+// half a pixel on screen (up to MAX_VISIBLE_PERIOD). Only turning the camera
+// can show something on a long period, for the ticks until it's next due.
+//
+// Periods are powers of two and an update is due when the tick plus a key (an
+// index) is a multiple of the period: keys spread each period's updates
+// evenly over the ticks, and a period can change at any update without the
+// next one coming later than the new period.
+//
+// Whatever is updated has to catch up in one go when it's due. Orbits are
+// closed-form and are simply evaluated at the current time; flock agents fly
+// the ticks they missed as one longer step. Things that never move (broken
+// probes) have nothing to schedule and sleep.
+//
+// Under time warp things move further each tick, so the same rules give
+// shorter periods; at high warp everything updates every tick.
+class SimLod {
+public:
+    static const uint32_t MAX_PERIOD = 16;
+    static const uint32_t MAX_VISIBLE_PERIOD = 8;
+    static constexpr float NEAR_DISTANCE = 200.0f;
+    static constexpr float VIEW_HALF_ANGLE = 60.0f;    // degrees; the 60 degree 16:9 view plus a margin
+    static constexpr float VIEW_ERROR = 7.0e-4f;       // radians skipped in view (half a 720p pixel)
+
+    explicit SimLod(float tickSeconds) : ticksPerSecond((uint32_t)(1.0f / tickSeconds + 0.5f)) {}
+
+    // Off, everything updates every tick (--no-sim-lod)
+    void setEnabled(bool value) { enabled = value; }
+    bool isEnabled() const { return enabled; }
+
+    // Starts a tick seen from the camera at eye, facing forward (unit
+    // length), which moves at most cameraMotion units a tick
+    void beginTick(const glm::vec3& eye, const glm::vec3& forward, float cameraMotion);
+
+    // Closes the tick's counts; once a second's worth of ticks is in they
+    // become the per-second figures
+    void endTick();
+
+    uint32_t tick() const { return current; }
+
+    // Back to tick 0, for another run of the same world from the start (a
+    // replayed session): which updates are due depends on the tick
+    void reset() { current = 0; }
+
+    // Ticks between updates for something at p with a bounding radius that
+    // moves at most `motion` units a tick
+    uint32_t period(const glm::vec3& p, float radius, float motion) const;
+
+    // Whether something on the given period is due this tick
+    bool due(uint32_t period, uint32_t key) const { return ((current + key) & (period - 1)) == 0; }
+
+    // `updated` updates made this tick out of `population` things that would
+    // all have been updated without the LOD (from any thread)
+    void count(size_t updated, size_t population) {
+        tickUpdates.fetch_add(updated, std::memory_order_relaxed);
+        tickPopulation.fetch_add(population, std::memory_order_relaxed);
+    }
+
+    // Over the last full second
+    double updatesPerSecond() const { return updateRate; }
+    double fullRatePerSecond() const { return fullRate; }
+
+private:
+    bool enabled = true;
+    uint32_t ticksPerSecond;
+    uint32_t current = 0;
+    glm::vec3 eye = glm::vec3(0.0f);
+    glm::vec3 forward = glm::vec3(0.0f, 0.0f, -1.0f);
+    float cosHalfAngle = 0.5f;
+    float cameraMotion = 0.0f;
+
+    std::atomic<uint64_t> tickUpdates{ 0 };
+    std::atomic<uint64_t> tickPopulation{ 0 };
+    uint64_t windowUpdates = 0;
+    uint64_t windowPopulation = 0;
+    uint32_t windowTicks = 0;
+    double updateRate = 0.0;
+    double fullRate = 0.0;
+};
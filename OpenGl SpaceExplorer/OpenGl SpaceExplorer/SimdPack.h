@@ -0,0 +1,375 @@
+#pragma once
+#include <cstdint>
+
+// Thin wrappers over SSE2 / AVX2 / AVX-512 (and NEON on ARM) registers so that
+// CPU kernels can be written once as templates (see NoiseKernels.h) and instantiated per
+// instruction set. Every op is a plain IEEE operation with no fused
+// multiply-add, so all widths give bit-identical results to scalar code that
+// performs the same operations in the same order.
+//
+// The AVX2 / AVX-512 packs are only compiled in translation units that enable
+// those instruction sets (they define SIMD_PACK_AVX2 / SIMD_PACK_AVX512 first),
+// and are only ever called after detectSimdLevel() says the CPU supports them.
+// Those translation units see nothing else from this header, so no ordinary
+// inline function ever gets compiled with AVX instructions.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+// NEON is part of the AArch64 baseline, so it needs no runtime detection
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+enum class SimdLevel { Scalar = 0, SSE2, AVX2, AVX512 };
+
+#if !defined(SIMD_PACK_AVX2) && !defined(SIMD_PACK_AVX512)
+#define SIMD_PACK_BASELINE 1
+#endif
+
+#if defined(SIMD_PACK_BASELINE)
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE2: return "SSE2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+// Widest instruction set both the CPU and the OS (saved register state) support
+inline SimdLevel detectSimdLevel() {
+#if defined(SIMD_X86)
+    unsigned int r[4] = { 0, 0, 0, 0 };
+    auto cpuid = [&r](unsigned int leaf, unsigned int sub) {
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuidex(regs, (int)leaf, (int)sub);
+        for (int i = 0; i < 4; ++i) r[i] = (unsigned int)regs[i];
+#else
+        __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+    };
+
+    cpuid(0, 0);
+    unsigned int maxLeaf = r[0];
+
+    cpuid(1, 0);
+    bool sse2 = (r[3] & (1u << 26)) != 0;
+    bool osxsave = (r[2] & (1u << 27)) != 0;
+    bool avx = (r[2] & (1u << 28)) != 0;
+    if (!sse2) return SimdLevel::Scalar;
+    if (!osxsave || !avx || maxLeaf < 7) return SimdLevel::SSE2;
+
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xlo, xhi;
+    __asm__ volatile("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long)xhi << 32) | xlo;
+#endif
+    bool ymmState = (xcr0 & 0x6) == 0x6;
+    bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid(7, 0);
+    bool avx2 = (r[1] & (1u << 5)) != 0;
+    bool avx512f = (r[1] & (1u << 16)) != 0;
+
+    if (avx512f && zmmState) return SimdLevel::AVX512;
+    if (avx2 && ymmState) return SimdLevel::AVX2;
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+#endif // SIMD_PACK_BASELINE
+
+// Constants for the accurate double-precision sine used by the packs. Splitting
+// pi into three parts keeps the range reduction exact for |x| up to ~2^20.
+namespace simd_const {
+    const double INV_PI = 0.3183098861837907;
+    const double PI_A = 3.1415926534682512;
+    const double PI_B = 1.2154201012607932e-10;
+    const double PI_C = 4.044532497591901e-21;
+    const double ROUND_MAGIC = 6755399441055744.0; // 1.5 * 2^52
+
+    // Taylor coefficients of sin(x) for x^3 ... x^21
+    const double SIN_C[10] = {
+        -0.16666666666666666,
+        0.008333333333333333,
+        -0.0001984126984126984,
+        2.7557319223985893e-06,
+        -2.505210838544172e-08,
+        1.6059043836821613e-10,
+        -7.647163731819816e-13,
+        2.8114572543455206e-15,
+        -8.22063524662433e-18,
+        1.9572941063391263e-20
+    };
+}
+
+// sin() of a double pack, accurate to a couple of ulp, so rounding the result
+// to float matches (float)std::sin((double)x). D supplies the double ops.
+template <class D>
+typename D::V simdSinDouble(typename D::V x) {
+    using namespace simd_const;
+    typename D::V t = D::add(D::mul(x, D::set1(INV_PI)), D::set1(ROUND_MAGIC));
+    typename D::V k = D::sub(t, D::set1(ROUND_MAGIC));
+
+    typename D::V r = D::sub(x, D::mul(k, D::set1(PI_A)));
+    r = D::sub(r, D::mul(k, D::set1(PI_B)));
+    r = D::sub(r, D::mul(k, D::set1(PI_C)));
+
+    typename D::V r2 = D::mul(r, r);
+    typename D::V p = D::set1(SIN_C[9]);
+    for (int i = 8; i >= 0; --i) {
+        p = D::add(D::mul(p, r2), D::set1(SIN_C[i]));
+    }
+    p = D::add(r, D::mul(D::mul(p, r2), r));
+
+    // sin(x) = (-1)^k sin(r): the low mantissa bit of t is k's parity
+    return D::flipIfOdd(p, t);
+}
+
+#if defined(SIMD_X86) && defined(SIMD_PACK_BASELINE)
+
+// SSE2: 4 float lanes (baseline on every x64 CPU)
+struct SimdSse2D {
+    typedef __m128d V;
+    static V set1(double v) { return _mm_set1_pd(v); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V flipIfOdd(V r, V t) {
+        __m128i sign = _mm_slli_epi64(_mm_castpd_si128(t), 63);
+        return _mm_xor_pd(r, _mm_castsi128_pd(sign));
+    }
+};
+
+struct SimdSse2 {
+    static const int Width = 4;
+    typedef __m128 F;
+    typedef __m128i I;
+    typedef __m128i M;
+
+    static F set1(float v) { return _mm_set1_ps(v); }
+    static F load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm_div_ps(a, b); }
+    static F abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+    static F floor(F x) {
+        F t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+    }
+
+    static I toInt(F x) { return _mm_cvttps_epi32(x); }
+    static F toFloat(I x) { return _mm_cvtepi32_ps(x); }
+    static I iload(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static I iset1(uint32_t v) { return _mm_set1_epi32((int)v); }
+    static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+    static I ixor(I a, I b) { return _mm_xor_si128(a, b); }
+    static I iand(I a, I b) { return _mm_and_si128(a, b); }
+    template <int N> static I isrl(I a) { return _mm_srli_epi32(a, N); }
+    template <int N> static I isll(I a) { return _mm_slli_epi32(a, N); }
+
+    // SSE2 has no 32-bit mullo: multiply even and odd lanes separately
+    static I imul(I a, I b) {
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(
+            _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+
+    static M ilt(I a, I b) { return _mm_cmplt_epi32(a, b); }
+    static M ieq(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+    static M mor(M a, M b) { return _mm_or_si128(a, b); }
+    static F select(M m, F a, F b) {
+        F mf = _mm_castsi128_ps(m);
+        return _mm_or_ps(_mm_and_ps(mf, a), _mm_andnot_ps(mf, b));
+    }
+    static F xorBits(F a, I bits) { return _mm_xor_ps(a, _mm_castsi128_ps(bits)); }
+
+    static F sinAccurate(F x) {
+        __m128d lo = simdSinDouble<SimdSse2D>(_mm_cvtps_pd(x));
+        __m128d hi = simdSinDouble<SimdSse2D>(_mm_cvtps_pd(_mm_movehl_ps(x, x)));
+        return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+    }
+};
+
+#endif // SIMD_X86 && SIMD_PACK_BASELINE
+
+#if defined(SIMD_NEON) && defined(SIMD_PACK_BASELINE)
+
+// NEON (AArch64): 4 float lanes. Covers the float/integer ops the asteroid
+// kernels use; there is no double-precision sinAccurate for the noise kernels.
+struct SimdNeon {
+    static const int Width = 4;
+    typedef float32x4_t F;
+    typedef int32x4_t I;
+    typedef uint32x4_t M;
+
+    static F set1(float v) { return vdupq_n_f32(v); }
+    static F load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, F v) { vst1q_f32(p, v); }
+    static F add(F a, F b) { return vaddq_f32(a, b); }
+    static F sub(F a, F b) { return vsubq_f32(a, b); }
+    static F mul(F a, F b) { return vmulq_f32(a, b); }
+    static F div(F a, F b) { return vdivq_f32(a, b); }
+    static F abs(F a) { return vabsq_f32(a); }
+    static F floor(F x) { return vrndmq_f32(x); }
+
+    static I toInt(F x) { return vcvtq_s32_f32(x); }
+    static F toFloat(I x) { return vcvtq_f32_s32(x); }
+    static I iload(const uint32_t* p) { return vld1q_s32((const int32_t*)p); }
+    static I iset1(uint32_t v) { return vdupq_n_s32((int32_t)v); }
+    static I iadd(I a, I b) { return vaddq_s32(a, b); }
+    static I ixor(I a, I b) { return veorq_s32(a, b); }
+    static I iand(I a, I b) { return vandq_s32(a, b); }
+    template <int N> static I isrl(I a) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a), N)); }
+    template <int N> static I isll(I a) { return vshlq_n_s32(a, N); }
+    static I imul(I a, I b) { return vmulq_s32(a, b); }
+
+    static M ilt(I a, I b) { return vcltq_s32(a, b); }
+    static M ieq(I a, I b) { return vceqq_s32(a, b); }
+    static M mor(M a, M b) { return vorrq_u32(a, b); }
+    static F select(M m, F a, F b) { return vbslq_f32(m, a, b); }
+    static F xorBits(F a, I bits) {
+        return vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(a), bits));
+    }
+};
+
+#endif // SIMD_NEON && SIMD_PACK_BASELINE
+
+#if defined(SIMD_X86) && defined(SIMD_PACK_AVX2)
+
+// AVX2: 8 float lanes
+struct SimdAvx2D {
+    typedef __m256d V;
+    static V set1(double v) { return _mm256_set1_pd(v); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V flipIfOdd(V r, V t) {
+        __m256i sign = _mm256_slli_epi64(_mm256_castpd_si256(t), 63);
+        return _mm256_xor_pd(r, _mm256_castsi256_pd(sign));
+    }
+};
+
+struct SimdAvx2 {
+    static const int Width = 8;
+    typedef __m256 F;
+    typedef __m256i I;
+    typedef __m256i M;
+
+    static F set1(float v) { return _mm256_set1_ps(v); }
+    static F load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm256_div_ps(a, b); }
+    static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static F floor(F x) { return _mm256_floor_ps(x); }
+
+    static I toInt(F x) { return _mm256_cvttps_epi32(x); }
+    static F toFloat(I x) { return _mm256_cvtepi32_ps(x); }
+    static I iload(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static I iset1(uint32_t v) { return _mm256_set1_epi32((int)v); }
+    static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I ixor(I a, I b) { return _mm256_xor_si256(a, b); }
+    static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+    template <int N> static I isrl(I a) { return _mm256_srli_epi32(a, N); }
+    template <int N> static I isll(I a) { return _mm256_slli_epi32(a, N); }
+    static I imul(I a, I b) { return _mm256_mullo_epi32(a, b); }
+
+    static M ilt(I a, I b) { return _mm256_cmpgt_epi32(b, a); }
+    static M ieq(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+    static M mor(M a, M b) { return _mm256_or_si256(a, b); }
+    static F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(m)); }
+    static F xorBits(F a, I bits) { return _mm256_xor_ps(a, _mm256_castsi256_ps(bits)); }
+
+    static F sinAccurate(F x) {
+        __m256d lo = simdSinDouble<SimdAvx2D>(_mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        __m256d hi = simdSinDouble<SimdAvx2D>(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+    }
+};
+
+#endif // SIMD_X86 && SIMD_PACK_AVX2
+
+#if defined(SIMD_X86) && defined(SIMD_PACK_AVX512)
+
+// AVX-512F: 16 float lanes, comparisons produce k-masks
+struct SimdAvx512D {
+    typedef __m512d V;
+    static V set1(double v) { return _mm512_set1_pd(v); }
+    static V add(V a, V b) { return _mm512_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+    static V flipIfOdd(V r, V t) {
+        __m512i sign = _mm512_slli_epi64(_mm512_castpd_si512(t), 63);
+        return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(r), sign));
+    }
+};
+
+struct SimdAvx512 {
+    static const int Width = 16;
+    typedef __m512 F;
+    typedef __m512i I;
+    typedef __mmask16 M;
+
+    static F set1(float v) { return _mm512_set1_ps(v); }
+    static F load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, F v) { _mm512_storeu_ps(p, v); }
+    static F add(F a, F b) { return _mm512_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    static F div(F a, F b) { return _mm512_div_ps(a, b); }
+    static F abs(F a) {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+    }
+    static F floor(F x) { return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+    static I toInt(F x) { return _mm512_cvttps_epi32(x); }
+    static F toFloat(I x) { return _mm512_cvtepi32_ps(x); }
+    static I iload(const uint32_t* p) { return _mm512_loadu_si512((const void*)p); }
+    static I iset1(uint32_t v) { return _mm512_set1_epi32((int)v); }
+    static I iadd(I a, I b) { return _mm512_add_epi32(a, b); }
+    static I ixor(I a, I b) { return _mm512_xor_si512(a, b); }
+    static I iand(I a, I b) { return _mm512_and_si512(a, b); }
+    template <int N> static I isrl(I a) { return _mm512_srli_epi32(a, N); }
+    template <int N> static I isll(I a) { return _mm512_slli_epi32(a, N); }
+    static I imul(I a, I b) { return _mm512_mullo_epi32(a, b); }
+
+    static M ilt(I a, I b) { return _mm512_cmplt_epi32_mask(a, b); }
+    static M ieq(I a, I b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    static M mor(M a, M b) { return (M)(a | b); }
+    static F select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+    static F xorBits(F a, I bits) {
+        return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), bits));
+    }
+
+    static F sinAccurate(F x) {
+        __m256 xlo = _mm512_castps512_ps256(x);
+        __m256 xhi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(x), 1));
+        __m256 lo = _mm512_cvtpd_ps(simdSinDouble<SimdAvx512D>(_mm512_cvtps_pd(xlo)));
+        __m256 hi = _mm512_cvtpd_ps(simdSinDouble<SimdAvx512D>(_mm512_cvtps_pd(xhi)));
+        __m512d both = _mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(lo)), _mm256_castps_pd(hi), 1);
+        return _mm512_castpd_ps(both);
+    }
+};
+
+#endif // SIMD_X86 && SIMD_PACK_AVX512
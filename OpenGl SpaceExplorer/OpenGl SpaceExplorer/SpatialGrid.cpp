@@ -0,0 +1,144 @@
+#include "SpatialGrid.h"
+#include "AsteroidField.h"
+#include "Orbits.h"
+
+#include <chrono>
+#include <iostream>
+
+const uint32_t SpatialGrid::NONE;
+
+void SpatialGrid::build() {
+    size_t count = items.size();
+
+    // Twice as many buckets as items keeps most cells in a bucket of their own
+    size_t buckets = 16;
+    while (buckets < count * 2) buckets *= 2;
+    bucketMask = buckets - 1;
+    heads.assign(buckets, NONE);
+    next.resize(count);
+
+    // Bounds are kept in locals: as members they'd be stored and reloaded for
+    // every item (the compiler can't tell they don't alias the items)
+    float largest = 0.0f;
+    glm::vec3 low = count ? items[0].position : glm::vec3(0.0f);
+    glm::vec3 high = low;
+    for (size_t i = 0; i < count; ++i) {
+        const Item& item = items[i];
+        uint32_t& head = heads[bucketOf(item.cell)];
+        next[i] = head;
+        head = (uint32_t)i;
+        largest = std::max(largest, item.radius);
+        low = glm::min(low, item.position);
+        high = glm::max(high, item.position);
+    }
+    maxRadius = largest;
+    lo = low;
+    hi = high;
+    loCell = count ? cellOf(lo) : CellCoord{ 0, 0, 0 };
+    hiCell = count ? cellOf(hi) : CellCoord{ -1, -1, -1 };
+}
+
+bool SpatialGrid::selfTest(uint64_t seed) {
+    // The game's own distributions: a belt, dense clusters and planet-sized spheres
+    std::vector<Asteroid> source;
+    PlanetGenerator::generateAsteroids(source, seed, 20000);
+    PlanetGenerator::generateAsteroidClusters(source, seed, 60, 25, 55, 300.0f, 1400.0f);
+    AsteroidField field;
+    field.build(source, 1.0f / 120.0f);
+
+    std::vector<Planet> planets;
+    PlanetGenerator::generatePlanets(planets, seed);
+
+    std::vector<glm::vec3> positions;
+    std::vector<float> radii;
+    for (size_t i = 0; i < field.size(); ++i) {
+        positions.push_back(field.position(i));
+        radii.push_back(field.collisionRadius(i));
+    }
+    for (const Planet& planet : planets) {
+        positions.push_back(Orbits::planetOffset(planet, 0.0));
+        radii.push_back(planet.collisionRadius);
+    }
+
+    SpatialGrid grid(50.0f);
+    for (size_t i = 0; i < positions.size(); ++i) grid.insert((uint32_t)i, positions[i], radii[i]);
+    grid.build();
+
+    // Query points on and around items, and a few far outside everything
+    std::vector<glm::vec3> queries;
+    for (size_t i = 0; i < positions.size(); i += 97) {
+        queries.push_back(positions[i] + glm::vec3((float)(i % 7), -(float)(i % 5), (float)(i % 11)));
+    }
+    queries.push_back(glm::vec3(1.0e5f, 0.0f, 0.0f));
+    queries.push_back(glm::vec3(0.0f, -3.0e4f, 2.0e4f));
+
+    auto odd = [](uint32_t id) { return (id & 1) != 0; };
+    bool ok = true;
+    size_t overlaps = 0, inRange = 0;
+    std::vector<uint32_t> expected, found;
+    std::vector<Hit> bruteNearest, gridNearest;
+
+    for (const glm::vec3& q : queries) {
+        // Overlap with a player-sized sphere
+        expected.clear();
+        found.clear();
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (glm::length(q - positions[i]) < 2.0f + radii[i]) expected.push_back((uint32_t)i);
+        }
+        grid.forEachOverlap(q, 2.0f, [&](uint32_t id, float) { found.push_back(id); });
+        std::sort(found.begin(), found.end());
+        ok = ok && found == expected;
+        overlaps += found.size();
+
+        // Radar-sized radius
+        expected.clear();
+        found.clear();
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (!(glm::length(q - positions[i]) > 150.0f)) expected.push_back((uint32_t)i);
+        }
+        grid.forEachInRadius(q, 150.0f, [&](uint32_t id, float) { found.push_back(id); });
+        std::sort(found.begin(), found.end());
+        ok = ok && found == expected;
+        inRange += found.size();
+
+        // 8 nearest odd ids, and the single nearest
+        bruteNearest.clear();
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (odd((uint32_t)i)) bruteNearest.push_back(Hit{ (uint32_t)i, glm::length(q - positions[i]) });
+        }
+        std::sort(bruteNearest.begin(), bruteNearest.end(), closer);
+        bruteNearest.resize(8);
+        grid.nearest(q, 8, odd, gridNearest);
+        bool same = gridNearest.size() == bruteNearest.size();
+        for (size_t k = 0; same && k < gridNearest.size(); ++k) same = gridNearest[k].id == bruteNearest[k].id;
+        ok = ok && same && grid.nearest(q, odd) == bruteNearest[0].id;
+    }
+
+    // No item passes the filter: nothing found, however far it searched
+    ok = ok && grid.nearest(queries[0], [](uint32_t) { return false; }) == NONE;
+
+    std::cout << "Grid selftest: " << positions.size() << " items, " << queries.size() << " queries, "
+        << overlaps << " overlaps, " << inRange << " in radar range: " << (ok ? "OK" : "FAILED") << std::endl;
+
+    // Rough cost of a radar query compared with the linear scan it replaces
+    const int reps = 20;
+    volatile size_t sink = 0;   // keeps both loops from being optimised away
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (const glm::vec3& q : queries) grid.forEachInRadius(q, 150.0f, [&](uint32_t id, float) { sink += id; });
+    }
+    double gridUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (const glm::vec3& q : queries) {
+            for (size_t i = 0; i < positions.size(); ++i) {
+                if (!(glm::length(q - positions[i]) > 150.0f)) sink += i;
+            }
+        }
+    }
+    double scanUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    size_t queryCount = queries.size() * reps;
+    std::cout << "Grid selftest: radius query " << gridUs / queryCount << " us, linear scan "
+        << scanUs / queryCount << " us" << std::endl;
+    return ok;
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+// Broad phase: a hashed uniform grid of spheres, rebuilt whenever the things
+// in it move (once per tick).
+//
+// Items are binned by the cell their centre falls in, and the cells are
+// hashed into a table of twice the item count whose buckets chain their items
+// together. Working out each item's cell is the expensive part of a build and
+// can be spread over threads (set()); linking the chains is one cheap serial
+// pass, and nothing is allocated once the vectors have grown. A query only
+// visits the cells its sphere (grown by the largest item radius) touches,
+// clamped to the cells that hold anything; if that's more cells than the
+// table has buckets it scans the items instead.
+//
+// Item ids are whatever the caller inserted them with (an asteroid index, a
+// slot in a list of entities). Callbacks get (id, distance between centres).
+// The exact tests use glm::length, as the linear scans they replace did.
+class SpatialGrid {
+public:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct Hit {
+        uint32_t id;
+        float distance;
+    };
+
+    explicit SpatialGrid(float cellSize) : cellSize(cellSize), invCellSize(1.0f / cellSize) {}
+
+    // Filling: clear() and insert() every item, or resize() and set() every
+    // slot (from any number of threads, each with its own slots); then build()
+    // before querying.
+    void clear() { items.clear(); }
+    void insert(uint32_t id, const glm::vec3& position, float radius) {
+        items.push_back(Item());
+        set(items.size() - 1, id, position, radius);
+    }
+
+    void resize(size_t count) { items.resize(count); }
+    void set(size_t slot, uint32_t id, const glm::vec3& position, float radius) {
+        CellCoord c = cellOf(position);
+        items[slot] = Item{ position, radius, id, cellKey(c.x, c.y, c.z) };
+    }
+
+    void build();
+
+    size_t size() const { return items.size(); }
+
+    // fn(id, distance) for every item whose sphere overlaps this one
+    template <typename Fn>
+    void forEachOverlap(const glm::vec3& center, float radius, Fn fn) const {
+        visit(center, radius + maxRadius, [&](const Item& item) {
+            float distance = glm::length(center - item.position);
+            if (distance < radius + item.radius) fn(item.id, distance);
+        });
+    }
+
+    // fn(id, distance) for every item whose centre is within range
+    template <typename Fn>
+    void forEachInRadius(const glm::vec3& center, float range, Fn fn) const {
+        visit(center, range, [&](const Item& item) {
+            float distance = glm::length(center - item.position);
+            if (!(distance > range)) fn(item.id, distance);
+        });
+    }
+
+    // The k closest items (by centre) that pass filter(id), nearest first;
+    // equal distances go to the lower id. Searches a growing radius until it
+    // has k or has covered every item.
+    template <typename Filter>
+    size_t nearest(const glm::vec3& center, size_t k, Filter filter, std::vector<Hit>& out) const {
+        out.clear();
+        if (k == 0 || items.empty()) return 0;
+
+        float reach = reachFrom(center);
+        for (float range = cellSize;; range *= 2.0f) {
+            range = std::min(range, reach);
+            out.clear();
+            forEachInRadius(center, range, [&](uint32_t id, float distance) {
+                if (filter(id)) out.push_back(Hit{ id, distance });
+            });
+            if (out.size() >= k || range >= reach) break;
+        }
+
+        k = std::min(k, out.size());
+        std::partial_sort(out.begin(), out.begin() + k, out.end(), closer);
+        out.resize(k);
+        return k;
+    }
+
+    // The closest item passing filter(id), or NONE
+    template <typename Filter>
+    uint32_t nearest(const glm::vec3& center, Filter filter) const {
+        Hit best{ NONE, 0.0f };
+        if (items.empty()) return NONE;
+
+        // Anything found within a range is closer than everything outside it
+        float reach = reachFrom(center);
+        for (float range = cellSize; best.id == NONE; range *= 2.0f) {
+            range = std::min(range, reach);
+            forEachInRadius(center, range, [&](uint32_t id, float distance) {
+                Hit hit{ id, distance };
+                if ((best.id == NONE || closer(hit, best)) && filter(id)) best = hit;
+            });
+            if (range >= reach) break;
+        }
+        return best.id;
+    }
+
+    // Checks every query against brute force on random items
+    // (--grid-selftest). Returns false on any mismatch.
+    static bool selfTest(uint64_t seed);
+
+private:
+    struct Item {
+        glm::vec3 position;
+        float radius;
+        uint32_t id;
+        uint64_t cell;
+    };
+
+    struct CellCoord {
+        int x, y, z;
+    };
+
+    // 21 bits per axis; the world is far smaller than 2^20 cells either way
+    static uint64_t cellKey(int x, int y, int z) {
+        const int BIAS = 1 << 20;
+        return (uint64_t)(uint32_t)(x + BIAS) | ((uint64_t)(uint32_t)(y + BIAS) << 21) | ((uint64_t)(uint32_t)(z + BIAS) << 42);
+    }
+
+    size_t bucketOf(uint64_t key) const {
+        key ^= key >> 29;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 32;
+        return (size_t)key & bucketMask;
+    }
+
+    static bool closer(const Hit& a, const Hit& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    }
+
+    // Distance from a point to the far corner of the item bounds
+    float reachFrom(const glm::vec3& center) const {
+        return glm::length(glm::max(glm::abs(center - lo), glm::abs(center - hi)));
+    }
+
+    CellCoord cellOf(const glm::vec3& p) const {
+        const float LIMIT = (float)((1 << 20) - 1);
+        glm::vec3 c = glm::clamp(p * invCellSize, glm::vec3(-LIMIT), glm::vec3(LIMIT));
+        return CellCoord{ floorToInt(c.x), floorToInt(c.y), floorToInt(c.z) };
+    }
+
+    // Without SSE4.1 glm::floor is a much longer sequence; values are in range
+    static int floorToInt(float v) {
+        int i = (int)v;
+        return (float)i > v ? i - 1 : i;
+    }
+
+    // visitor(item) for every item in the cells a sphere of this range touches
+    template <typename Visitor>
+    void visit(const glm::vec3& center, float range, Visitor visitor) const {
+        if (items.empty()) return;
+        CellCoord a = cellOf(center - glm::vec3(range));
+        CellCoord b = cellOf(center + glm::vec3(range));
+        a.x = std::max(a.x, loCell.x); a.y = std::max(a.y, loCell.y); a.z = std::max(a.z, loCell.z);
+        b.x = std::min(b.x, hiCell.x); b.y = std::min(b.y, hiCell.y); b.z = std::min(b.z, hiCell.z);
+        if (a.x > b.x || a.y > b.y || a.z > b.z) return;
+
+        double cells = (double)(b.x - a.x + 1) * (double)(b.y - a.y + 1) * (double)(b.z - a.z + 1);
+        if (cells > (double)(bucketMask + 1)) {
+            for (const Item& item : items) visitor(item);
+            return;
+        }
+
+        for (int z = a.z; z <= b.z; ++z) {
+            for (int y = a.y; y <= b.y; ++y) {
+                for (int x = a.x; x <= b.x; ++x) {
+                    uint64_t key = cellKey(x, y, z);
+                    // Buckets are shared by every cell hashing to them
+                    for (uint32_t i = heads[bucketOf(key)]; i != NONE; i = next[i]) {
+                        if (items[i].cell == key) visitor(items[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    float cellSize;
+    float invCellSize;
+
+    std::vector<Item> items;             // in insertion order
+    std::vector<uint32_t> heads;         // first item in each bucket (NONE if empty)
+    std::vector<uint32_t> next;          // next item in the same bucket
+    size_t bucketMask = 0;               // bucket count - 1 (a power of two)
+    float maxRadius = 0.0f;
+    glm::vec3 lo = glm::vec3(0.0f);      // bounds of the item centres
+    glm::vec3 hi = glm::vec3(0.0f);
+    CellCoord loCell = CellCoord{ 0, 0, 0 };
+    CellCoord hiCell = CellCoord{ -1, -1, -1 };
+};
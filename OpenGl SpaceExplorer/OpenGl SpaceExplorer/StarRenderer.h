@@ -3,6 +3,9 @@
 #include <glm/glm.hpp>
 #include <GL/glew.h>
 
+#include "PlanetGenerator.h"
+#include "RenderStats.h"
+
 struct StarVertex {
     glm::vec3 Position;
     float Brightness;
@@ -21,14 +24,14 @@ public:
         if (VBO != 0) glDeleteBuffers(1, &VBO);
     }
 
-    void loadStars(const std::vector<glm::vec3>& starPositions) {
+    void loadStars(const std::vector<Star>& stars) {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
 
-        std::vector<StarVertex> vertices;
-        for (const auto& pos : starPositions) {
-            float brightness = 0.3f + (rand() / (float)RAND_MAX) * 0.7f;
-            vertices.push_back({ pos, brightness });
+        // Brightness comes from the generator so the starfield follows the world seed
+        std::vector<StarVertex> vertices(stars.size());
+        for (size_t i = 0; i < stars.size(); ++i) {
+            vertices[i] = { stars[i].pos, stars[i].brightness };
         }
 
         glBindVertexArray(VAO);
@@ -50,6 +53,7 @@ public:
         glBindVertexArray(VAO);
         glPointSize(2.0f);
         glDrawArrays(GL_POINTS, 0, vertexCount);
+        RenderStats::draw(0);
         glPointSize(1.0f);
     }
 };
\ No newline at end of file
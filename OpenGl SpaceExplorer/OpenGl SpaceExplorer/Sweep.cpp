@@ -0,0 +1,98 @@
+#include "Sweep.h"
+#include "AsteroidField.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Sweep {
+
+bool selfTest(uint64_t seed) {
+    // The game's asteroids, grown by a player-sized mover
+    const float MOVER_RADIUS = 2.0f;
+    std::vector<Asteroid> source;
+    PlanetGenerator::generateAsteroids(source, seed, 20000);
+    PlanetGenerator::generateAsteroidClusters(source, seed, 60, 25, 55, 300.0f, 1400.0f);
+    AsteroidField field;
+    field.build(source, 1.0f / 60.0f);
+
+    std::vector<Obstacle> all(field.size());
+    for (size_t i = 0; i < field.size(); ++i) {
+        all[i] = Obstacle{ field.position(i), field.collisionRadius(i) + MOVER_RADIUS };
+    }
+
+    // Moves start just off a random asteroid and are up to 60 units long
+    // (boost speed at 2 ticks a second)
+    const int MOVES = 2000;
+    const int SUBSTEPS = 4000;
+    EntityRng rng(seed, STREAM_SYSTEM, 41);
+    bool ok = true;
+    int hits = 0, discreteMisses = 0, grazes = 0, contacts = 0;
+    std::vector<Obstacle> nearby;
+
+    for (int n = 0; n < MOVES; ++n) {
+        const Obstacle& anchor = all[rng.below((int)all.size())];
+        glm::vec3 start = anchor.center + glm::vec3(rng.uniform(-12.0f, 12.0f), rng.uniform(-12.0f, 12.0f), rng.uniform(-12.0f, 12.0f));
+        glm::vec3 delta(rng.uniform(-1.0f, 1.0f), rng.uniform(-1.0f, 1.0f), rng.uniform(-1.0f, 1.0f));
+        if (glm::dot(delta, delta) == 0.0f) continue;
+        delta = glm::normalize(delta) * rng.uniform(1.0f, 60.0f);
+        float reach = glm::length(delta);
+
+        // Anything the move (or a slide, never longer than the move) can touch
+        nearby.clear();
+        bool inside = false;
+        for (const Obstacle& obstacle : all) {
+            float distance = glm::length(start - obstacle.center);
+            if (distance < reach + obstacle.radius) nearby.push_back(obstacle);
+            inside = inside || distance <= obstacle.radius;
+        }
+        if (inside) continue;
+
+        // Time of impact against sampling the move finely
+        float first = 2.0f;
+        for (const Obstacle& obstacle : nearby) {
+            float t;
+            if (timeOfImpact(start, delta, obstacle, t)) first = std::min(first, t);
+        }
+        int sampled = -1;
+        for (int k = 1; k <= SUBSTEPS && sampled < 0; ++k) {
+            glm::vec3 p = start + delta * ((float)k / SUBSTEPS);
+            for (const Obstacle& obstacle : nearby) {
+                if (glm::length(p - obstacle.center) < obstacle.radius) {
+                    sampled = k;
+                    break;
+                }
+            }
+        }
+        if (sampled >= 0) {
+            // The exact contact lies within the step that first overlapped
+            float tolerance = 1.0e-4f;
+            ok = ok && first >= (float)(sampled - 1) / SUBSTEPS - tolerance && first <= (float)sampled / SUBSTEPS + tolerance;
+        }
+        else if (first <= 1.0f) {
+            ++grazes;   // clipped an edge between two samples
+        }
+        if (first <= 1.0f) {
+            ++hits;
+            // Checking only where the move ends, as a discrete test does
+            glm::vec3 end = start + delta;
+            bool overlapped = false;
+            for (const Obstacle& obstacle : nearby) overlapped = overlapped || glm::length(end - obstacle.center) < obstacle.radius;
+            if (!overlapped) ++discreteMisses;
+        }
+
+        // Sliding never ends inside anything or goes further than the move
+        int slides = 0;
+        glm::vec3 end = slide(start, delta, nearby, &slides);
+        contacts += slides;
+        for (const Obstacle& obstacle : nearby) ok = ok && glm::length(end - obstacle.center) >= obstacle.radius;
+        ok = ok && glm::length(end - start) <= reach * 1.001f + CONTACT_GAP;
+        ok = ok && (first <= 1.0f) == (slides > 0);
+    }
+
+    std::cout << "Sweep selftest: " << MOVES << " moves, " << hits << " hits (" << grazes << " grazing), "
+        << discreteMisses << " missed by an end-of-move overlap test, " << contacts << " slide contacts: "
+        << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+} // namespace Sweep
@@ -0,0 +1,98 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Continuous collision for a moving sphere against spheres that hold still
+// for the duration of the move (a tick's move against the tick's positions).
+//
+// Rather than testing where the sphere ends up, which lets a fast move step
+// straight over anything thinner than the move, every obstacle is grown by
+// the mover's radius and the move becomes a ray: the time of impact is where
+// the ray first enters the grown sphere. On impact the rest of the move is
+// projected onto the contact plane and swept again (collide and slide), so
+// the mover glides along a surface instead of stopping dead.
+namespace Sweep {
+
+// An obstacle's centre and its radius plus the mover's
+struct Obstacle {
+    glm::vec3 center;
+    float radius;
+};
+
+const int MAX_SLIDES = 4;          // contacts resolved per move (corners need a few)
+const float CONTACT_GAP = 1.0e-3f; // left between mover and surface after a contact
+
+// Earliest t in [0, 1] at which start + t * delta touches the obstacle.
+// Starting inside counts as touching at 0 unless the move heads outwards.
+inline bool timeOfImpact(const glm::vec3& start, const glm::vec3& delta, const Obstacle& obstacle, float& t) {
+    glm::vec3 m = start - obstacle.center;
+    float b = glm::dot(m, delta);
+    if (b >= 0.0f) return false;   // not moving towards the centre
+    float c = glm::dot(m, m) - obstacle.radius * obstacle.radius;
+    if (c <= 0.0f) {
+        t = 0.0f;
+        return true;
+    }
+
+    float a = glm::dot(delta, delta);
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return false;
+    t = (-b - std::sqrt(discriminant)) / a;
+    return t <= 1.0f;
+}
+
+// Where a move from start by delta ends up, sliding along any obstacles in
+// the way (a start inside one goes back out to its surface). contacts (if
+// given) counts the surfaces hit.
+inline glm::vec3 slide(const glm::vec3& start, const glm::vec3& delta, const std::vector<Obstacle>& obstacles,
+    int* contacts = nullptr) {
+    glm::vec3 position = start;
+    glm::vec3 move = delta;
+    int hits = 0;
+
+    for (int pass = 0; pass < MAX_SLIDES; ++pass) {
+        if (glm::dot(move, move) == 0.0f) break;
+
+        float first = 2.0f;
+        const Obstacle* hit = nullptr;
+        for (const Obstacle& obstacle : obstacles) {
+            float t;
+            if (timeOfImpact(position, move, obstacle, t) && t < first) {
+                first = t;
+                hit = &obstacle;
+            }
+        }
+        if (!hit) {
+            position += move;
+            break;
+        }
+
+        // Stop at the surface, then keep only the part of what's left that
+        // runs along it
+        glm::vec3 contact = position + move * first;
+        glm::vec3 offset = contact - hit->center;
+        float distance = glm::length(offset);
+        glm::vec3 normal = distance > 0.0f ? offset / distance : -glm::normalize(move);
+        position = hit->center + normal * (hit->radius + CONTACT_GAP);
+
+        glm::vec3 rest = move * (1.0f - first);
+        move = rest - normal * glm::dot(rest, normal);
+        ++hits;
+
+        // Out of passes: stay at the last contact rather than risk the rest
+        if (pass == MAX_SLIDES - 1) move = glm::vec3(0.0f);
+    }
+
+    if (contacts) *contacts = hits;
+    return position;
+}
+
+// Checks timeOfImpact against a finely sub-stepped overlap test and that
+// slide() never ends up inside anything, on fast moves through an asteroid
+// field (--sweep-selftest). Returns false on any mismatch.
+bool selfTest(uint64_t seed);
+
+} // namespace Sweep
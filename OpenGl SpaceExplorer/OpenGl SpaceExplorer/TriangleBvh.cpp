@@ -0,0 +1,198 @@
+#include "TriangleBvh.h"
+#include "PlanetGenerator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+
+const uint32_t TriangleBvh::LEAF_SIZE;
+
+TriangleBvh::TriangleBvh(const std::vector<glm::vec3>& positions) {
+    triangles.reserve(positions.size() / 3);
+    for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+        triangles.push_back(Triangle{ positions[i], positions[i + 1], positions[i + 2] });
+        for (size_t k = i; k < i + 3; ++k) radius = std::max(radius, glm::length(positions[k]));
+    }
+    if (triangles.empty()) return;
+
+    nodes.reserve(2 * triangles.size());
+    build(0, triangles.size());
+}
+
+void TriangleBvh::build(size_t begin, size_t end) {
+    uint32_t index = (uint32_t)nodes.size();
+    nodes.push_back(Node());
+
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX), centroidLo(FLT_MAX), centroidHi(-FLT_MAX);
+    for (size_t i = begin; i < end; ++i) {
+        const Triangle& t = triangles[i];
+        lo = glm::min(lo, glm::min(t.a, glm::min(t.b, t.c)));
+        hi = glm::max(hi, glm::max(t.a, glm::max(t.b, t.c)));
+        glm::vec3 centroid = (t.a + t.b + t.c) / 3.0f;
+        centroidLo = glm::min(centroidLo, centroid);
+        centroidHi = glm::max(centroidHi, centroid);
+    }
+    nodes[index].lo = lo;
+    nodes[index].hi = hi;
+
+    if (end - begin <= LEAF_SIZE) {
+        nodes[index].first = (uint32_t)begin;
+        nodes[index].count = (uint32_t)(end - begin);
+        return;
+    }
+
+    glm::vec3 extent = centroidHi - centroidLo;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(triangles.begin() + begin, triangles.begin() + mid, triangles.begin() + end,
+        [axis](const Triangle& x, const Triangle& y) {
+            return x.a[axis] + x.b[axis] + x.c[axis] < y.a[axis] + y.b[axis] + y.c[axis];
+        });
+
+    build(begin, mid);
+    nodes[index].first = (uint32_t)nodes.size();
+    nodes[index].count = 0;
+    build(mid, end);
+}
+
+bool TriangleBvh::closestPoint(const glm::vec3& center, float range, Contact& out) const {
+    if (nodes.empty()) return false;
+
+    auto boxDistance = [&](const Node& node) {
+        return glm::length(glm::max(glm::max(node.lo - center, center - node.hi), glm::vec3(0.0f)));
+    };
+
+    // Nothing further away than the best so far can matter
+    float best = range;
+    bool found = false;
+    uint32_t stack[64];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const Node& node = nodes[stack[--depth]];
+        if (boxDistance(node) > best) continue;
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const Triangle& t = triangles[i];
+                glm::vec3 point = closestPointOnTriangle(center, t.a, t.b, t.c);
+                float distance = glm::length(center - point);
+                if (distance <= best) {
+                    best = distance;
+                    out = Contact{ point, distance };
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top; a median split keeps the depth near log2 of
+        // the leaf count, far inside the stack
+        uint32_t closer = (uint32_t)(&node - nodes.data()) + 1;
+        uint32_t further = node.first;
+        if (boxDistance(nodes[further]) < boxDistance(nodes[closer])) std::swap(closer, further);
+        stack[depth++] = further;
+        stack[depth++] = closer;
+    }
+    return found;
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5: which feature (a vertex, an
+// edge or the face) the point projects onto, from its barycentric regions
+glm::vec3 TriangleBvh::closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+bool TriangleBvh::selfTest(uint64_t seed) {
+    // A lumpy closed shell plus loose panels, roughly probe-sized but with
+    // far more triangles than the probe models so the tree has some depth
+    EntityRng rng(seed, STREAM_SYSTEM, 42);
+    std::vector<glm::vec3> positions;
+    const int RINGS = 24, SEGMENTS = 48;
+    auto shell = [&](int ring, int segment) {
+        float theta = 3.14159265f * ring / RINGS;
+        float phi = 6.28318531f * segment / SEGMENTS;
+        float r = 1.0f + 0.15f * std::sin(3.0f * phi) * std::sin(2.0f * theta);
+        return glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)) * r;
+    };
+    for (int ring = 0; ring < RINGS; ++ring) {
+        for (int segment = 0; segment < SEGMENTS; ++segment) {
+            glm::vec3 a = shell(ring, segment), b = shell(ring + 1, segment);
+            glm::vec3 c = shell(ring + 1, segment + 1), d = shell(ring, segment + 1);
+            positions.insert(positions.end(), { a, b, c, a, c, d });
+        }
+    }
+    for (int panel = 0; panel < 200; ++panel) {
+        glm::vec3 corner(rng.uniform(-2.0f, 2.0f), rng.uniform(-2.0f, 2.0f), rng.uniform(-2.0f, 2.0f));
+        for (int k = 0; k < 3; ++k) {
+            positions.push_back(corner + glm::vec3(rng.uniform(-0.4f, 0.4f), rng.uniform(-0.4f, 0.4f), rng.uniform(-0.4f, 0.4f)));
+        }
+    }
+
+    TriangleBvh bvh(positions);
+    bool ok = bvh.triangleCount() == positions.size() / 3;
+
+    const int QUERIES = 5000;
+    const float RANGE = 0.5f;
+    int contacts = 0;
+    double bvhUs = 0.0, scanUs = 0.0;
+    for (int q = 0; q < QUERIES; ++q) {
+        glm::vec3 center(rng.uniform(-2.5f, 2.5f), rng.uniform(-2.5f, 2.5f), rng.uniform(-2.5f, 2.5f));
+
+        auto start = std::chrono::steady_clock::now();
+        Contact contact{ glm::vec3(0.0f), 0.0f };
+        bool found = bvh.closestPoint(center, RANGE, contact);
+        auto middle = std::chrono::steady_clock::now();
+
+        float best = RANGE;
+        bool expected = false;
+        for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+            glm::vec3 point = closestPointOnTriangle(center, positions[i], positions[i + 1], positions[i + 2]);
+            float distance = glm::length(center - point);
+            if (distance <= best) {
+                best = distance;
+                expected = true;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        bvhUs += std::chrono::duration<double, std::micro>(middle - start).count();
+        scanUs += std::chrono::duration<double, std::micro>(end - middle).count();
+
+        // Same answer (ties between triangles may pick a different point at
+        // the same distance)
+        ok = ok && found == expected && (!found || contact.distance == best);
+        if (found) ++contacts;
+    }
+
+    std::cout << "Mesh selftest: " << bvh.triangleCount() << " triangles, " << QUERIES << " queries, "
+        << contacts << " contacts: " << (ok ? "OK" : "FAILED") << std::endl;
+    std::cout << "Mesh selftest: closest point " << bvhUs / QUERIES << " us, every triangle "
+        << scanUs / QUERIES << " us" << std::endl;
+    return ok;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Static bounding volume hierarchy over one mesh's triangles, for exact
+// collision against models. It's built once when the model loads and shared
+// by every instance of it: queries are made in the mesh's own space, so the
+// caller brings its sphere in through the instance's transform and takes the
+// answer back out.
+//
+// Nodes are laid out depth first (a node's left child is the next node), and
+// leaves hold a few triangles each, split at the median along the longest axis.
+class TriangleBvh {
+public:
+    struct Contact {
+        glm::vec3 point;    // closest point on the surface
+        float distance;     // from the query centre to it
+    };
+
+    TriangleBvh() = default;
+
+    // Three positions per triangle, in model space
+    explicit TriangleBvh(const std::vector<glm::vec3>& positions);
+
+    bool empty() const { return triangles.empty(); }
+    size_t triangleCount() const { return triangles.size(); }
+
+    // Radius of the sphere about the model origin that holds every triangle
+    float boundingRadius() const { return radius; }
+
+    // The point on any triangle closest to center, if one is within range
+    bool closestPoint(const glm::vec3& center, float range, Contact& out) const;
+
+    static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+    // Checks closestPoint against testing every triangle on a generated mesh
+    // (--mesh-selftest). Returns false on any mismatch.
+    static bool selfTest(uint64_t seed);
+
+private:
+    static const uint32_t LEAF_SIZE = 4;
+
+    struct Triangle {
+        glm::vec3 a, b, c;
+    };
+
+    struct Node {
+        glm::vec3 lo, hi;
+        uint32_t first;     // leaf: first triangle; internal: right child
+        uint32_t count;     // triangles in a leaf, 0 for an internal node
+    };
+
+    void build(size_t begin, size_t end);
+
+    std::vector<Triangle> triangles;
+    std::vector<Node> nodes;
+    float radius = 0.0f;
+};
@@ -4,6 +4,7 @@ in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoord;
+    vec3 LocalPos;
 } fs_in;
 
 out vec4 FragColor;
@@ -22,6 +23,10 @@ uniform vec3 noiseOffset;
 
 uniform float scanHighlight; // 0 = none, 1 = target, >1 = scanning
 
+// Planet surface baked on the CPU at generation time (see PlanetBaker)
+uniform samplerCube surfaceMap;
+uniform float useBakedSurface;
+
 /* ===== SIMPLE SMOOTH NOISE ===== */
 float hash(vec2 p) {
     return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
@@ -46,6 +51,25 @@ mat2 rot2(float a) {
     return mat2(c, -s, s, c);
 }
 
+// Lava planets: dark crust vs bright, self-illuminating lava
+vec3 shadeLava(float cracks, vec3 ambient, vec3 diffuse, vec3 specular) {
+    vec3 crustColor = vec3(0.08, 0.02, 0.01);
+    vec3 lavaColor  = vec3(1.2, 0.35, 0.05); // HDR-style brightness
+
+    vec3 surfaceColor = mix(crustColor, lavaColor, cracks);
+
+    float glow = cracks * 1.5;
+    vec3 lavaLit = ambient + diffuse * surfaceColor + specular + lavaColor * glow;
+
+    // Scan highlight (green tint) for lava too
+    if (scanHighlight > 0.0) {
+        vec3 highlightColor = vec3(0.2, 1.0, 0.4);
+        lavaLit = mix(lavaLit, highlightColor, clamp(scanHighlight, 0.0, 1.0));
+    }
+
+    return lavaLit;
+}
+
 void main() {
     if (isEmissive > 0.5) {
         FragColor = vec4(baseColor * 2.5, 1.0);
@@ -68,6 +92,15 @@ void main() {
 
     if (isAsteroid > 0.5) {
         finalColor = texture(diffuseMap, fs_in.TexCoord).rgb * 0.8;
+    } else if (useBakedSurface > 0.5) {
+        // RGB = classified surface colour, A = height (or lava crack mask)
+        vec4 surface = texture(surfaceMap, fs_in.LocalPos);
+
+        if (planetType == 1) {
+            FragColor = vec4(shadeLava(surface.a, ambient, diffuse, specular), 1.0);
+            return;
+        }
+        finalColor = surface.rgb;
     } else {
         vec2 uv = fs_in.TexCoord * 2.5;
         uv += noiseOffset.xy * 0.01;
@@ -89,24 +122,7 @@ void main() {
         if (planetType == 1) {
             // Lava crack pattern
             float cracks = smoothstep(0.55, 0.7, continent);
-
-            // Dark crust vs bright lava
-            vec3 crustColor = vec3(0.08, 0.02, 0.01);
-            vec3 lavaColor  = vec3(1.2, 0.35, 0.05); // HDR-style brightness
-
-            finalColor = mix(crustColor, lavaColor, cracks);
-
-            // Make lava self-illuminating
-            float glow = cracks * 1.5;
-            vec3 lavaLit = ambient + diffuse * finalColor + specular + lavaColor * glow;
-
-            // Scan highlight (green tint) for lava too
-            if (scanHighlight > 0.0) {
-                vec3 highlightColor = vec3(0.2, 1.0, 0.4);
-                lavaLit = mix(lavaLit, highlightColor, clamp(scanHighlight, 0.0, 1.0));
-            }
-
-            FragColor = vec4(lavaLit, 1.0);
+            FragColor = vec4(shadeLava(cracks, ambient, diffuse, specular), 1.0);
             return;
         }
         else if (ocean < 0.5)       finalColor = vec3(0.0, 0.15, 0.35);
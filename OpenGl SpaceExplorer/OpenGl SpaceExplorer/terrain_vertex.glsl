@@ -0,0 +1,43 @@
+#version 410 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in vec3 morphDelta;
+
+uniform mat4 model;        // planet translation (relative to the camera) + spin (chunks are already in world units)
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+/* === CDLOD chunk === */
+uniform vec3 chunkOrigin;  // planet-local position the chunk's vertices are relative to
+uniform float morphStart;  // camera distance where vertices start moving to the parent grid
+uniform float morphEnd;    // ... and where they reach it
+
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoord;
+    vec3 LocalPos;
+} vs_out;
+
+void main()
+{
+    vec3 localPos = chunkOrigin + position;
+
+    /* --- Geomorph towards the coarser level near this level's outer range --- */
+    float dist = length((model * vec4(localPos, 1.0)).xyz - viewPos);
+    float morph = clamp((dist - morphStart) / (morphEnd - morphStart), 0.0, 1.0);
+    localPos += morphDelta * morph;
+
+    vec4 worldPos = model * vec4(localPos, 1.0);
+    vs_out.FragPos = worldPos.xyz;
+
+    /* No scale in the model matrix, so its rotation part transforms normals */
+    vs_out.Normal = mat3(model) * normal;
+    vs_out.TexCoord = texCoord;
+    vs_out.LocalPos = localPos;
+
+    gl_Position = projection * view * worldPos;
+}
@@ -4,7 +4,7 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texCoord;
 
-uniform mat4 model;
+uniform mat4 model;   // relative to the camera: view only rotates, and lightPos/viewPos are relative too
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -15,6 +15,7 @@ out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoord;
+    vec3 LocalPos;   // undisplaced model-space position (baked surface lookup)
 } vs_out;
 
 void main()
@@ -29,6 +30,7 @@ void main()
     /* Correct normal transform */
     vs_out.Normal = mat3(transpose(inverse(model))) * normal;
     vs_out.TexCoord = texCoord;
+    vs_out.LocalPos = position;
 
     gl_Position = projection * view * worldPos;
 }